@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HIPERF_ASYNC_FILE_WRITER_H
+#define HIPERF_ASYNC_FILE_WRITER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+// write a continuous part of file from a pool of buffers.
+// the caller fills the buffers, a flush thread writes the full ones out by pwrite,
+// so a slow disk does not stall the caller until all the buffers are full.
+class AsyncFileWriter {
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 2 * 1024 * 1024;
+    static constexpr size_t DEFAULT_BUFFER_COUNT = 4;
+    // offset, size and memory of O_DIRECT writes must be aligned to this
+    static constexpr size_t DIRECT_IO_ALIGN = 4096;
+
+    struct Stat {
+        uint64_t writtenBytes = 0;
+        uint64_t flushCount = 0;
+        // times the caller waited for a free buffer, the disk is slower than the records
+        uint64_t stallCount = 0;
+        std::chrono::microseconds stallTime = std::chrono::microseconds::zero();
+        std::chrono::microseconds flushTime = std::chrono::microseconds::zero();
+        size_t maxPendingBuffers = 0;
+    };
+
+    // fd is not closed by the writer
+    explicit AsyncFileWriter(const int fd, const size_t bufferSize = DEFAULT_BUFFER_SIZE,
+                             const size_t bufferCount = DEFAULT_BUFFER_COUNT);
+    ~AsyncFileWriter();
+
+    // write from offset of the file.
+    // directFd is the same file opened with O_DIRECT, the aligned buffers are written by it.
+    bool Start(const uint64_t offset, const int directFd = -1);
+    // only called by one thread
+    bool Write(const void *buf, size_t len);
+    // write out all the buffered data and stop the flush thread
+    bool Stop();
+
+    Stat GetStat();
+
+private:
+    struct Buffer {
+        std::vector<uint8_t> storage;
+        uint8_t *data = nullptr; // aligned to DIRECT_IO_ALIGN
+        size_t capacity = 0;
+        size_t size = 0;
+        uint64_t offset = 0;
+    };
+
+    bool AcquireBuffer();
+    void SubmitBuffer();
+    void FlushLoop();
+    bool WriteBuffer(const Buffer &buffer);
+
+    const int fd_;
+    int directFd_ = -1;
+    const size_t bufferSize_;
+    std::vector<std::unique_ptr<Buffer>> buffers_;
+    Buffer *current_ = nullptr;
+    uint64_t nextOffset_ = 0;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Buffer *> freeBuffers_;
+    std::deque<Buffer *> fullBuffers_;
+    bool stop_ = false;
+    bool failed_ = false;
+    Stat stat_;
+};
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
+#endif // HIPERF_ASYNC_FILE_WRITER_H
@@ -46,6 +46,17 @@ public:
     ~CallStackProcessor() = default;
 
     void UnwindFromRecord(PerfRecordSample& record);
+#if defined(is_ohos) && is_ohos
+    // the thread which the user stack is unwound in, null if the sample has no user stack
+    VirtualThread *GetUnwindThread(PerfRecordSample& record);
+    // it can be called by several threads with their own call stacks,
+    // if the samples of one process are always unwound by the same call stack.
+    // the unwound frames and the new ips of record are kept in callFrames and ips
+    void UnwindUserStack(PerfRecordSample& record, const VirtualThread& thread, CallStack& callstack,
+                         std::vector<DfxFrame>& callFrames, std::vector<u64>& ips) const;
+#endif
+    // the steps after unwinding, they are done in the order of records
+    void FinishUnwind(PerfRecordSample& record);
     void SymbolicRecord(PerfRecordSample& record);
     void SymbolSpeRecord(PerfRecordAuxtrace& record);
     void ProcessAuxtraceRecord(PerfRecordAuxtrace& record);
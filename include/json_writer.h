@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HIPERF_JSON_WRITER_H
+#define HIPERF_JSON_WRITER_H
+
+#include <charconv>
+#include <cstdio>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+// buffered json output for the report.
+// numbers are formatted by to_chars and strings are escaped when they are written,
+// the buffer is written out to the file when it is full, so the whole json is never kept in memory.
+class JsonWriter {
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 1024 * 1024;
+    // enough for any integer
+    static constexpr size_t MAX_NUMBER_LENGTH = 24;
+
+    // output is not closed by the writer
+    explicit JsonWriter(FILE *output, const size_t bufferSize = DEFAULT_BUFFER_SIZE);
+    ~JsonWriter();
+    JsonWriter(const JsonWriter &) = delete;
+    JsonWriter &operator=(const JsonWriter &) = delete;
+
+    void Write(const char c)
+    {
+        if (size_ == buffer_.size()) {
+            Flush();
+        }
+        buffer_[size_++] = c;
+    }
+    // raw text, not escaped
+    void Write(const std::string_view &text);
+    // quoted and escaped string
+    void WriteString(const std::string_view &str);
+
+    template<class T>
+    void WriteNumber(const T value)
+    {
+        static_assert(std::is_integral<T>::value, "only integers are supported");
+        if constexpr (std::is_same<T, bool>::value) {
+            Write(value ? '1' : '0');
+        } else {
+            if (buffer_.size() - size_ < MAX_NUMBER_LENGTH) {
+                Flush();
+            }
+            auto result = std::to_chars(buffer_.data() + size_, buffer_.data() + buffer_.size(), value);
+            size_ = static_cast<size_t>(result.ptr - buffer_.data());
+        }
+    }
+
+    // write the buffered data to the file, return false if any write has failed
+    bool Flush();
+
+private:
+    FILE *output_ = nullptr;
+    std::vector<char> buffer_;
+    size_t size_ = 0;
+    bool failed_ = false;
+};
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
+#endif // HIPERF_JSON_WRITER_H
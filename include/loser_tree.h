@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HIPERF_LOSER_TREE_H
+#define HIPERF_LOSER_TREE_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+// tournament tree used to merge k sorted sources.
+// leaves are source indexes, Less(a, b) compares the current keys of source a and b.
+// after the key of the winner changed, Replay() it, only log(k) compares are needed.
+// Replay() and Exhaust() are only valid for the current winner.
+template<typename Less>
+class LoserTree {
+public:
+    explicit LoserTree(Less less) : less_(std::move(less)) {}
+    ~LoserTree() = default;
+
+    // all sources are alive after build
+    void Build(const size_t count)
+    {
+        count_ = count;
+        exhausted_.assign(count, false);
+        tree_.assign(count == 0 ? 1 : count, count);
+        if (count <= 1) {
+            tree_[0] = 0;
+            return;
+        }
+        // winners of each node, leaves are put at [count, 2 * count)
+        std::vector<size_t> winners(count * 2);
+        for (size_t i = 0; i < count; i++) {
+            winners[count + i] = i;
+        }
+        for (size_t node = count - 1; node > 0; node--) {
+            size_t left = winners[node * 2];
+            size_t right = winners[node * 2 + 1];
+            if (Beats(left, right)) {
+                winners[node] = left;
+                tree_[node] = right;
+            } else {
+                winners[node] = right;
+                tree_[node] = left;
+            }
+        }
+        tree_[0] = winners[1];
+    }
+
+    // return count if all the sources are exhausted
+    size_t Top() const
+    {
+        if (count_ == 0 || exhausted_[tree_[0]]) {
+            return count_;
+        }
+        return tree_[0];
+    }
+
+    // replay the winner after its key changed
+    void Replay(const size_t leaf)
+    {
+        size_t winner = leaf;
+        for (size_t node = (leaf + count_) / 2; node > 0; node /= 2) {
+            if (Beats(tree_[node], winner)) {
+                std::swap(tree_[node], winner);
+            }
+        }
+        tree_[0] = winner;
+    }
+
+    // the winner has no more data, it never wins again
+    void Exhaust(const size_t leaf)
+    {
+        exhausted_[leaf] = true;
+        Replay(leaf);
+    }
+
+    // the best loser on the way from leaf to root, it is the next winner if leaf is exhausted.
+    // return count if there is no other alive source
+    size_t RunnerUp(const size_t leaf) const
+    {
+        size_t runnerUp = count_;
+        for (size_t node = (leaf + count_) / 2; node > 0; node /= 2) {
+            size_t loser = tree_[node];
+            if (exhausted_[loser]) {
+                continue;
+            }
+            if (runnerUp == count_ || Beats(loser, runnerUp)) {
+                runnerUp = loser;
+            }
+        }
+        return runnerUp;
+    }
+
+private:
+    // stable, the smaller index wins when the keys are equal
+    bool Beats(const size_t a, const size_t b) const
+    {
+        if (exhausted_[a] || exhausted_[b]) {
+            return !exhausted_[a];
+        }
+        if (less_(a, b)) {
+            return true;
+        }
+        if (less_(b, a)) {
+            return false;
+        }
+        return a < b;
+    }
+
+    Less less_;
+    size_t count_ = 0;
+    std::vector<size_t> tree_; // tree_[0] is the winner, others are the losers of each node
+    std::vector<bool> exhausted_;
+};
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
+#endif // HIPERF_LOSER_TREE_H
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HIPERF_PARALLEL_REPORT_AGGREGATOR_H
+#define HIPERF_PARALLEL_REPORT_AGGREGATOR_H
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "perf_event_record.h"
+#include "report.h"
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+// add the samples of report into the report items by several threads.
+// the caller still unwinds and symbolizes the samples in order, because the process maps and
+// symbols files are shared. the symbolized samples are sharded by pid, each worker aggregates
+// its shard into its own report, and the shard reports are merged into the report at last.
+class ParallelReportAggregator {
+public:
+    static constexpr size_t MAX_THREAD_COUNT = 8;
+    // used when the thread count is not given, the report still runs beside the other work of the device
+    static constexpr size_t DEFAULT_THREAD_COUNT = 4;
+    // samples are handed over to the workers in batches
+    static constexpr size_t BATCH_SIZE = 256;
+    // the caller waits if a worker has so many batches not aggregated
+    static constexpr size_t MAX_PENDING_BATCHES = 16;
+
+    ParallelReportAggregator(Report &report, const size_t threadCount, const bool includeCallStack);
+    ~ParallelReportAggregator();
+
+    // the configs of report must have been loaded
+    bool Start();
+    // only called by one thread. the call frames of sample are moved to the worker,
+    // comm is the current name of the sample thread
+    void AddSample(const PerfRecordSample &sample, const std::string &comm);
+    // aggregate all the pending samples, stop the workers and merge the shards into report
+    bool Finish();
+
+    size_t GetThreadCount() const
+    {
+        return threadCount_;
+    }
+
+    // DEFAULT_THREAD_COUNT at most, and no more than the cpu count
+    static size_t GetDefaultThreadCount();
+
+private:
+    struct SampleTask {
+        pid_t pid = 0;
+        pid_t tid = 0;
+        uint64_t id = 0;
+        uint64_t period = 0;
+        std::string_view comm;
+        std::vector<DfxFrame> callFrames;
+    };
+
+    struct Shard {
+        std::unique_ptr<Report> report;
+        std::thread thread;
+        // filled by the caller
+        std::vector<SampleTask> batch;
+        std::deque<std::vector<SampleTask>> pendingBatches;
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool stop = false;
+    };
+
+    void SubmitBatch(Shard &shard);
+    void AggregateLoop(Shard &shard);
+    void Stop();
+
+    Report &report_;
+    const size_t threadCount_;
+    const bool includeCallStack_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    // the thread which adds the samples, it owns the thread_local call frames moved out
+    std::thread::id callerThread_;
+    // tid -> name kept by the string pool, the name of a thread may be changed by comm record
+    std::unordered_map<pid_t, std::string_view> comms_;
+};
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
+#endif // HIPERF_PARALLEL_REPORT_AGGREGATOR_H
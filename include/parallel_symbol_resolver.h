@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HIPERF_PARALLEL_SYMBOL_RESOLVER_H
+#define HIPERF_PARALLEL_SYMBOL_RESOLVER_H
+
+#include <vector>
+
+#include "virtual_runtime.h"
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+// resolve the symbols of a batch of addresses by several threads.
+// the results are not returned, resolving marks the matched symbols in the symbols files
+// and fills the symbol cache shared by the threads.
+// user addresses are bucketed by the symbols file they are in, so one symbols file is only
+// searched by one thread, the buckets are balanced among the threads by their sizes.
+class ParallelSymbolResolver {
+public:
+    // --parallel-symbolic always used two threads, a small --cpu-limit does not go below it
+    static constexpr size_t MIN_THREAD_COUNT = 2;
+    static constexpr size_t MAX_THREAD_COUNT = 8;
+
+    struct Request {
+        pid_t pid = 0;
+        uint64_t ip = 0;
+        perf_callchain_context context = PERF_CONTEXT_USER;
+    };
+
+    ParallelSymbolResolver(VirtualRuntime &virtualRuntime, const size_t threadCount);
+    ~ParallelSymbolResolver() = default;
+
+    void Resolve(const std::vector<Request> &requests);
+
+    size_t GetThreadCount() const
+    {
+        return threadCount_;
+    }
+
+    // threads can be used for cpuPercent of all the online cpus, at least MIN_THREAD_COUNT
+    static size_t GetThreadCountByCpuPercent(const int cpuPercent);
+
+private:
+    using Bucket = std::vector<Request>;
+    void BuildBuckets(const std::vector<Request> &requests, std::vector<Bucket> &buckets, Bucket &unknown);
+    std::vector<std::vector<const Bucket *>> AssignBuckets(std::vector<Bucket> &buckets) const;
+    void ResolveBucket(const Bucket &bucket);
+
+    VirtualRuntime &virtualRuntime_;
+    const size_t threadCount_;
+};
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
+#endif // HIPERF_PARALLEL_SYMBOL_RESOLVER_H
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HIPERF_PARALLEL_UNWINDER_H
+#define HIPERF_PARALLEL_UNWINDER_H
+
+#include <memory>
+#include <vector>
+
+#include "perf_event_record.h"
+#include "virtual_runtime.h"
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+// unwind the user stacks of a batch of samples by several threads.
+// samples are sharded by the process they are unwound in, each worker has its own call stack,
+// so the unwind and expand caches of a process always stay in the same worker.
+class ParallelUnwinder {
+public:
+    static constexpr size_t MAX_THREAD_COUNT = 8;
+
+    ParallelUnwinder(VirtualRuntime &virtualRuntime, const size_t threadCount);
+    ~ParallelUnwinder() = default;
+
+    // the steps after unwinding, like the stack dedup, are done in the order of samples.
+    // the unwound samples are valid until the next Unwind()
+    void Unwind(const std::vector<PerfRecordSample *> &samples);
+
+    size_t GetThreadCount() const
+    {
+        return threadCount_;
+    }
+
+private:
+    VirtualRuntime &virtualRuntime_;
+    const size_t threadCount_;
+#if defined(is_ohos) && is_ohos
+    struct UnwindTask {
+        PerfRecordSample *sample = nullptr;
+        const VirtualThread *thread = nullptr;
+        // the frames and ips of PerfRecordSample are shared by all the samples,
+        // each task keeps its own, the ips are used by the sample until the next batch
+        std::vector<DfxFrame> callFrames;
+        std::vector<u64> ips;
+    };
+    void UnwindShard(const size_t index);
+
+    std::vector<std::unique_ptr<CallStack>> callStacks_;
+    std::vector<std::vector<UnwindTask>> shards_;
+#endif
+};
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
+#endif // HIPERF_PARALLEL_UNWINDER_H
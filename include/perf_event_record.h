@@ -74,10 +74,13 @@ static constexpr char PERF_RECORD_TYPE_SMO[] = "smoRecord";
 static constexpr char* PERF_RECORD_TYPE_NULL = nullptr;
 
 enum perf_event_hiperf_ext_type {
+    PERF_RECORD_HEADER_ATTR = 64,
     PERF_RECORD_AUXTRACE_INFO = 70,
     PERF_RECORD_AUXTRACE = 71,
     PERF_RECORD_CPU_MAP = 74,
     PERF_RECORD_TIME_CONV = 79,
+    PERF_RECORD_HEADER_FEATURE = 80,
+    PERF_RECORD_COMPRESSED = 81,
     PERF_RECORD_HIPERF_CALLSTACK = UINT32_MAX / 2,
     PERF_RECORD_TYPE_SMO_NUM = 82
 };
@@ -289,9 +292,10 @@ public:
     // extend
     // hold the new ips memory (after unwind)
     // used for data_.ips replace (ReplaceWithCallStack)
-    static std::vector<u64> ips_;
-    static std::vector<DfxFrame> callFrames_;
-    static std::vector<pid_t> serverPidMap_;
+    // they are shared by the samples handled in the same thread
+    static thread_local std::vector<u64> ips_;
+    static thread_local std::vector<DfxFrame> callFrames_;
+    static thread_local std::vector<pid_t> serverPidMap_;
 
     PerfRecordSample() = default;
     PerfRecordSample(const PerfRecordSample& sample);
@@ -314,6 +318,10 @@ public:
     void RecoverCallStack();
     // originalSize is use for expand callstack
     void ReplaceWithCallStack(const size_t originalSize = 0);
+    // same as above, but the call frames and the new ips are held by the caller,
+    // used when several samples are unwound at the same time
+    void ReplaceWithCallStack(const std::vector<DfxFrame> &callFrames, std::vector<u64> &ips,
+                              const size_t originalSize = 0);
     pid_t GetPid() const override;
     uint64_t GetTime() const;
     void Clean();
@@ -514,6 +522,8 @@ class PerfEventRecordFactory {
 public:
     static PerfEventRecord& GetPerfEventRecord(PerfRecordType type, uint8_t* data,
                                                const perf_event_attr& attr);
+    // a record owned by the caller, it is not cached like GetPerfEventRecord()
+    static std::unique_ptr<PerfEventRecord> MakePerfEventRecord(PerfRecordType type);
     static void Cleanup();
 private:
     static thread_local std::unordered_map<PerfRecordType, PerfEventRecord*> recordMap_;
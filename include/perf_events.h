@@ -24,6 +24,7 @@
 #include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <variant>
@@ -408,6 +409,15 @@ public:
     void SetSampleStackType(const SampleStackType type);
     void SetDwarfSampleStackSize(const uint32_t stackSize);
     void SetMmapPages(const size_t mmapPages);
+    // 0 means all mmaps are read by the record loop, otherwise cpus are split into groups
+    // and each group is read by its own thread
+    void SetMmapReaders(const size_t mmapReaders);
+    // records newer than (the newest record in mmaps - reorderWindowMs) are kept in mmap until
+    // next reading, so that records from different cpus are still in time order across wakeups.
+    // 0 means all the records are read at each wakeup
+    void SetReorderWindow(const uint64_t reorderWindowMs);
+    // resize the mmap of each cpu by its lost records and fill level, the total pages do not grow
+    void SetMmapAdaptive(const bool mmapAdaptive);
     std::vector<AttrWithId> GetAttrWithId() const;
 
     void SetInherit(const bool inherit)
@@ -463,9 +473,12 @@ public:
     using StatCallBack =
         std::function<void(const std::map<std::string, std::unique_ptr<PerfEvents::CountEvent>> &, FILE*)>;
     using RecordCallBack = std::function<bool(PerfEventRecord&)>;
+    using RecordTickCallBack = std::function<void()>;
 
     void SetStatCallBack(const StatCallBack reportCallBack);
     void SetRecordCallBack(const RecordCallBack recordCallBack);
+    // called about once a second by the thread of the record callback, even if no record comes
+    void SetRecordTickCallBack(const RecordTickCallBack recordTickCallBack);
     void SetStatReportFd(FILE* reportPtr);
     void GetLostSamples(size_t &lostSamples, size_t &lostNonSamples)
     {
@@ -540,6 +553,17 @@ public:
         int cpu = -1;
         void *auxBuf = nullptr;
         pid_t tid_ = -1;
+        // position of the next record to read, data_tail stays behind it while
+        // the records are still used in place by the consumer thread
+        uint64_t readPos = 0;
+        uint32_t refsInFlight = 0;
+        // data_head at the last reading, for the reorder window and the backtrack snapshot
+        uint64_t lastDataHead = 0;
+        bool hasNewData = false;
+        // for adaptive mmap size, reset at each check
+        size_t mmapPages = 0;
+        uint64_t lostInPeriod = 0;
+        size_t peakDataSize = 0;
     };
 
     bool isHM_ = false;
@@ -556,13 +580,12 @@ private:
     std::chrono::microseconds recordSleepTime_ = std::chrono::microseconds::zero();
     std::chrono::microseconds recordKernelReadTime_ = std::chrono::microseconds::zero();
 #endif
-    size_t lostSamples_ = 0;
-    size_t lostNonSamples_ = 0;
+    std::atomic_size_t lostSamples_ = 0;
+    std::atomic_size_t lostNonSamples_ = 0;
 
     std::unique_ptr<RingBuffer> recordBuf_ {nullptr};
-    bool recordBufReady_ = false;
-    std::mutex mtxRrecordBuf_;
-    std::condition_variable cvRecordBuf_;
+    // eventfd to wake up the consumer thread when a record buffer becomes non-empty
+    OHOS::UniqueFd recordBufEventFd_ {-1};
     std::thread readRecordBufThread_;
     std::atomic_bool readRecordThreadRunning_ = false;
     bool startedTracking_ = false;
@@ -574,16 +597,93 @@ private:
     void ReadRecordsFromSpeMmaps(MmapFd& mmapFd, const u64 auxOffset, u64 auxSize, const u32 pid, const u32 tid);
     void SpeReadData(void *dataPage, u64 *dataTail, uint8_t *buf, const u32 size);
     bool GetRecordFromMmap(MmapFd &mmap);
-    void GetRecords(bool &enableFlag);
+    uint64_t GetRecords(std::vector<MmapFd *> &recordHeap, RingBuffer &recordBuf, bool &enableFlag);
+    void MoveOneRecordToBuf(RingBuffer &recordBuf, MmapFd &mmap, bool &enableFlag);
+    bool IsReorderNeeded(const std::vector<MmapFd *> &recordHeap);
     void GetRecordFieldFromMmap(MmapFd &mmap, void *dest, size_t pos, size_t size);
-    void MoveRecordToBuf(MmapFd &mmap, bool &isAuxEvent, u64 &auxOffset, u64 &auxSize, u32 &pid, u32 &tid);
+    void MoveRecordToBuf(RingBuffer &recordBuf, MmapFd &mmap, bool &isAuxEvent, u64 &auxOffset, u64 &auxSize,
+                         u32 &pid, u32 &tid);
     size_t GetCallChainPosInSampleRecord(const perf_event_attr &attr);
     size_t GetSampleReadSizeInSampleRecord(MmapFd &mmap, size_t pos);
     size_t GetStackSizePosInSampleRecord(MmapFd &mmap);
-    bool CutStackAndMove(MmapFd &mmap);
+    bool GetCutStackSize(MmapFd &mmap, size_t &stackSizePos, uint64_t &stackSize, uint64_t &newStackSize);
+    bool CutStackAndMove(RingBuffer &recordBuf, MmapFd &mmap);
+    void ConsumeMmapRecord(MmapFd &mmap, const size_t size);
+
+    // zero copy: samples which do not wrap in mmap are passed to the consumer thread by reference,
+    // data_tail moves after the callback is done.
+    static constexpr uint32_t PERF_RECORD_MMAP_REF = 0xF0; // only used in record buffer
+    static constexpr uint64_t NO_STACK_CUT = std::numeric_limits<uint64_t>::max();
+    struct MmapRecordRef {
+        perf_event_header header;
+        MmapFd *mmap;
+        uint64_t pos;
+        uint64_t endPos;
+        uint64_t timestamp;
+        uint64_t newStackSize; // NO_STACK_CUT or the user stack size after cut
+    };
+    bool mmapZeroCopy_ = false;
+    bool MoveRecordRefToBuf(RingBuffer &recordBuf, MmapFd &mmap);
+    uint8_t *GetRecordFromRef(const uint8_t *data, MmapRecordRef &ref);
+    void ReleaseRecordRef(const MmapRecordRef &ref);
     inline void WaitDataFromRingBuffer();
-    inline bool ProcessRecord(const perf_event_attr* attr, uint8_t* data);
+    inline void NotifyRecordBufReady();
+    inline void CommitRecordBuf(RingBuffer &recordBuf);
+    bool CommitReadRecordBufs();
+    inline bool ProcessRecord(RingBuffer &recordBuf, const perf_event_attr* attr, uint8_t* data);
+    bool ReadRecordsFromBuffers(const perf_event_attr* attr);
     void ReadRecordFromBuf();
+
+    // for mmap reader threads
+    struct MmapReader {
+        size_t index = 0;
+        std::vector<int> cpus;
+        std::vector<MmapFd *> mmaps;
+        std::vector<MmapFd *> recordHeap;
+#if !is_mingw
+        std::vector<struct pollfd> pollFds;
+#endif
+        std::unique_ptr<RingBuffer> recordBuf {nullptr};
+        std::thread thread;
+        // no sample older than it will be committed to recordBuf
+        std::atomic<uint64_t> publishedTime = 0;
+    };
+    static constexpr size_t MIN_READER_BUFFER_SIZE = 2 * BUFFER_LOW_LEVEL;
+    static constexpr int READER_POLL_TIMEOUT_MS = 10;
+    uint64_t reorderWindowNs_ = 0;
+    std::atomic_bool flushMmaps_ = false; // ignore reorder window, read all the records in mmaps
+    size_t mmapReaderCount_ = 0;
+    std::vector<std::unique_ptr<MmapReader>> mmapReaders_;
+    std::atomic_bool mmapReadersRunning_ = false;
+    std::atomic<uint64_t> newestReaderTime_ = 0; // the newest sample time committed by all the readers
+    std::atomic_bool mergeBlocked_ = false; // records are waiting for a newer merge watermark
+    bool mmapAdaptive_ = false;
+    // pages of each cpu are between mmapPages_ / ADAPTIVE_MMAP_TIMES and mmapPages_ * ADAPTIVE_MMAP_TIMES
+    static constexpr size_t ADAPTIVE_MMAP_TIMES = 4;
+    static constexpr size_t HOT_MMAP_FILL_PERCENT = 75;
+    static constexpr size_t COLD_MMAP_FILL_DIVISOR = 8;
+    static constexpr int MAX_WAIT_REFS_MS = 10;
+    bool IsMmapAdaptive() const
+    {
+        return mmapAdaptive_ && mmapReaderCount_ == 0 && !backtrack_ && !isSpe_;
+    }
+    size_t GetAdaptiveMinPages() const;
+    std::map<int, size_t> PlanMmapPages() const;
+    std::map<int, OHOS::UniqueFd> resizedMmapFds_; // cpu -> the dummy event owning the resized mmap
+    void CountUnreadRecords(MmapFd &mmapItem);
+    bool ResizeCpuMmap(const int cpu, MmapFd &mmapItem, const size_t pages);
+    void AdaptMmapPages();
+    void CreateMmapReaders();
+    void StartMmapReaders();
+    void StopMmapReaders();
+    void MmapReaderLoop(MmapReader &reader);
+#if !is_mingw
+    void RemoveHungUpFds(MmapReader &reader);
+#endif
+    void ReadRecordsFromReaderMmaps(MmapReader &reader);
+    uint64_t GetMergeWatermark() const;
+    bool MergeRecordsFromReaders(const perf_event_attr* attr);
+    static uint64_t GetRecordTimeFromBuf(const uint8_t *data);
     void ReleaseCpuMmap();
     size_t CalcBufferSize();
     bool PrepareRecordThread();
@@ -699,6 +799,8 @@ private:
 
     StatCallBack reportCallBack_;
     RecordCallBack recordCallBack_;
+    RecordTickCallBack recordTickCallBack_;
+    std::atomic_bool recordTickPending_ = false;
 
     void LoadTracepointEventTypesFromSystem();
     bool PerfEventsEnable(const bool);
@@ -724,8 +826,22 @@ private:
     bool PrepareFdEvents();
     bool CreateFdEvents();
     int HandleCreateFdOpenError(const EventItem &eventItem, size_t icpu, size_t ipid) const;
+    // perf_event_open of a group on one cpu and pid, opened by the worker threads
+    struct OpenedFd {
+        OHOS::UniqueFd fd;
+        int err = 0;
+    };
+    static constexpr size_t MAX_OPEN_THREADS = 8;
+    static constexpr size_t MIN_OPENS_PER_THREAD = 16;
+    void OpenGroupFds(EventGroupItem &eventGroupItem, const size_t icpu, const size_t ipid,
+                      std::vector<OpenedFd> &openedFds);
+    void OpenFdsInParallel(EventGroupItem &eventGroupItem, std::vector<std::vector<OpenedFd>> &openedFds);
+    static constexpr size_t MIN_MMAPS_PER_THREAD = 2;
+    std::map<int, std::pair<int, void *>> premappedBufs_; // cpu -> owner fd, buffer mapped in parallel
+    void MapCpuBuffersInParallel(const std::vector<std::vector<OpenedFd>> &openedFds);
+    void ReleasePremappedBuffers();
     int CreateFdEventsForEachPid(EventItem &eventItem, const size_t icpu, const size_t ipid,
-                                 uint &fdNumber, int &groupFdCache);
+                                 OpenedFd &openedFd, uint &fdNumber, int &groupFdCache);
     bool StatReport(const __u64 &durationInSec);
     bool CreateMmap(const FdItem &item, const perf_event_attr &attr);
     bool CreateSpeMmap(const FdItem &item, const perf_event_attr &attr);
@@ -748,10 +864,19 @@ private:
 
     // for background track
     bool backtrack_ = false;
-    bool outputTracking_ = false;
+    std::atomic_bool outputTracking_ = false;
     uint64_t backtrackTime_ = 0;
     uint64_t outputEndTime_ = 0;
     bool IsSkipRecordForBacktrack(const PerfRecordSample& sample);
+    // backtrack with kernel overwrite mmaps, records are only copied out when output
+    bool IsOverwriteBacktrack() const
+    {
+        return backtrack_ && !isSpe_;
+    }
+    std::mutex mmapMutex_; // protect cpuMmap_ between the snapshot and the release
+    std::atomic_bool snapshotPending_ = false; // the consumer thread reads the mmaps before output
+    void CollectBackwardRecords(MmapFd &mmap, std::vector<uint64_t> &positions);
+    void ReadBacktrackSnapshot(const perf_event_attr *attr);
     void ProcessEventGroupItems(__u64 durationInSec);
     bool HandleTokensTracePoint(const std::vector<std::string>& eventTokens, std::string& name,
                                 bool& excludeUser, bool& excludeKernel, bool& isTracePoint);
@@ -807,6 +932,24 @@ public:
         return *this;
     }
 
+    PerfEventsBuilder &SetMmapReaders(size_t mmapReaders)
+    {
+        mmapReaders_ = mmapReaders;
+        return *this;
+    }
+
+    PerfEventsBuilder &SetReorderWindow(uint64_t reorderWindowMs)
+    {
+        reorderWindowMs_ = reorderWindowMs;
+        return *this;
+    }
+
+    PerfEventsBuilder &SetMmapAdaptive(bool mmapAdaptive)
+    {
+        mmapAdaptive_ = mmapAdaptive;
+        return *this;
+    }
+
     PerfEventsBuilder &SetSampleRaw(bool sampleRaw)
     {
         sampleRaw_ = sampleRaw;
@@ -883,6 +1026,9 @@ public:
         target_.SetTimeOut(timeOut_);
         target_.SetVerboseReport(verboseReport_);
         target_.SetMmapPages(mmapPages_);
+        target_.SetMmapReaders(mmapReaders_);
+        target_.SetReorderWindow(reorderWindowMs_);
+        target_.SetMmapAdaptive(mmapAdaptive_);
         target_.SetSampleRaw(sampleRaw_);
         if (hasClockId_) {
             target_.SetClockId(clockId_);
@@ -916,6 +1062,9 @@ private:
     float timeOut_ = 0.0f;
     bool verboseReport_ = false;
     size_t mmapPages_ = 0;
+    size_t mmapReaders_ = 0;
+    uint64_t reorderWindowMs_ = 0;
+    bool mmapAdaptive_ = false;
     bool sampleRaw_ = false;
     int clockId_ = -1;
     bool hasClockId_ = false;
@@ -15,6 +15,7 @@
 #ifndef HIPERF_PERF_FILE_FORMAT_H
 #define HIPERF_PERF_FILE_FORMAT_H
 
+#include <limits>
 #include <string>
 
 #include "perf_event_record.h"
@@ -62,8 +63,10 @@ enum class FEATURE {
     HIPERF_HM_DEVHOST,
     HIPERF_FILES_UNISTACK_TABLE,
     HIPERF_ADD_COUNTER,
-    // HIPERF_LAST_FEATURE = HIPERF_ADD_COUNTER,
-    HIPERF_LAST_FEATURE = HIPERF_ADD_COUNTER,
+    HIPERF_COMPRESSED_DATA, // An uint64_t with the uncompressed size of the data section.
+    HIPERF_RECORD_INDEX,    // Time and pid of the samples in each block of the data section.
+    // HIPERF_LAST_FEATURE = HIPERF_RECORD_INDEX,
+    HIPERF_LAST_FEATURE = HIPERF_RECORD_INDEX,
     FEATURE_MAX_BITS = 256,
 };
 
@@ -111,6 +114,19 @@ struct perf_file_header {
     uint8_t features[NUM_FEATURES_FILE_HEADER / BITS_IN_BYTE] = {0};
 };
 
+// a stream has no sections to seek, this header is followed by PERF_RECORD_HEADER_ATTR records,
+// the PERF_RECORD_HEADER_FEATURE records known before the data, then the data records,
+// and the PERF_RECORD_HEADER_FEATURE records added after the data at the end
+struct perf_pipe_file_header {
+    char magic[8] = {'P', 'E', 'R', 'F', 'I', 'L', 'E', '2'};
+    uint64_t size = sizeof(perf_pipe_file_header);
+};
+
+// output names of the streams besides the FIFO files
+constexpr char PIPE_OUTPUT_STDIO[] = "-";
+constexpr char PIPE_OUTPUT_FD_PREFIX[] = "fd:";
+constexpr char PIPE_OUTPUT_UNIX_PREFIX[] = "unix:";
+
 class PerfFileSection {
 public:
     struct perf_file_section header;
@@ -243,6 +259,40 @@ private:
     bool GetBinary(char *buf, const size_t size);
 };
 
+// a block of continuous records in the data section, the blocks cover the data section without gap
+struct RecordIndexEntry {
+    static constexpr uint32_t FLAG_SIDEBAND = 1; // has non-sample records
+    static constexpr uint32_t FLAG_SMO = 1 << 1; // has smo records
+    static constexpr uint32_t FLAG_ALL_PIDS = 1 << 2; // too many pids to list, any pid may be in it
+    static constexpr size_t MAX_PIDS = 32;
+
+    uint64_t offset = 0; // from the start of the data section
+    uint64_t size = 0;
+    // time range of the samples, minTime > maxTime if there is no sample
+    uint64_t minTime = std::numeric_limits<uint64_t>::max();
+    uint64_t maxTime = 0;
+    uint32_t flags = 0;
+    std::vector<pid_t> pids; // sorted pids of the samples
+
+    void AddSample(const uint64_t time, const pid_t pid);
+    // may have samples in [startTime, endTime] of pid, pid -1 means any pid
+    bool MatchSample(const uint64_t startTime, const uint64_t endTime, const pid_t pid) const;
+};
+
+class PerfFileSectionRecordIndex : public PerfFileSection {
+public:
+    std::vector<RecordIndexEntry> entries_;
+
+    PerfFileSectionRecordIndex(const FEATURE id, std::vector<RecordIndexEntry> entries)
+        : PerfFileSection(id), entries_(std::move(entries))
+    {
+    }
+    PerfFileSectionRecordIndex(const FEATURE id, const char *buf, const size_t size);
+
+    bool GetBinary(char *buf, const size_t size);
+    size_t GetSize();
+};
+
 struct AttrWithId;
 class PerfFileSectionEventDesc : public PerfFileSection {
 public:
@@ -17,16 +17,25 @@
 #define HIPERF_FILE_READER
 
 #include <functional>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
 #include "perf_event_record.h"
 #include "perf_file_format.h"
+#include "record_compressor.h"
 
 namespace OHOS {
 namespace Developtools {
 namespace HiPerf {
 using ProcessRecordCB = const std::function<bool(PerfEventRecord& record)>;
+// the data section is cut into chunks of this size for parallel decoding if it is not indexed
+constexpr const uint64_t DECODE_CHUNK_SIZE = 1024 * 1024;
+// decide the count of the decoding threads by the cpu count and the data section size
+constexpr const size_t AUTO_DECODE_THREADS = 0;
+constexpr const size_t MAX_DECODE_THREADS = 16;
+// each decoding thread takes at least this size, a smaller data section is read by the caller thread
+constexpr const uint64_t MIN_DECODE_SIZE_PER_THREAD = 4 * DECODE_CHUNK_SIZE;
 // read record from data file, like perf.data.
 // format of file follow
 // tools/perf/Documentation/perf.data-file-format.txt
@@ -34,6 +43,8 @@ class PerfFileReader {
 public:
     virtual ~PerfFileReader();
 
+    // fileName "-" reads a pipe from stdin, a pipe is written by PerfFileWriter to a stream.
+    // the features of a pipe are only got after ReadDataSection().
     static std::unique_ptr<PerfFileReader> Instance(const std::string &fileName);
 
     const perf_file_header &GetHeader() const;
@@ -42,6 +53,19 @@ public:
 
     // read data section, construct record, call callback for each record
     bool ReadDataSection(ProcessRecordCB &callback);
+    // decode the records by threadCount threads, each of them takes a chunk of the data section at a time.
+    // if ordered, callback is called by the caller thread in file order,
+    // otherwise it is called by the decoding threads concurrently and must be thread safe.
+    // the same as ReadDataSection() if the data section can not be mapped or only one thread is used.
+    bool ReadDataSectionParallel(ProcessRecordCB &callback, const size_t threadCount = AUTO_DECODE_THREADS,
+                                 const bool ordered = true);
+    size_t GetAutoDecodeThreads() const;
+    // only call callback for the samples in [startTime, endTime] of pid, pid -1 means all the pids.
+    // non-sample records are always passed, they are needed to resolve the samples.
+    // with HIPERF_RECORD_INDEX only the blocks which may have them are read.
+    // ReadFeatureSection() must be called first.
+    bool ReadDataSectionInRange(ProcessRecordCB &callback, const uint64_t startTime, const uint64_t endTime,
+                                const pid_t pid = -1);
 
     bool ReadFeatureSection();
     const std::vector<FEATURE> &GetFeatures() const;
@@ -68,10 +92,45 @@ protected:
 private:
     bool ReadRecord(ProcessRecordCB &callback);
     bool ReadRecordByAttr(ProcessRecordCB &callback, uint8_t *buf,
-                          uint64_t &remainingSize, size_t &recordNumber, const perf_event_attr *attr);
+                          uint64_t &remainingSize, size_t &recordNumber, const perf_event_attr *attr,
+                          const bool skipSample = false);
+    bool ReadIndexedRecord(ProcessRecordCB &callback, const std::vector<RecordIndexEntry> &entries,
+                           const uint64_t startTime, const uint64_t endTime, const pid_t pid);
+    bool SeekData(const uint64_t offset);
+    bool ReadPipeRecord(uint8_t *buf);
+    bool ReadPipeAttrs();
+    bool AddPipeAttr(const perf_event_header &header);
+    bool AddPipeFeature(const perf_event_header &header);
+    void AddPipeFeatureSections();
+    bool ReadPipeData(ProcessRecordCB &callback);
+    void AddFeatureSection(const FEATURE feature, std::vector<char> &buf);
+    // records of a chunk decoded by ReadDataSectionParallel(), they are reused for the following chunks
+    struct DecodeSlot {
+        std::vector<std::unique_ptr<PerfEventRecord>> records;
+        size_t count = 0;
+        size_t chunk = 0;
+        bool ready = false;
+        bool failed = false;
+    };
+    using MappedRecordCB = std::function<bool(uint8_t *data, const perf_event_header &header)>;
+    bool SplitDataSection(std::vector<RecordIndexEntry> &chunks) const;
+    bool GetMappedRecordSize(const uint64_t pos, const uint64_t end, uint64_t &size) const;
+    bool ForEachMappedRecord(const RecordIndexEntry &chunk, const MappedRecordCB &func) const;
+    bool DecodeChunk(const RecordIndexEntry &chunk, const perf_event_attr &attr, DecodeSlot &slot) const;
+    bool ReadChunksOrdered(ProcessRecordCB &callback, const std::vector<RecordIndexEntry> &chunks,
+                           const size_t threadCount);
+    bool ReadChunksUnordered(ProcessRecordCB &callback, const std::vector<RecordIndexEntry> &chunks,
+                             const size_t threadCount);
     bool SMOReadRecordByAttr(ProcessRecordCB &callback, uint8_t *buf,
         uint64_t &remainingSize, size_t &recordNumber, const perf_event_attr *attr);
     bool ValidateSMOReadRecord(uint8_t *buf, perf_event_header *header, uint64_t &remainingSize);
+    // read the data section to buf, decompress it if the records are compressed.
+    // return the address of the data, it is in the mapped pages if the data section is mapped
+    uint8_t *ReadData(uint8_t *buf, const size_t len);
+    bool MapDataSection();
+    void UnmapDataSection();
+    bool IsDataCompressed() const;
+    bool IsDataEnd();
     bool IsValidDataFile();
     bool IsGzipFile();
 
@@ -94,11 +153,24 @@ private:
     uint64_t featureSectionOffset_ = 0;
     std::vector<FEATURE> features_;
     std::vector<std::unique_ptr<PerfFileSection>> perfFileSections_;
+    std::unique_ptr<RecordDecompressor> decompressor_;
+    void *mapAddr_ = nullptr;
+    size_t mapLength_ = 0;
+    uint8_t *mappedData_ = nullptr; // start of the data section in the mapped pages
+    uint64_t mappedPos_ = 0;
+
+    // for the records read from a pipe
+    bool isPipe_ = false;
+    bool pipeEnd_ = false;
+    bool pipeRecordPending_ = false; // pipeRecord_ is read but not processed
+    std::vector<uint8_t> pipeRecord_;
+    std::vector<std::pair<FEATURE, std::vector<char>>> pipeFeatures_;
 
     size_t fileSize_ = 0;
 #ifdef HIPERF_DEBUG_TIME
     std::chrono::microseconds readRecordTime_ = std::chrono::microseconds::zero();
     std::chrono::microseconds readCallbackTime_ = std::chrono::microseconds::zero();
+    void PrintReadTimes() const;
 #endif
 };
 } // namespace HiPerf
@@ -19,8 +19,10 @@
 #include <unordered_map>
 #include <vector>
 
+#include "async_file_writer.h"
 #include "perf_event_record.h"
 #include "perf_file_format.h"
+#include "record_compressor.h"
 #include "symbols_file.h"
 #include "virtual_runtime.h"
 
@@ -28,6 +30,8 @@ namespace OHOS {
 namespace Developtools {
 namespace HiPerf {
 constexpr const int WRITER_BUFFER_SIZE = 4 * 1024 * 1024;
+// records are indexed in blocks of this size for HIPERF_RECORD_INDEX
+constexpr const uint64_t RECORD_INDEX_BLOCK_SIZE = 512 * 1024;
 
 // write record to data file, like perf.data.
 // format of file follow
@@ -43,7 +47,20 @@ public:
     }
     ~PerfFileWriter();
 
-    bool Open(const std::string &fileName, const bool compressData = false);
+    // the data section is compressed on the fly if compressData is true.
+    // if IsStreamOutput(fileName), the records are streamed with the attrs and features inline,
+    // they can be consumed before Close(), but can not be read back or compressed.
+    bool Open(const std::string &fileName, const bool compressData = false,
+              const int compressLevel = DEFAULT_COMPRESS_LEVEL);
+    // "-" for stdout, "fd:<fd>", "unix:<socket path>" or a FIFO file
+    static bool IsStreamOutput(const std::string &fileName);
+    bool IsStream() const
+    {
+        return isStream_;
+    }
+    // write the data section by a flush thread, must be called before WriteAttrAndId()
+    // the aligned part is written with O_DIRECT if directIo is true
+    void SetAsyncWrite(const bool asyncWrite, const bool directIo = false);
     // WriteAttrAndId() must be called before WriteRecord()
     bool WriteAttrAndId(const std::vector<AttrWithId> &attrIds, const bool isSpe = false);
     bool WriteRecord(const PerfEventRecord &record);
@@ -54,11 +71,15 @@ public:
     bool AddBoolFeature(const FEATURE feature);
     bool AddSymbolsFeature(const std::vector<std::unique_ptr<SymbolsFile>> &);
     bool AddUniStackTableFeature(const ProcessStackMap *table);
+    // rename the opened file, the records can still be written to it
+    bool Rename(const std::string &fileName);
     // close file
     bool Close();
 
+    // size of the uncompressed records
     uint64_t GetDataSize() const;
     uint GetRecordCount() const;
+    AsyncFileWriter::Stat GetWriteStat() const;
     std::chrono::microseconds writeTimes_ = std::chrono::microseconds::zero();
 
     using ProcessRecordCB = const std::function<bool(PerfEventRecord& record)>;
@@ -70,10 +91,26 @@ public:
 private:
     std::string fileBuffer_;
 
+    bool OpenStream(const std::string &fileName);
+    bool OpenCommon(const std::string &fileName, bool compressData, const int compressLevel);
     bool GetFilePos(uint64_t &pos) const;
     bool Write(const void *buf, size_t len);
+    // write to the data section, through the compressor if compressData_ is true
+    bool WriteData(const void *buf, size_t len);
+    // write the (compressed) data to file, through the flush thread if asyncWrite_ is true
+    bool WriteDataToFile(const void *buf, size_t len);
+    bool StartAsyncWrite(const uint64_t offset);
+    void CloseDirectFd();
+    bool ReadData(void *buf, size_t len);
+    // no more records can be compressed after this
+    bool FinishData();
+    void IndexRecord(const PerfEventRecord &record, const uint64_t offset);
+    void FinishIndexBlock();
+    bool AddRecordIndexFeature();
     bool WriteHeader();
     bool WriteFeatureData();
+    bool WriteStreamAttrs(const std::vector<AttrWithId> &attrIds);
+    bool WriteStreamFeatures();
     bool WriteTimeConvEvent();
     bool WriteAuxTraceInfoEvent();
     bool WriteCpuMapEvent();
@@ -81,6 +118,9 @@ private:
 
     std::string fileName_;
     FILE *fp_ = nullptr;
+    bool isStream_ = false;
+    // the features written to the stream, the ones added later follow the records
+    size_t streamFeatureCount_ = 0;
 
     perf_file_header header_;
     perf_file_section attrSection_;
@@ -89,8 +129,20 @@ private:
 
     perf_event_attr defaultEventAttr_;
 
+    std::vector<u8> recordBuf_ = {};
     uint recordCount_ = 0;
+    uint64_t rawDataSize_ = 0;
     bool compressData_ = false;
+    int compressLevel_ = DEFAULT_COMPRESS_LEVEL;
+    bool dataFinished_ = false;
+    std::unique_ptr<RecordCompressor> compressor_;
+    std::unique_ptr<RecordDecompressor> decompressor_;
+    bool asyncWrite_ = false;
+    bool directIo_ = false;
+    int directFd_ = -1;
+    std::unique_ptr<AsyncFileWriter> asyncWriter_;
+    std::vector<RecordIndexEntry> recordIndex_;
+    RecordIndexEntry indexBlock_; // the block being written
     bool isWritingRecord = false;
 };
 } // namespace HiPerf
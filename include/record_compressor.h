@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HIPERF_RECORD_COMPRESSOR_H
+#define HIPERF_RECORD_COMPRESSOR_H
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+constexpr const int DEFAULT_COMPRESS_LEVEL = 6;
+constexpr const int MIN_COMPRESS_LEVEL = 1;
+constexpr const int MAX_COMPRESS_LEVEL = 9;
+
+// compress the data section of perf.data into PERF_RECORD_COMPRESSED records.
+// the caller appends raw records, a background thread deflates them and
+// writes the compressed records out by the write callback.
+class RecordCompressor {
+public:
+    using WriteFunc = std::function<bool(const void *buf, size_t len)>;
+    // raw data is swapped to the compress thread every BUFFER_SIZE bytes
+    static constexpr size_t BUFFER_SIZE = 1024 * 1024;
+
+    RecordCompressor(WriteFunc write, const int level = DEFAULT_COMPRESS_LEVEL);
+    ~RecordCompressor();
+
+    bool Start();
+    // append raw data, only called by one thread
+    bool Write(const void *buf, size_t len);
+    // compress all the pending data, end the stream and stop the thread
+    bool Finish();
+
+    // size of the compressed records that have been written
+    uint64_t GetCompressedSize() const
+    {
+        return compressedSize_;
+    }
+
+private:
+    void CompressLoop();
+    bool Deflate(const std::vector<uint8_t> &data, const int flush);
+    bool WriteCompressedRecord(const uint8_t *buf, size_t len);
+    bool SubmitBuffer(const bool finish);
+
+    WriteFunc write_;
+    const int level_;
+    z_stream stream_ {};
+    bool streamInited_ = false;
+
+    // filled by the caller
+    std::vector<uint8_t> writeBuf_;
+    // compressed by the thread
+    std::vector<uint8_t> compressBuf_;
+    std::vector<uint8_t> outBuf_;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool pending_ = false;
+    bool finish_ = false;
+    bool failed_ = false;
+    uint64_t compressedSize_ = 0;
+};
+
+// read the uncompressed data section from PERF_RECORD_COMPRESSED records.
+// compressed records are fetched by the read callback only when needed.
+class RecordDecompressor {
+public:
+    using ReadFunc = std::function<bool(void *buf, size_t len)>;
+
+    // compressedSize is the size of the data section in file
+    RecordDecompressor(ReadFunc read, const uint64_t compressedSize);
+    ~RecordDecompressor();
+
+    // read len bytes of uncompressed data
+    bool Read(void *buf, size_t len);
+    // return true if all the uncompressed data has been read
+    bool IsEnd();
+
+private:
+    bool Inflate();
+    bool ReadCompressedRecord();
+
+    ReadFunc read_;
+    uint64_t remainingSize_ = 0;
+    z_stream stream_ {};
+    bool streamInited_ = false;
+    bool streamEnd_ = false;
+
+    std::vector<uint8_t> inBuf_;
+    std::vector<uint8_t> outBuf_;
+    size_t outPos_ = 0;
+};
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
+#endif // HIPERF_RECORD_COMPRESSOR_H
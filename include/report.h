@@ -17,12 +17,15 @@
 #define REPORT_H
 
 #include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
 #include <functional>
 #include <map>
+#include <unordered_map>
 
 #include "debug_logger.h"
+#include "report_call_tree.h"
 // remove me latter
 #include "report_json_file.h"
 #include "utilities.h"
@@ -123,8 +126,10 @@ public:
     std::vector<uint64_t> counts_ = {};
     std::vector<uint64_t> accCounts_ = {};
     std::vector<ReportItemCallFrame> callStacks_;
+    // callstacks are merged in Report::callTree_ and exported to callStacks_ after adjusted
+    uint32_t callTreeRoot_ = ReportCallTree::INVALID_ID;
     float heat = 0.0f;
-    static unsigned long long allIndex_; // debug only
+    static std::atomic<unsigned long long> allIndex_; // debug only
     unsigned long long index_ = 0;
 
     // only for ut test
@@ -142,11 +147,11 @@ public:
         index_ = allIndex_++;
     }
 
-    ReportItem(pid_t pid, pid_t tid, std::string &comm, const std::string_view &dso,
+    ReportItem(pid_t pid, pid_t tid, const std::string_view &comm, const std::string_view &dso,
                const std::string_view &func, uint64_t vaddr, uint64_t eventCount)
         : pid_(pid),
           tid_(tid),
-          comm_(comm),
+          comm_(StringViewHold::Get().Hold(comm)),
           dso_(StringViewHold::Get().Hold(dso)),
           func_(StringViewHold::Get().Hold(func)),
           vaddr_(vaddr),
@@ -379,6 +384,10 @@ public:
     bool MultiLevelSame(const ReportItem &a, const ReportItem &b);
     void AdjustReportItems();
     void AddReportItem(const PerfRecordSample &sample, const bool includeCallStack);
+    // comm is the thread name of sample, it must be kept until the report is output
+    void AddReportItem(const PerfRecordSample &sample, const bool includeCallStack, const std::string_view &comm);
+    // move the items of other into this report, other must have the same configs
+    void MergeReport(Report &other);
     void AddReportItemBranch(const PerfRecordSample &sample);
     void OutputStd(FILE *output);
     void OutputStdDiff(FILE *output, Report &other);
@@ -478,6 +487,8 @@ public:
         uint64_t sampleCount_ = 0;
         uint64_t eventCount_ = 0;
         std::vector<ReportItem> reportItems_;
+        // hash of the sort keys -> index in reportItems_, items are aggregated when added
+        std::unordered_multimap<size_t, size_t> reportItemIndexes_;
         uint32_t type_ = 0;
         uint64_t config_ = 0;
         std::vector<uint64_t> ids_;
@@ -540,6 +551,20 @@ private:
     virtual int MultiLevelCompare(const ReportItem &a, const ReportItem &b);
     std::string GetAdltExtendMapName(const std::string &mapName, const std::string &originSoName);
 
+    // aggregate the items of same sort keys when they are added
+    using ReportKeyHashFunction = size_t(const ReportItem &);
+    std::vector<std::string> aggregateKeys_;
+    std::vector<ReportKeyHashFunction *> aggregateHashFunctions_;
+    // some items are not in the indexes, such as the ones added before the sort keys changed or before adjusted
+    bool itemsNotIndexed_ = false;
+    bool UpdateAggregateKeys();
+    bool IsAggregated() const;
+    size_t HashReportItem(const ReportItem &item) const;
+    ReportItem &InsertReportItem(ReportEventConfigItem &config, ReportItem &item);
+
+    ReportCallTree callTree_;
+    void ExportCallFrames(const uint32_t parent, std::vector<ReportItemCallFrame> &callFrames);
+
     void StatisticsRecords();
     void FilterDisplayRecords();
     void UpdateReportItemsAfterAdjust();
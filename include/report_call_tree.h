@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HIPERF_REPORT_CALL_TREE_H
+#define HIPERF_REPORT_CALL_TREE_H
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+// call trees of all the report items, the nodes are kept in one pool and linked by index.
+// frames are interned to ids, and a child is found by the hash of (parent, frame id),
+// so adding a callstack costs O(depth) no matter how many siblings a node has.
+class ReportCallTree {
+public:
+    static constexpr uint32_t INVALID_ID = UINT32_MAX;
+
+    struct Frame {
+        std::string_view func;
+        uint64_t vaddr = 0;
+        std::string_view dso;
+    };
+
+    struct Node {
+        uint32_t frameId = INVALID_ID; // INVALID_ID for root
+        uint32_t firstChild = INVALID_ID;
+        uint32_t nextSibling = INVALID_ID;
+        uint64_t eventCount = 0;
+        uint64_t selfEventCount = 0;
+    };
+
+    ReportCallTree() = default;
+    ~ReportCallTree() = default;
+
+    // a root has no frame, its children are the outermost callers
+    uint32_t NewRoot();
+    // same func, vaddr and dso get the same id
+    uint32_t GetFrameId(const std::string_view &func, const uint64_t vaddr, const std::string_view &dso);
+    // add the counts to the child of parent with the frame, the child is created if not found
+    uint32_t AddChild(const uint32_t parent, const uint32_t frameId, const uint64_t eventCount,
+                      const uint64_t selfEventCount);
+    // add all the descendants of from to to
+    void Merge(const uint32_t to, const uint32_t from);
+    // add all the descendants of from in other tree to to.
+    // frameMap maps the frame ids of other to this tree, it is filled on demand and
+    // can be reused by all the merges from the same other tree
+    void Merge(const uint32_t to, const ReportCallTree &other, const uint32_t from,
+               std::vector<uint32_t> &frameMap);
+
+    const Node &GetNode(const uint32_t id) const
+    {
+        return nodes_[id];
+    }
+    const Frame &GetFrame(const uint32_t id) const
+    {
+        return frames_[id];
+    }
+    size_t GetNodeCount() const
+    {
+        return nodes_.size();
+    }
+    size_t GetFrameCount() const
+    {
+        return frames_.size();
+    }
+    void Clear();
+
+private:
+    struct FrameHash {
+        size_t operator()(const Frame &frame) const;
+    };
+    struct FrameEqual {
+        bool operator()(const Frame &a, const Frame &b) const
+        {
+            return a.vaddr == b.vaddr && a.func == b.func && a.dso == b.dso;
+        }
+    };
+
+    static constexpr uint32_t PARENT_SHIFT = 32;
+    static uint64_t GetChildKey(const uint32_t parent, const uint32_t frameId)
+    {
+        return (static_cast<uint64_t>(parent) << PARENT_SHIFT) | frameId;
+    }
+
+    std::vector<Node> nodes_;
+    std::vector<Frame> frames_;
+    std::unordered_map<Frame, uint32_t, FrameHash, FrameEqual> frameIds_;
+    // (parent, frame id) -> child
+    std::unordered_map<uint64_t, uint32_t> childIds_;
+};
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
+#endif // HIPERF_REPORT_CALL_TREE_H
@@ -21,8 +21,11 @@
 #include <cstdlib>
 #include <functional>
 #include <map>
+#include <string_view>
+#include <unordered_map>
 
 #include "debug_logger.h"
+#include "json_writer.h"
 #include "perf_file_reader.h"
 #include "utilities.h"
 #include "virtual_runtime.h"
@@ -35,50 +38,46 @@ using jsonStringVector = std::vector<std::string>;
 using jsonIntVector = std::vector<int>;
 
 template<class T>
-void OutputJsonKey(FILE *output, const T &value)
+constexpr bool IsJsonCString()
 {
-    if constexpr (std::is_same<T, std::string>::value) {
-        if (value.empty()) {
-            // for key vector [] mode, not key is needed
-            return;
-        }
-        fprintf(output, "\"%s\":", value.c_str());
-    } else if constexpr (std::is_same<T, std::string_view>::value) {
+    using Type = typename std::decay<T>::type;
+    return std::is_same<Type, char *>::value || std::is_same<Type, const char *>::value;
+}
+
+template<class T>
+void OutputJsonKey(JsonWriter &output, const T &value)
+{
+    if constexpr (std::is_same<T, std::string>::value || std::is_same<T, std::string_view>::value) {
         if (value.empty()) {
             // for key vector [] mode, not key is needed
             return;
         }
-        fprintf(output, "\"%s\":", value.data());
-    } else if constexpr (std::is_same<typename std::decay<T>::type, char *>::value) {
+        output.WriteString(value);
+    } else if constexpr (IsJsonCString<T>()) {
         if (value[0] == '\0') {
             // same as value.empty()
             return;
         }
-        fprintf(output, "\"%s\":", value);
+        output.WriteString(value);
     } else {
-        fprintf(output, "\"%s\":", std::to_string(value).c_str());
+        output.Write('"');
+        output.WriteNumber(value);
+        output.Write('"');
     }
+    output.Write(':');
 }
+
 template<class T>
-void OutputJsonValue(FILE *output, const T &value, const bool first = true)
+void OutputJsonValue(JsonWriter &output, const T &value, const bool first = true)
 {
     if (!first) {
-        fprintf(output, ",");
+        output.Write(',');
     }
-    if constexpr (std::is_same<T, std::string>::value) {
-        fprintf(output, "\"%s\"", value.c_str());
-    } else if constexpr (std::is_same<T, std::string_view>::value) {
-        fprintf(output, "\"%s\"", value.data());
-    } else if constexpr (std::is_same<T, int>::value) {
-        fprintf(output, "%s", std::to_string(value).c_str());
-    } else if constexpr (std::is_same<T, uint64_t>::value) {
-        fprintf(output, "%s", std::to_string(value).c_str());
-    } else if constexpr (std::is_same<T, bool>::value) {
-        fprintf(output, "%s", std::to_string(value).c_str());
-    } else if constexpr (std::is_same<T, size_t>::value) {
-        fprintf(output, "%s", std::to_string(value).c_str());
-    } else if constexpr (std::is_same<typename std::decay<T>::type, char *>::value) {
-        fprintf(output, "\"%s\"", value);
+    if constexpr (std::is_same<T, std::string>::value || std::is_same<T, std::string_view>::value ||
+                  IsJsonCString<T>()) {
+        output.WriteString(value);
+    } else if constexpr (std::is_integral<T>::value) {
+        output.WriteNumber(value);
     } else {
         value.OutputJson(output);
     }
@@ -89,12 +88,10 @@ void OutputJsonValue(FILE *output, const T &value, const bool first = true)
     k:1
 */
 template<class K, class T>
-void OutputJsonPair(FILE *output, const K &key, const T &value, const bool first = false)
+void OutputJsonPair(JsonWriter &output, const K &key, const T &value, const bool first = false)
 {
     if (!first) {
-        if (fprintf(output, ",") < 0) {
-            return;
-        }
+        output.Write(',');
     }
     // for id, symbol
     OutputJsonKey(output, key);
@@ -106,72 +103,54 @@ void OutputJsonPair(FILE *output, const K &key, const T &value, const bool first
     k:[v1,v2,v3]
 */
 template<class T>
-void OutputJsonVectorList(FILE *output, const std::string &key, const std::vector<T> &value,
+void OutputJsonVectorList(JsonWriter &output, const std::string &key, const std::vector<T> &value,
                           const bool first = false)
 {
     if (!first) {
-        if (fprintf(output, ",") < 0) {
-            return;
-        }
+        output.Write(',');
     }
-    if (fprintf(output, "\"%s\":[", key.c_str()) != -1) {
-        auto it = value.begin();
-        while (it != value.end()) {
-            OutputJsonValue(output, *it, it == value.begin());
-            it++;
-        }
-        if (fprintf(output, "]") < 0) {
-            return;
-        }
+    output.WriteString(key);
+    output.Write(":[");
+    for (auto it = value.begin(); it != value.end(); it++) {
+        OutputJsonValue(output, *it, it == value.begin());
     }
+    output.Write(']');
 }
 
 /*
     k:[v1,v2,v3]
 */
 template<class K, class V>
-void OutputJsonMapList(FILE *output, const std::string &key, const std::map<K, V> &value,
+void OutputJsonMapList(JsonWriter &output, const std::string &key, const std::map<K, V> &value,
                        const bool first = false)
 {
     if (!first) {
-        if (fprintf(output, ",") < 0) {
-            return;
-        }
+        output.Write(',');
     }
-    if (fprintf(output, "\"%s\":[", key.c_str()) != -1) {
-        auto it = value.begin();
-        while (it != value.end()) {
-            OutputJsonValue(output, it->second, it == value.begin());
-            it++;
-        }
-        if (fprintf(output, "]") < 0) {
-            return;
-        }
+    output.WriteString(key);
+    output.Write(":[");
+    for (auto it = value.begin(); it != value.end(); it++) {
+        OutputJsonValue(output, it->second, it == value.begin());
     }
+    output.Write(']');
 }
 
 /*
     k:{k1:v1,k2:v2,k3:v3}
 */
 template<class K, class V>
-void OutputJsonMap(FILE *output, const std::string &key, const std::map<K, V> &value,
+void OutputJsonMap(JsonWriter &output, const std::string &key, const std::map<K, V> &value,
                    const bool first = false)
 {
     if (!first) {
-        if (fprintf(output, ",") < 0) {
-            return;
-        }
+        output.Write(',');
     }
-    if (fprintf(output, "\"%s\":{", key.c_str()) != -1) {
-        auto it = value.begin();
-        while (it != value.end()) {
-            OutputJsonPair(output, it->first, it->second, it == value.begin());
-            it++;
-        }
-        if (fprintf(output, "}") < 0) {
-            return;
-        }
+    output.WriteString(key);
+    output.Write(":{");
+    for (auto it = value.begin(); it != value.end(); it++) {
+        OutputJsonPair(output, it->first, it->second, it == value.begin());
     }
+    output.Write('}');
 }
 
 template<class K, class V>
@@ -188,17 +167,12 @@ struct ReportFuncMapItem {
     std::string funcName_;
     int reportFuncId_ = -1;
     bool hiddenFlag = false;
-    void OutputJson(FILE *output) const
+    void OutputJson(JsonWriter &output) const
     {
-        if (fprintf(output, "{") < 0) {
-            return;
-        }
+        output.Write('{');
         OutputJsonPair(output, "file", libId_, true);
-        std::string funcName = StringReplace(funcName_, "\"", "");
-        OutputJsonPair(output, "symbol", funcName);
-        if (fprintf(output, "}") < 0) {
-            return;
-        }
+        OutputJsonPair(output, "symbol", funcName_);
+        output.Write('}');
     }
     ReportFuncMapItem(int libId, std::string &funcName, int reportFuncId)
         : libId_(libId), funcName_(funcName), reportFuncId_(reportFuncId) {}
@@ -211,17 +185,18 @@ struct ReportFuncItem {
     uint64_t eventCount_ = 0;
     uint64_t subTreeEventCount_ = 0;
     explicit ReportFuncItem(int functionId) : functionId_(functionId) {}
-    void OutputJson(FILE *output) const
+    void OutputJson(JsonWriter &output) const
     {
-        if (fprintf(output, "{") < 0) {
-            return;
-        }
+        output.Write('{');
         OutputJsonPair(output, "symbol", functionId_, true);
-        OutputJsonVectorList(output, "counts",
-                             std::vector<uint64_t> {sampleCount_, eventCount_, subTreeEventCount_});
-        if (fprintf(output, "}") < 0) {
-            return;
-        }
+        output.Write(",\"counts\":[");
+        output.WriteNumber(sampleCount_);
+        output.Write(',');
+        output.WriteNumber(eventCount_);
+        output.Write(',');
+        output.WriteNumber(subTreeEventCount_);
+        output.Write(']');
+        output.Write('}');
     }
 };
 
@@ -235,11 +210,12 @@ struct ReportCallNodeItem {
     std::string debug_ = "";
     std::map<int, ReportCallNodeItem> childrenMap;
 
-    void OutputJson(FILE *output) const
+    // the call tree may be very deep, it is output by a stack instead of recursion
+    void OutputJson(JsonWriter &output) const;
+    // all the fields before the children
+    void OutputJsonHead(JsonWriter &output) const
     {
-        if (fprintf(output, "{") < 0) {
-            return;
-        }
+        output.Write('{');
         OutputJsonPair(output, "selfEvents", selfEventCount_, true);
         OutputJsonPair(output, "subEvents", subTreeEventCount_);
         OutputJsonPair(output, "symbol", functionId_);
@@ -248,10 +224,7 @@ struct ReportCallNodeItem {
             OutputJsonPair(output, "nodeIndex", nodeIndex_);
             OutputJsonPair(output, "reversed", reverseCaller_);
         }
-        OutputJsonMapList(output, "callStack", childrenMap);
-        if (fprintf(output, "}") < 0) {
-            return;
-        }
+        output.Write(",\"callStack\":[");
     }
 
     uint64_t UpdateChildrenEventCount()
@@ -277,17 +250,13 @@ struct ReportLibItem {
     int libId_ = 0;
     uint64_t eventCount_ = 0;
     std::map<int, ReportFuncItem> funcs_;
-    void OutputJson(FILE *output) const
+    void OutputJson(JsonWriter &output) const
     {
-        if (fprintf(output, "{") < 0) {
-            return;
-        }
+        output.Write('{');
         OutputJsonPair(output, "fileId", libId_, true);
         OutputJsonPair(output, "eventCount", eventCount_);
         OutputJsonMapList(output, "functions", funcs_);
-        if (fprintf(output, "}") < 0) {
-            return;
-        }
+        output.Write('}');
     }
 };
 
@@ -298,20 +267,16 @@ struct ReportThreadItem {
     std::map<int, ReportLibItem> libs_;
     ReportCallNodeItem callNode;
     ReportCallNodeItem callNodeReverse;
-    void OutputJson(FILE *output) const
+    void OutputJson(JsonWriter &output) const
     {
-        if (fprintf(output, "{") < 0) {
-            return;
-        }
+        output.Write('{');
         OutputJsonPair(output, "tid", tid_, true);
         OutputJsonPair(output, "eventCount", eventCount_);
         OutputJsonPair(output, "sampleCount", sampleCount_);
         OutputJsonMapList(output, "libs", libs_);
         OutputJsonPair(output, "CallOrder", callNode);
         OutputJsonPair(output, "CalledOrder", callNodeReverse);
-        if (fprintf(output, "}") < 0) {
-            return;
-        }
+        output.Write('}');
     }
     ReportThreadItem(pid_t id) : tid_(id), callNode(-1), callNodeReverse(-1) {}
 };
@@ -320,17 +285,13 @@ struct ReportProcessItem {
     pid_t pid_ = 0;
     uint64_t eventCount_ = 0;
     std::map<pid_t, ReportThreadItem> threads_;
-    void OutputJson(FILE *output) const
+    void OutputJson(JsonWriter &output) const
     {
-        if (fprintf(output, "{") < 0) {
-            return;
-        }
+        output.Write('{');
         OutputJsonPair(output, "pid", pid_, true);
         OutputJsonPair(output, "eventCount", eventCount_);
         OutputJsonMapList(output, "threads", threads_);
-        if (fprintf(output, "}") < 0) {
-            return;
-        }
+        output.Write('}');
     }
     explicit ReportProcessItem(pid_t pid) : pid_(pid) {}
 };
@@ -340,17 +301,13 @@ struct ReportConfigItem {
     std::string eventName_;
     uint64_t eventCount_ = 0;
     std::map<pid_t, ReportProcessItem> processes_;
-    void OutputJson(FILE *output) const
+    void OutputJson(JsonWriter &output) const
     {
-        if (fprintf(output, "{") < 0) {
-            return;
-        }
+        output.Write('{');
         OutputJsonPair(output, "eventConfigName", eventName_, true);
         OutputJsonPair(output, "eventCount", eventCount_);
         OutputJsonMapList(output, "processes", processes_);
-        if (fprintf(output, "}") < 0) {
-            return;
-        }
+        output.Write('}');
     }
     ReportConfigItem(int index, std::string eventName) : index_(index), eventName_(eventName) {}
 };
@@ -362,7 +319,6 @@ class ReportJsonFile {
 public:
     int nodeIndex_ = 0; // debug only
     static bool debug_;
-    FILE *output_ = nullptr;
     ReportJsonFile(const std::unique_ptr<PerfFileReader> &recordFileReader,
                    const VirtualRuntime &virtualRuntime)
         : recordFileReader_(recordFileReader), virtualRuntime_(virtualRuntime)
@@ -385,10 +341,18 @@ private:
     const std::unique_ptr<PerfFileReader> &recordFileReader_;
     const VirtualRuntime &virtualRuntime_;
     std::vector<std::string_view> libList_;
+    // path -> index in libList_, the paths appended to libList_ are indexed when looked up
+    std::unordered_map<std::string_view, int> libIds_;
+    // symbols file index -> the lib id of its path, indexed with libIds_
+    std::vector<int> libIdsBySymbolsFile_;
+    size_t indexedLibCount_ = 0;
     int functionId_ = 0;
-    std::map<int, std::map<std::string, ReportFuncMapItem>> functionMap_;
+    // lib id -> function name -> function
+    std::unordered_map<int, std::unordered_map<std::string, ReportFuncMapItem>> functionMap_;
+    // function id -> function, to output them in the order of id
+    std::vector<const ReportFuncMapItem *> functionList_;
     void AddNewFunction(const int libId, std::string name);
-    void OutputJsonFunctionMap(FILE *output);
+    void OutputJsonFunctionMap(JsonWriter &output);
 
     ReportConfigItem &GetConfig(const uint64_t id);
     std::string GetConfigName(const uint64_t id);
@@ -396,10 +360,15 @@ private:
 
     int GetFunctionID(const int libId, const std::string &function);
     void HiddenFunctionInLib(const int libId, const std::string &function);
-    int GetLibID(const std::string filepath, const std::string originSoName = "", const std::string funcName = "");
+    int GetLibID(const std::string &filepath, const std::string &originSoName = "",
+                 const std::string &funcName = "");
+    // use the symbols file index of frame if it is set, or find the lib by path
+    int GetLibID(const DfxFrame &frame);
+    int FindLibID(const std::string_view &filepath);
+    void IndexLibs();
 
-    void OutputJsonFeatureString();
-    void OutputJsonRuntimeInfo();
+    void OutputJsonFeatureString(JsonWriter &output);
+    void OutputJsonRuntimeInfo(JsonWriter &output);
 
     void AddReportCallStack(const uint64_t eventCount, ReportCallNodeItem &callNode,
                             const std::vector<DfxFrame> &frames);
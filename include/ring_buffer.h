@@ -26,24 +26,45 @@ public:
 
     explicit RingBuffer(const size_t size);
     ~RingBuffer();
-    // get size of the writable space
+    // get size of the writable space, only called by writer
     size_t GetFreeSize() const;
 
+    // writer: AllocForWrite and EndWrite for each record, then CommitWrite for the whole batch.
     // before writing data to rbuff, alloc space first
     uint8_t *AllocForWrite(const size_t writeSize);
-    // after writing data, move head pointer
+    // after writing data, move head pointer, the data is not visible to reader before commit
     void EndWrite();
+    // make all the written data visible to reader,
+    // return true if the buffer was empty before, the reader may be waiting for data
+    bool CommitWrite();
+
+    // reader: GetReadData and EndRead for each record, then CommitRead for the whole batch.
     // get data from buff, return nullptr if no readable data
     uint8_t *GetReadData();
-    // after reading, move tail pointer
+    // after reading, move tail pointer, the space is not released to writer before commit
     void EndRead();
+    // release all the read space to writer, return true if there is no more data to read
+    bool CommitRead();
 
 private:
+    // commit automatically if a batch is larger than size_ / AUTO_COMMIT_DIVISOR
+    static constexpr size_t AUTO_COMMIT_DIVISOR = 8;
+    void PublishHead();
+    uint8_t *AllocAt(const size_t writeSize, const size_t readHead);
+
     std::unique_ptr<uint8_t[]> buf_ = nullptr;
     const size_t size_;
     std::atomic_size_t head_ = 0; // write after this, always increase
     std::atomic_size_t tail_ = 0; // read from this, always increase
+
+    // only used by writer
+    size_t writeHead_ = 0; // head_ after commit
+    size_t cachedTail_ = 0; // last tail_ seen by writer
     size_t writeSize_ = 0;
+    bool needWakeup_ = false;
+    // only used by reader
+    size_t readTail_ = 0; // tail_ after commit
+    size_t cachedHead_ = 0; // last head_ seen by reader
     size_t readSize_ = 0;
 };
 } // namespace HiPerf
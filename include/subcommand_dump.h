@@ -17,6 +17,7 @@
 
 #include "perf_file_reader.h"
 
+#include <limits>
 #include <memory>
 
 #if defined(HAVE_PROTOBUF) && HAVE_PROTOBUF && defined(is_ohos) && is_ohos
@@ -47,13 +48,20 @@ public:
         "   --sympath <symbols path>\n"
         "       use symbols path to find symbols.\n"
         "   -i <file name>\n"
-        "       perf data file to dump, default is perf.data\n"
+        "       perf data file to dump, default is perf.data, '-' reads the records streamed from stdin\n"
         "   --elf <elf file name>\n"
         "       dump elf not perf data.\n"
 #if defined(HAVE_PROTOBUF) && HAVE_PROTOBUF && defined(is_ohos) && is_ohos
         "   --proto <protobuf file name>\n"
         "       dump perf data from protobuf file.\n"
 #endif
+        "   --pid <pid>\n"
+        "       only dump the samples of this pid in the data section, the other records are all dumped.\n"
+        "   --start-time <time>\n"
+        "       only dump the samples not earlier than this time(ns) in the data section.\n"
+        "   --end-time <time>\n"
+        "       only dump the samples not later than this time(ns) in the data section.\n"
+        "       with the record index feature, only the parts of the data section which may have them are read.\n"
         "   --export <sample index>\n"
         "       also export the user stack data to some split file,\n"
         "       use this command to produce ut data.\n"
@@ -82,6 +90,13 @@ private:
     static void DumpSampleType(uint64_t sampleType, int indent);
     bool PrepareDumpOutput();
     int exportSampleIndex_ = -1;
+    int rangePid_ = -1;
+    uint64_t rangeStartTime_ = 0;
+    uint64_t rangeEndTime_ = std::numeric_limits<uint64_t>::max();
+    bool IsRangeDump() const
+    {
+        return rangePid_ != -1 || rangeStartTime_ != 0 || rangeEndTime_ != std::numeric_limits<uint64_t>::max();
+    }
     int currectSampleIndex_ = 0;
     std::string dumpFileName_;
     std::string elfFileName_;
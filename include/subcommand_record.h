@@ -30,6 +30,10 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include "parallel_unwinder.h"
 #include "perf_event_record.h"
 #include "perf_events.h"
 #include "perf_file_writer.h"
@@ -40,6 +44,33 @@
 namespace OHOS {
 namespace Developtools {
 namespace HiPerf {
+#if USE_COLLECT_SYMBOLIC
+// one address of a sample, the context of a kernel thread hit is PERF_CONTEXT_MAX
+struct SymbolHit {
+    pid_t pid;
+    uint64_t ip;
+    perf_callchain_context context;
+};
+
+// the addresses of the samples, symbolized once when the record file is finished
+struct SymbolHits {
+    std::unordered_map<pid_t, std::unordered_set<uint64_t>> kernelThreadHits;
+    kSymbolsHits kernelHits;
+    uSymbolsHits userHits;
+
+    void Add(const SymbolHit &hit)
+    {
+        if (hit.context == PERF_CONTEXT_MAX) {
+            kernelThreadHits[hit.pid].insert(hit.ip);
+        } else if (hit.context == PERF_CONTEXT_KERNEL) {
+            kernelHits.insert(hit.ip);
+        } else {
+            userHits[hit.pid].insert(hit.ip);
+        }
+    }
+};
+#endif
+
 class SubCommandRecord : public SubCommand {
 public:
     static constexpr int DEFAULT_CPU_PERCENT = 25;
@@ -50,6 +81,7 @@ public:
     static constexpr int DEFAULT_MMAP_PAGES = 256;
     static constexpr int MIN_PERF_MMAP_PAGE = 2;
     static constexpr int MAX_PERF_MMAP_PAGE = 1024;
+    static constexpr int MAX_REORDER_WINDOW_MS = 1000;
     static constexpr int DEFAULT_CHECK_APP_MS = 10;
     static constexpr int MIN_CHECK_APP_MS = 1;
     static constexpr int MAX_CHECK_APP_MS = 200;
@@ -61,6 +93,12 @@ public:
     static constexpr uint64_t MIN_BACKTRACK_TIME_SEC = 5;
     static constexpr uint64_t DEFAULT_BACKTRACK_TIME_SEC = 10;
     static constexpr uint64_t MAX_BACKTRACK_TIME_SEC = 30;
+    // the mmaps keep the history of backtrack, they are sized by the estimated size of a sample
+    static constexpr int MAX_BACKTRACK_MMAP_PAGE = 4096;
+    static constexpr uint64_t BACKTRACK_SAMPLE_SIZE = 128;
+    static constexpr uint64_t BACKTRACK_CALLCHAIN_SIZE = 512;
+    static constexpr int MAX_SPLIT_TIME_SEC = 86400;
+    static constexpr int MAX_SPLIT_FILES = 10000;
 
     SubCommandRecord()
         // clang-format off
@@ -175,9 +213,24 @@ public:
         "         when using the hiperf command tool.\n"
         "   --symbol-dir <dir>\n"
         "         Set directory to look for symbol files, used for unwinding. \n"
+        "   --symbol-cache <dir>\n"
+        "         Save the parsed symbols of elf files into dir by build id,\n"
+        "         and load them from dir next time instead of parsing the elf again.\n"
         "   -m <mmap_pages>\n"
         "         Number of the mmap pages, used to receiving record data from kernel,\n"
         "         must be a power of two, rang[2,1024], default is 1024.\n"
+        "   --mmap-readers <num>\n"
+        "         Number of threads used to read the mmap data from kernel, the cpus are split\n"
+        "         into <num> groups and each group is read by its own thread.\n"
+        "         rang[0,cpu count], default is 0, means all cpus are read by the main thread.\n"
+        "   --mmap-adaptive\n"
+        "         Resize the mmap of each cpu at runtime, the cpus which lose records get the pages\n"
+        "         of the idle cpus, the total pages are not more than <mmap_pages> * cpu count.\n"
+        "         Not work with --mmap-readers or --backtrack.\n"
+        "   --reorder-window <ms>\n"
+        "         Keep the records of the last <ms> milliseconds in the mmaps until the next reading,\n"
+        "         so that records from different cpus stay in time order across wakeups.\n"
+        "         rang[0,1000], default is 0, means all records are read at each wakeup.\n"
         "   --app <package_name>\n"
         "         Collect profile info for an OHOS app, the app must be debuggable.\n"
         "         Record will exit if the process is not started within 20 seconds.\n"
@@ -186,9 +239,19 @@ public:
         "         <millisec> is in range [1-200], default is 10.\n"
         "   --parallel-symbolic\n"
         "         Enable parallel symbol resolution to speed up symbolization.\n"
-        "         Conflicts with the --cpu-limit option.\n"
+        "         At least 2 threads are used, more are scaled by the cpu count and the --cpu-limit percent.\n"
         "   --data-limit <SIZE[K|M|G]>\n"
         "         Stop recording after SIZE bytes of records. Default is unlimited.\n"
+        "   --split-size <SIZE[K|M|G]>\n"
+        "         Close the output file after SIZE bytes of records and continue in a new one.\n"
+        "         The closed files are renamed to <output_file_name>.<N>, N starts from 1.\n"
+        "         Conflicts with the --data-limit, --delay-unwind, --backtrack and --dedup_stack options.\n"
+        "   --split-time <sec>\n"
+        "         Close the output file every <sec> seconds and continue in a new one.\n"
+        "         <sec> is in range [1-86400], can be used with --split-size.\n"
+        "   --split-max-files <count>\n"
+        "         Keep at most <count> closed files of --split-size or --split-time,\n"
+        "         the oldest ones are removed. Default is 0, keep all of them.\n"
         "   --append-smo-data\n"
         "         Output information about the original shared libraries included in SOs\n"
         "         that support the SMO(Shared library Merge Optimization) feature. \n"
@@ -200,8 +263,16 @@ public:
 #else
         "         Set output file name, default is /data/local/tmp/perf.data.\n"
 #endif
+        "         Records are streamed if the output is '-' for stdout, 'fd:<fd>', 'unix:<socket path>'\n"
+        "         or a FIFO file, the attrs and features are sent as records, 'hiperf dump -i -' can read it.\n"
+        "         Conflicts with the -z, --delay-unwind, --backtrack, --report and --split-* options.\n"
         "   -z\n"
         "         Compress record data.\n"
+        "   --compress-level <level>\n"
+        "         Set the compression level of -z, range: 1~9, default: 6.\n"
+        "         Higher level makes smaller file and costs more cpu.\n"
+        "   --direct-io\n"
+        "         Write record data with O_DIRECT, bypass the page cache of the output file.\n"
         "   --restart\n"
         "         Collect performance counter information of application startup.\n"
         "         Record will exit if the process is not started within 30 seconds.\n"
@@ -224,9 +295,11 @@ public:
         "         Report with callstack after record. Conflicts with the -a option.\n"
         "   --backtrack\n"
         "         Collect data of the previous period. only restrain using with --control.\n"
+        "         The samples are kept in the kernel mmaps until output.\n"
         "   --backtrack-sec\n"
         "         If '--backtrack' is used, stop in <sec> seconds. seconds is in range [5-30]\n"
         "         default is 10\n"
+        "         The mmap pages grow to keep the samples of <sec> seconds, up to 4096 pages.\n"
         "   --dumpoptions\n"
         "         Dump command options.\n"
         )
@@ -259,6 +332,8 @@ private:
 
     bool targetSystemWide_ = false;
     bool compressData_ = false;
+    int compressLevel_ = DEFAULT_COMPRESS_LEVEL;
+    bool directIo_ = false;
     bool noInherit_ = false;
     bool excludeHiperf_ = false;
     bool appendSmoData_ = false;
@@ -277,9 +352,13 @@ private:
     int period_ = 0;
     int cpuPercent_ = DEFAULT_CPU_PERCENT;
     int mmapPages_ = MAX_PERF_MMAP_PAGE;
+    int mmapReaders_ = 0;
+    bool mmapAdaptive_ = false;
+    int reorderWindowMs_ = 0;
     int cmdlinesSize_ = DEFAULT_SAVED_CMDLINES_SIZE;
     int oldCmdlinesSize_ = 0;
     std::vector<std::string> symbolDir_ = {};
+    std::string symbolCacheDir_;
 #if defined(is_sandbox_mapping) && is_sandbox_mapping
     std::string outputFilename_ = GetDefaultPathByEnv("perf.data");
 #else
@@ -345,6 +424,66 @@ private:
     uint64_t dataSizeLimit_ = 0;
     bool isDataSizeLimitStop_ = false;
 
+    // for split output files
+    std::string strSplitSize_ = {};
+    uint64_t splitSize_ = 0;
+    int splitTimeSec_ = 0;
+    int splitMaxFiles_ = 0;
+    uint32_t splitIndex_ = 0;
+    std::deque<std::string> splitFiles_ = {};
+    std::chrono::steady_clock::time_point segmentStartTime_;
+    bool CheckSplitOption();
+    bool IsSplitNeeded();
+    void OnRecordTick();
+    // the closed files are finished by the background thread, the record thread goes on with the next file
+    struct SplitFile {
+        std::unique_ptr<PerfFileWriter> fileWriter;
+        std::string fileName;
+        std::vector<pid_t> mapPids;
+        pid_t devhostPid = 0;
+    };
+    bool FinishSplitFile(SplitFile &splitFile);
+    void PrepareSplitRuntime(VirtualRuntime &runtime, const SplitFile &splitFile);
+
+    // the work taken off the record thread, the tasks are run in order by one thread
+    using BackgroundTask = std::function<bool()>;
+    std::thread backgroundThread_;
+    std::mutex backgroundMutex_;
+    std::condition_variable backgroundCond_;
+    std::deque<BackgroundTask> backgroundTasks_ = {};
+    bool backgroundThreadExit_ = false;
+    bool backgroundFailed_ = false;
+    void PostBackgroundTask(BackgroundTask task);
+    void BackgroundThreadLoop();
+    // wait for the posted tasks, false if any of them failed
+    bool WaitBackgroundTasks();
+
+    // for stream output
+    bool CheckStreamOption();
+    bool PrepareStreamOutput();
+#if USE_COLLECT_SYMBOLIC
+    // the hits of the streamed samples are added to symbolHits_ by the background thread
+    static constexpr size_t SYMBOL_HITS_BATCH_SIZE = 4096;
+    std::vector<SymbolHit> pendingHits_ = {};
+    void QueueSymbolHits(PerfRecordSample *sample);
+    void PostSymbolHits();
+#endif
+
+    // records read back for delay unwind, the samples of a batch are unwound together
+    struct DelayUnwindBatch {
+        // reused by the batches, the first count of them hold the records of this batch
+        std::vector<std::vector<uint8_t>> records;
+        size_t count = 0;
+        size_t size = 0;
+        // reused by the batches
+        std::vector<std::unique_ptr<PerfRecordSample>> samples;
+    };
+    bool AddDelayUnwindRecord(DelayUnwindBatch &batch, const PerfEventRecord &record);
+    void FlushDelayUnwindBatch(DelayUnwindBatch &batch, ParallelUnwinder &unwinder, const perf_event_attr &attr);
+    // the symbols have been collected when the records are saved
+    bool symbolsCollected_ = false;
+    bool RotateRecordFile();
+
     std::unique_ptr<PerfFileWriter> fileWriter_ = nullptr;
 
     // for client
@@ -440,16 +579,23 @@ private:
 
     bool CollectionSymbol(PerfEventRecord& record);
     void CollectSymbol(PerfRecordSample *sample);
+#if USE_COLLECT_SYMBOLIC
+    void CollectSymbol(PerfRecordSample *sample, VirtualRuntime &runtime, SymbolHits &hits) const;
+    template <typename AddHit>
+    void ForEachSymbolHit(PerfRecordSample *sample, VirtualRuntime &runtime, AddHit addHit) const;
+#endif
     bool SetPerfLimit(const std::string& file, const int value, std::function<bool (int, int)> const& cmd,
         const std::string& param);
     bool SetPerfCpuMaxPercent();
     bool SetPerfMaxSampleRate();
     bool SetPerfEventMlock();
+    int GetBacktrackMmapPages() const;
     bool SetPerfHarden();
 
     bool TraceOffCpu();
     bool ParseCallStackOption(const std::vector<std::string> &callStackType);
     bool ParseDataLimitOption(const std::string &str);
+    bool ParseSizeOption(const std::string &str, uint64_t &size);
     bool ParseBranchSampleType(const std::vector<std::string> &vecBranchSampleTypes);
     bool ParseControlCmd(const std::string cmd);
     bool CheckTargetProcessOptions();
@@ -470,45 +616,9 @@ private:
 
     VirtualRuntime virtualRuntime_;
 #if USE_COLLECT_SYMBOLIC
-    std::unordered_map<pid_t, std::unordered_set<uint64_t>> kernelThreadSymbolsHits_;
-    kSymbolsHits kernelSymbolsHits_;
-    uSymbolsHits userSymbolsHits_;
-    void SymbolicHits();
-    void SymbolicHitsParallel();
-
-    using AddrItem = std::pair<pid_t, uint64_t>;
-
-    enum class BucketType {
-        User,           // User symbols (bucketed by SymbolsFile)
-        KernelThread,   // Kernel thread symbols (all pids merged)
-        Kernel          // Kernel symbols
-    };
-
-    struct SymbolBucket {
-        BucketType type;
-        std::vector<AddrItem> items;
-    };
-
-    void CollectSymbolBuckets(
-        std::unordered_map<SymbolsFile*, std::vector<AddrItem>>& userBuckets,
-        std::vector<AddrItem>& ktAddrs,
-        std::vector<uint64_t>& kAddrs,
-        std::vector<AddrItem>& unknownItems);
-    void BuildSymbolBuckets(
-        std::unordered_map<SymbolsFile*, std::vector<AddrItem>>& userBuckets,
-        std::vector<AddrItem>& ktAddrs,
-        std::vector<uint64_t>& kAddrs,
-        std::vector<SymbolBucket>& bucketVec);
-    void AssignBucketsToThreads(
-        std::vector<SymbolBucket>& bucketVec,
-        std::vector<std::vector<size_t>>& threadBuckets,
-        size_t numThreads);
-    void ExecuteParallelResolution(
-        const std::vector<SymbolBucket>& bucketVec,
-        const std::vector<std::vector<size_t>>& threadBuckets,
-        const std::vector<AddrItem>& unknownItems,
-        size_t numThreads);
-    void ResolveBucket(const SymbolBucket& bucket);
+    SymbolHits symbolHits_;
+    void SymbolicHits(VirtualRuntime &runtime, const SymbolHits &hits);
+    void SymbolicHitsParallel(VirtualRuntime &runtime, const SymbolHits &hits);
 #endif
 
 #ifdef HIPERF_DEBUG_TIME
@@ -36,6 +36,7 @@
 #endif
 #include "debug_logger.h"
 #include "option.h"
+#include "parallel_report_aggregator.h"
 #if defined(is_ohos) && is_ohos
 #include <perf_events.h>
 #endif
@@ -61,6 +62,9 @@ public:
         "   --symbol-dir <dir>\n"
         "       use symbols path to find symbols.\n"
         "       separate the paths with commas.\n"
+        "   --symbol-cache <dir>\n"
+        "       save the parsed symbols of elf files into dir by build id,\n"
+        "       and load them from dir next time instead of parsing the elf again.\n"
         "   --limit-percent <number>\n"
         "       only show heat percent limit content.\n"
         "   -s / --call-stack\n"
@@ -78,6 +82,15 @@ public:
         "       example: \"report -i a.data --diff b.data\"\n"
         "   --branch\n"
         "       show the branch from address instead of ip address\n"
+        "   --parallel\n"
+        "       aggregate the samples by several threads, sharded by pid. off by default.\n"
+        "       only for the default text report, not for --json, --proto or --branch.\n"
+        "   --parallel-threads <count>\n"
+        "       the threads used by --parallel, at most 8.\n"
+        "       default is 0, the cpu count but no more than 4.\n"
+        "   --decode-threads <count>\n"
+        "       decode the record file by <count> threads, 1 means decode it serially.\n"
+        "       default is 0, decided by the cpu count and the record file size.\n"
         "   --<keys> <keyname1>[,keyname2][,...]\n"
         "       select able keys: comms,pids,tids,dsos,funcs,from_dsos,from_funcs\n"
         "           example: --comms hiperf\n"
@@ -148,6 +161,7 @@ private:
     // create record file reader pointer
     std::unique_ptr<PerfFileReader> recordFileReader_;
     std::vector<std::string> symbolsPaths_;
+    std::string symbolCacheDir_;
 
     // report file name , if empty will use stdout
     std::string reportFile_;
@@ -174,6 +188,12 @@ private:
     std::map<pid_t, std::unique_ptr<PerfRecordSample>> prevSampleCache_;
     void FlushCacheRecord();
 
+    bool parallel_ = false;
+    int parallelThreads_ = 0;
+    int decodeThreads_ = 0;
+    std::unique_ptr<ParallelReportAggregator> parallelAggregator_ = nullptr;
+    void StartParallelAggregator();
+
     // in debug mode we will output some more debug info
     bool debug_ = false;
     bool branch_ = false;
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SUBCOMMAND_TOP_H
+#define SUBCOMMAND_TOP_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "perf_event_record.h"
+#include "perf_events.h"
+#include "subcommand.h"
+#include "top_aggregator.h"
+#include "virtual_runtime.h"
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+class SubCommandTop : public SubCommand {
+public:
+    static constexpr int MIN_SAMPLE_FREQUENCY = 1;
+    static constexpr int MAX_SAMPLE_FREQUENCY = 100000;
+    static constexpr float MIN_STOP_SECONDS = 0.100;
+    static constexpr float MAX_STOP_SECONDS = 10000.0;
+    static constexpr int DEFAULT_REFRESH_MS = 1000;
+    static constexpr int MIN_REFRESH_MS = 100;
+    static constexpr int MAX_REFRESH_MS = 60000;
+    static constexpr int DEFAULT_SHOW_COUNT = 20;
+    static constexpr int MIN_SHOW_COUNT = 1;
+    static constexpr int MAX_SHOW_COUNT = 1000;
+    static constexpr int MIN_MAX_ENTRIES = 16;
+    static constexpr int MAX_MAX_ENTRIES = 1000000;
+
+    SubCommandTop()
+        // clang-format off
+        : SubCommand("top", "Show the hot functions in real time",
+        "Usage: hiperf top [options]\n"
+        "       Sample and show the hot functions in real time, nothing is written to file.\n"
+        "       The default options are: -a -d 10000.0 -e hw-cpu-cycles -f 4000 -i 1000 -n 20\n"
+        "   -a\n"
+        "         Collect system-wide information, it is the default if no -p or -t is given.\n"
+        "         This requires CAP_PERFMON (since Linux 5.8) or CAP_SYS_ADMIN capability or a\n"
+        "         /proc/sys/kernel/perf_event_paranoid value of less than 1.\n"
+        "   -c <cpuid>[<,cpuid>]...\n"
+        "         cpuid should be 0,1,2...\n"
+        "         Limit the CPU that collects data.\n"
+        "   -d <sec>\n"
+        "         stop in <sec> seconds. floating point number. seconds is in range [0.100-10000.0]\n"
+        "         default is 10000.0\n"
+        "   -f <freq>\n"
+        "         Set event sampling frequency. default is 4000 samples every second.\n"
+        "   -e <event1[:<u|k>]>[,event1[:<u|k>]]...\n"
+        "         Customize the name of the event that needs to be sampled.\n"
+        "           u - monitor user space events only\n"
+        "           k - monitor kernel space events only\n"
+        "   -p <pid1>[,pid2]...\n"
+        "         Limit the process id of the collection target. Conflicts with the -a option.\n"
+        "   -t <tid1>[,tid2]...\n"
+        "         Limit the thread id of the collection target. Conflicts with the -a option.\n"
+        "   -i <ms>\n"
+        "         Refresh the table every <ms> milliseconds, in range [100-60000], default is 1000.\n"
+        "   -n <count>\n"
+        "         Show the <count> hottest items, in range [1-1000], default is 20.\n"
+        "   --dso\n"
+        "         Show the hot shared objects instead of the functions.\n"
+        "   --decay <ratio>\n"
+        "         Keep <ratio> of the weight of each item at every refresh, in range (0-1], default is 0.5.\n"
+        "         1 means the items are aggregated since the start.\n"
+        "   --max-entries <count>\n"
+        "         Limit the functions kept in memory, the coldest ones are evicted.\n"
+        "         count is in range [16-1000000], default is 4096.\n"
+        "   --include-hiperf\n"
+        "         Also show the events issued by hiperf itself.\n"
+        )
+        // clang-format on
+    {
+    }
+
+    bool ParseOption(std::vector<std::string> &args) override;
+    void DumpOptions(void) const override;
+    HiperfError OnSubCommand(std::vector<std::string>& args) override;
+
+    static bool RegisterSubCommandTop(void);
+    static SubCommand& GetInstance();
+
+private:
+    bool CheckOptions();
+    bool CheckTargetOptions();
+    bool PreparePerfEvent();
+    void PrepareVirtualRuntime();
+    bool ProcessRecord(PerfEventRecord &record);
+
+    void StartRefresh();
+    void StopRefresh();
+    void RefreshLoop();
+    // show the table and decay it
+    void Refresh(const bool last);
+
+    PerfEvents perfEvents_;
+    VirtualRuntime virtualRuntime_;
+
+    bool targetSystemWide_ = false;
+    std::vector<int> selectCpus_ = {};
+    float timeStopSec_ = PerfEvents::DEFAULT_TIMEOUT;
+    int frequency_ = static_cast<int>(PerfEvents::DEFAULT_SAMPLE_FREQUNCY);
+    std::vector<std::string> selectEvents_ = {};
+    std::vector<pid_t> selectPids_ = {};
+    std::vector<pid_t> selectTids_ = {};
+    int refreshMs_ = DEFAULT_REFRESH_MS;
+    int showCount_ = DEFAULT_SHOW_COUNT;
+    bool showDso_ = false;
+    float decay_ = static_cast<float>(TopAggregator::DEFAULT_DECAY);
+    int maxEntries_ = static_cast<int>(TopAggregator::DEFAULT_MAX_ENTRIES);
+    bool includeHiperf_ = false;
+    pid_t hiperfPid_ = -1;
+    bool isRoot_ = false;
+
+    // samples are added by the record thread and shown by the refresh thread
+    std::unique_ptr<TopAggregator> aggregator_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopRefresh_ = false;
+    std::thread refreshThread_;
+    std::chrono::steady_clock::time_point lastRefreshTime_;
+};
+
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
+#endif // SUBCOMMAND_TOP_H
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HIPERF_SYMBOL_CACHE_H
+#define HIPERF_SYMBOL_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dfx_symbol.h"
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+using namespace OHOS::HiviewDFX;
+
+// layout of a cache file, all in native byte order:
+//   SymbolCacheHeader
+//   SymbolCacheEntry[symbolCount], sorted by vaddr and unique
+//   string table, the names, demangled names and modules of the entries
+struct SymbolCacheHeader {
+    char magic[8] = {'H', 'P', 'S', 'Y', 'M', 'C', 'H', 'E'};
+    uint32_t version = 2;
+    uint32_t symbolCount = 0;
+    uint64_t stringTableSize = 0;
+};
+
+struct SymbolCacheEntry {
+    uint64_t vaddr = 0;
+    uint64_t len = 0;
+    uint32_t nameOffset = 0;
+    uint32_t nameSize = 0;
+    uint32_t demangleOffset = 0;
+    uint32_t demangleSize = 0;
+    // empty if it is the module of the whole file, like the symbols of an elf
+    uint32_t moduleOffset = 0;
+    uint32_t moduleSize = 0;
+};
+
+// the symbol tables of elf files, saved in a directory and keyed by build id.
+// the symbols are saved after sorted, uniqued and demangled, so they can be used directly.
+class SymbolCache {
+public:
+    // the cache is disabled if the directory is empty
+    static void SetDirectory(const std::string &dir);
+    static const std::string &GetDirectory();
+    static bool IsEnabled();
+
+    // symbols are appended, module is used for the ones saved without module. return false if not cached
+    static bool Load(const std::string &buildId, const std::string &module, std::vector<DfxSymbol> &symbols);
+    // symbols must have been sorted and uniqued, the module of them is not saved if it is module
+    static bool Save(const std::string &buildId, const std::string &module, const std::vector<DfxSymbol> &symbols);
+
+    static std::string GetCacheFilePath(const std::string &buildId);
+
+private:
+    static bool ParseCacheData(const uint8_t *data, const size_t size, const std::string &module,
+                               std::vector<DfxSymbol> &symbols);
+
+    static std::string directory_;
+};
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
+#endif // HIPERF_SYMBOL_CACHE_H
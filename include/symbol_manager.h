@@ -20,6 +20,7 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <vector>
 
@@ -57,15 +58,12 @@ public:
 
     CacheStats GetCacheStats() const;
     size_t GetCacheSize() const;
-    size_t GetCurrentCacheSize() const;
     void ClearCache();
 
-    // Public constant for parallel thread count (must match cache array size)
-    static constexpr size_t PARALLEL_THREAD_COUNT = 2;
-
-    static void SetCurrentThreadId(size_t id)
+    // the cache is locked only when Resolve is called by several threads
+    void SetConcurrent(const bool concurrent)
     {
-        currentThreadId_ = id;
+        concurrent_ = concurrent;
     }
 
 protected:
@@ -74,21 +72,28 @@ protected:
     SymbolsFile* FindSymbolsFile(const std::string& filePath) const;
     const std::vector<std::unique_ptr<SymbolsFile>>& symbolsFiles_;
 
-    // Thread-local cache for zero-lock concurrency
+    // Cache shared by all the resolving threads, a symbol found by one thread is hit by the others.
+    // Sharded by vaddr so the threads seldom wait for the same lock.
     static constexpr size_t CACHE_SIZE = 4000;
+    static constexpr size_t CACHE_SHARD_COUNT = 16;
 
-    struct ThreadCache {
+    struct CacheShard {
         HashList<uint64_t, DfxSymbol> cache;
-        ThreadCache() : cache(CACHE_SIZE) {}
+        mutable std::mutex mutex;
+        CacheShard() : cache(CACHE_SIZE / CACHE_SHARD_COUNT) {}
     };
 
-    std::array<ThreadCache, PARALLEL_THREAD_COUNT> threadCaches_;
-    static thread_local size_t currentThreadId_;
+    std::array<CacheShard, CACHE_SHARD_COUNT> cacheShards_;
+    // only changed when no thread is resolving
+    bool concurrent_ = false;
 
-    HashList<uint64_t, DfxSymbol>& GetCurrentCache()
+    CacheShard& GetCacheShard(uint64_t fileVaddr)
     {
-        size_t id = currentThreadId_ < PARALLEL_THREAD_COUNT ? currentThreadId_ : 0;
-        return threadCaches_[id].cache;
+        // fibonacci hashing, the nearby vaddrs of one function are spread to different shards
+        constexpr uint64_t goldenRatio = 0x9E3779B97F4A7C15;
+        constexpr int shardBits = 4;
+        static_assert((1u << shardBits) == CACHE_SHARD_COUNT, "shard count must be 2^shardBits");
+        return cacheShards_[(fileVaddr * goldenRatio) >> (sizeof(uint64_t) * BITS_OF_BYTE - shardBits)];
     }
 
     mutable std::atomic_size_t cacheHits_ = 0;
@@ -96,8 +101,9 @@ protected:
 
     void ClearAllCaches()
     {
-        for (auto& tc : threadCaches_) {
-            tc.cache.clear();
+        for (auto& shard : cacheShards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.cache.clear();
         }
     }
 };
@@ -156,6 +162,8 @@ public:
     void SetSoMappingMap(const std::map<std::string, std::vector<AdltMapDataFragment>>& soMappingMap);
     void SetRecordMode(bool needRecordCallBack);
     void SetDevhostPid(pid_t devhostPid);
+    // ResolveSymbol will be called by several threads
+    void SetConcurrent(const bool concurrent);
     void DumpStats() const;
 
 private:
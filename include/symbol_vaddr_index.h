@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HIPERF_SYMBOL_VADDR_INDEX_H
+#define HIPERF_SYMBOL_VADDR_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+// dense index of the start vaddrs of a sorted symbol table.
+// the vaddrs are kept apart from the large symbol objects in eytzinger (bfs) order,
+// so the first levels of the search share a few hot cache lines, and the search has no
+// unpredictable branch.
+class SymbolVaddrIndex {
+public:
+    static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+    // symbols must be sorted by funcVaddr_
+    template<typename Symbols>
+    void Build(const Symbols &symbols)
+    {
+        size_ = symbols.size();
+        // 1 based, children of k are 2k and 2k + 1
+        vaddrs_.assign(size_ + 1, 0);
+        positions_.assign(size_ + 1, 0);
+        Fill(symbols, 0, 1);
+    }
+
+    void Clear()
+    {
+        size_ = 0;
+        std::vector<uint64_t>().swap(vaddrs_);
+        std::vector<uint32_t>().swap(positions_);
+    }
+
+    size_t Size() const
+    {
+        return size_;
+    }
+
+    // position of the last symbol whose start vaddr <= vaddr, NOT_FOUND if all of them are after vaddr
+    size_t FindFloor(const uint64_t vaddr) const
+    {
+        size_t k = 1;
+        while (k <= size_) {
+            k = k * 2 + static_cast<size_t>(vaddrs_[k] <= vaddr);
+        }
+        // drop the right turns and the last left turn, k is the first node > vaddr
+        k >>= TrailingOnes(k) + 1;
+        if (k == 0) {
+            return size_ == 0 ? NOT_FOUND : size_ - 1;
+        }
+        return positions_[k] == 0 ? NOT_FOUND : positions_[k] - 1;
+    }
+
+private:
+    // in order traversal of the implicit tree visits the nodes in sorted order, depth is log(n)
+    template<typename Symbols>
+    size_t Fill(const Symbols &symbols, size_t next, const size_t k)
+    {
+        if (k > size_) {
+            return next;
+        }
+        next = Fill(symbols, next, k * 2);
+        vaddrs_[k] = symbols[next].funcVaddr_;
+        positions_[k] = static_cast<uint32_t>(next);
+        return Fill(symbols, next + 1, k * 2 + 1);
+    }
+
+    static size_t TrailingOnes(size_t k)
+    {
+        size_t count = 0;
+        while ((k & 1) != 0) {
+            k >>= 1;
+            count++;
+        }
+        return count;
+    }
+
+    size_t size_ = 0;
+    std::vector<uint64_t> vaddrs_;
+    std::vector<uint32_t> positions_; // position in the sorted symbols of each node
+};
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
+#endif // HIPERF_SYMBOL_VADDR_INDEX_H
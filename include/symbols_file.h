@@ -18,6 +18,7 @@
 
 #include <cinttypes>
 #include <iomanip>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <unordered_map>
@@ -25,6 +26,7 @@
 #include "dfx_elf.h"
 #include "dfx_symbol.h"
 #include "perf_file_format.h"
+#include "symbol_vaddr_index.h"
 #include "utilities.h"
 
 #define HIPERF_ELF_READ_USE_MMAP
@@ -102,6 +104,8 @@ public:
     uint64_t textExecVaddrFileOffset_ = 0;
     uint64_t textExecVaddrRange_ = maxVaddr;
     std::shared_ptr<DfxMap> map_ = nullptr;
+    // guards the lazy loading of the elf and debug info, the file is shared by the unwinding threads
+    std::mutex loadMutex_;
 
     SymbolsFile(SymbolsFileType symbolType, const std::string path)
         : symbolFileType_(symbolType), filePath_(path) {};
@@ -175,6 +179,10 @@ public:
     uint64_t GetVaddrByLoadBase(uint64_t ip, uint64_t loadBase) const;
     // get symbols from vaddr
     const DfxSymbol GetSymbolWithVaddr(uint64_t vaddrInFile);
+    // the symbol contains vaddr in symbols_, without copy. return nullptr if not found
+    DfxSymbol *FindSymbolWithVaddr(const uint64_t vaddrInFile);
+    // the copy of a symbol found by FindSymbolWithVaddr, filled for vaddrInFile
+    DfxSymbol GetVaddrSymbol(const DfxSymbol &found, const uint64_t vaddrInFile) const;
 
     // get the section info , like .ARM.exidx
     virtual bool GetSectionInfo([[maybe_unused]] const std::string &name,
@@ -211,10 +219,16 @@ public:
     }
 
     void AddSymbol(DfxSymbol symbol);
+    // the symbols added in order by AddSymbol are indexed once all of them are added
+    void IndexSymbols()
+    {
+        symbolsIndex_.Build(symbols_);
+    }
 
     void ReleaseSymbols()
     {
         { std::vector<DfxSymbol>().swap(symbols_); }
+        symbolsIndex_.Clear();
         { std::vector<DfxSymbol *>().swap(matchedSymbols_); }
         { std::unordered_map<uint64_t, DfxSymbol>().swap(symbolsMap_); }
         symbolsLoaded_ = false;
@@ -260,8 +274,11 @@ protected:
     std::string buildId_ = "";
     std::vector<std::string> symbolsFileSearchPaths_;
     std::vector<FileSymbol> fileSymbols_ {};
+    // start vaddrs of symbols_, built when the symbols are loaded, never while searching
+    SymbolVaddrIndex symbolsIndex_;
 
-    void AdjustSymbols();
+    // sorted symbols only need to be indexed, such as the ones from symbol cache
+    void AdjustSymbols(const bool sorted = false);
     void SortMatchedSymbols();
     bool CheckPathReadable(const std::string &path) const;
 };
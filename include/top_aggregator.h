@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HIPERF_TOP_AGGREGATOR_H
+#define HIPERF_TOP_AGGREGATOR_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+// incremental aggregation of the live samples for hiperf top.
+// the weight of each entry is its event count, it decays at every refresh,
+// so the table shows what is hot recently instead of since the start.
+// the function entries are bounded, the coldest ones are evicted when the table is full.
+class TopAggregator {
+public:
+    static constexpr size_t DEFAULT_MAX_ENTRIES = 4096;
+    static constexpr double DEFAULT_DECAY = 0.5;
+    // entries lighter than this ratio of the total weight or one event are dropped at decay
+    static constexpr double COLD_RATIO = 0.0001;
+    static constexpr double MIN_WEIGHT = 1.0;
+
+    struct TopItem {
+        std::string dso;
+        std::string func; // empty for the dso items
+        double weight = 0;
+    };
+
+    // decay is the ratio of weight kept at each refresh, in (0, 1]
+    explicit TopAggregator(const size_t maxEntries = DEFAULT_MAX_ENTRIES, const double decay = DEFAULT_DECAY);
+    ~TopAggregator() = default;
+
+    void AddSample(const std::string &dso, const std::string &func, const uint64_t eventCount);
+    // called at each refresh, the cold entries are dropped.
+    // an idle target is cleared after a few refreshes.
+    void Decay();
+
+    // the hottest items, heaviest first
+    std::vector<TopItem> GetTopFunctions(const size_t count) const;
+    std::vector<TopItem> GetTopDsos(const size_t count) const;
+
+    double GetTotalWeight() const
+    {
+        return totalWeight_;
+    }
+    // samples added since the last decay
+    uint64_t GetRecentSamples() const
+    {
+        return recentSamples_;
+    }
+    size_t GetFunctionCount() const
+    {
+        return funcCount_;
+    }
+    size_t GetDsoCount() const
+    {
+        return dsos_.size();
+    }
+
+private:
+    struct DsoEntry {
+        double weight = 0;
+        std::unordered_map<std::string, double> funcs;
+    };
+
+    // drop the coldest functions until the table is 3/4 full.
+    // the dso entries left without function are dropped too, except keepDso.
+    void Evict(const std::string &keepDso);
+
+    const size_t maxEntries_;
+    const double decay_;
+    std::unordered_map<std::string, DsoEntry> dsos_;
+    size_t funcCount_ = 0;
+    double totalWeight_ = 0;
+    uint64_t recentSamples_ = 0;
+};
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
+#endif // HIPERF_TOP_AGGREGATOR_H
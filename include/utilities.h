@@ -209,6 +209,15 @@ bool IsDigits(const std::string &str);
 
 bool IsHexDigits(const std::string &str);
 
+// mix the hash of one more field into seed, like boost::hash_combine
+constexpr size_t HASH_GOLDEN_RATIO = 0x9e3779b9;
+inline void HashCombine(size_t &seed, const size_t hash)
+{
+    constexpr size_t hashShiftLeft = 6;
+    constexpr size_t hashShiftRight = 2;
+    seed ^= hash + HASH_GOLDEN_RATIO + (seed << hashShiftLeft) + (seed >> hashShiftRight);
+}
+
 constexpr const int COMPRESS_READ_BUF_SIZE = 4096;
 // compress specified dataFile into gzip file
 bool CompressFile(const std::string &dataFile, const std::string &destFile);
@@ -107,6 +107,8 @@ public:
     DfxSymbol GetSymbol(const uint64_t ip, const pid_t pid, const pid_t tid,
                         const perf_callchain_context &context = PERF_CONTEXT_MAX);
     void ClearSymbolCache();
+    // GetSymbol will be called by several threads, see ParallelSymbolResolver
+    void SetSymbolConcurrent(const bool concurrent);
     void ReleaseRecordResources();
     VirtualThread &GetThread(const pid_t pid, const pid_t tid, const std::string name = "");
     const std::map<pid_t, VirtualThread> &GetThreads() const;
@@ -117,6 +119,13 @@ public:
     void UpdateFromPerfData(const std::vector<SymbolFileStruct> &);
     void UpdateFilesFromSmoRecordData();
     void UnwindFromRecord(PerfRecordSample &recordSample);
+#if defined(is_ohos) && is_ohos
+    // for unwinding the samples by several threads, see CallStackProcessor
+    VirtualThread *GetUnwindThread(PerfRecordSample &recordSample);
+    void UnwindUserStack(PerfRecordSample &recordSample, const VirtualThread &thread, CallStack &callstack,
+                         std::vector<DfxFrame> &callFrames, std::vector<u64> &ips) const;
+#endif
+    void FinishUnwind(PerfRecordSample &recordSample);
     std::string ReadThreadName(const pid_t tid, const bool isThread);
     std::string ReadFromSavedCmdLines(const pid_t tid);
     bool IsKernelThread(const pid_t pid);
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define HILOG_TAG "AsyncWriter"
+
+#include "async_file_writer.h"
+
+#include <cerrno>
+#include <cinttypes>
+#include <unistd.h>
+
+#include "hiperf_hilog.h"
+#include "utilities.h"
+
+using namespace std::chrono;
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+AsyncFileWriter::AsyncFileWriter(const int fd, const size_t bufferSize, const size_t bufferCount)
+    : fd_(fd), bufferSize_((bufferSize + DIRECT_IO_ALIGN - 1) / DIRECT_IO_ALIGN * DIRECT_IO_ALIGN)
+{
+    for (size_t i = 0; i < bufferCount; i++) {
+        auto buffer = std::make_unique<Buffer>();
+        buffer->storage.resize(bufferSize_ + DIRECT_IO_ALIGN);
+        uintptr_t addr = reinterpret_cast<uintptr_t>(buffer->storage.data());
+        buffer->data = buffer->storage.data() + (DIRECT_IO_ALIGN - addr % DIRECT_IO_ALIGN) % DIRECT_IO_ALIGN;
+        freeBuffers_.push_back(buffer.get());
+        buffers_.emplace_back(std::move(buffer));
+    }
+}
+
+AsyncFileWriter::~AsyncFileWriter()
+{
+    if (thread_.joinable()) {
+        Stop();
+    }
+}
+
+bool AsyncFileWriter::Start(const uint64_t offset, const int directFd)
+{
+    CHECK_TRUE(!thread_.joinable(), false, 1, "async writer has been started");
+    CHECK_TRUE(!buffers_.empty(), false, 1, "no buffer for async writer");
+    nextOffset_ = offset;
+    directFd_ = directFd;
+    stop_ = false;
+    thread_ = std::thread(&AsyncFileWriter::FlushLoop, this);
+    return true;
+}
+
+bool AsyncFileWriter::Write(const void *buf, size_t len)
+{
+    CHECK_TRUE(thread_.joinable(), false, 1, "async writer is not running");
+    const uint8_t *src = static_cast<const uint8_t *>(buf);
+    while (len > 0) {
+        if (current_ == nullptr && !AcquireBuffer()) {
+            return false;
+        }
+        size_t copySize = std::min(len, current_->capacity - current_->size);
+        if (memcpy_s(current_->data + current_->size, current_->capacity - current_->size, src, copySize) != EOK) {
+            HLOGE("memcpy_s failed");
+            return false;
+        }
+        current_->size += copySize;
+        src += copySize;
+        len -= copySize;
+        if (current_->size == current_->capacity) {
+            SubmitBuffer();
+        }
+    }
+    return true;
+}
+
+bool AsyncFileWriter::Stop()
+{
+    if (!thread_.joinable()) {
+        return !failed_;
+    }
+    if (current_ != nullptr && current_->size > 0) {
+        SubmitBuffer();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+    HLOGD("async writer wrote %" PRIu64 " bytes in %" PRIu64 " flushes, stalled %" PRIu64 " times",
+          stat_.writtenBytes, stat_.flushCount, stat_.stallCount);
+    return !failed_;
+}
+
+AsyncFileWriter::Stat AsyncFileWriter::GetStat()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stat_;
+}
+
+// wait for a free buffer if all of them are waiting for the disk
+bool AsyncFileWriter::AcquireBuffer()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (freeBuffers_.empty()) {
+        stat_.stallCount++;
+        const auto startTime = steady_clock::now();
+        cv_.wait(lock, [this] { return !freeBuffers_.empty() || failed_; });
+        stat_.stallTime += duration_cast<microseconds>(steady_clock::now() - startTime);
+    }
+    CHECK_TRUE(!failed_, false, 1, "async writer failed to write file");
+    current_ = freeBuffers_.front();
+    freeBuffers_.pop_front();
+    current_->size = 0;
+    current_->offset = nextOffset_;
+    // the buffer ends at an aligned offset, so the following buffers can be written by O_DIRECT
+    current_->capacity = bufferSize_ - nextOffset_ % DIRECT_IO_ALIGN;
+    return true;
+}
+
+void AsyncFileWriter::SubmitBuffer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        nextOffset_ += current_->size;
+        fullBuffers_.push_back(current_);
+        stat_.maxPendingBuffers = std::max(stat_.maxPendingBuffers, fullBuffers_.size());
+    }
+    current_ = nullptr;
+    cv_.notify_all();
+}
+
+void AsyncFileWriter::FlushLoop()
+{
+    pthread_setname_np(pthread_self(), "file_writer");
+    while (true) {
+        Buffer *buffer = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return !fullBuffers_.empty() || stop_; });
+            if (fullBuffers_.empty()) {
+                break;
+            }
+            buffer = fullBuffers_.front();
+            fullBuffers_.pop_front();
+        }
+        const auto startTime = steady_clock::now();
+        bool ret = WriteBuffer(*buffer);
+        std::lock_guard<std::mutex> lock(mutex_);
+        stat_.flushTime += duration_cast<microseconds>(steady_clock::now() - startTime);
+        stat_.flushCount++;
+        if (ret) {
+            stat_.writtenBytes += buffer->size;
+        } else {
+            failed_ = true;
+        }
+        freeBuffers_.push_back(buffer);
+        cv_.notify_all();
+    }
+}
+
+bool AsyncFileWriter::WriteBuffer(const Buffer &buffer)
+{
+    int fd = fd_;
+    if (directFd_ >= 0 && buffer.offset % DIRECT_IO_ALIGN == 0 && buffer.size % DIRECT_IO_ALIGN == 0) {
+        fd = directFd_;
+    }
+    size_t written = 0;
+    while (written < buffer.size) {
+        ssize_t ret = pwrite(fd, buffer.data + written, buffer.size - written, buffer.offset + written);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret < 0 && errno == EINVAL && fd == directFd_) {
+            // O_DIRECT is not supported by this file system
+            HLOGW("O_DIRECT write failed, fall back to buffered write");
+            directFd_ = -1;
+            fd = fd_;
+            continue;
+        }
+        if (ret <= 0) {
+            char errInfo[ERRINFOLEN] = { 0 };
+            strerror_r(errno, errInfo, ERRINFOLEN);
+            HLOGE("pwrite %zu bytes at %" PRIu64 " failed, errno:%d:%s", buffer.size - written,
+                  buffer.offset + written, errno, errInfo);
+            return false;
+        }
+        written += static_cast<size_t>(ret);
+    }
+    return true;
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
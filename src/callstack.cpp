@@ -19,6 +19,7 @@
 #include <dlfcn.h>
 #include <pthread.h>
 #include <iostream>
+#include <mutex>
 
 #include <string>
 #include <utility>
@@ -47,6 +48,7 @@ bool CallStack::ReadVirtualThreadMemory(UnwindInfo &unwindInfoPtr, const ADDR_TY
         return true;
     }
 
+    // the maps of a process are unwound by one thread, the shared symbols files lock their lazy loading
     if (unwindInfoPtr.thread.ReadRoMemory(vaddr, reinterpret_cast<uint8_t*>(data), sizeof(ADDR_TYPE))) {
         unwindInfoPtr.callStack.lastPid_ = unwindInfoPtr.thread.pid_;
         unwindInfoPtr.callStack.lastAddr_ = vaddr;
@@ -358,6 +360,7 @@ int CallStack::FindUnwindTable(const uintptr_t pc, UnwindTableInfo& outTableInfo
         if (map != nullptr) {
             SymbolsFile *symbolsFile = unwindInfoPtr->thread.FindSymbolsFileByMap(map);
             if (symbolsFile != nullptr) {
+                std::lock_guard<std::mutex> lock(symbolsFile->loadMutex_);
                 return FillUnwindTable(symbolsFile, map, unwindInfoPtr, pc, outTableInfo);
             } else {
                 HLOGD("no symbols file found for thread %d:%s", unwindInfoPtr->thread.tid_,
@@ -245,35 +245,57 @@ void CallStackProcessor::UnwindFromRecord(PerfRecordSample& recordSample)
     const auto startTime = steady_clock::now();
 #endif
     HLOGV("unwind record (time:%llu)", recordSample.data_.time);
-    // if we have userstack ?
-    if (recordSample.data_.stack_size > 0) {
-        pid_t serverPid = recordSample.GetUstackServerPid();
-        pid_t pid = static_cast<pid_t>(recordSample.data_.pid);
-        pid_t tid = static_cast<pid_t>(recordSample.data_.tid);
-        if (serverPid != pid) {
-            pid = tid = serverPid;
-        }
-        auto& thread = threadManager_.UpdateThread(pid, tid);
-        callstack_.UnwindCallStack(thread, recordSample.data_.user_abi == PERF_SAMPLE_REGS_ABI_32,
-                                   recordSample.data_.user_regs, recordSample.data_.reg_nr,
-                                   recordSample.data_.stack_data, recordSample.data_.dyn_size,
-                                   recordSample.callFrames_);
+    VirtualThread *thread = GetUnwindThread(recordSample);
+    if (thread != nullptr) {
+        UnwindUserStack(recordSample, *thread, callstack_, recordSample.callFrames_, recordSample.ips_);
 #ifdef HIPERF_DEBUG_TIME
         unwindCallStackTimes_ += duration_cast<microseconds>(steady_clock::now() - startTime);
 #endif
-        size_t oldSize = recordSample.callFrames_.size();
-        HLOGV("unwind %zu", recordSample.callFrames_.size());
-        callstack_.ExpandCallStack(thread.tid_, recordSample.callFrames_, callstackMergeLevel_);
-        HLOGV("expand %zu (+%zu)", recordSample.callFrames_.size(),
-              recordSample.callFrames_.size() - oldSize);
-
-        recordSample.ReplaceWithCallStack(oldSize);
     }
 
 #ifdef HIPERF_DEBUG_TIME
     unwindFromRecordTimes_ += duration_cast<microseconds>(steady_clock::now() - startTime);
 #endif
+#endif
+    FinishUnwind(recordSample);
+}
 
+#if defined(is_ohos) && is_ohos
+VirtualThread *CallStackProcessor::GetUnwindThread(PerfRecordSample& recordSample)
+{
+    // if we have userstack ?
+    if (recordSample.data_.stack_size == 0) {
+        return nullptr;
+    }
+    pid_t serverPid = recordSample.GetUstackServerPid();
+    pid_t pid = static_cast<pid_t>(recordSample.data_.pid);
+    pid_t tid = static_cast<pid_t>(recordSample.data_.tid);
+    if (serverPid != pid) {
+        pid = tid = serverPid;
+    }
+    return &threadManager_.UpdateThread(pid, tid);
+}
+
+void CallStackProcessor::UnwindUserStack(PerfRecordSample& recordSample, const VirtualThread& thread,
+                                         CallStack& callstack, std::vector<DfxFrame>& callFrames,
+                                         std::vector<u64>& ips) const
+{
+    callstack.UnwindCallStack(thread, recordSample.data_.user_abi == PERF_SAMPLE_REGS_ABI_32,
+                              recordSample.data_.user_regs, recordSample.data_.reg_nr,
+                              recordSample.data_.stack_data, recordSample.data_.dyn_size,
+                              callFrames);
+    size_t oldSize = callFrames.size();
+    HLOGV("unwind %zu", callFrames.size());
+    callstack.ExpandCallStack(thread.tid_, callFrames, callstackMergeLevel_);
+    HLOGV("expand %zu (+%zu)", callFrames.size(), callFrames.size() - oldSize);
+
+    recordSample.ReplaceWithCallStack(callFrames, ips, oldSize);
+}
+#endif
+
+void CallStackProcessor::FinishUnwind(PerfRecordSample& recordSample)
+{
+#if defined(is_ohos) && is_ohos
     NeedDropKernelCallChain(recordSample);
     // we will not do this in non record mode.
     if (dedupStack_ && recordCallBack_ != nullptr) {
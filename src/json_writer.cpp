@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define HILOG_TAG "Report"
+
+#include "json_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+
+#include "debug_logger.h"
+#include "hiperf_hilog.h"
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+namespace {
+constexpr unsigned char FIRST_PRINTABLE_CHAR = 0x20;
+constexpr unsigned char HEX_MASK = 0xf;
+constexpr unsigned int HEX_SHIFT = 4;
+constexpr const char *HEX_DIGITS = "0123456789abcdef";
+
+bool NeedEscape(const char c)
+{
+    return c == '"' || c == '\\' || static_cast<unsigned char>(c) < FIRST_PRINTABLE_CHAR;
+}
+} // namespace
+
+JsonWriter::JsonWriter(FILE *output, const size_t bufferSize)
+    : output_(output), buffer_(std::max(bufferSize, MAX_NUMBER_LENGTH))
+{
+}
+
+JsonWriter::~JsonWriter()
+{
+    Flush();
+}
+
+void JsonWriter::Write(const std::string_view &text)
+{
+    size_t written = 0;
+    while (written < text.size()) {
+        if (size_ == buffer_.size()) {
+            Flush();
+        }
+        size_t copySize = std::min(text.size() - written, buffer_.size() - size_);
+        std::copy_n(text.data() + written, copySize, buffer_.data() + size_);
+        size_ += copySize;
+        written += copySize;
+    }
+}
+
+void JsonWriter::WriteString(const std::string_view &str)
+{
+    Write('"');
+    size_t begin = 0;
+    for (size_t i = 0; i < str.size(); i++) {
+        if (!NeedEscape(str[i])) {
+            continue;
+        }
+        // the chars before are copied at once
+        Write(str.substr(begin, i - begin));
+        begin = i + 1;
+        Write('\\');
+        switch (str[i]) {
+            case '"':
+            case '\\':
+                Write(str[i]);
+                break;
+            case '\n':
+                Write('n');
+                break;
+            case '\r':
+                Write('r');
+                break;
+            case '\t':
+                Write('t');
+                break;
+            default: {
+                unsigned char c = static_cast<unsigned char>(str[i]);
+                Write("u00");
+                Write(HEX_DIGITS[c >> HEX_SHIFT]);
+                Write(HEX_DIGITS[c & HEX_MASK]);
+                break;
+            }
+        }
+    }
+    Write(str.substr(begin));
+    Write('"');
+}
+
+bool JsonWriter::Flush()
+{
+    if (output_ == nullptr) {
+        size_ = 0;
+        return false;
+    }
+    if (size_ > 0) {
+        if (fwrite(buffer_.data(), 1, size_, output_) != size_) {
+            HLOGE("write json failed, errno:%d", errno);
+            failed_ = true;
+        }
+        size_ = 0;
+    }
+    if (fflush(output_) != 0) {
+        failed_ = true;
+    }
+    return !failed_;
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
@@ -127,6 +127,8 @@ void KernelSymbolLoader::UpdateDevhostSymbols()
             }
             HLOGD("Load %zu symbols to %s", it.second->GetSymbols().size(),
                   it.second->filePath_.c_str());
+            // added in the order of kallsyms
+            it.second->IndexSymbols();
             registerFunc_(std::move(it.second));
         }
     } else {
@@ -29,6 +29,7 @@
 #include "subcommand_list.h"
 #include "subcommand_record.h"
 #include "subcommand_stat.h"
+#include "subcommand_top.h"
 #endif
 #include "subcommand_dump.h"
 #include "subcommand_report.h"
@@ -53,6 +54,7 @@ void RegisterCommandComponent()
     RegisterSubCommandStat();
     SubCommandList::RegisterSubCommandList();
     SubCommandRecord::RegisterSubCommandRecord();
+    SubCommandTop::RegisterSubCommandTop();
 #endif
 
     SubCommandDump::RegisterSubCommandDump();
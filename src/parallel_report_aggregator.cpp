@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define HILOG_TAG "ParallelReport"
+
+#include "parallel_report_aggregator.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "dfx_symbol.h"
+#include "hiperf_hilog.h"
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+ParallelReportAggregator::ParallelReportAggregator(Report &report, const size_t threadCount,
+                                                   const bool includeCallStack)
+    : report_(report),
+      threadCount_(std::clamp<size_t>(threadCount, 1, MAX_THREAD_COUNT)),
+      includeCallStack_(includeCallStack)
+{
+}
+
+ParallelReportAggregator::~ParallelReportAggregator()
+{
+    Stop();
+}
+
+size_t ParallelReportAggregator::GetDefaultThreadCount()
+{
+    return std::clamp<size_t>(std::thread::hardware_concurrency(), 1, DEFAULT_THREAD_COUNT);
+}
+
+bool ParallelReportAggregator::Start()
+{
+    CHECK_TRUE(shards_.empty(), false, 1, "parallel report has been started");
+    CHECK_TRUE(!report_.configs_.empty(), false, 1, "no event config for parallel report");
+    for (size_t i = 0; i < threadCount_; i++) {
+        auto &shard = shards_.emplace_back(std::make_unique<Shard>());
+        shard->report = std::make_unique<Report>(report_.option_);
+        // the shard report has the same configs, so its items can be merged by index
+        for (const auto &config : report_.configs_) {
+            auto &shardConfig = shard->report->configs_.emplace_back(config.eventName_, config.type_,
+                                                                     config.config_, config.coutMode_);
+            shardConfig.ids_ = config.ids_;
+        }
+        shard->report->configIdIndexMaps_ = report_.configIdIndexMaps_;
+        shard->batch.reserve(BATCH_SIZE);
+    }
+    for (auto &shard : shards_) {
+        shard->thread = std::thread(&ParallelReportAggregator::AggregateLoop, this, std::ref(*shard));
+    }
+    callerThread_ = std::this_thread::get_id();
+    HLOGD("aggregate report by %zu threads", threadCount_);
+    return true;
+}
+
+void ParallelReportAggregator::AddSample(const PerfRecordSample &sample, const std::string &comm)
+{
+    auto it = comms_.find(sample.data_.tid);
+    if (it == comms_.end() || it->second != comm) {
+        it = comms_.insert_or_assign(sample.data_.tid, HiviewDFX::StringViewHold::Get().Hold(comm)).first;
+    }
+    Shard &shard = *shards_[static_cast<size_t>(sample.data_.pid) % threadCount_];
+    SampleTask &task = shard.batch.emplace_back();
+    task.pid = static_cast<pid_t>(sample.data_.pid);
+    task.tid = static_cast<pid_t>(sample.data_.tid);
+    task.id = sample.data_.id;
+    task.period = sample.data_.period;
+    task.comm = it->second;
+    // PerfRecordSample::callFrames_ is thread_local, sample has been unwound and symbolized into the one
+    // of this thread. it is cleared and rebuilt for the next sample, so its frames can be moved away
+    HLOG_ASSERT(std::this_thread::get_id() == callerThread_);
+    task.callFrames = std::move(PerfRecordSample::callFrames_);
+    PerfRecordSample::callFrames_.clear();
+    if (shard.batch.size() >= BATCH_SIZE) {
+        SubmitBatch(shard);
+    }
+}
+
+bool ParallelReportAggregator::Finish()
+{
+    CHECK_TRUE(!shards_.empty(), false, 1, "parallel report is not started");
+    Stop();
+    for (auto &shard : shards_) {
+        report_.MergeReport(*shard->report);
+    }
+    shards_.clear();
+    comms_.clear();
+    return true;
+}
+
+// wait if the worker is too slow, the pending samples keep their call frames in memory
+void ParallelReportAggregator::SubmitBatch(Shard &shard)
+{
+    {
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        shard.cv.wait(lock, [&shard] { return shard.pendingBatches.size() < MAX_PENDING_BATCHES; });
+        shard.pendingBatches.emplace_back(std::move(shard.batch));
+    }
+    shard.cv.notify_all();
+    shard.batch.clear();
+    shard.batch.reserve(BATCH_SIZE);
+}
+
+void ParallelReportAggregator::AggregateLoop(Shard &shard)
+{
+#if defined(is_ohos) && is_ohos
+    pthread_setname_np(pthread_self(), "report_worker");
+#endif
+    PerfRecordSample sample;
+    while (true) {
+        std::vector<SampleTask> batch;
+        {
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            shard.cv.wait(lock, [&shard] { return !shard.pendingBatches.empty() || shard.stop; });
+            if (shard.pendingBatches.empty()) {
+                break;
+            }
+            batch = std::move(shard.pendingBatches.front());
+            shard.pendingBatches.pop_front();
+        }
+        shard.cv.notify_all();
+        for (SampleTask &task : batch) {
+            sample.data_.pid = static_cast<u32>(task.pid);
+            sample.data_.tid = static_cast<u32>(task.tid);
+            sample.data_.id = task.id;
+            sample.data_.period = task.period;
+            std::swap(PerfRecordSample::callFrames_, task.callFrames);
+            shard.report->AddReportItem(sample, includeCallStack_, task.comm);
+        }
+    }
+    PerfRecordSample::callFrames_.clear();
+}
+
+void ParallelReportAggregator::Stop()
+{
+    for (auto &shard : shards_) {
+        if (!shard->batch.empty()) {
+            SubmitBatch(*shard);
+        }
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->stop = true;
+        }
+        shard->cv.notify_all();
+    }
+    for (auto &shard : shards_) {
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
+    }
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define HILOG_TAG "ParallelSymbolResolver"
+
+#include "parallel_symbol_resolver.h"
+
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+
+#include "hiperf_hilog.h"
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+namespace {
+constexpr int MAX_CPU_PERCENT = 100;
+} // namespace
+
+ParallelSymbolResolver::ParallelSymbolResolver(VirtualRuntime &virtualRuntime, const size_t threadCount)
+    : virtualRuntime_(virtualRuntime), threadCount_(std::clamp<size_t>(threadCount, 1, MAX_THREAD_COUNT))
+{
+}
+
+size_t ParallelSymbolResolver::GetThreadCountByCpuPercent(const int cpuPercent)
+{
+    size_t cpuCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    size_t percent = static_cast<size_t>(std::clamp(cpuPercent, 0, MAX_CPU_PERCENT));
+    return std::clamp<size_t>(cpuCount * percent / MAX_CPU_PERCENT, MIN_THREAD_COUNT, MAX_THREAD_COUNT);
+}
+
+void ParallelSymbolResolver::Resolve(const std::vector<Request> &requests)
+{
+    std::vector<Bucket> buckets;
+    Bucket unknown;
+    BuildBuckets(requests, buckets, unknown);
+    auto threadBuckets = AssignBuckets(buckets);
+
+    virtualRuntime_.SetSymbolConcurrent(true);
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadBuckets.size(); i++) {
+        if (threadBuckets[i].empty()) {
+            continue;
+        }
+        threads.emplace_back([this, &threadBuckets, i] {
+            for (const Bucket *bucket : threadBuckets[i]) {
+                ResolveBucket(*bucket);
+            }
+        });
+    }
+    for (const Bucket *bucket : threadBuckets[0]) {
+        ResolveBucket(*bucket);
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    virtualRuntime_.SetSymbolConcurrent(false);
+
+    // the symbols files of these are not known, they may be loaded while resolving
+    ResolveBucket(unknown);
+    HLOGD("resolve %zu addresses in %zu buckets by %zu threads, %zu unknown", requests.size(), buckets.size(),
+          threads.size() + 1, unknown.size());
+}
+
+void ParallelSymbolResolver::BuildBuckets(const std::vector<Request> &requests, std::vector<Bucket> &buckets,
+                                          Bucket &unknown)
+{
+    std::unordered_map<SymbolsFile *, Bucket> userBuckets;
+    Bucket kernelThreadBucket;
+    Bucket kernelBucket;
+    for (const Request &request : requests) {
+        // the threads are created here, the workers only read them
+        VirtualThread &thread = virtualRuntime_.GetThread(request.pid, request.pid);
+        if (request.context == PERF_CONTEXT_KERNEL) {
+            kernelBucket.emplace_back(request);
+            continue;
+        }
+        if (request.context != PERF_CONTEXT_USER) {
+            kernelThreadBucket.emplace_back(request);
+            continue;
+        }
+        int64_t mapIndex = thread.FindMapIndexByAddr(request.ip);
+        std::shared_ptr<DfxMap> map = mapIndex < 0 ? nullptr : thread.GetMaps()[mapIndex];
+        SymbolsFile *symbolsFile = map == nullptr ? nullptr : thread.FindSymbolsFileByMap(map);
+        if (symbolsFile == nullptr) {
+            unknown.emplace_back(request);
+            continue;
+        }
+        userBuckets[symbolsFile].emplace_back(request);
+    }
+    buckets.reserve(userBuckets.size() + 2);  // 2: kernel thread and kernel
+    for (auto &[symbolsFile, bucket] : userBuckets) {
+        buckets.emplace_back(std::move(bucket));
+    }
+    if (!kernelThreadBucket.empty()) {
+        buckets.emplace_back(std::move(kernelThreadBucket));
+    }
+    if (!kernelBucket.empty()) {
+        buckets.emplace_back(std::move(kernelBucket));
+    }
+}
+
+// the largest bucket goes to the least loaded thread first
+std::vector<std::vector<const ParallelSymbolResolver::Bucket *>> ParallelSymbolResolver::AssignBuckets(
+    std::vector<Bucket> &buckets) const
+{
+    std::sort(buckets.begin(), buckets.end(), [](const Bucket &a, const Bucket &b) {
+        return a.size() > b.size();
+    });
+    std::vector<std::vector<const Bucket *>> threadBuckets(threadCount_);
+    std::vector<size_t> threadLoads(threadCount_, 0);
+    for (const Bucket &bucket : buckets) {
+        size_t minThread = static_cast<size_t>(
+            std::min_element(threadLoads.begin(), threadLoads.end()) - threadLoads.begin());
+        threadBuckets[minThread].emplace_back(&bucket);
+        threadLoads[minThread] += bucket.size();
+    }
+    return threadBuckets;
+}
+
+void ParallelSymbolResolver::ResolveBucket(const Bucket &bucket)
+{
+    for (const Request &request : bucket) {
+        if (request.context == PERF_CONTEXT_KERNEL) {
+            virtualRuntime_.GetSymbol(request.ip, 0, 0, PERF_CONTEXT_KERNEL);
+        } else {
+            virtualRuntime_.GetSymbol(request.ip, request.pid, request.pid, request.context);
+        }
+    }
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
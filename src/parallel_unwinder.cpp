@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define HILOG_TAG "ParallelUnwinder"
+
+#include "parallel_unwinder.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "hiperf_hilog.h"
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+ParallelUnwinder::ParallelUnwinder(VirtualRuntime &virtualRuntime, const size_t threadCount)
+    : virtualRuntime_(virtualRuntime), threadCount_(std::clamp<size_t>(threadCount, 1, MAX_THREAD_COUNT))
+{
+#if defined(is_ohos) && is_ohos
+    for (size_t i = 0; i < threadCount_; i++) {
+        callStacks_.emplace_back(std::make_unique<CallStack>());
+    }
+    shards_.resize(threadCount_);
+#endif
+}
+
+void ParallelUnwinder::Unwind(const std::vector<PerfRecordSample *> &samples)
+{
+#if defined(is_ohos) && is_ohos
+    for (auto &shard : shards_) {
+        shard.clear();
+    }
+    // the threads are created before the workers start, the workers only read them
+    for (PerfRecordSample *sample : samples) {
+        const VirtualThread *thread = virtualRuntime_.GetUnwindThread(*sample);
+        if (thread != nullptr) {
+            UnwindTask &task = shards_[static_cast<size_t>(thread->pid_) % threadCount_].emplace_back();
+            task.sample = sample;
+            task.thread = thread;
+        }
+    }
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount_; i++) {
+        if (!shards_[i].empty()) {
+            threads.emplace_back(&ParallelUnwinder::UnwindShard, this, i);
+        }
+    }
+    UnwindShard(0);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    HLOGV("unwind %zu samples by %zu threads", samples.size(), threads.size() + 1);
+#endif
+    for (PerfRecordSample *sample : samples) {
+        virtualRuntime_.FinishUnwind(*sample);
+    }
+}
+
+#if defined(is_ohos) && is_ohos
+void ParallelUnwinder::UnwindShard(const size_t index)
+{
+    for (UnwindTask &task : shards_[index]) {
+        virtualRuntime_.UnwindUserStack(*task.sample, *task.thread, *callStacks_[index], task.callFrames, task.ips);
+    }
+}
+#endif
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
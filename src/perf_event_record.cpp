@@ -31,9 +31,9 @@ constexpr u64 GROUP_READ_VALUE_ID_STRIDE = 2;
 }
 
 bool PerfRecordSample::dumpRemoveStack_ = false;
-std::vector<u64> PerfRecordSample::ips_ = {};
-std::vector<DfxFrame> PerfRecordSample::callFrames_ = {};
-std::vector<pid_t> PerfRecordSample::serverPidMap_ = {};
+thread_local std::vector<u64> PerfRecordSample::ips_ = {};
+thread_local std::vector<DfxFrame> PerfRecordSample::callFrames_ = {};
+thread_local std::vector<pid_t> PerfRecordSample::serverPidMap_ = {};
 thread_local std::unordered_map<PerfRecordType, PerfEventRecord*> PerfEventRecordFactory::recordMap_ = {};
 
 using PerfRecordCreator = PerfEventRecord* (*)();
@@ -977,35 +977,41 @@ void PerfRecordSample::RecoverCallStack()
 }
 
 void PerfRecordSample::ReplaceWithCallStack(const size_t originalSize)
+{
+    ReplaceWithCallStack(callFrames_, ips_, originalSize);
+}
+
+void PerfRecordSample::ReplaceWithCallStack(const std::vector<DfxFrame> &callFrames, std::vector<u64> &ips,
+                                            const size_t originalSize)
 {
     // first we check if we have some user unwind stack need to merge ?
-    if (callFrames_.size() != 0) {
+    if (callFrames.size() != 0) {
         // when we have some kernel ips , we cp it first
         // new size is user call frames + kernel call frames
         // + PERF_CONTEXT_USER(last + 1) + expand mark(also PERF_CONTEXT_USER)
         const unsigned int perfContextSize = 2;
-        ips_.reserve(data_.nr + callFrames_.size() + perfContextSize);
+        ips.reserve(data_.nr + callFrames.size() + perfContextSize);
         if (data_.nr > 0) {
-            ips_.assign(data_.ips, data_.ips + data_.nr);
+            ips.assign(data_.ips, data_.ips + data_.nr);
         }
         // add user context mark
-        ips_.emplace_back(PERF_CONTEXT_USER);
+        ips.emplace_back(PERF_CONTEXT_USER);
         // we also need make a expand mark just for debug only
-        const size_t beginIpsSize = ips_.size();
-        bool ret = std::all_of(callFrames_.begin(), callFrames_.end(), [&](const DfxFrame &frame) {
-            ips_.emplace_back(frame.pc);
-            if (originalSize != 0 && (originalSize != callFrames_.size()) &&
-                ips_.size() == (originalSize + beginIpsSize)) {
+        const size_t beginIpsSize = ips.size();
+        bool ret = std::all_of(callFrames.begin(), callFrames.end(), [&](const DfxFrame &frame) {
+            ips.emplace_back(frame.pc);
+            if (originalSize != 0 && (originalSize != callFrames.size()) &&
+                ips.size() == (originalSize + beginIpsSize)) {
                 // just for debug
                 // so we can see which frame begin is expand call frames
-                ips_.emplace_back(PERF_CONTEXT_USER);
+                ips.emplace_back(PERF_CONTEXT_USER);
             }
             return true;
         });
         if (ret) {
-            HLOGV("combed %zu", callFrames_.size());
+            HLOGV("combed %zu", callFrames.size());
         } else {
-            HLOGV("failed to combed %zu", callFrames_.size());
+            HLOGV("failed to combed %zu", callFrames.size());
         }
 
         if (sampleType_ & PERF_SAMPLE_REGS_USER) {
@@ -1025,17 +1031,17 @@ void PerfRecordSample::ReplaceWithCallStack(const size_t originalSize)
         }
 
         if (sampleType_ & PERF_SAMPLE_CALLCHAIN) {
-            HLOGV("ips change from %llu -> %zu", data_.nr, ips_.size());
+            HLOGV("ips change from %llu -> %zu", data_.nr, ips.size());
 
             // 3. remove the nr size
             header_.size -= data_.nr * sizeof(u64);
 
             // 4. add new nr size
-            data_.nr = ips_.size();
+            data_.nr = ips.size();
             header_.size += data_.nr * sizeof(u64);
 
             // 5. change ips potin to our ips array and hold it.
-            data_.ips = ips_.data();
+            data_.ips = ips.data();
         }
     }
 }
@@ -1426,6 +1432,11 @@ void PerfRecordSwitchCpuWide::DumpData(const int indent) const
                  data_.next_prev_tid);
 }
 
+std::unique_ptr<PerfEventRecord> PerfEventRecordFactory::MakePerfEventRecord(PerfRecordType type)
+{
+    return std::unique_ptr<PerfEventRecord>(CreatePerfEventRecord(type));
+}
+
 void PerfEventRecordFactory::Cleanup()
 {
     for (auto &kv : recordMap_) {
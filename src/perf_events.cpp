@@ -22,6 +22,7 @@
 #include <iostream>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sys/eventfd.h>
 #include <sys/resource.h>
 #include <sys/syscall.h>
 #include <unistd.h>
@@ -31,6 +32,7 @@
 
 #include "debug_logger.h"
 #include "hiperf_hilog.h"
+#include "loser_tree.h"
 #include "register.h"
 #include "spe_decoder.h"
 #include "subcommand_dump.h"
@@ -48,6 +50,9 @@ static constexpr int32_t UPDATE_TIME_INTERVAL = 10;    // 10ms
 static constexpr uint64_t NANO_SECONDS_PER_SECOND = 1000000000;
 static constexpr uint32_t POLL_FAIL_COUNT_THRESHOLD = 10;
 static constexpr unsigned int MAX_WAKEUP_MARK = 1024 * 1024;
+// in PERF_RECORD_SAMPLE : header + u64 sample_id + u64 ip + u32 pid + u32 tid + u64 time
+static constexpr size_t SAMPLE_TIME_POS = sizeof(perf_event_header) + sizeof(uint64_t) + sizeof(uint64_t) +
+                                          sizeof(uint32_t) + sizeof(uint32_t);
 
 OHOS::UniqueFd PerfEvents::Open(perf_event_attr &attr, const pid_t pid, const int cpu, const int groupFd,
                                 const unsigned long flags)
@@ -534,6 +539,12 @@ void PerfEvents::SetEventAttr(EventItem &eventItem, const perf_type_id type, con
     if (eventItem.attr.wakeup_watermark > MAX_WAKEUP_MARK) {
         eventItem.attr.wakeup_watermark = MAX_WAKEUP_MARK;
     }
+    if (IsOverwriteBacktrack()) {
+        // the kernel keeps overwriting the oldest records, nothing is read until output.
+        // the wakeup can not be turned off, wake up once per whole mmap, and the fds are not polled.
+        eventItem.attr.write_backward = 1;
+        eventItem.attr.wakeup_watermark = mmapPages_ * pageSize_;
+    }
 
     // for a group of events, only enable comm/mmap on the first event
     if (!followGroup) {
@@ -687,10 +698,11 @@ bool PerfEvents::PrepareTracking(void)
 
 void PerfEvents::ReleaseCpuMmap()
 {
+    std::lock_guard<std::mutex> lock(mmapMutex_);
     for (auto it = cpuMmap_.begin(); it != cpuMmap_.end();) {
         const MmapFd &mmapItem = it->second;
         if (!isSpe_) {
-            if (munmap(mmapItem.mmapPage, (1 + mmapPages_) * pageSize_) == -1) {
+            if (munmap(mmapItem.mmapPage, (1 + mmapItem.mmapPages) * pageSize_) == -1) {
                 HLOGW("munmap failed.");
             }
         } else {
@@ -703,6 +715,8 @@ void PerfEvents::ReleaseCpuMmap()
         }
         it = cpuMmap_.erase(it);
     }
+    // the dummy events of the resized mmaps are closed after unmap
+    resizedMmapFds_.clear();
 }
 
 void PerfEvents::ExitReadRecordBufThread()
@@ -713,27 +727,41 @@ void PerfEvents::ExitReadRecordBufThread()
         }
     }
     if (readRecordBufThread_.joinable()) {
-        {
-            std::lock_guard<std::mutex> lk(mtxRrecordBuf_);
-            readRecordThreadRunning_ = false;
-            __sync_synchronize();
-            cvRecordBuf_.notify_one();
-        }
+        readRecordThreadRunning_ = false;
+        NotifyRecordBufReady();
         readRecordBufThread_.join();
     }
 }
 
 bool PerfEvents::PrepareRecordThread()
 {
+    recordBufEventFd_ = OHOS::UniqueFd(eventfd(0, EFD_CLOEXEC));
+    if (recordBufEventFd_ < 0) {
+        printf("create record buffer eventfd failed: %d\n", errno);
+        HIPERF_HILOGE(MODULE_DEFAULT, "create record buffer eventfd failed: %{public}d", errno);
+        return false;
+    }
+    flushMmaps_ = false;
+    newestReaderTime_ = 0;
+    mergeBlocked_ = false;
+    recordTickPending_ = false;
+    // backtrack keeps records in the record buffer for a long time, they can not stay in mmap
+    mmapZeroCopy_ = !backtrack_ && !isSpe_;
     try {
-        recordBuf_ = std::make_unique<RingBuffer>(CalcBufferSize());
+        if (mmapReaderCount_ > 0 && !isSpe_ && !backtrack_) {
+            CreateMmapReaders();
+        } else {
+            recordBuf_ = std::make_unique<RingBuffer>(CalcBufferSize());
+        }
     } catch (const std::exception &e) {
         printf("create record buffer(size %zu) failed: %s\n", CalcBufferSize(), e.what());
         HIPERF_HILOGI(MODULE_DEFAULT, "create record buffer failed: %{public}s", e.what());
+        mmapReaders_.clear();
         return false;
     }
     readRecordThreadRunning_ = true;
     readRecordBufThread_ = std::thread(&PerfEvents::ReadRecordFromBuf, this);
+    StartMmapReaders();
     if (backtrack_) {
         std::thread updateTimeThread(&PerfEvents::UpdateCurrentTime);
         updateTimeThread.detach();
@@ -761,6 +789,7 @@ void PerfEvents::WaitRecordThread()
     HIPERF_HILOGI(MODULE_DEFAULT, "Process and Saving data...");
     ExitReadRecordBufThread();
     recordBuf_.reset();
+    mmapReaders_.clear();
 
     const auto usedTimeMsTick = duration_cast<milliseconds>(steady_clock::now() - trackingEndTime_);
     if (verboseReport_) {
@@ -784,6 +813,7 @@ bool PerfEvents::SetupTrackingState()
     if (!CaptureSig()) {
         HLOGE("captureSig() failed");
         g_trackRunning.store(false);
+        StopMmapReaders();
         ExitReadRecordBufThread();
         return false;
     }
@@ -799,7 +829,14 @@ void PerfEvents::DisableTrackingStep()
     }
     if (recordCallBack_) {
         // 禁用事件后读取剩余样本
+        StopMmapReaders();
+        flushMmaps_ = true;
         ReadRecordsFromMmaps();
+        if (mmapZeroCopy_ || IsOverwriteBacktrack()) {
+            // records may be still used in place, or a pending output still reads the mmaps.
+            // wait for the consumer thread before unmap
+            ExitReadRecordBufThread();
+        }
         ReleaseCpuMmap();
     }
     trackingEndTime_ = steady_clock::now();
@@ -895,6 +932,13 @@ bool PerfEvents::OutputTracking()
     }
 
     outputEndTime_ = currentTimeSecond_.load();
+    if (IsOverwriteBacktrack()) {
+        // the consumer thread copies the records out of the mmaps before output, set before outputTracking_
+        snapshotPending_ = true;
+        outputTracking_ = true;
+        NotifyRecordBufReady();
+        return true;
+    }
     outputTracking_ = true;
     return true;
 }
@@ -1107,6 +1151,21 @@ void PerfEvents::SetMmapPages(const size_t mmapPages)
     mmapPages_ = mmapPages;
 }
 
+void PerfEvents::SetMmapReaders(const size_t mmapReaders)
+{
+    mmapReaderCount_ = mmapReaders;
+}
+
+void PerfEvents::SetReorderWindow(const uint64_t reorderWindowMs)
+{
+    reorderWindowNs_ = reorderWindowMs * NANO_SECONDS_PER_SECOND / THOUSANDS;
+}
+
+void PerfEvents::SetMmapAdaptive(const bool mmapAdaptive)
+{
+    mmapAdaptive_ = mmapAdaptive;
+}
+
 void PerfEvents::SetSampleStackType(const SampleStackType type)
 {
     sampleStackType_ = type;
@@ -1144,8 +1203,10 @@ bool PerfEvents::PerfEventsEnable(const bool enable)
 
 void PerfEvents::ReleaseRecordResources()
 {
+    StopMmapReaders();
     ExitReadRecordBufThread();
     recordBuf_.reset();
+    mmapReaders_.clear();
 
     ReleaseCpuMmap();
 
@@ -1156,7 +1217,6 @@ void PerfEvents::ReleaseRecordResources()
     prepared_ = false;
     readRecordThreadRunning_ = false;
     outputTracking_ = false;
-    recordBufReady_ = false;
 }
 
 void PerfEvents::SetHM(const bool isHM)
@@ -1179,6 +1239,11 @@ void PerfEvents::SetRecordCallBack(const RecordCallBack recordCallBack)
     recordCallBack_ = recordCallBack;
 }
 
+void PerfEvents::SetRecordTickCallBack(const RecordTickCallBack recordTickCallBack)
+{
+    recordTickCallBack_ = recordTickCallBack;
+}
+
 inline void PerfEvents::PutAllCpus()
 {
     int cpuConfigs = sysconf(_SC_NPROCESSORS_CONF);
@@ -1274,17 +1339,127 @@ int PerfEvents::HandleCreateFdOpenError(const EventItem &eventItem, size_t icpu,
     return 0; // jump to next cpu
 }
 
+// open the events of the group one by one, the leader must be opened before the others
+void PerfEvents::OpenGroupFds(EventGroupItem &eventGroupItem, const size_t icpu, const size_t ipid,
+                              std::vector<OpenedFd> &openedFds)
+{
+    openedFds.resize(eventGroupItem.eventItems.size());
+    int groupFd = -1;
+    for (size_t i = 0; i < eventGroupItem.eventItems.size(); i++) {
+        openedFds[i].fd = Open(eventGroupItem.eventItems[i].attr, pids_[ipid], cpus_[icpu], groupFd, 0);
+        if (openedFds[i].fd < 0) {
+            openedFds[i].err = errno;
+            // same as HandleCreateFdOpenError, only a gone pid goes on with the next event
+            if (openedFds[i].err != ESRCH) {
+                break;
+            }
+            continue;
+        }
+        if (groupFd == -1) {
+            groupFd = openedFds[i].fd.Get();
+        }
+    }
+}
+
+// each cpu and pid is a task, opened by a few threads, the result is in the order of tasks
+// the calling thread takes tasks too, return the count of the threads used
+template<typename Task>
+static size_t RunTasksInParallel(const size_t taskCount, const size_t minTasksPerThread, const size_t maxThreads,
+                                 const Task &runTask)
+{
+    const size_t threadCount = std::min({taskCount / minTasksPerThread, maxThreads,
+                                         static_cast<size_t>(std::thread::hardware_concurrency())});
+    std::atomic_size_t nextTask = 0;
+    auto runTasks = [&nextTask, &runTask, taskCount]() {
+        size_t task = 0;
+        while ((task = nextTask.fetch_add(1)) < taskCount) {
+            runTask(task);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; i++) {
+        try {
+            threads.emplace_back(runTasks);
+        } catch (const std::system_error &e) {
+            HLOGW("create worker thread failed: %s", e.what());
+            break;
+        }
+    }
+    runTasks();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    return threads.size() + 1;
+}
+
+void PerfEvents::OpenFdsInParallel(EventGroupItem &eventGroupItem, std::vector<std::vector<OpenedFd>> &openedFds)
+{
+    const size_t taskCount = pids_.size() * cpus_.size();
+    openedFds.clear();
+    openedFds.resize(taskCount);
+    size_t threadCount = RunTasksInParallel(taskCount, MIN_OPENS_PER_THREAD, MAX_OPEN_THREADS,
+        [this, &eventGroupItem, &openedFds](const size_t task) {
+            OpenGroupFds(eventGroupItem, task % cpus_.size(), task / cpus_.size(), openedFds[task]);
+        });
+    HLOGD("open %zu tasks with %zu threads", taskCount, threadCount);
+}
+
+// mmap allocates and locks all the pages of the ring buffer, it is slow for big buffers on many cpus.
+// map the buffer of each cpu in parallel with the fd which is going to own it, CreateMmap takes it later.
+void PerfEvents::MapCpuBuffersInParallel(const std::vector<std::vector<OpenedFd>> &openedFds)
+{
+    if (!recordCallBack_ || isSpe_) {
+        return;
+    }
+    // the owner is the first fd of the cpu in the order of CreateFdEvents
+    std::vector<std::pair<int, int>> owners; // cpu, fd
+    for (size_t icpu = 0; icpu < cpus_.size(); icpu++) {
+        if (cpuMmap_.count(cpus_[icpu]) != 0 || premappedBufs_.count(cpus_[icpu]) != 0) {
+            continue;
+        }
+        for (size_t ipid = 0; ipid < pids_.size(); ipid++) {
+            const std::vector<OpenedFd> &taskFds = openedFds[ipid * cpus_.size() + icpu];
+            if (!taskFds.empty() && taskFds[0].fd >= 0) {
+                owners.emplace_back(cpus_[icpu], taskFds[0].fd.Get());
+                break;
+            }
+        }
+    }
+    const int prot = IsOverwriteBacktrack() ? PROT_READ : (PROT_READ | PROT_WRITE);
+    std::vector<void *> bufs(owners.size(), MMAP_FAILED);
+    size_t threadCount = RunTasksInParallel(owners.size(), MIN_MMAPS_PER_THREAD, MAX_OPEN_THREADS,
+        [this, &owners, &bufs, prot](const size_t task) {
+            bufs[task] = mmap(nullptr, (1 + mmapPages_) * pageSize_, prot, MAP_SHARED, owners[task].second, 0);
+        });
+    for (size_t i = 0; i < owners.size(); i++) {
+        // a failed one is mapped again by CreateMmap, which reports the error
+        if (bufs[i] != MMAP_FAILED) {
+            premappedBufs_[owners[i].first] = {owners[i].second, bufs[i]};
+        }
+    }
+    HLOGD("map %zu cpu buffers with %zu threads", owners.size(), threadCount);
+}
+
+void PerfEvents::ReleasePremappedBuffers()
+{
+    for (const auto &[cpu, premapped] : premappedBufs_) {
+        if (munmap(premapped.second, (1 + mmapPages_) * pageSize_) == -1) {
+            HLOGW("munmap the buffer of cpu %d failed.", cpu);
+        }
+    }
+    premappedBufs_.clear();
+}
+
 int PerfEvents::CreateFdEventsForEachPid(EventItem &eventItem, const size_t icpu, const size_t ipid,
-                                         uint &fdNumber, int &groupFdCache)
+                                         OpenedFd &openedFd, uint &fdNumber, int &groupFdCache)
 {
-    UniqueFd fd = Open(eventItem.attr, pids_[ipid], cpus_[icpu], groupFdCache, 0);
-    // clang-format on
-    if (fd < 0) {
+    if (openedFd.fd < 0) {
+        errno = openedFd.err;
         return HandleCreateFdOpenError(eventItem, icpu, ipid);
     }
     // after open successed , fill the result and make a new FdItem
     FdItem &fdItem = eventItem.fdItems.emplace_back();
-    fdItem.fd = std::move(fd);
+    fdItem.fd = std::move(openedFd.fd);
     fdItem.cpu = cpus_[icpu];
     fdItem.pid = pids_[ipid];
     fdNumber++;
@@ -1361,15 +1536,22 @@ bool PerfEvents::CreateFdEvents(void)
             }
         }
 
+        // perf_event_open is slow with many threads or events, open them in parallel first,
+        // then fill the fd items and create the mmaps in the same order as before
+        std::vector<std::vector<OpenedFd>> openedFds;
+        OpenFdsInParallel(eventGroupItem, openedFds);
+        MapCpuBuffersInParallel(openedFds);
         for (size_t ipid = 0; ipid < pids_.size(); ipid++) { // each pid
             for (size_t icpu = 0; icpu < cpus_.size(); icpu++) {     // each cpu
-                for (auto &eventItem : eventGroupItem.eventItems) {
+                std::vector<OpenedFd> &taskFds = openedFds[ipid * cpus_.size() + icpu];
+                for (size_t i = 0; i < eventGroupItem.eventItems.size(); i++) {
                     // one fd event group must match same cpu and same pid config (event can be
                     // different)
                     // clang-format off
-                    int ret = CreateFdEventsForEachPid(eventItem, icpu, ipid,
+                    int ret = CreateFdEventsForEachPid(eventGroupItem.eventItems[i], icpu, ipid, taskFds[i],
                                                        fdNumber, groupFdCache[icpu][ipid]);
                     if (ret == -1) {
+                        ReleasePremappedBuffers();
                         return false;
                     } else if (ret == 0) {
                         break;
@@ -1379,6 +1561,8 @@ bool PerfEvents::CreateFdEvents(void)
             eventNumber++;
         }
     }
+    // the owner failed to be filled, its cpu is mapped by another fd
+    ReleasePremappedBuffers();
 
     CHECK_TRUE(fdNumber != 0, false, 1, "open %d fd for %d events", fdNumber, eventNumber);
 
@@ -1489,8 +1673,16 @@ bool PerfEvents::CreateMmap(const FdItem &item, const perf_event_attr &attr)
 {
     auto it = cpuMmap_.find(item.cpu);
     if (it == cpuMmap_.end()) {
-        void *rbuf = mmap(nullptr, (1 + mmapPages_) * pageSize_, PROT_READ | PROT_WRITE, MAP_SHARED,
-                          item.fd.Get(), 0);
+        void *rbuf = MMAP_FAILED;
+        auto premapped = premappedBufs_.find(item.cpu);
+        if (premapped != premappedBufs_.end() && premapped->second.first == item.fd.Get()) {
+            rbuf = premapped->second.second;
+            premappedBufs_.erase(premapped);
+        } else {
+            // a read only mapping makes the kernel overwrite the old records instead of stopping
+            int prot = IsOverwriteBacktrack() ? PROT_READ : (PROT_READ | PROT_WRITE);
+            rbuf = mmap(nullptr, (1 + mmapPages_) * pageSize_, prot, MAP_SHARED, item.fd.Get(), 0);
+        }
         if (rbuf == MMAP_FAILED) {
             char errInfo[ERRINFOLEN] = {0};
             strerror_r(errno, errInfo, ERRINFOLEN);
@@ -1505,6 +1697,7 @@ bool PerfEvents::CreateMmap(const FdItem &item, const perf_event_attr &attr)
         mmapItem.mmapPage = reinterpret_cast<perf_event_mmap_page *>(rbuf);
         mmapItem.buf = reinterpret_cast<uint8_t *>(rbuf) + pageSize_;
         mmapItem.bufSize = mmapPages_ * pageSize_;
+        mmapItem.mmapPages = mmapPages_;
         mmapItem.attr = &attr;
         mmapItem.posCallChain = GetCallChainPosInSampleRecord(attr);
 
@@ -1547,6 +1740,221 @@ std::vector<AttrWithId> PerfEvents::GetAttrWithId() const
     return result;
 }
 
+size_t PerfEvents::GetAdaptiveMinPages() const
+{
+    return std::max<size_t>(mmapPages_ / ADAPTIVE_MMAP_TIMES, 1);
+}
+
+// double the pages of the hot cpus with the pages taken from the cold cpus,
+// the sum of all the cpus never grows over cpu count * mmapPages_
+std::map<int, size_t> PerfEvents::PlanMmapPages() const
+{
+    const size_t minPages = GetAdaptiveMinPages();
+    const size_t maxPages = mmapPages_ * ADAPTIVE_MMAP_TIMES;
+    size_t freePages = cpuMmap_.size() * mmapPages_;
+    std::map<int, size_t> plan;
+    std::vector<int> hotCpus;
+    for (const auto &[cpu, mmapItem] : cpuMmap_) {
+        plan[cpu] = mmapItem.mmapPages;
+        freePages -= std::min(freePages, mmapItem.mmapPages);
+        if (mmapItem.mmapPages < maxPages && (mmapItem.lostInPeriod > 0 ||
+            mmapItem.peakDataSize * HUNDREDS > mmapItem.bufSize * HOT_MMAP_FILL_PERCENT)) {
+            hotCpus.push_back(cpu);
+        }
+    }
+    // the cpu lost the most records goes first
+    std::sort(hotCpus.begin(), hotCpus.end(), [this](const int left, const int right) {
+        const MmapFd &l = cpuMmap_.at(left);
+        const MmapFd &r = cpuMmap_.at(right);
+        if (l.lostInPeriod != r.lostInPeriod) {
+            return l.lostInPeriod > r.lostInPeriod;
+        }
+        return l.peakDataSize > r.peakDataSize;
+    });
+    auto isCold = [this, &plan, minPages](const int cpu) {
+        const MmapFd &mmapItem = cpuMmap_.at(cpu);
+        return mmapItem.lostInPeriod == 0 && plan[cpu] > minPages &&
+               mmapItem.peakDataSize * COLD_MMAP_FILL_DIVISOR < plan[cpu] * pageSize_;
+    };
+
+    for (const int cpu : hotCpus) {
+        const std::map<int, size_t> lastPlan = plan;
+        const size_t lastFreePages = freePages;
+        const size_t needPages = plan[cpu];
+        while (freePages < needPages) {
+            // halve the biggest cold one each time
+            auto coldIt = plan.end();
+            for (auto it = plan.begin(); it != plan.end(); it++) {
+                if (isCold(it->first) && (coldIt == plan.end() || it->second > coldIt->second)) {
+                    coldIt = it;
+                }
+            }
+            if (coldIt == plan.end()) {
+                break;
+            }
+            coldIt->second /= 2; // 2: pages must be a power of two
+            freePages += coldIt->second;
+        }
+        if (freePages < needPages) {
+            // not enough cold pages, do not shrink any one for it
+            plan = lastPlan;
+            freePages = lastFreePages;
+            continue;
+        }
+        freePages -= needPages;
+        plan[cpu] += needPages;
+    }
+    return plan;
+}
+
+// the records written after the last reading can not be read any more, count them as lost
+void PerfEvents::CountUnreadRecords(MmapFd &mmapItem)
+{
+    const uint64_t head = __atomic_load_n(&mmapItem.mmapPage->data_head, __ATOMIC_ACQUIRE);
+    uint64_t pos = mmapItem.readPos;
+    perf_event_header header;
+    while (pos + sizeof(header) <= head) {
+        GetRecordFieldFromMmap(mmapItem, &header, pos, sizeof(header));
+        if (header.size < sizeof(header)) {
+            break;
+        }
+        if (header.type == PERF_RECORD_SAMPLE) {
+            lostSamples_++;
+        } else if (header.type == PERF_RECORD_LOST) {
+            constexpr size_t lostPos = sizeof(perf_event_header) + sizeof(uint64_t);
+            uint64_t lost = 0;
+            GetRecordFieldFromMmap(mmapItem, &lost, pos + lostPos, sizeof(lost));
+            lostSamples_ += lost;
+        } else {
+            lostNonSamples_++;
+        }
+        pos += header.size;
+    }
+}
+
+// the kernel can not map a buffer of another size to the same event, so the new buffer is mapped
+// to a dummy event of the cpu first, and the old one is kept if it fails.
+// then the events are redirected to the new buffer and the old one is read out before unmap.
+// the event owning the old buffer can only be redirected after unmap, its records in between are lost.
+// the wakeup watermark is taken from the dummy event, so each buffer has its own.
+bool PerfEvents::ResizeCpuMmap(const int cpu, MmapFd &mmapItem, const size_t pages)
+{
+    pid_t pid = -1;
+    int ownerFd = -1;
+    std::vector<int> redirectFds;
+    for (auto &eventGroupItem : eventGroupItem_) {
+        for (auto &eventItem : eventGroupItem.eventItems) {
+            for (auto &fdItem : eventItem.fdItems) {
+                if (fdItem.cpu != cpu) {
+                    continue;
+                }
+                pid = fdItem.pid;
+                if (fdItem.fd.Get() == mmapItem.fd) {
+                    ownerFd = fdItem.fd.Get();
+                } else {
+                    redirectFds.push_back(fdItem.fd.Get());
+                }
+            }
+        }
+    }
+    perf_event_attr attr = {};
+    attr.size = sizeof(perf_event_attr);
+    attr.type = PERF_TYPE_SOFTWARE;
+    attr.config = PERF_COUNT_SW_DUMMY;
+    attr.disabled = 1;
+    attr.watermark = 1;
+    attr.wakeup_watermark = std::min<size_t>((pages * pageSize_) >> 1, MAX_WAKEUP_MARK);
+    // same as the events, or the kernel refuses to redirect them
+    attr.use_clockid = mmapItem.attr->use_clockid;
+    attr.clockid = mmapItem.attr->clockid;
+    attr.exclude_kernel = mmapItem.attr->exclude_kernel;
+    attr.exclude_user = mmapItem.attr->exclude_user;
+    OHOS::UniqueFd fd = Open(attr, pid, cpu, -1, 0);
+    if (fd < 0) {
+        HLOGW("open dummy event for cpu %d failed, keep %zu pages", cpu, mmapItem.mmapPages);
+        return false;
+    }
+    void *rbuf = mmap(nullptr, (1 + pages) * pageSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd.Get(), 0);
+    if (rbuf == MMAP_FAILED) {
+        HLOGEP("mmap %zu pages for cpu %d failed, keep %zu pages", pages, cpu, mmapItem.mmapPages);
+        return false;
+    }
+    for (const int redirectFd : redirectFds) {
+        if (ioctl(redirectFd, PERF_EVENT_IOC_SET_OUTPUT, fd.Get()) != 0) {
+            HLOGEP("ioctl PERF_EVENT_IOC_SET_OUTPUT (%d -> %d) ", redirectFd, fd.Get());
+        }
+    }
+
+    // only the owner writes the old buffer now, read it out through the normal path
+    flushMmaps_ = true;
+    ReadRecordsFromMmaps();
+    flushMmaps_ = false;
+    CountUnreadRecords(mmapItem);
+    if (munmap(mmapItem.mmapPage, (1 + mmapItem.mmapPages) * pageSize_) == -1) {
+        HLOGEP("munmap mmap of cpu %d failed", cpu);
+    }
+    if (ownerFd >= 0 && ioctl(ownerFd, PERF_EVENT_IOC_SET_OUTPUT, fd.Get()) != 0) {
+        HLOGEP("ioctl PERF_EVENT_IOC_SET_OUTPUT (%d -> %d) ", ownerFd, fd.Get());
+    }
+    for (auto &pollFd : pollFds_) {
+        if (pollFd.fd == mmapItem.fd) {
+            pollFd.fd = fd.Get();
+        }
+    }
+    mmapItem.fd = fd.Get();
+    mmapItem.mmapPage = reinterpret_cast<perf_event_mmap_page *>(rbuf);
+    mmapItem.buf = reinterpret_cast<uint8_t *>(rbuf) + pageSize_;
+    mmapItem.bufSize = pages * pageSize_;
+    mmapItem.mmapPages = pages;
+    mmapItem.readPos = 0;
+    mmapItem.dataSize = 0;
+    mmapItem.lastDataHead = 0;
+    // the dummy event of the last resizing is closed, its buffer has been unmapped
+    resizedMmapFds_[cpu] = std::move(fd);
+    HLOGD("resize mmap of cpu %d to %zu pages", cpu, pages);
+    return true;
+}
+
+void PerfEvents::AdaptMmapPages()
+{
+    std::map<int, size_t> plan = PlanMmapPages();
+    std::vector<int> resizeCpus;
+    for (const auto &[cpu, mmapItem] : cpuMmap_) {
+        if (plan[cpu] != mmapItem.mmapPages) {
+            resizeCpus.push_back(cpu);
+        }
+    }
+    if (!resizeCpus.empty()) {
+        // the records in place must be released before unmap, copy the others out from now on
+        const bool zeroCopy = mmapZeroCopy_;
+        mmapZeroCopy_ = false;
+        for (const int cpu : resizeCpus) {
+            const MmapFd &mmapItem = cpuMmap_[cpu];
+            int waitMs = 0;
+            while (__atomic_load_n(&mmapItem.refsInFlight, __ATOMIC_ACQUIRE) != 0 && waitMs++ < MAX_WAIT_REFS_MS) {
+                std::this_thread::sleep_for(milliseconds(1));
+            }
+        }
+        // shrink first, the locked pages never exceed the budget
+        std::stable_sort(resizeCpus.begin(), resizeCpus.end(), [this, &plan](const int left, const int right) {
+            return plan[left] < cpuMmap_[left].mmapPages && plan[right] >= cpuMmap_[right].mmapPages;
+        });
+        for (const int cpu : resizeCpus) {
+            MmapFd &mmapItem = cpuMmap_[cpu];
+            if (__atomic_load_n(&mmapItem.refsInFlight, __ATOMIC_ACQUIRE) != 0) {
+                HLOGD("mmap of cpu %d is still in use, resize it later", cpu);
+                continue;
+            }
+            ResizeCpuMmap(cpu, mmapItem, plan[cpu]);
+        }
+        mmapZeroCopy_ = zeroCopy;
+    }
+    for (auto &it : cpuMmap_) {
+        it.second.lostInPeriod = 0;
+        it.second.peakDataSize = 0;
+    }
+}
+
 #ifdef CONFIG_HAS_CCM
 void PerfEvents::GetBufferSizeCfg(size_t &maxBufferSize, size_t &minBufferSize)
 {
@@ -1621,105 +2029,396 @@ inline bool PerfEvents::IsRecordInMmap(const int timeout)
     return true;
 }
 
-static bool CompareRecordTime(const PerfEvents::MmapFd *left, const PerfEvents::MmapFd *right)
+// data_tail is moved by both the reading thread and the consumer thread in zero copy mode, never move it back
+static void AdvanceDataTail(PerfEvents::MmapFd &mmap, const uint64_t pos)
 {
-    return left->timestamp > right->timestamp;
+    uint64_t tail = __atomic_load_n(&mmap.mmapPage->data_tail, __ATOMIC_ACQUIRE);
+    while (tail < pos) {
+        if (__atomic_compare_exchange_n(&mmap.mmapPage->data_tail, &tail, pos, false, __ATOMIC_SEQ_CST,
+                                        __ATOMIC_ACQUIRE)) {
+            break;
+        }
+    }
 }
 
-void PerfEvents::GetRecords(bool &enableFlag)
+void PerfEvents::MoveOneRecordToBuf(RingBuffer &recordBuf, MmapFd &mmap, bool &enableFlag)
 {
-    if (MmapRecordHeap_.size() > 1) {
-        for (const auto &it : MmapRecordHeap_) {
-            GetRecordFromMmap(*it);
-        }
-        std::make_heap(MmapRecordHeap_.begin(), MmapRecordHeap_.end(), CompareRecordTime);
+    bool auxEvent = false;
+    u32 pid = 0;
+    u32 tid = 0;
+    u64 auxOffset = 0;
+    u64 auxSize = 0;
+    MoveRecordToBuf(recordBuf, mmap, auxEvent, auxOffset, auxSize, pid, tid);
+    if (isSpe_ && auxEvent) {
+        ReadRecordsFromSpeMmaps(mmap, auxOffset, auxSize, pid, tid);
+        enableFlag = true;
+    }
+}
 
-        size_t heapSize = MmapRecordHeap_.size();
-        while (heapSize > 1) {
-            std::pop_heap(MmapRecordHeap_.begin(), MmapRecordHeap_.begin() + heapSize,
-                          CompareRecordTime);
-            bool auxEvent = false;
-            u32 pid = 0;
-            u32 tid = 0;
-            u64 auxOffset = 0;
-            u64 auxSize = 0;
-            MoveRecordToBuf(*MmapRecordHeap_[heapSize - 1], auxEvent, auxOffset, auxSize, pid, tid);
-            if (isSpe_ && auxEvent) {
-                ReadRecordsFromSpeMmaps(*MmapRecordHeap_[heapSize - 1], auxOffset, auxSize, pid, tid);
-                enableFlag = true;
-            }
-            if (GetRecordFromMmap(*MmapRecordHeap_[heapSize - 1])) {
-                std::push_heap(MmapRecordHeap_.begin(), MmapRecordHeap_.begin() + heapSize,
-                               CompareRecordTime);
-            } else {
-                heapSize--;
-            }
+// keep the records in the reorder window of the newest one read, unless no more records come
+bool PerfEvents::IsReorderNeeded(const std::vector<MmapFd *> &recordHeap)
+{
+    if (reorderWindowNs_ == 0 || flushMmaps_.load()) {
+        return false;
+    }
+    bool hasNewData = false;
+    for (MmapFd *mmap : recordHeap) {
+        // do not keep records in a mmap which is going to be full
+        if (mmap->dataSize > mmap->bufSize / 2) {
+            return false;
         }
+        hasNewData = hasNewData || mmap->hasNewData;
+    }
+    // nothing is written since the last reading, the records kept can not be reordered any more
+    return hasNewData;
+}
+
+// return the time of the newest sample moved to the record buffer
+uint64_t PerfEvents::GetRecords(std::vector<MmapFd *> &recordHeap, RingBuffer &recordBuf, bool &enableFlag)
+{
+    // the newest time is tracked while reading, the watermark moves forward with it
+    uint64_t newestReadTime = 0;
+    for (const auto &it : recordHeap) {
+        GetRecordFromMmap(*it);
+        newestReadTime = std::max(newestReadTime, it->timestamp);
     }
-    while (GetRecordFromMmap(*MmapRecordHeap_.front())) {
-        bool auxEvent = false;
-        u32 pid = 0;
-        u32 tid = 0;
-        u64 auxOffset = 0;
-        u64 auxSize = 0;
-        MoveRecordToBuf(*MmapRecordHeap_.front(), auxEvent, auxOffset, auxSize, pid, tid);
-        if (isSpe_ && auxEvent) {
-            ReadRecordsFromSpeMmaps(*MmapRecordHeap_.front(), auxOffset, auxSize, pid, tid);
-            enableFlag = true;
+    const bool reorder = IsReorderNeeded(recordHeap);
+    auto getWatermark = [this, reorder, &newestReadTime]() {
+        if (!reorder) {
+            return std::numeric_limits<uint64_t>::max();
+        }
+        return newestReadTime > reorderWindowNs_ ? newestReadTime - reorderWindowNs_ : 0;
+    };
+    const size_t count = recordHeap.size();
+    auto compareTime = [&recordHeap](const size_t left, const size_t right) {
+        return recordHeap[left]->timestamp < recordHeap[right]->timestamp;
+    };
+    LoserTree<decltype(compareTime)> tree(compareTime);
+    tree.Build(count);
+
+    uint64_t newestTime = 0;
+    size_t winner = 0;
+    while ((winner = tree.Top()) != count) {
+        MmapFd &mmap = *recordHeap[winner];
+        const uint64_t watermark = getWatermark();
+        if (mmap.timestamp > watermark) {
+            // the winner is the oldest one, all the others are newer than watermark too
+            break;
         }
+        // move a batch from the winner, until it is newer than the next winner
+        size_t runnerUp = tree.RunnerUp(winner);
+        uint64_t batchEnd = (runnerUp == count) ? watermark : std::min(watermark, recordHeap[runnerUp]->timestamp);
+        bool hasRecord = false;
+        do {
+            newestTime = std::max(newestTime, mmap.timestamp);
+            MoveOneRecordToBuf(recordBuf, mmap, enableFlag);
+            hasRecord = GetRecordFromMmap(mmap);
+            newestReadTime = std::max(newestReadTime, mmap.timestamp);
+        } while (hasRecord && mmap.timestamp <= batchEnd);
+        if (hasRecord) {
+            tree.Replay(winner);
+        } else {
+            tree.Exhaust(winner);
+        }
+    }
+    return newestTime;
+}
+
+static void PushReadableMmap(PerfEvents::MmapFd &mmap, std::vector<PerfEvents::MmapFd *> &recordHeap)
+{
+    // release the space of records copied while some records were still used in place
+    if (__atomic_load_n(&mmap.refsInFlight, __ATOMIC_ACQUIRE) == 0) {
+        AdvanceDataTail(mmap, mmap.readPos);
     }
+    const uint64_t dataHead = mmap.mmapPage->data_head;
+    __sync_synchronize(); // this same as rmb in gcc, after reading mmapPage->data_head
+    mmap.hasNewData = dataHead != mmap.lastDataHead;
+    mmap.lastDataHead = dataHead;
+    ssize_t dataSize = dataHead - mmap.readPos;
+    if (dataSize <= 0) {
+        return;
+    }
+    mmap.dataSize = dataSize;
+    mmap.peakDataSize = std::max(mmap.peakDataSize, mmap.dataSize);
+    recordHeap.push_back(&mmap);
 }
 
 void PerfEvents::ReadRecordsFromMmaps()
 {
+    if (IsOverwriteBacktrack()) {
+        // records stay in the overwrite mmaps until the consumer thread takes a snapshot for output
+        return;
+    }
+    if (!mmapReaders_.empty()) {
+        // reader threads have been stopped, read the data left over in each group
+        for (auto &reader : mmapReaders_) {
+            ReadRecordsFromReaderMmaps(*reader);
+        }
+        return;
+    }
 #ifdef HIPERF_DEBUG_TIME
     const auto readKenelStartTime = steady_clock::now();
 #endif
     // get readable mmap at this time
     for (auto &it : cpuMmap_) {
-        ssize_t dataSize = it.second.mmapPage->data_head - it.second.mmapPage->data_tail;
-        __sync_synchronize(); // this same as rmb in gcc, after reading mmapPage->data_head
-        if (dataSize <= 0) {
-            continue;
-        }
-        it.second.dataSize = dataSize;
-        MmapRecordHeap_.push_back(&(it.second));
+        PushReadableMmap(it.second, MmapRecordHeap_);
     }
     if (MmapRecordHeap_.empty()) {
         return;
     }
     bool enableFlag = false;
-    GetRecords(enableFlag);
+    GetRecords(MmapRecordHeap_, *recordBuf_, enableFlag);
     if (isSpe_ && enableFlag) {
         PerfEventsEnable(false);
         PerfEventsEnable(true);
     }
     MmapRecordHeap_.clear();
-    {
-        std::lock_guard<std::mutex> lk(mtxRrecordBuf_);
-        recordBufReady_ = true;
-    }
-    cvRecordBuf_.notify_one();
+    CommitRecordBuf(*recordBuf_);
 #ifdef HIPERF_DEBUG_TIME
     recordKernelReadTime_ += duration_cast<milliseconds>(steady_clock::now() - readKenelStartTime);
 #endif
 }
 
+// the kernel writes backward from data_head, so data_head is the newest record.
+// walk to data_head of the last snapshot, stop at the record cut by the newer ones if the kernel has wrapped.
+void PerfEvents::CollectBackwardRecords(MmapFd &mmap, std::vector<uint64_t> &positions)
+{
+    const uint64_t head = __atomic_load_n(&mmap.mmapPage->data_head, __ATOMIC_ACQUIRE);
+    const uint64_t newSize = mmap.lastDataHead - head;
+    if (newSize > mmap.bufSize) {
+        HLOGD("cpu %d: %" PRIu64 " bytes are overwritten since the last snapshot", mmap.cpu, newSize - mmap.bufSize);
+    }
+    const uint64_t limit = std::min<uint64_t>(newSize, mmap.bufSize);
+    uint64_t offset = 0;
+    perf_event_header header;
+    while (offset + sizeof(header) <= limit) {
+        GetRecordFieldFromMmap(mmap, &header, head + offset, sizeof(header));
+        if (header.size < sizeof(header) || offset + header.size > limit) {
+            break;
+        }
+        positions.push_back(head + offset);
+        offset += header.size;
+    }
+    mmap.lastDataHead = head;
+    // oldest first
+    std::reverse(positions.begin(), positions.end());
+}
+
+// only called by the consumer thread when output, the records in the backtrack time are copied to
+// the record buffer, which is processed in between if the snapshot is larger than it.
+void PerfEvents::ReadBacktrackSnapshot(const perf_event_attr *attr)
+{
+    std::lock_guard<std::mutex> lock(mmapMutex_);
+    CHECK_TRUE(recordBuf_ != nullptr, NO_RETVAL, 1, "record buffer is not ready");
+    std::vector<MmapFd *> mmaps;
+    std::vector<std::vector<uint64_t>> positions;
+    std::vector<MmapFd *> pausedMmaps;
+    for (auto &it : cpuMmap_) {
+        // the kernel must not write while the records are copied
+        if (ioctl(it.second.fd, PERF_EVENT_IOC_PAUSE_OUTPUT, 1) != 0) {
+            HLOGEP("ioctl PERF_EVENT_IOC_PAUSE_OUTPUT failed, cpu %d", it.first);
+            continue;
+        }
+        pausedMmaps.push_back(&it.second);
+        std::vector<uint64_t> mmapPositions;
+        CollectBackwardRecords(it.second, mmapPositions);
+        if (mmapPositions.empty()) {
+            continue;
+        }
+        mmaps.push_back(&it.second);
+        positions.push_back(std::move(mmapPositions));
+    }
+    HLOGD("backtrack snapshot from %zu mmaps", mmaps.size());
+
+    // merge the cpus in time order like GetRecords
+    std::vector<size_t> cursors(mmaps.size(), 0);
+    auto nextRecord = [&mmaps, &positions, &cursors, this](const size_t index) {
+        if (cursors[index] >= positions[index].size()) {
+            return false;
+        }
+        MmapFd &mmap = *mmaps[index];
+        mmap.readPos = positions[index][cursors[index]++];
+        mmap.dataSize = mmap.bufSize;
+        return GetRecordFromMmap(mmap);
+    };
+    for (size_t i = 0; i < mmaps.size(); i++) {
+        nextRecord(i);
+    }
+    const size_t count = mmaps.size();
+    auto compareTime = [&mmaps](const size_t left, const size_t right) {
+        return mmaps[left]->timestamp < mmaps[right]->timestamp;
+    };
+    LoserTree<decltype(compareTime)> tree(compareTime);
+    tree.Build(count);
+
+    bool enableFlag = false;
+    size_t winner = 0;
+    while ((winner = tree.Top()) != count) {
+        MmapFd &mmap = *mmaps[winner];
+        // non-sample records have no time, keep them for the symbols
+        uint64_t timeSecond = mmap.timestamp / NANO_SECONDS_PER_SECOND;
+        if (mmap.timestamp == 0 ||
+            (timeSecond <= outputEndTime_ && outputEndTime_ - timeSecond <= backtrackTime_)) {
+            if (recordBuf_->GetFreeSize() <= BUFFER_CRITICAL_LEVEL + mmap.header.size) {
+                // this thread is the consumer, make room by processing the records copied
+                recordBuf_->CommitWrite();
+                ReadRecordsFromBuffers(attr);
+                CommitReadRecordBufs();
+            }
+            MoveOneRecordToBuf(*recordBuf_, mmap, enableFlag);
+        }
+        if (nextRecord(winner)) {
+            tree.Replay(winner);
+        } else {
+            tree.Exhaust(winner);
+        }
+    }
+
+    for (MmapFd *mmap : pausedMmaps) {
+        if (ioctl(mmap->fd, PERF_EVENT_IOC_PAUSE_OUTPUT, 0) != 0) {
+            HLOGEP("ioctl PERF_EVENT_IOC_PAUSE_OUTPUT resume failed, cpu %d", mmap->cpu);
+        }
+    }
+    recordBuf_->CommitWrite();
+}
+
+void PerfEvents::CreateMmapReaders()
+{
+    size_t readerCount = std::min(mmapReaderCount_, cpuMmap_.size());
+    if (readerCount == 0) {
+        return;
+    }
+    size_t bufferSize = std::max(CalcBufferSize() / readerCount, MIN_READER_BUFFER_SIZE);
+    for (size_t i = 0; i < readerCount; i++) {
+        auto reader = std::make_unique<MmapReader>();
+        reader->index = i;
+        reader->recordBuf = std::make_unique<RingBuffer>(bufferSize);
+        mmapReaders_.emplace_back(std::move(reader));
+    }
+    // split cpus into contiguous groups, neighbouring cpus usually share the same cluster
+    size_t index = 0;
+    for (auto &it : cpuMmap_) {
+        MmapReader &reader = *mmapReaders_[index * readerCount / cpuMmap_.size()];
+        reader.cpus.push_back(it.first);
+        reader.mmaps.push_back(&(it.second));
+#if !is_mingw
+        reader.pollFds.emplace_back(pollfd {it.second.fd, POLLIN, 0});
+#endif
+        index++;
+    }
+    HLOGD("create %zu mmap readers for %zu cpus, buffer size %zu", readerCount, cpuMmap_.size(), bufferSize);
+}
+
+void PerfEvents::StartMmapReaders()
+{
+    if (mmapReaders_.empty()) {
+        return;
+    }
+    mmapReadersRunning_ = true;
+    for (auto &reader : mmapReaders_) {
+        reader->thread = std::thread(&PerfEvents::MmapReaderLoop, this, std::ref(*reader));
+    }
+}
+
+void PerfEvents::StopMmapReaders()
+{
+    mmapReadersRunning_ = false;
+    for (auto &reader : mmapReaders_) {
+        if (reader->thread.joinable()) {
+            reader->thread.join();
+        }
+    }
+}
+
+void PerfEvents::MmapReaderLoop(MmapReader &reader)
+{
+#if !is_mingw
+    // not bound to the sampled cpus, the reader would be sampled and disturb the workload there
+    std::string threadName = "hiperf_reader" + std::to_string(reader.index);
+    pthread_setname_np(pthread_self(), threadName.c_str());
+
+    while (mmapReadersRunning_.load()) {
+        // an idle reader still publishes its time in a short period, the others wait for it to merge.
+        // poll with no fd left just sleeps.
+        int ret = poll(reader.pollFds.data(), reader.pollFds.size(), READER_POLL_TIMEOUT_MS);
+        if (ret < 0) {
+            if (errno != EINTR) {
+                HLOGEP("mmap reader %zu poll failed", reader.index);
+                std::this_thread::sleep_for(milliseconds(READER_POLL_TIMEOUT_MS));
+            }
+            continue;
+        }
+        ReadRecordsFromReaderMmaps(reader);
+        if (ret > 0) {
+            RemoveHungUpFds(reader);
+        }
+    }
+#endif
+    HLOGD("mmap reader %zu exit", reader.index);
+}
+
+#if !is_mingw
+// the event fd is never readable again after POLLHUP/POLLERR, poll would return at once forever.
+// the records left in its mmap have been read just now.
+void PerfEvents::RemoveHungUpFds(MmapReader &reader)
+{
+    auto it = std::remove_if(reader.pollFds.begin(), reader.pollFds.end(), [&reader](const pollfd &pfd) {
+        if ((pfd.revents & (POLLHUP | POLLERR | POLLNVAL)) == 0) {
+            return false;
+        }
+        HLOGD("mmap reader %zu remove fd %d, revents 0x%x", reader.index, pfd.fd, pfd.revents);
+        return true;
+    });
+    reader.pollFds.erase(it, reader.pollFds.end());
+}
+#endif
+
+void PerfEvents::ReadRecordsFromReaderMmaps(MmapReader &reader)
+{
+    // the records written after this point are newer than any record committed before it
+    const uint64_t committedTime = newestReaderTime_.load(std::memory_order_acquire);
+    for (MmapFd *mmap : reader.mmaps) {
+        PushReadableMmap(*mmap, reader.recordHeap);
+    }
+    uint64_t publishTime = committedTime;
+    if (!reader.recordHeap.empty()) {
+        bool enableFlag = false;
+        uint64_t newestTime = GetRecords(reader.recordHeap, *reader.recordBuf, enableFlag);
+        for (MmapFd *mmap : reader.recordHeap) {
+            if (mmap->dataSize > 0) {
+                // kept in the reorder window, only the records moved out are known to be complete
+                publishTime = 0;
+                break;
+            }
+        }
+        publishTime = std::max(publishTime, newestTime);
+        reader.recordHeap.clear();
+        CommitRecordBuf(*reader.recordBuf);
+        uint64_t expected = newestReaderTime_.load(std::memory_order_relaxed);
+        while (expected < newestTime &&
+               !newestReaderTime_.compare_exchange_weak(expected, newestTime, std::memory_order_release)) {
+        }
+    }
+    if (publishTime > reader.publishedTime.load(std::memory_order_relaxed)) {
+        reader.publishedTime.store(publishTime, std::memory_order_release);
+        if (mergeBlocked_.exchange(false)) {
+            NotifyRecordBufReady();
+        }
+    }
+}
+
 bool PerfEvents::GetRecordFromMmap(MmapFd &mmap)
 {
     if (mmap.dataSize <= 0) {
         return false;
     }
 
-    GetRecordFieldFromMmap(mmap, &(mmap.header), mmap.mmapPage->data_tail, sizeof(mmap.header));
+    GetRecordFieldFromMmap(mmap, &(mmap.header), mmap.readPos, sizeof(mmap.header));
     if (mmap.header.type != PERF_RECORD_SAMPLE) {
         mmap.timestamp = 0;
         return true;
     }
-    // in PERF_RECORD_SAMPLE : header + u64 sample_id + u64 ip + u32 pid + u32 tid + u64 time
-    constexpr size_t timePos = sizeof(perf_event_header) + sizeof(uint64_t) + sizeof(uint64_t) +
-                               sizeof(uint32_t) + sizeof(uint32_t);
-    GetRecordFieldFromMmap(mmap, &(mmap.timestamp), mmap.mmapPage->data_tail + timePos,
+    GetRecordFieldFromMmap(mmap, &(mmap.timestamp), mmap.readPos + SAMPLE_TIME_POS,
                            sizeof(mmap.timestamp));
     return true;
 }
@@ -1761,7 +2460,7 @@ size_t PerfEvents::GetSampleReadSizeInSampleRecord(MmapFd &mmap, size_t pos)
     uint64_t format = mmap.attr->read_format;
     if (format & PERF_FORMAT_GROUP) {
         uint64_t nr = 0;
-        GetRecordFieldFromMmap(mmap, &nr, mmap.mmapPage->data_tail + pos, sizeof(nr));
+        GetRecordFieldFromMmap(mmap, &nr, mmap.readPos + pos, sizeof(nr));
         if (format & PERF_FORMAT_TOTAL_TIME_ENABLED) {
             readSize += sizeof(uint64_t);
         }
@@ -1793,22 +2492,22 @@ size_t PerfEvents::GetStackSizePosInSampleRecord(MmapFd &mmap)
     pos += GetSampleReadSizeInSampleRecord(mmap, pos);
     if (mmap.attr->sample_type & PERF_SAMPLE_CALLCHAIN) {
         uint64_t nr = 0;
-        GetRecordFieldFromMmap(mmap, &nr, mmap.mmapPage->data_tail + pos, sizeof(nr));
+        GetRecordFieldFromMmap(mmap, &nr, mmap.readPos + pos, sizeof(nr));
         pos += (sizeof(nr) + nr * sizeof(uint64_t));
     }
     if (mmap.attr->sample_type & PERF_SAMPLE_RAW) {
         uint32_t raw_size = 0;
-        GetRecordFieldFromMmap(mmap, &raw_size, mmap.mmapPage->data_tail + pos, sizeof(raw_size));
+        GetRecordFieldFromMmap(mmap, &raw_size, mmap.readPos + pos, sizeof(raw_size));
         pos += (sizeof(raw_size) + raw_size);
     }
     if (mmap.attr->sample_type & PERF_SAMPLE_BRANCH_STACK) {
         uint64_t bnr = 0;
-        GetRecordFieldFromMmap(mmap, &bnr, mmap.mmapPage->data_tail + pos, sizeof(bnr));
+        GetRecordFieldFromMmap(mmap, &bnr, mmap.readPos + pos, sizeof(bnr));
         pos += (sizeof(bnr) + bnr * sizeof(PerfBranchEntry));
     }
     if (mmap.attr->sample_type & PERF_SAMPLE_REGS_USER) {
         uint64_t user_abi = 0;
-        GetRecordFieldFromMmap(mmap, &user_abi, mmap.mmapPage->data_tail + pos, sizeof(user_abi));
+        GetRecordFieldFromMmap(mmap, &user_abi, mmap.readPos + pos, sizeof(user_abi));
         pos += sizeof(user_abi);
         if (user_abi > 0) {
             uint64_t reg_nr = __builtin_popcountll(mmap.attr->sample_regs_user);
@@ -1817,41 +2516,48 @@ size_t PerfEvents::GetStackSizePosInSampleRecord(MmapFd &mmap)
     }
     if (mmap.attr->sample_type & PERF_SAMPLE_SERVER_PID) {
         uint64_t server_nr = 0;
-        GetRecordFieldFromMmap(mmap, &server_nr, mmap.mmapPage->data_tail + pos, sizeof(server_nr));
+        GetRecordFieldFromMmap(mmap, &server_nr, mmap.readPos + pos, sizeof(server_nr));
         pos += (sizeof(server_nr) + server_nr * sizeof(uint64_t));
     }
     return pos;
 }
 
-bool PerfEvents::CutStackAndMove(MmapFd &mmap)
+bool PerfEvents::GetCutStackSize(MmapFd &mmap, size_t &stackSizePos, uint64_t &stackSize, uint64_t &newStackSize)
 {
     constexpr uint32_t alignSize = 64;
     if (!(mmap.attr->sample_type & PERF_SAMPLE_STACK_USER)) {
         return false;
     }
-    size_t stackSizePos = GetStackSizePosInSampleRecord(mmap);
-    uint64_t stackSize = 0;
-    GetRecordFieldFromMmap(mmap, &stackSize, mmap.mmapPage->data_tail + stackSizePos,
-                           sizeof(stackSize));
+    stackSizePos = GetStackSizePosInSampleRecord(mmap);
+    GetRecordFieldFromMmap(mmap, &stackSize, mmap.readPos + stackSizePos, sizeof(stackSize));
     if (stackSize == 0) {
         return false;
     }
     size_t dynSizePos = stackSizePos + sizeof(uint64_t) + stackSize;
     uint64_t dynSize = 0;
-    GetRecordFieldFromMmap(mmap, &dynSize, mmap.mmapPage->data_tail + dynSizePos, sizeof(dynSize));
-    uint64_t newStackSize = std::min((dynSize + alignSize - 1) &
-                                     (~(alignSize >= 1 ? alignSize - 1 : 0)), stackSize);
-    if (newStackSize >= stackSize) {
+    GetRecordFieldFromMmap(mmap, &dynSize, mmap.readPos + dynSizePos, sizeof(dynSize));
+    newStackSize = std::min((dynSize + alignSize - 1) &
+                            (~(alignSize >= 1 ? alignSize - 1 : 0)), stackSize);
+    return newStackSize < stackSize;
+}
+
+bool PerfEvents::CutStackAndMove(RingBuffer &recordBuf, MmapFd &mmap)
+{
+    size_t stackSizePos = 0;
+    uint64_t stackSize = 0;
+    uint64_t newStackSize = 0;
+    if (!GetCutStackSize(mmap, stackSizePos, stackSize, newStackSize)) {
         return false;
     }
-    HLOGM("stackSize %" PRIx64 " dynSize %" PRIx64 " newStackSize %" PRIx64 "\n", stackSize, dynSize, newStackSize);
+    size_t dynSizePos = stackSizePos + sizeof(uint64_t) + stackSize;
+    HLOGM("stackSize %" PRIx64 " newStackSize %" PRIx64 "\n", stackSize, newStackSize);
     // move and cut stack_data
     // mmap: |<+++copy1+++>|<++++++copy2++++++>|<---------------cut--------------->|<+++copy3+++>|
     //             ^                    ^                        ^                 ^
     //         new_header          stackSizePos         <stackSize-dynSize>     dynSizePos
     uint16_t recordSize = mmap.header.size;
     mmap.header.size -= stackSize - newStackSize; // reduce the stack size
-    uint8_t *buf = recordBuf_->AllocForWrite(mmap.header.size);
+    uint8_t *buf = recordBuf.AllocForWrite(mmap.header.size);
     // copy1: new_header
     CHECK_TRUE(buf != nullptr, false, 0, "");
     if (memcpy_s(buf, sizeof(perf_event_header), &(mmap.header), sizeof(perf_event_header)) != 0) {
@@ -1860,40 +2566,112 @@ bool PerfEvents::CutStackAndMove(MmapFd &mmap)
     size_t copyPos = sizeof(perf_event_header);
     size_t copySize = stackSizePos - sizeof(perf_event_header) + sizeof(stackSize) + newStackSize;
     // copy2: copy stack_size, data[stack_size],
-    GetRecordFieldFromMmap(mmap, buf + copyPos, mmap.mmapPage->data_tail + copyPos, copySize);
+    GetRecordFieldFromMmap(mmap, buf + copyPos, mmap.readPos + copyPos, copySize);
     copyPos += copySize;
     // copy3: copy dyn_size
-    GetRecordFieldFromMmap(mmap, buf + copyPos, mmap.mmapPage->data_tail + dynSizePos,
+    GetRecordFieldFromMmap(mmap, buf + copyPos, mmap.readPos + dynSizePos,
                            recordSize - dynSizePos);
     // update stack_size
     if (memcpy_s(buf + stackSizePos, sizeof(stackSize), &(newStackSize), sizeof(newStackSize)) != 0) {
         HLOGEP("memcpy_s newStack to buf stackSizePos failed. size %zd", sizeof(newStackSize));
     }
-    recordBuf_->EndWrite();
-    __sync_synchronize();
-    mmap.mmapPage->data_tail += recordSize;
-    mmap.dataSize -= recordSize;
+    recordBuf.EndWrite();
+    ConsumeMmapRecord(mmap, recordSize);
+    return true;
+}
+
+void PerfEvents::ConsumeMmapRecord(MmapFd &mmap, const size_t size)
+{
+    mmap.readPos += size;
+    mmap.dataSize -= size;
+    if (IsOverwriteBacktrack()) {
+        // data_tail is not used by the kernel in overwrite mode, and the mmap is read only
+        return;
+    }
+    // records in front of it may be still used by the consumer thread
+    if (__atomic_load_n(&mmap.refsInFlight, __ATOMIC_ACQUIRE) == 0) {
+        AdvanceDataTail(mmap, mmap.readPos);
+    }
+}
+
+bool PerfEvents::MoveRecordRefToBuf(RingBuffer &recordBuf, MmapFd &mmap)
+{
+    if (!mmapZeroCopy_) {
+        return false;
+    }
+    if (mmap.readPos % mmap.bufSize + mmap.header.size > mmap.bufSize) {
+        // the record wraps at the end of mmap, copy it
+        return false;
+    }
+    // do not hold more than half of the mmap, otherwise the kernel drops samples when the consumer is slow
+    if (mmap.readPos + mmap.header.size - mmap.mmapPage->data_tail > mmap.bufSize / 2) {
+        return false;
+    }
+    MmapRecordRef ref;
+    ref.header = {PERF_RECORD_MMAP_REF, 0, sizeof(MmapRecordRef)};
+    ref.mmap = &mmap;
+    ref.pos = mmap.readPos;
+    ref.endPos = mmap.readPos + mmap.header.size;
+    ref.timestamp = mmap.timestamp;
+    ref.newStackSize = NO_STACK_CUT;
+    size_t stackSizePos = 0;
+    uint64_t stackSize = 0;
+    uint64_t newStackSize = 0;
+    if (GetCutStackSize(mmap, stackSizePos, stackSize, newStackSize)) {
+        if (newStackSize == 0) {
+            // the whole user stack is dropped, leave it to CutStackAndMove
+            return false;
+        }
+        ref.newStackSize = newStackSize;
+    }
+    uint8_t *buf = recordBuf.AllocForWrite(sizeof(MmapRecordRef));
+    if (buf == nullptr) {
+        return false;
+    }
+    if (memcpy_s(buf, sizeof(MmapRecordRef), &ref, sizeof(MmapRecordRef)) != 0) {
+        HLOGEP("memcpy_s record ref to buf failed. size %zd", sizeof(MmapRecordRef));
+    }
+    __atomic_fetch_add(&mmap.refsInFlight, 1, __ATOMIC_ACQ_REL);
+    recordBuf.EndWrite();
+    mmap.readPos += mmap.header.size;
+    mmap.dataSize -= mmap.header.size;
     return true;
 }
 
-void PerfEvents::MoveRecordToBuf(MmapFd &mmap, bool &isAuxEvent, u64 &auxOffset, u64 &auxSize, u32 &pid, u32 &tid)
+uint8_t *PerfEvents::GetRecordFromRef(const uint8_t *data, MmapRecordRef &ref)
+{
+    if (memcpy_s(&ref, sizeof(MmapRecordRef), data, sizeof(MmapRecordRef)) != 0) {
+        HLOGEP("memcpy_s record ref failed. size %zd", sizeof(MmapRecordRef));
+    }
+    return ref.mmap->buf + ref.pos % ref.mmap->bufSize;
+}
+
+void PerfEvents::ReleaseRecordRef(const MmapRecordRef &ref)
+{
+    AdvanceDataTail(*ref.mmap, ref.endPos);
+    __atomic_fetch_sub(&ref.mmap->refsInFlight, 1, __ATOMIC_ACQ_REL);
+}
+
+void PerfEvents::MoveRecordToBuf(RingBuffer &recordBuf, MmapFd &mmap, bool &isAuxEvent, u64 &auxOffset,
+                                 u64 &auxSize, u32 &pid, u32 &tid)
 {
     uint8_t *buf = nullptr;
     if (mmap.header.type == PERF_RECORD_SAMPLE) {
-        if (recordBuf_->GetFreeSize() <= BUFFER_CRITICAL_LEVEL) {
+        if (recordBuf.GetFreeSize() <= BUFFER_CRITICAL_LEVEL) {
             lostSamples_++;
             HLOGD("BUFFER_CRITICAL_LEVEL: lost sample record");
             goto RETURN;
         }
-        if (CutStackAndMove(mmap)) {
+        if (MoveRecordRefToBuf(recordBuf, mmap) || CutStackAndMove(recordBuf, mmap)) {
             return;
         }
     } else if (mmap.header.type == PERF_RECORD_LOST) {
         // in PERF_RECORD_LOST : header + u64 id + u64 lost
         constexpr size_t lostPos = sizeof(perf_event_header) + sizeof(uint64_t);
         uint64_t lost = 0;
-        GetRecordFieldFromMmap(mmap, &lost, mmap.mmapPage->data_tail + lostPos, sizeof(lost));
+        GetRecordFieldFromMmap(mmap, &lost, mmap.readPos + lostPos, sizeof(lost));
         lostSamples_ += lost;
+        mmap.lostInPeriod += lost;
         HLOGD("PERF_RECORD_LOST: lost sample record");
         goto RETURN;
     }
@@ -1904,48 +2682,93 @@ void PerfEvents::MoveRecordToBuf(MmapFd &mmap, bool &isAuxEvent, u64 &auxOffset,
         uint64_t auxSizePos = sizeof(perf_event_header) + sizeof(uint64_t);
         uint64_t pidPos = auxSizePos + sizeof(uint64_t) * 2; // 2 : offset
         uint64_t tidPos = pidPos + sizeof(uint32_t);
-        GetRecordFieldFromMmap(mmap, &auxOffset, mmap.mmapPage->data_tail + auxOffsetPos, sizeof(auxOffset));
-        GetRecordFieldFromMmap(mmap, &auxSize, mmap.mmapPage->data_tail + auxSizePos, sizeof(auxSize));
-        GetRecordFieldFromMmap(mmap, &pid, mmap.mmapPage->data_tail + pidPos, sizeof(pid));
-        GetRecordFieldFromMmap(mmap, &tid, mmap.mmapPage->data_tail + tidPos, sizeof(tid));
+        GetRecordFieldFromMmap(mmap, &auxOffset, mmap.readPos + auxOffsetPos, sizeof(auxOffset));
+        GetRecordFieldFromMmap(mmap, &auxSize, mmap.readPos + auxSizePos, sizeof(auxSize));
+        GetRecordFieldFromMmap(mmap, &pid, mmap.readPos + pidPos, sizeof(pid));
+        GetRecordFieldFromMmap(mmap, &tid, mmap.readPos + tidPos, sizeof(tid));
     }
 
-    if ((buf = recordBuf_->AllocForWrite(mmap.header.size)) == nullptr) {
+    if ((buf = recordBuf.AllocForWrite(mmap.header.size)) == nullptr) {
         // this record type must be Non-Sample
         lostNonSamples_++;
         HLOGD("alloc buffer failed: lost non-sample record");
         goto RETURN;
     }
 
-    GetRecordFieldFromMmap(mmap, buf, mmap.mmapPage->data_tail, mmap.header.size);
-    recordBuf_->EndWrite();
+    GetRecordFieldFromMmap(mmap, buf, mmap.readPos, mmap.header.size);
+    recordBuf.EndWrite();
 RETURN:
-    __sync_synchronize();
-    mmap.mmapPage->data_tail += mmap.header.size;
-    mmap.dataSize -= mmap.header.size;
+    ConsumeMmapRecord(mmap, mmap.header.size);
 }
 
-inline void PerfEvents::WaitDataFromRingBuffer()
+// release the read space of all the record buffers, return true if all of them are empty
+bool PerfEvents::CommitReadRecordBufs()
 {
-    std::unique_lock<std::mutex> lock(mtxRrecordBuf_);
-    cvRecordBuf_.wait(lock, [this] {
-        if (recordBufReady_) {
-            recordBufReady_ = false;
-            return true;
+    if (mmapReaders_.empty()) {
+        return recordBuf_->CommitRead();
+    }
+    bool empty = true;
+    for (auto &reader : mmapReaders_) {
+        if (!reader->recordBuf->CommitRead()) {
+            empty = false;
         }
-        return !readRecordThreadRunning_;
-    });
+    }
+    return empty;
+}
+
+inline void PerfEvents::WaitDataFromRingBuffer()
+{
+    // backtrack keeps records in buffer, it is woken up by each reading instead
+    // the records newer than the merge watermark wait for the readers to publish a newer time
+    if (!CommitReadRecordBufs() && !backtrack_ && !mergeBlocked_.load()) {
+        return;
+    }
+    if (!readRecordThreadRunning_) {
+        return;
+    }
+    uint64_t count = 0;
+    if (read(recordBufEventFd_, &count, sizeof(count)) < 0 && errno != EINTR) {
+        HLOGEP("read record buffer eventfd failed");
+    }
 }
 
-inline bool PerfEvents::ProcessRecord(const perf_event_attr* attr, uint8_t* data)
+inline void PerfEvents::NotifyRecordBufReady()
 {
+    uint64_t count = 1;
+    if (write(recordBufEventFd_, &count, sizeof(count)) < 0) {
+        HLOGEP("write record buffer eventfd failed");
+    }
+}
+
+// only wake up the consumer thread when the buffer was empty
+inline void PerfEvents::CommitRecordBuf(RingBuffer &recordBuf)
+{
+    if (recordBuf.CommitWrite() || backtrack_) {
+        NotifyRecordBufReady();
+    }
+}
+
+inline bool PerfEvents::ProcessRecord(RingBuffer &recordBuf, const perf_event_attr* attr, uint8_t* data)
+{
+    MmapRecordRef ref;
+    bool isRef = reinterpret_cast<perf_event_header *>(data)->type == PERF_RECORD_MMAP_REF;
+    if (isRef) {
+        data = GetRecordFromRef(data, ref);
+    }
     uint32_t* type = reinterpret_cast<uint32_t *>(data);
 #ifdef HIPERF_DEBUG_TIME
     const auto readingStartTime_ = steady_clock::now();
 #endif
 #if !HIDEBUG_SKIP_CALLBACK
     PerfEventRecord& record = PerfEventRecordFactory::GetPerfEventRecord(*type, data, *attr);
-    if (backtrack_ && readRecordThreadRunning_ && record.GetType() == PERF_RECORD_SAMPLE) {
+    if (isRef && ref.newStackSize != NO_STACK_CUT && record.GetType() == PERF_RECORD_SAMPLE) {
+        // same as CutStackAndMove, dyn_size is not more than the new stack size
+        PerfRecordSample& sample = static_cast<PerfRecordSample&>(record);
+        sample.header_.size -= sample.data_.stack_size - ref.newStackSize;
+        sample.data_.stack_size = ref.newStackSize;
+    }
+    if (backtrack_ && !IsOverwriteBacktrack() && readRecordThreadRunning_ &&
+        record.GetType() == PERF_RECORD_SAMPLE) {
         const PerfRecordSample& sample = static_cast<const PerfRecordSample&>(record);
         if (IsSkipRecordForBacktrack(sample)) {
             return false;
@@ -1958,34 +2781,126 @@ inline bool PerfEvents::ProcessRecord(const perf_event_attr* attr, uint8_t* data
 #ifdef HIPERF_DEBUG_TIME
     recordCallBackTime_ += duration_cast<milliseconds>(steady_clock::now() - readingStartTime_);
 #endif
-    recordBuf_->EndRead();
+    if (isRef) {
+        ReleaseRecordRef(ref);
+    }
+    recordBuf.EndRead();
+    return true;
+}
+
+uint64_t PerfEvents::GetRecordTimeFromBuf(const uint8_t *data)
+{
+    const perf_event_header *header = reinterpret_cast<const perf_event_header *>(data);
+    if (header->type == PERF_RECORD_MMAP_REF) {
+        return reinterpret_cast<const MmapRecordRef *>(data)->timestamp;
+    }
+    if (header->type != PERF_RECORD_SAMPLE) {
+        return 0;
+    }
+    uint64_t timestamp = 0;
+    if (memcpy_s(&timestamp, sizeof(timestamp), data + SAMPLE_TIME_POS, sizeof(timestamp)) != 0) {
+        HLOGEP("memcpy_s sample time failed. size %zd", sizeof(timestamp));
+    }
+    return timestamp;
+}
+
+// a reader never commits a sample older than the time it published,
+// the records older than the minimum of all the readers are safe to output in order.
+uint64_t PerfEvents::GetMergeWatermark() const
+{
+    if (!readRecordThreadRunning_) {
+        // all the readers have stopped and flushed their mmaps
+        return std::numeric_limits<uint64_t>::max();
+    }
+    uint64_t watermark = std::numeric_limits<uint64_t>::max();
+    for (auto &reader : mmapReaders_) {
+        watermark = std::min(watermark, reader->publishedTime.load(std::memory_order_acquire));
+    }
+    return watermark;
+}
+
+bool PerfEvents::MergeRecordsFromReaders(const perf_event_attr* attr)
+{
+    // records in each reader buffer are in time order, always take the oldest head record
+    uint64_t watermark = GetMergeWatermark();
+    while (true) {
+        RingBuffer *oldestBuf = nullptr;
+        uint8_t *oldestData = nullptr;
+        uint64_t oldestTime = 0;
+        for (auto &reader : mmapReaders_) {
+            uint8_t *data = reader->recordBuf->GetReadData();
+            if (data == nullptr) {
+                continue;
+            }
+            uint64_t time = GetRecordTimeFromBuf(data);
+            if (oldestBuf == nullptr || time < oldestTime) {
+                oldestBuf = reader->recordBuf.get();
+                oldestData = data;
+                oldestTime = time;
+            }
+        }
+        if (oldestBuf == nullptr) {
+            return true;
+        }
+        if (oldestTime > watermark) {
+            // set before checking again, a reader publishing after that wakes up this thread
+            mergeBlocked_ = true;
+            uint64_t newWatermark = GetMergeWatermark();
+            if (newWatermark == watermark) {
+                return true;
+            }
+            mergeBlocked_ = false;
+            watermark = newWatermark;
+            continue;
+        }
+        if (!ProcessRecord(*oldestBuf, attr, oldestData)) {
+            return false;
+        }
+    }
+}
+
+bool PerfEvents::ReadRecordsFromBuffers(const perf_event_attr* attr)
+{
+    if (!mmapReaders_.empty()) {
+        return MergeRecordsFromReaders(attr);
+    }
+    uint8_t *p = nullptr;
+    while ((p = recordBuf_->GetReadData()) != nullptr) {
+        if (!ProcessRecord(*recordBuf_, attr, p)) {
+            return false;
+        }
+    }
     return true;
 }
 
 void PerfEvents::ReadRecordFromBuf()
 {
     const perf_event_attr *attr = GetDefaultAttr();
-    uint8_t *p = nullptr;
 
     while (readRecordThreadRunning_) {
         WaitDataFromRingBuffer();
         bool output = outputTracking_;
-        while ((p = recordBuf_->GetReadData()) != nullptr) {
-            if (!ProcessRecord(attr, p)) {
-                break;
-            }
+        if (output && snapshotPending_.exchange(false)) {
+            // the output is written by this thread, take the records from the mmaps here
+            ReadBacktrackSnapshot(attr);
         }
+        ReadRecordsFromBuffers(attr);
         if (backtrack_ && output) {
             outputTracking_ = false;
             outputEndTime_ = 0;
         }
+        if (recordTickPending_.exchange(false)) {
+            recordTickCallBack_();
+        }
     }
     HLOGD("exit because trackStoped");
 
-    // read the data left over in buffer
-    while ((p = recordBuf_->GetReadData()) != nullptr) {
-        ProcessRecord(attr, p);
+    if (snapshotPending_.exchange(false)) {
+        // the output requested just before stop, the mmaps are released after this thread exits
+        ReadBacktrackSnapshot(attr);
     }
+    // read the data left over in buffer
+    ReadRecordsFromBuffers(attr);
     HLOGD("read all records from buffer");
     PerfEventRecordFactory::Cleanup();
 }
@@ -2042,6 +2957,13 @@ void PerfEvents::RecordLoop()
             if (HaveTargetsExit(startTime)) {
                 break;
             }
+            if (IsMmapAdaptive()) {
+                AdaptMmapPages();
+            }
+            if (recordTickCallBack_) {
+                recordTickPending_ = true;
+                NotifyRecordBufReady();
+            }
             ++count;
         }
 
@@ -2054,7 +2976,11 @@ void PerfEvents::RecordLoop()
         }
 
         int timeLeft = duration_cast<milliseconds>(endTime - thisTime).count();
-        if (IsRecordInMmap(std::min(timeLeft, pollTimeOut_))) {
+        if (!mmapReaders_.empty() || IsOverwriteBacktrack()) {
+            // mmaps are read by reader threads or at output, only check the exit conditions here
+            int sleepMs = timeLeft > 0 ? std::min(timeLeft, pollTimeOut_) : pollTimeOut_;
+            std::this_thread::sleep_for(milliseconds(sleepMs));
+        } else if (IsRecordInMmap(std::min(timeLeft, pollTimeOut_))) {
             ReadRecordsFromMmaps();
         }
     }
@@ -14,6 +14,8 @@
  */
 #include "perf_file_format.h"
 
+#include <algorithm>
+
 #include "debug_logger.h"
 #include "hiperf_hilog.h"
 
@@ -28,6 +30,8 @@ static const std::vector<std::string> EXT_FEATURE_NAMES = {
     "hiperf_hm_devhost",
     "hiperf_stack_table",
     "hiperf_add_counter",
+    "hiperf_compressed_data",
+    "hiperf_record_index",
 };
 static const std::vector<std::string> FEATURE_NAMES = {
     "unknown_feature", "tracing_data", "build_id",     "hostname",     "osrelease",
@@ -460,6 +464,96 @@ void PerfFileSectionU64::GetValue(uint64_t &v) const
     v = value_;
 }
 
+void RecordIndexEntry::AddSample(const uint64_t time, const pid_t pid)
+{
+    minTime = std::min(minTime, time);
+    maxTime = std::max(maxTime, time);
+    if ((flags & FLAG_ALL_PIDS) != 0) {
+        return;
+    }
+    auto it = std::lower_bound(pids.begin(), pids.end(), pid);
+    if (it != pids.end() && *it == pid) {
+        return;
+    }
+    if (pids.size() >= MAX_PIDS) {
+        flags |= FLAG_ALL_PIDS;
+        pids.clear();
+        return;
+    }
+    pids.insert(it, pid);
+}
+
+bool RecordIndexEntry::MatchSample(const uint64_t startTime, const uint64_t endTime, const pid_t pid) const
+{
+    if (minTime > maxTime || maxTime < startTime || minTime > endTime) {
+        return false;
+    }
+    if (pid == -1 || (flags & FLAG_ALL_PIDS) != 0) {
+        return true;
+    }
+    return std::binary_search(pids.begin(), pids.end(), pid);
+}
+
+PerfFileSectionRecordIndex::PerfFileSectionRecordIndex(const FEATURE id, const char *buf, const size_t size)
+    : PerfFileSection(id)
+{
+    // offset, size, minTime, maxTime, flags and pid count
+    constexpr size_t minEntrySize = sizeof(uint64_t) * 4 + sizeof(uint32_t) * 2;
+    uint32_t entryCount = 0;
+    Init(buf, size);
+    CHECK_TRUE(Read(entryCount), NO_RETVAL, 0, "");
+    CHECK_TRUE(entryCount <= size / minEntrySize, NO_RETVAL, 1, "entryCount %u is not correct", entryCount);
+    entries_.reserve(entryCount);
+    for (uint32_t i = 0; i < entryCount; ++i) {
+        RecordIndexEntry entry;
+        uint32_t pidCount = 0;
+        if (!Read(entry.offset) || !Read(entry.size) || !Read(entry.minTime) || !Read(entry.maxTime) ||
+            !Read(entry.flags) || !Read(pidCount) || pidCount > RecordIndexEntry::MAX_PIDS) {
+            HLOGE("record index %u is not correct", i);
+            entries_.clear();
+            return;
+        }
+        for (uint32_t j = 0; j < pidCount; ++j) {
+            uint32_t pid = 0;
+            if (!Read(pid)) {
+                entries_.clear();
+                return;
+            }
+            entry.pids.emplace_back(static_cast<pid_t>(pid));
+        }
+        entries_.emplace_back(std::move(entry));
+    }
+}
+
+bool PerfFileSectionRecordIndex::GetBinary(char *buf, const size_t size)
+{
+    CHECK_TRUE(size >= GetSize(), false, 0, "");
+    Init(buf, size);
+    Write(static_cast<uint32_t>(entries_.size()));
+    for (const RecordIndexEntry &entry : entries_) {
+        Write(entry.offset);
+        Write(entry.size);
+        Write(entry.minTime);
+        Write(entry.maxTime);
+        Write(entry.flags);
+        Write(static_cast<uint32_t>(entry.pids.size()));
+        for (const pid_t pid : entry.pids) {
+            Write(static_cast<uint32_t>(pid));
+        }
+    }
+    return true;
+}
+
+size_t PerfFileSectionRecordIndex::GetSize()
+{
+    size_t size = sizeof(uint32_t);
+    for (const RecordIndexEntry &entry : entries_) {
+        size += sizeof(entry.offset) + sizeof(entry.size) + sizeof(entry.minTime) + sizeof(entry.maxTime);
+        size += sizeof(entry.flags) + sizeof(uint32_t) + entry.pids.size() * sizeof(uint32_t);
+    }
+    return size;
+}
+
 PerfFileSectionEventDesc::PerfFileSectionEventDesc(FEATURE id,
                                                    const std::vector<AttrWithId> &eventDesces)
     : PerfFileSection(id)
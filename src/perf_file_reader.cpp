@@ -14,11 +14,18 @@
  */
 #include "perf_file_reader.h"
 
+#include <algorithm>
+#include <atomic>
 #include <bitset>
 #include <cinttypes>
+#include <condition_variable>
 #include <cstdlib>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <thread>
 
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -36,8 +43,11 @@ constexpr char UNCOMPRESS_TMP_FILE[] = "/data/local/tmp/.perf.data";
 
 std::unique_ptr<PerfFileReader> PerfFileReader::Instance(const std::string &fileName)
 {
-    std::string resolvedPath = CanonicalizeSpecPath(fileName.c_str());
-    FILE *fp = fopen(resolvedPath.c_str(), "rb");
+    FILE *fp = stdin;
+    if (fileName != PIPE_OUTPUT_STDIO) {
+        std::string resolvedPath = CanonicalizeSpecPath(fileName.c_str());
+        fp = fopen(resolvedPath.c_str(), "rb");
+    }
     if (fp == nullptr) {
         HLOGE("fail to open file %s", fileName.c_str());
         return nullptr;
@@ -45,7 +55,7 @@ std::unique_ptr<PerfFileReader> PerfFileReader::Instance(const std::string &file
 
     std::unique_ptr<PerfFileReader> reader = std::make_unique<PerfFileReader>(fileName, fp);
     if (!reader->ReadFileHeader()) {
-        // Fail to read header, maybe its compressed
+        // Fail to read header, maybe the whole file is gzipped by an old version
         if (reader->IsGzipFile()) {
             if (fp != nullptr) {
                 fclose(fp);
@@ -91,8 +101,9 @@ PerfFileReader::PerfFileReader(const std::string &fileName, FILE *fp) : fp_(fp),
 
 PerfFileReader::~PerfFileReader()
 {
+    UnmapDataSection();
     // if file was not closed properly
-    if (fp_ != nullptr && fp_ != stdout) {
+    if (fp_ != nullptr && fp_ != stdout && fp_ != stdin) {
         fclose(fp_);
     }
     fp_ = nullptr;
@@ -118,7 +129,16 @@ bool PerfFileReader::IsGzipFile()
 
 bool PerfFileReader::ReadFileHeader()
 {
-    if (Read(&header_, sizeof(header_))) {
+    // the header of a pipe is the head of the file header, do not read over it
+    constexpr size_t pipeHeaderSize = sizeof(perf_pipe_file_header);
+    CHECK_TRUE(Read(&header_, pipeHeaderSize), false, 0, "");
+    if (header_.size == pipeHeaderSize && IsValidDataFile()) {
+        HLOGD("read records from pipe");
+        isPipe_ = true;
+        pipeRecord_.resize(RECORD_SIZE_LIMIT_SPE);
+        return true;
+    }
+    if (Read(reinterpret_cast<char *>(&header_) + pipeHeaderSize, sizeof(header_) - pipeHeaderSize)) {
         dataSectionSize_ = header_.data.size;
         if (IsValidDataFile()) {
             featureSectionOffset_ = header_.data.offset + header_.data.size;
@@ -138,6 +158,9 @@ bool PerfFileReader::ReadFileHeader()
 
 bool PerfFileReader::ReadAttrSection()
 {
+    if (isPipe_) {
+        return ReadPipeAttrs();
+    }
     if (header_.attrSize != sizeof(perf_file_attr)) {
         // 4.19 and 5.1 use diff size , 128 vs 136
         HLOGW("attr size %" PRId64 " doesn't match expected size %zu", header_.attrSize,
@@ -218,6 +241,9 @@ std::vector<AttrWithId> PerfFileReader::GetAttrSection() const
 
 bool PerfFileReader::ReadDataSection(ProcessRecordCB &callback)
 {
+    if (isPipe_) {
+        return ReadPipeData(callback);
+    }
     if (fseek(fp_, header_.data.offset, SEEK_SET) != 0) {
         HLOGE("fseek() failed");
         return false;
@@ -229,12 +255,291 @@ bool PerfFileReader::ReadDataSection(ProcessRecordCB &callback)
     CHECK_TRUE(ReadRecord(callback), false, LOG_TYPE_PRINTF, "some record format is error!\n");
 
 #ifdef HIPERF_DEBUG_TIME
+    PrintReadTimes();
+#endif
+    return dataSectionSize_ == 0;
+}
+
+#ifdef HIPERF_DEBUG_TIME
+void PerfFileReader::PrintReadTimes() const
+{
     printf("readRecordTime: %" PRId64 " ms\n",
            duration_cast<milliseconds>(readRecordTime_).count());
     printf("readCallbackTime: %" PRId64 " ms\n",
            duration_cast<milliseconds>(readCallbackTime_).count());
+}
 #endif
-    return dataSectionSize_ == 0;
+
+size_t PerfFileReader::GetAutoDecodeThreads() const
+{
+    const size_t sizeLimit = static_cast<size_t>(header_.data.size / MIN_DECODE_SIZE_PER_THREAD);
+    const size_t cpuCount = static_cast<size_t>(std::thread::hardware_concurrency());
+    return std::max<size_t>(std::min({sizeLimit, cpuCount, MAX_DECODE_THREADS}), 1);
+}
+
+bool PerfFileReader::ReadDataSectionParallel(ProcessRecordCB &callback, size_t threadCount,
+                                             const bool ordered)
+{
+    if (threadCount == AUTO_DECODE_THREADS) {
+        threadCount = GetAutoDecodeThreads();
+    }
+    if (isPipe_ || threadCount <= 1 || !MapDataSection()) {
+        return ReadDataSection(callback);
+    }
+#ifdef HIPERF_DEBUG_TIME
+    const auto startReadTime = steady_clock::now();
+#endif
+    const perf_event_attr *attr = GetDefaultAttr();
+    std::vector<RecordIndexEntry> chunks;
+    bool ret = attr != nullptr && SplitDataSection(chunks);
+    HLOGD("decode %zu chunks by %zu threads", chunks.size(), threadCount);
+    // the smo records are read first, the same as ReadRecord()
+    for (size_t i = 0; ret && i < chunks.size(); i++) {
+        if ((chunks[i].flags & RecordIndexEntry::FLAG_SMO) == 0) {
+            continue;
+        }
+        ret = ForEachMappedRecord(chunks[i], [&callback, attr](uint8_t *data, const perf_event_header &header) {
+            if (header.type == PERF_RECORD_TYPE_SMO_NUM) {
+                callback(PerfEventRecordFactory::GetPerfEventRecord(header.type, data, *attr));
+            }
+            return true;
+        });
+    }
+    if (ret) {
+        ret = ordered ? ReadChunksOrdered(callback, chunks, threadCount) :
+                        ReadChunksUnordered(callback, chunks, threadCount);
+    }
+    UnmapDataSection();
+#ifdef HIPERF_DEBUG_TIME
+    readRecordTime_ += duration_cast<microseconds>(steady_clock::now() - startReadTime);
+    PrintReadTimes();
+#endif
+    CHECK_TRUE(ret, false, LOG_TYPE_PRINTF, "some record format is error!\n");
+    return true;
+}
+
+// cut the mapped data section at the record boundaries, by HIPERF_RECORD_INDEX if the file has it
+bool PerfFileReader::SplitDataSection(std::vector<RecordIndexEntry> &chunks) const
+{
+    const PerfFileSectionRecordIndex *index =
+        static_cast<const PerfFileSectionRecordIndex *>(GetFeatureSection(FEATURE::HIPERF_RECORD_INDEX));
+    if (index != nullptr && !index->entries_.empty()) {
+        uint64_t end = 0;
+        for (const RecordIndexEntry &entry : index->entries_) {
+            if (entry.offset != end || entry.size > header_.data.size - end) {
+                break;
+            }
+            end += entry.size;
+        }
+        if (end == header_.data.size) {
+            chunks = index->entries_;
+            return true;
+        }
+        HLOGW("record index does not cover the data section, find the record boundaries");
+    }
+    RecordIndexEntry chunk;
+    uint64_t pos = 0;
+    while (pos < header_.data.size) {
+        uint64_t size = 0;
+        CHECK_TRUE(GetMappedRecordSize(pos, header_.data.size, size), false, 0, "");
+        if (reinterpret_cast<const perf_event_header *>(mappedData_ + pos)->type == PERF_RECORD_TYPE_SMO_NUM) {
+            chunk.flags |= RecordIndexEntry::FLAG_SMO;
+        }
+        pos += size;
+        chunk.size = pos - chunk.offset;
+        if (chunk.size >= DECODE_CHUNK_SIZE || pos == header_.data.size) {
+            chunks.emplace_back(chunk);
+            chunk = RecordIndexEntry();
+            chunk.offset = pos;
+        }
+    }
+    return true;
+}
+
+// size of the record at pos of the mapped data section, including the aux data after it
+bool PerfFileReader::GetMappedRecordSize(const uint64_t pos, const uint64_t end, uint64_t &size) const
+{
+    CHECK_TRUE(end - pos >= sizeof(perf_event_header), false, 1, "not enough sizeof perf_event_header");
+    const perf_event_header *header = reinterpret_cast<const perf_event_header *>(mappedData_ + pos);
+    CHECK_TRUE(header->size >= sizeof(perf_event_header) && header->size <= RECORD_SIZE_LIMIT, false, 1,
+               "read record header size error %hu", header->size);
+    CHECK_TRUE(header->size <= end - pos, false, 1, "not enough header->size.");
+    size = header->size;
+    if (header->type == PERF_RECORD_AUXTRACE && header->size >= sizeof(perf_event_header) +
+        sizeof(PerfRecordAuxtraceData)) {
+        const PerfRecordAuxtraceData *auxtrace = reinterpret_cast<const PerfRecordAuxtraceData *>(header + 1);
+        CHECK_TRUE(auxtrace->size <= end - pos - size, false, 1, "aux data size error %" PRIu64, auxtrace->size);
+        size += auxtrace->size;
+    }
+    return true;
+}
+
+bool PerfFileReader::ForEachMappedRecord(const RecordIndexEntry &chunk, const MappedRecordCB &func) const
+{
+    const uint64_t end = chunk.offset + chunk.size;
+    uint64_t pos = chunk.offset;
+    while (pos < end) {
+        uint64_t size = 0;
+        CHECK_TRUE(GetMappedRecordSize(pos, end, size), false, 0, "");
+        uint8_t *data = mappedData_ + pos;
+        if (!func(data, *reinterpret_cast<const perf_event_header *>(data))) {
+            return false;
+        }
+        pos += size;
+    }
+    return true;
+}
+
+// construct the records of chunk in slot, the record at the same place of the last chunk is reused
+bool PerfFileReader::DecodeChunk(const RecordIndexEntry &chunk, const perf_event_attr &attr, DecodeSlot &slot) const
+{
+    slot.count = 0;
+    return ForEachMappedRecord(chunk, [&slot, &attr](uint8_t *data, const perf_event_header &header) {
+        std::vector<std::unique_ptr<PerfEventRecord>> &records = slot.records;
+        if (slot.count == records.size()) {
+            records.emplace_back(nullptr);
+        }
+        std::unique_ptr<PerfEventRecord> &record = records[slot.count];
+        if (record == nullptr || record->GetType() != header.type) {
+            record = PerfEventRecordFactory::MakePerfEventRecord(header.type);
+        }
+        record->Init(data, attr);
+        // unknown record, break the process
+        if (record->GetName() == nullptr) {
+            return false;
+        }
+        slot.count++;
+        return true;
+    });
+}
+
+bool PerfFileReader::ReadChunksOrdered(ProcessRecordCB &callback, const std::vector<RecordIndexEntry> &chunks,
+                                       const size_t threadCount)
+{
+    const perf_event_attr *attr = GetDefaultAttr();
+    // chunk i is decoded in slot i % size, after chunk i - size in it has been delivered
+    std::vector<DecodeSlot> slots(threadCount * 2);
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::atomic<size_t> nextChunk = 0;
+    size_t delivered = 0;
+    bool stop = false;
+    auto decode = [&]() {
+        size_t chunk = 0;
+        while ((chunk = nextChunk++) < chunks.size()) {
+            DecodeSlot &slot = slots[chunk % slots.size()];
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return stop || chunk < delivered + slots.size(); });
+                if (stop) {
+                    return;
+                }
+            }
+            bool ret = DecodeChunk(chunks[chunk], *attr, slot);
+            std::lock_guard<std::mutex> lock(mutex);
+            slot.chunk = chunk;
+            slot.failed = !ret;
+            slot.ready = true;
+            cv.notify_all();
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        threads.emplace_back(decode);
+    }
+    bool ret = true;
+    for (size_t chunk = 0; chunk < chunks.size(); chunk++) {
+        DecodeSlot &slot = slots[chunk % slots.size()];
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return slot.ready && slot.chunk == chunk; });
+        }
+        if (slot.failed) {
+            ret = false;
+            break;
+        }
+        for (size_t i = 0; i < slot.count; i++) {
+            PerfEventRecord &record = *slot.records[i];
+            if (record.GetType() == PERF_RECORD_SAMPLE) {
+                // Init() cleaned the sample buffers of the decode thread, clean the ones of this thread
+                static_cast<PerfRecordSample &>(record).Clean();
+            }
+            callback(record);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        slot.ready = false;
+        delivered++;
+        cv.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    cv.notify_all();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    return ret;
+}
+
+bool PerfFileReader::ReadChunksUnordered(ProcessRecordCB &callback, const std::vector<RecordIndexEntry> &chunks,
+                                         const size_t threadCount)
+{
+    const perf_event_attr *attr = GetDefaultAttr();
+    std::atomic<size_t> nextChunk = 0;
+    std::atomic<bool> failed = false;
+    auto decode = [&]() {
+        size_t chunk = 0;
+        while (!failed && (chunk = nextChunk++) < chunks.size()) {
+            bool ret = ForEachMappedRecord(chunks[chunk], [&callback, attr](uint8_t *data,
+                                                                            const perf_event_header &header) {
+                // the cached records of the factory are per thread
+                PerfEventRecord &record = PerfEventRecordFactory::GetPerfEventRecord(header.type, data, *attr);
+                if (record.GetName() == nullptr) {
+                    return false;
+                }
+                callback(record);
+                return true;
+            });
+            if (!ret) {
+                failed = true;
+            }
+        }
+        PerfEventRecordFactory::Cleanup();
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        threads.emplace_back(decode);
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    return !failed;
+}
+
+bool PerfFileReader::ReadDataSectionInRange(ProcessRecordCB &callback, const uint64_t startTime,
+                                            const uint64_t endTime, const pid_t pid)
+{
+    auto filter = [&callback, startTime, endTime, pid](PerfEventRecord &record) -> bool {
+        if (record.GetType() == PERF_RECORD_SAMPLE) {
+            const uint64_t time = static_cast<PerfRecordSample &>(record).GetTime();
+            if (time < startTime || time > endTime || (pid != -1 && record.GetPid() != pid)) {
+                return true;
+            }
+        }
+        return callback(record);
+    };
+    const PerfFileSectionRecordIndex *index =
+        static_cast<const PerfFileSectionRecordIndex *>(GetFeatureSection(FEATURE::HIPERF_RECORD_INDEX));
+    if (index == nullptr || index->entries_.empty() || IsDataCompressed()) {
+        HLOGD("no record index, read the whole data section");
+        return ReadDataSection(filter);
+    }
+    CHECK_TRUE(ReadIndexedRecord(filter, index->entries_, startTime, endTime, pid), false, LOG_TYPE_PRINTF,
+               "some record format is error!\n");
+    return true;
 }
 
 const perf_event_attr *PerfFileReader::GetDefaultAttr()
@@ -250,18 +555,22 @@ void PerfFileReader::ReadSpeRecord(perf_event_header *header, uint8_t *buf, size
         reinterpret_cast<struct PerfRecordAuxtraceData *>(header + 1);
     speSize = auxtrace->size;
     if (speSize > 0 && header->size + auxtrace->size <= RECORD_SIZE_LIMIT_SPE) {
-        Read(buf + header->size, auxtrace->size);
+        ReadData(buf + header->size, auxtrace->size);
     }
 }
 
 bool PerfFileReader::ReadRecordByAttr(ProcessRecordCB &callback, uint8_t *buf,
-                                      uint64_t &remainingSize, size_t &recordNumber, const perf_event_attr *attr)
+                                      uint64_t &remainingSize, size_t &recordNumber, const perf_event_attr *attr,
+                                      const bool skipSample)
 {
     CHECK_TRUE(buf != nullptr && attr != nullptr, false, 0, "");
     if (remainingSize < sizeof(perf_event_header)) {
         HLOGW("not enough sizeof perf_event_header");
         return false;
-    } else if (!Read(buf, sizeof(perf_event_header))) {
+    }
+    // the record is not copied if the data section is mapped, buf points to the mapped pages then
+    buf = ReadData(buf, sizeof(perf_event_header));
+    if (buf == nullptr) {
         HLOGW("read perf_event_header failed.");
         return false;
     }
@@ -275,10 +584,14 @@ bool PerfFileReader::ReadRecordByAttr(ProcessRecordCB &callback, uint8_t *buf,
         return false;
     }
     size_t headerSize = sizeof(perf_event_header);
-    if (!Read(buf + headerSize, header->size - headerSize)) {
+    if (ReadData(buf + headerSize, header->size - headerSize) == nullptr) {
         HLOGE("read record data size failed %zu", header->size - headerSize);
         return false;
     }
+    if (skipSample && header->type == PERF_RECORD_SAMPLE) {
+        remainingSize -= header->size;
+        return true;
+    }
     size_t speSize = 0;
     if (header->type == PERF_RECORD_AUXTRACE) {
         ReadSpeRecord(header, buf, speSize);
@@ -317,7 +630,7 @@ bool PerfFileReader::ValidateSMOReadRecord(uint8_t *buf, perf_event_header *head
         return false;
     }
     size_t headerSize = sizeof(perf_event_header);
-    if (!Read(buf + headerSize, header->size - headerSize)) {
+    if (ReadData(buf + headerSize, header->size - headerSize) == nullptr) {
         HLOGE("read record data size failed %zu", header->size - headerSize);
         return false;
     }
@@ -331,7 +644,10 @@ bool PerfFileReader::SMOReadRecordByAttr(ProcessRecordCB &callback, uint8_t *buf
     if (remainingSize < sizeof(perf_event_header)) {
         HLOGW("not enough sizeof perf_event_header");
         return false;
-    } else if (!Read(buf, sizeof(perf_event_header))) {
+    }
+    // the record is not copied if the data section is mapped, buf points to the mapped pages then
+    buf = ReadData(buf, sizeof(perf_event_header));
+    if (buf == nullptr) {
         HLOGW("read perf_event_header failed.");
         return false;
     }
@@ -385,17 +701,31 @@ bool PerfFileReader::ReadRecord(ProcessRecordCB &callback)
     // record size can not exceed 64K
     HIPERF_BUF_ALIGN static uint8_t buf[RECORD_SIZE_LIMIT_SPE];
     // diff with reader
-    uint64_t remainingSize = header_.data.size;
+    // the uncompressed size is not known, compressed records end with the stream
+    const uint64_t dataSize = IsDataCompressed() ? std::numeric_limits<uint64_t>::max() : header_.data.size;
+    uint64_t remainingSize = dataSize;
     size_t recordNumber = 0;
     const perf_event_attr *attr = GetDefaultAttr();
     CHECK_TRUE(attr != nullptr, false, 1, "attr is null");
-    uint64_t smoRemainingSize = header_.data.size;
+    uint64_t smoRemainingSize = dataSize;
     size_t smoRecordNumber = 0;
     HIPERF_BUF_ALIGN static uint8_t smoBuf[RECORD_SIZE_LIMIT_SPE];
     const perf_event_attr *smoAttr = GetDefaultAttr();
     CHECK_TRUE(smoAttr != nullptr, false, 1, "smoAttr is null");
     long originalPosition = ftell(fp_);
-    while (smoRemainingSize > 0) {
+    if (MapDataSection()) {
+        HLOGD("data section is mapped");
+    }
+    // both passes read from the start of the data section
+    auto rewindData = [this]() {
+        mappedPos_ = 0;
+        if (IsDataCompressed()) {
+            decompressor_ = std::make_unique<RecordDecompressor>(
+                [this](void *buf, size_t len) { return Read(buf, len); }, header_.data.size);
+        }
+    };
+    rewindData();
+    while (smoRemainingSize > 0 && !IsDataEnd()) {
         if (!SMOReadRecordByAttr(callback, smoBuf, smoRemainingSize, smoRecordNumber, smoAttr)) {
             return false;
         }
@@ -403,11 +733,14 @@ bool PerfFileReader::ReadRecord(ProcessRecordCB &callback)
     if (fseek(fp_, originalPosition, SEEK_SET)) {
         return false;
     }
-    while (remainingSize > 0) {
+    rewindData();
+    while (remainingSize > 0 && !IsDataEnd()) {
         if (!ReadRecordByAttr(callback, buf, remainingSize, recordNumber, attr)) {
             return false;
         }
     }
+    decompressor_.reset();
+    UnmapDataSection();
     HLOGD("read back %zu records", recordNumber);
 #ifdef HIPERF_DEBUG_TIME
     readRecordTime_ += duration_cast<microseconds>(steady_clock::now() - startReadTime);
@@ -415,6 +748,145 @@ bool PerfFileReader::ReadRecord(ProcessRecordCB &callback)
     return true;
 }
 
+// read like ReadRecord(), but only the non-sample records are constructed in the blocks without matched samples
+bool PerfFileReader::ReadIndexedRecord(ProcessRecordCB &callback, const std::vector<RecordIndexEntry> &entries,
+                                       const uint64_t startTime, const uint64_t endTime, const pid_t pid)
+{
+#ifdef HIPERF_DEBUG_TIME
+    const auto startReadTime = steady_clock::now();
+#endif
+    HIPERF_BUF_ALIGN static uint8_t buf[RECORD_SIZE_LIMIT_SPE];
+    const perf_event_attr *attr = GetDefaultAttr();
+    CHECK_TRUE(attr != nullptr, false, 1, "attr is null");
+    // the non-sample records after the last matched sample are not needed
+    size_t endEntry = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        CHECK_TRUE(entries[i].size <= header_.data.size && entries[i].offset <= header_.data.size - entries[i].size,
+                   false, 1, "record index %zu exceeds the data section", i);
+        if (entries[i].MatchSample(startTime, endTime, pid)) {
+            endEntry = i + 1;
+        }
+    }
+    if (MapDataSection()) {
+        HLOGD("data section is mapped");
+    }
+    size_t recordNumber = 0;
+    // the smo records are read first, the same as ReadRecord()
+    for (const RecordIndexEntry &entry : entries) {
+        if ((entry.flags & RecordIndexEntry::FLAG_SMO) == 0) {
+            continue;
+        }
+        uint64_t remainingSize = entry.size;
+        CHECK_TRUE(SeekData(entry.offset), false, 1, "seek to %" PRIu64 " failed", entry.offset);
+        while (remainingSize > 0) {
+            CHECK_TRUE(SMOReadRecordByAttr(callback, buf, remainingSize, recordNumber, attr), false, 0, "");
+        }
+    }
+    for (size_t i = 0; i < endEntry; i++) {
+        const RecordIndexEntry &entry = entries[i];
+        const bool matched = entry.MatchSample(startTime, endTime, pid);
+        if (!matched && (entry.flags & RecordIndexEntry::FLAG_SIDEBAND) == 0) {
+            continue;
+        }
+        uint64_t remainingSize = entry.size;
+        CHECK_TRUE(SeekData(entry.offset), false, 1, "seek to %" PRIu64 " failed", entry.offset);
+        while (remainingSize > 0) {
+            CHECK_TRUE(ReadRecordByAttr(callback, buf, remainingSize, recordNumber, attr, !matched), false, 0, "");
+        }
+    }
+    UnmapDataSection();
+    HLOGD("read back %zu records from %zu blocks", recordNumber, entries.size());
+#ifdef HIPERF_DEBUG_TIME
+    readRecordTime_ += duration_cast<microseconds>(steady_clock::now() - startReadTime);
+#endif
+    return true;
+}
+
+bool PerfFileReader::SeekData(const uint64_t offset)
+{
+    if (mappedData_ != nullptr) {
+        mappedPos_ = offset;
+        return true;
+    }
+    return fseek(fp_, static_cast<long>(header_.data.offset + offset), SEEK_SET) == 0;
+}
+
+uint8_t *PerfFileReader::ReadData(uint8_t *buf, const size_t len)
+{
+    if (mappedData_ != nullptr) {
+        // records are continuous in the mapped pages, buf + len of the last read is here
+        CHECK_TRUE(len <= header_.data.size - mappedPos_, nullptr, 1, "read %zu bytes beyond data section", len);
+        uint8_t *data = mappedData_ + mappedPos_;
+        mappedPos_ += len;
+        return data;
+    }
+    if (decompressor_ != nullptr) {
+        return decompressor_->Read(buf, len) ? buf : nullptr;
+    }
+    return Read(buf, len) ? buf : nullptr;
+}
+
+// map the data section to construct records over the pages, instead of fread each of them.
+// pipes and compressed data are still read by fp_.
+bool PerfFileReader::MapDataSection()
+{
+    UnmapDataSection();
+    if (fp_ == nullptr || header_.data.size == 0 || IsDataCompressed()) {
+        return false;
+    }
+    int fd = fileno(fp_);
+    struct stat fileStat;
+    if (fd < 0 || fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode)) {
+        return false;
+    }
+    const uint64_t dataEnd = header_.data.offset + header_.data.size;
+    if (dataEnd < header_.data.offset || dataEnd > static_cast<uint64_t>(fileStat.st_size)) {
+        HLOGW("data section exceeds the file size %" PRId64 "", static_cast<int64_t>(fileStat.st_size));
+        return false;
+    }
+    const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    const uint64_t mapOffset = header_.data.offset / pageSize * pageSize;
+    if (dataEnd - mapOffset > std::numeric_limits<size_t>::max()) {
+        return false;
+    }
+    const size_t mapLength = static_cast<size_t>(dataEnd - mapOffset);
+    // private writable mapping, the records may be modified when they are parsed
+    void *addr = mmap(nullptr, mapLength, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, static_cast<off_t>(mapOffset));
+    if (addr == MAP_FAILED) {
+        HLOGW("mmap data section failed, errno:%d, read it by file", errno);
+        return false;
+    }
+    if (madvise(addr, mapLength, MADV_SEQUENTIAL) != 0) {
+        HLOGD("madvise failed, errno:%d", errno);
+    }
+    mapAddr_ = addr;
+    mapLength_ = mapLength;
+    mappedData_ = static_cast<uint8_t *>(addr) + (header_.data.offset - mapOffset);
+    mappedPos_ = 0;
+    return true;
+}
+
+void PerfFileReader::UnmapDataSection()
+{
+    if (mapAddr_ != nullptr) {
+        munmap(mapAddr_, mapLength_);
+    }
+    mapAddr_ = nullptr;
+    mapLength_ = 0;
+    mappedData_ = nullptr;
+    mappedPos_ = 0;
+}
+
+bool PerfFileReader::IsDataCompressed() const
+{
+    return std::find(features_.begin(), features_.end(), FEATURE::HIPERF_COMPRESSED_DATA) != features_.end();
+}
+
+bool PerfFileReader::IsDataEnd()
+{
+    return decompressor_ != nullptr && decompressor_->IsEnd();
+}
+
 bool PerfFileReader::Read(void *buf, const size_t len)
 {
     if (buf == nullptr || len == 0) {
@@ -498,8 +970,138 @@ const PerfFileSection *PerfFileReader::GetFeatureSection(const FEATURE feature)
     return nullptr;
 }
 
+// read a whole record of the pipe into buf, return false at the end of the stream or on error
+bool PerfFileReader::ReadPipeRecord(uint8_t *buf)
+{
+    perf_event_header *header = reinterpret_cast<perf_event_header *>(buf);
+    if (fread(header, sizeof(perf_event_header), 1, fp_) != 1) {
+        // the writer closed the pipe after a whole record
+        pipeEnd_ = feof(fp_) != 0;
+        return false;
+    }
+    const size_t headerSize = sizeof(perf_event_header);
+    CHECK_TRUE(header->size >= headerSize, false, 1, "read record header size error %hu", header->size);
+    if (header->size > headerSize) {
+        CHECK_TRUE(Read(buf + headerSize, header->size - headerSize), false, 1, "read record data size failed %zu",
+                   header->size - headerSize);
+    }
+    if (header->type == PERF_RECORD_AUXTRACE) {
+        CHECK_TRUE(header->size >= headerSize + sizeof(PerfRecordAuxtraceData), false, 1,
+                   "auxtrace record size error %hu", header->size);
+        const PerfRecordAuxtraceData *auxtrace = reinterpret_cast<const PerfRecordAuxtraceData *>(header + 1);
+        CHECK_TRUE(header->size + auxtrace->size <= RECORD_SIZE_LIMIT_SPE, false, 1,
+                   "auxtrace size error %" PRIu64 "", auxtrace->size);
+        if (auxtrace->size > 0) {
+            CHECK_TRUE(Read(buf + header->size, auxtrace->size), false, 1, "read aux data failed");
+        }
+    }
+    return true;
+}
+
+// the attr and feature records are at the head of the pipe, the first data record is kept for ReadDataSection()
+bool PerfFileReader::ReadPipeAttrs()
+{
+    while (ReadPipeRecord(pipeRecord_.data())) {
+        const perf_event_header *header = reinterpret_cast<const perf_event_header *>(pipeRecord_.data());
+        if (header->type == PERF_RECORD_HEADER_ATTR) {
+            CHECK_TRUE(AddPipeAttr(*header), false, 0, "");
+        } else if (header->type == PERF_RECORD_HEADER_FEATURE) {
+            CHECK_TRUE(AddPipeFeature(*header), false, 0, "");
+        } else {
+            pipeRecordPending_ = true;
+            break;
+        }
+    }
+    CHECK_TRUE(!vecAttr_.empty(), false, 1, "no attr in pipe");
+    // the features ahead of the records can be used before reading them
+    AddPipeFeatureSections();
+    return true;
+}
+
+bool PerfFileReader::AddPipeAttr(const perf_event_header &header)
+{
+    const size_t idsOffset = sizeof(perf_event_header) + sizeof(perf_event_attr);
+    CHECK_TRUE(header.size >= idsOffset, false, 1, "attr record size error %hu", header.size);
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(&header);
+    perf_file_attr attr {};
+    attr.attr = *reinterpret_cast<const perf_event_attr *>(data + sizeof(perf_event_header));
+    std::vector<uint64_t> ids((header.size - idsOffset) / sizeof(uint64_t));
+    if (!ids.empty() &&
+        memcpy_s(ids.data(), ids.size() * sizeof(uint64_t), data + idsOffset, ids.size() * sizeof(uint64_t)) != EOK) {
+        HLOGE("memcpy_s failed");
+        return false;
+    }
+    for (auto id : ids) {
+        mapId2Attr_[id] = vecAttr_.size();
+    }
+    vecAttr_.push_back(attr);
+    vecAttrIds_.push_back(std::move(ids));
+    return true;
+}
+
+bool PerfFileReader::AddPipeFeature(const perf_event_header &header)
+{
+    const size_t featureOffset = sizeof(perf_event_header) + sizeof(uint64_t);
+    CHECK_TRUE(header.size >= featureOffset, false, 1, "feature record size error %hu", header.size);
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(&header);
+    const uint64_t featureId = *reinterpret_cast<const uint64_t *>(data + sizeof(perf_event_header));
+    CHECK_TRUE(featureId < FETURE_MAX, false, 1, "feature id error %" PRIu64 "", featureId);
+    const FEATURE feature = static_cast<FEATURE>(featureId);
+    // a large feature is split into continuous records
+    if (pipeFeatures_.empty() || pipeFeatures_.back().first != feature) {
+        pipeFeatures_.emplace_back(feature, std::vector<char>());
+    }
+    std::vector<char> &buf = pipeFeatures_.back().second;
+    buf.insert(buf.end(), data + featureOffset, data + header.size);
+    return true;
+}
+
+bool PerfFileReader::ReadPipeData(ProcessRecordCB &callback)
+{
+    size_t recordNumber = 0;
+    while (pipeRecordPending_ || ReadPipeRecord(pipeRecord_.data())) {
+        pipeRecordPending_ = false;
+        const perf_event_header *header = reinterpret_cast<const perf_event_header *>(pipeRecord_.data());
+        if (header->type == PERF_RECORD_HEADER_ATTR) {
+            CHECK_TRUE(AddPipeAttr(*header), false, 0, "");
+            continue;
+        } else if (header->type == PERF_RECORD_HEADER_FEATURE) {
+            CHECK_TRUE(AddPipeFeature(*header), false, 0, "");
+            continue;
+        }
+        // the attrs may grow with the records, get it each time
+        const perf_event_attr *attr = GetDefaultAttr();
+        CHECK_TRUE(attr != nullptr, false, 1, "attr is null");
+        uint8_t *data = pipeRecord_.data();
+        PerfEventRecord& record = PerfEventRecordFactory::GetPerfEventRecord(
+            static_cast<perf_event_type>(header->type), data, *attr);
+        // unknown record , break the process
+        CHECK_TRUE(record.GetName() != nullptr, false, 1, "unknown record type %u", header->type);
+        callback(record);
+        recordNumber++;
+    }
+    CHECK_TRUE(pipeEnd_, false, LOG_TYPE_PRINTF, "pipe is broken after %zu records\n", recordNumber);
+    AddPipeFeatureSections();
+    HLOGD("read %zu records from pipe", recordNumber);
+    return true;
+}
+
+void PerfFileReader::AddPipeFeatureSections()
+{
+    for (auto &[feature, buf] : pipeFeatures_) {
+        features_.emplace_back(feature);
+        header_.features[static_cast<int>(feature) / BITS_IN_BYTE] |= 1 << (static_cast<int>(feature) % BITS_IN_BYTE);
+        AddFeatureSection(feature, buf);
+    }
+    pipeFeatures_.clear();
+}
+
 bool PerfFileReader::ReadFeatureSection()
 {
+    if (isPipe_) {
+        // the features of a pipe are read with the attrs, the ones after the records by ReadDataSection()
+        return true;
+    }
     uint64_t featureSectionOffsetRead = featureSectionOffset_;
     HLOGV(" ReadDataSection data offset '0x%" PRIx64 " ", featureSectionOffset_);
 
@@ -520,27 +1122,38 @@ bool PerfFileReader::ReadFeatureSection()
         // read failed ??
         CHECK_TRUE(Read(&buf[0], sectionHeader.offset, buf.size()), false, LOG_TYPE_PRINTF,
                    "file format not correct. featureSectionDataOffset '0x%" PRIx64 "\n", sectionHeader.offset);
-        if (IsFeatureStringSection(feature)) {
-            perfFileSections_.emplace_back(
-                std::make_unique<PerfFileSectionString>(feature, (char *)&buf[0], buf.size()));
-        } else if (feature == FEATURE::HIPERF_FILES_SYMBOL) {
-            perfFileSections_.emplace_back(std::make_unique<PerfFileSectionSymbolsFiles>(
-                feature, (char *)&buf[0], buf.size()));
-        } else if (feature == FEATURE::EVENT_DESC) {
-            perfFileSections_.emplace_back(
-                std::make_unique<PerfFileSectionEventDesc>(feature, (char *)&buf[0], buf.size()));
-        } else if (feature == FEATURE::HIPERF_FILES_UNISTACK_TABLE) {
-            perfFileSections_.emplace_back(
-                std::make_unique<PerfFileSectionUniStackTable>(feature, (char *)&buf[0], buf.size()));
-            PerfRecordSample::SetDumpRemoveStack(true);
-        } else {
-            HLOGW("still not imp how to process with feature %d", feature);
-        }
+        AddFeatureSection(feature, buf);
 
         featureSectionOffsetRead += sizeof(sectionHeader); // next feaure
     }
     return true;
 }
+
+void PerfFileReader::AddFeatureSection(const FEATURE feature, std::vector<char> &buf)
+{
+    if (IsFeatureStringSection(feature)) {
+        perfFileSections_.emplace_back(
+            std::make_unique<PerfFileSectionString>(feature, (char *)&buf[0], buf.size()));
+    } else if (feature == FEATURE::HIPERF_FILES_SYMBOL) {
+        perfFileSections_.emplace_back(std::make_unique<PerfFileSectionSymbolsFiles>(
+            feature, (char *)&buf[0], buf.size()));
+    } else if (feature == FEATURE::EVENT_DESC) {
+        perfFileSections_.emplace_back(
+            std::make_unique<PerfFileSectionEventDesc>(feature, (char *)&buf[0], buf.size()));
+    } else if (feature == FEATURE::HIPERF_FILES_UNISTACK_TABLE) {
+        perfFileSections_.emplace_back(
+            std::make_unique<PerfFileSectionUniStackTable>(feature, (char *)&buf[0], buf.size()));
+        PerfRecordSample::SetDumpRemoveStack(true);
+    } else if (feature == FEATURE::HIPERF_COMPRESSED_DATA) {
+        perfFileSections_.emplace_back(
+            std::make_unique<PerfFileSectionU64>(feature, (char *)&buf[0], buf.size()));
+    } else if (feature == FEATURE::HIPERF_RECORD_INDEX) {
+        perfFileSections_.emplace_back(
+            std::make_unique<PerfFileSectionRecordIndex>(feature, (char *)&buf[0], buf.size()));
+    } else {
+        HLOGW("still not imp how to process with feature %d", feature);
+    }
+}
 } // namespace HiPerf
 } // namespace Developtools
 } // namespace OHOS
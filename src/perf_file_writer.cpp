@@ -16,7 +16,11 @@
 
 #include <cinttypes>
 #include <cstdlib>
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 
 #include "hiperf_hilog.h"
 #include "utilities.h"
@@ -25,20 +29,97 @@ using namespace std::chrono;
 namespace OHOS {
 namespace Developtools {
 namespace HiPerf {
+namespace {
+// records are sent to the stream every STREAM_BUFFER_SIZE bytes, smaller than the file buffer
+// so the reader gets them soon
+constexpr int STREAM_BUFFER_SIZE = 64 * 1024;
+// data of a feature in one PERF_RECORD_HEADER_FEATURE record, after the header and the feature id
+constexpr size_t STREAM_FEATURE_CHUNK_SIZE =
+    (RECORD_SIZE_LIMIT - sizeof(perf_event_header) - sizeof(uint64_t)) / sizeof(uint64_t) * sizeof(uint64_t);
+
+int ConnectUnixSocket(const std::string &path)
+{
+    sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    CHECK_TRUE(!path.empty() && path.size() < sizeof(addr.sun_path), -1, 1, "invalid socket path %s",
+               path.c_str());
+    if (memcpy_s(addr.sun_path, sizeof(addr.sun_path), path.c_str(), path.size()) != EOK) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    CHECK_TRUE(fd >= 0, -1, 1, "create unix socket failed, errno:%d", errno);
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        HLOGE("connect to %s failed, errno:%d", path.c_str(), errno);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+} // namespace
+
 PerfFileWriter::~PerfFileWriter()
 {
     // if file was not closed properly, remove it before exit
+    // the compressor and the flush thread may still write to fp_, stop them first
+    compressor_.reset();
+    asyncWriter_.reset();
+    CloseDirectFd();
     if (fp_ != nullptr) {
         fclose(fp_);
         fp_ = nullptr;
-        if (remove(fileName_.c_str()) != 0) {
+        if (!isStream_ && remove(fileName_.c_str()) != 0) {
             HLOGE("fail to remove file(%s).", fileName_.c_str());
         }
     }
 }
 
-bool PerfFileWriter::Open(const std::string &fileName, bool compressData)
+bool PerfFileWriter::IsStreamOutput(const std::string &fileName)
+{
+    if (fileName == PIPE_OUTPUT_STDIO || StringStartsWith(fileName, PIPE_OUTPUT_FD_PREFIX) ||
+        StringStartsWith(fileName, PIPE_OUTPUT_UNIX_PREFIX)) {
+        return true;
+    }
+    struct stat fileStat;
+    return stat(fileName.c_str(), &fileStat) == 0 && S_ISFIFO(fileStat.st_mode);
+}
+
+bool PerfFileWriter::OpenStream(const std::string &fileName)
+{
+    int fd = -1;
+    if (fileName == PIPE_OUTPUT_STDIO) {
+        fd = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 0);
+    } else if (StringStartsWith(fileName, PIPE_OUTPUT_FD_PREFIX)) {
+        int outFd = -1;
+        CHECK_TRUE(IsStringToIntSuccess(fileName.substr(strlen(PIPE_OUTPUT_FD_PREFIX)), outFd) && outFd >= 0,
+                   false, LOG_TYPE_PRINTF, "invalid output fd %s\n", fileName.c_str());
+        fd = fcntl(outFd, F_DUPFD_CLOEXEC, 0);
+    } else if (StringStartsWith(fileName, PIPE_OUTPUT_UNIX_PREFIX)) {
+        fd = ConnectUnixSocket(fileName.substr(strlen(PIPE_OUTPUT_UNIX_PREFIX)));
+    } else {
+        // block until the reader opens the FIFO
+        std::string resolvedPath = CanonicalizeSpecPath(fileName.c_str());
+        fd = open(resolvedPath.c_str(), O_WRONLY | O_CLOEXEC);
+    }
+    CHECK_TRUE(fd >= 0, false, LOG_TYPE_PRINTF, "can't open stream(%s). %d\n", fileName.c_str(), errno);
+    fp_ = fdopen(fd, "wb");
+    if (fp_ == nullptr) {
+        printf("can't open stream(%s). %d\n", fileName.c_str(), errno);
+        close(fd);
+        return false;
+    }
+    return true;
+}
+
+bool PerfFileWriter::Open(const std::string &fileName, bool compressData, const int compressLevel)
 {
+    isStream_ = IsStreamOutput(fileName);
+    if (isStream_) {
+        // the reader of a stream can not know the records are compressed before the features at the end
+        CHECK_TRUE(!compressData, false, LOG_TYPE_PRINTF, "can't compress the records of stream %s\n",
+                   fileName.c_str());
+        CHECK_TRUE(OpenStream(fileName), false, 0, "");
+        return OpenCommon(fileName, compressData, compressLevel);
+    }
     // check file existence, if exist, remove it
     if (access(fileName.c_str(), F_OK) == 0) {
         // file exists
@@ -58,31 +139,73 @@ bool PerfFileWriter::Open(const std::string &fileName, bool compressData)
         printf("can't create file(%s). %d:%s\n", fileName.c_str(), errno, errInfo);
         return false;
     }
+    return OpenCommon(fileName, compressData, compressLevel);
+}
 
+bool PerfFileWriter::OpenCommon(const std::string &fileName, bool compressData, const int compressLevel)
+{
     fileName_ = fileName;
     compressData_ = compressData;
+    compressLevel_ = compressLevel;
+    rawDataSize_ = 0;
+    dataFinished_ = false;
+    compressor_.reset();
+    asyncWriter_.reset();
+    CloseDirectFd();
+    recordIndex_.clear();
+    indexBlock_ = RecordIndexEntry();
+    streamFeatureCount_ = 0;
     attrSection_.offset = 0;
     attrSection_.size = 0;
     dataSection_ = attrSection_;
     header_.size = sizeof(header_);
-    fileBuffer_.resize(WRITER_BUFFER_SIZE);
-    if (setvbuf(fp_, fileBuffer_.data(), _IOFBF, WRITER_BUFFER_SIZE) != 0) {
+    const int bufferSize = isStream_ ? STREAM_BUFFER_SIZE : WRITER_BUFFER_SIZE;
+    fileBuffer_.resize(bufferSize);
+    if (setvbuf(fp_, fileBuffer_.data(), _IOFBF, bufferSize) != 0) {
         HLOGD("setvbuf failed");
     }
+    if (isStream_) {
+        perf_pipe_file_header pipeHeader;
+        CHECK_TRUE(Write(&pipeHeader, sizeof(pipeHeader)), false, 0, "");
+    }
 
     return true;
 }
 
+bool PerfFileWriter::Rename(const std::string &fileName)
+{
+    CHECK_TRUE(fp_ != nullptr && !isStream_, false, 1, "can't rename %s", fileName_.c_str());
+    if (rename(fileName_.c_str(), fileName.c_str()) != 0) {
+        HLOGEP("fail to rename %s to %s", fileName_.c_str(), fileName.c_str());
+        return false;
+    }
+    fileName_ = fileName;
+    return true;
+}
+
 bool PerfFileWriter::Close()
 {
     HLOG_ASSERT(fp_ != nullptr);
     bool rc = true;
 
-    if (!WriteHeader()) {
+    if (!FinishData()) {
         rc = false;
     }
-    if (!WriteFeatureData()) {
-        rc = false;
+    if (isStream_) {
+        // nothing can be seeked back, the features follow the records
+        if (!WriteStreamFeatures()) {
+            rc = false;
+        }
+    } else {
+        if (!AddRecordIndexFeature()) {
+            rc = false;
+        }
+        if (!WriteHeader()) {
+            rc = false;
+        }
+        if (!WriteFeatureData()) {
+            rc = false;
+        }
     }
 
     if (fclose(fp_) != 0) {
@@ -90,31 +213,6 @@ bool PerfFileWriter::Close()
         rc = false;
     }
     fp_ = nullptr;
-
-    // compress and rename .perf.data to gzip file
-    if (compressData_) {
-        std::string gzName = fileName_ + ".gz";
-        if (CompressFile(fileName_, gzName)) {
-            if (remove(fileName_.c_str()) != 0) {
-                char errInfo[ERRINFOLEN] = { 0 };
-                strerror_r(errno, errInfo, ERRINFOLEN);
-                printf("can't remove file(%s). %d:%s\n",
-                    fileName_.c_str(), errno, errInfo);
-            }
-            if (rename(gzName.c_str(), fileName_.c_str()) != 0) {
-                char errInfo[ERRINFOLEN] = { 0 };
-                strerror_r(errno, errInfo, ERRINFOLEN);
-                printf("can't rename file(%s) to (%s). %d:%s\n", gzName.c_str(), fileName_.c_str(),
-                       errno, errInfo);
-            }
-        } else {
-            char errInfo[ERRINFOLEN] = { 0 };
-            strerror_r(errno, errInfo, ERRINFOLEN);
-            printf("failed to compress file(%s). %d:%s\n", fileName_.c_str(), errno,
-                   errInfo);
-        }
-    }
-
     return rc;
 }
 
@@ -129,22 +227,77 @@ bool PerfFileWriter::WriteRecord(const PerfEventRecord &record)
 
     CHECK_TRUE(record.GetSize() <= RECORD_SIZE_LIMIT_SPE, false, 1,
                "%s record size exceed limit", record.GetName());
+    if (isStream_ && recordCount_ == 0) {
+        // the features known before the records go ahead of them, like the attrs
+        CHECK_TRUE(WriteStreamFeatures(), false, 0, "");
+    }
     // signal 7 (SIGBUS), code 1 (BUS_ADRALN), fault addr 0xb64eb195
-    static std::vector<u8> buf(RECORD_SIZE_LIMIT_SPE);
+    // each writer has its own buffer, a split file is finished by another thread
+    CHECK_TRUE(record.GetBinary(recordBuf_), false, 0, "");
 
-    CHECK_TRUE(record.GetBinary(buf), false, 0, "");
-
-    CHECK_TRUE(Write(buf.data(), record.GetSize()), false, 0, "");
-    dataSection_.size += record.GetSize();
+    const uint64_t offset = rawDataSize_;
+    CHECK_TRUE(WriteData(recordBuf_.data(), record.GetSize()), false, 0, "");
+    if (!isStream_) {
+        IndexRecord(record, offset);
+    }
 
     ++recordCount_;
 
     return true;
 }
 
+void PerfFileWriter::IndexRecord(const PerfEventRecord &record, const uint64_t offset)
+{
+    if (offset != indexBlock_.offset + indexBlock_.size) {
+        // written without WriteRecord(), like the auxtrace info
+        indexBlock_.flags |= RecordIndexEntry::FLAG_SIDEBAND;
+    }
+    indexBlock_.size = rawDataSize_ - indexBlock_.offset;
+    if (record.GetType() == PERF_RECORD_SAMPLE) {
+        const PerfRecordSample &sample = static_cast<const PerfRecordSample &>(record);
+        indexBlock_.AddSample(sample.GetTime(), record.GetPid());
+    } else {
+        indexBlock_.flags |= RecordIndexEntry::FLAG_SIDEBAND;
+        if (record.GetType() == PERF_RECORD_TYPE_SMO_NUM) {
+            indexBlock_.flags |= RecordIndexEntry::FLAG_SMO;
+        }
+    }
+    if (indexBlock_.size >= RECORD_INDEX_BLOCK_SIZE) {
+        FinishIndexBlock();
+    }
+}
+
+void PerfFileWriter::FinishIndexBlock()
+{
+    if (indexBlock_.size == 0) {
+        return;
+    }
+    const uint64_t nextOffset = indexBlock_.offset + indexBlock_.size;
+    recordIndex_.emplace_back(std::move(indexBlock_));
+    indexBlock_ = RecordIndexEntry();
+    indexBlock_.offset = nextOffset;
+}
+
+// the offsets can not be seeked in the compressed data, so it is not indexed
+bool PerfFileWriter::AddRecordIndexFeature()
+{
+    FinishIndexBlock();
+    if (compressData_ || recordIndex_.empty()) {
+        return true;
+    }
+    const FEATURE feature = FEATURE::HIPERF_RECORD_INDEX;
+    HLOGV("add feature record index %zu blocks", recordIndex_.size());
+    featureSections_.emplace_back(std::make_unique<PerfFileSectionRecordIndex>(feature, std::move(recordIndex_)));
+    recordIndex_.clear();
+    header_.features[static_cast<int>(feature) / BITS_IN_BYTE] |= 1 << (static_cast<int>(feature) % BITS_IN_BYTE);
+    return true;
+}
+
 bool PerfFileWriter::ReadDataSection(ProcessRecordCB &callback)
 {
     HLOG_ASSERT(fp_ != nullptr);
+    CHECK_TRUE(!isStream_, false, 1, "can't read back the records of stream %s", fileName_.c_str());
+    CHECK_TRUE(FinishData(), false, 0, "");
     if (fseek(fp_, dataSection_.offset, SEEK_SET) != 0) {
         HLOGE("fseek() failed");
         return false;
@@ -158,15 +311,20 @@ bool PerfFileWriter::ReadDataSection(ProcessRecordCB &callback)
 bool PerfFileWriter::ReadRecords(ProcessRecordCB &callback)
 {
     // record size can not exceed 64K
-    HIPERF_BUF_ALIGN static uint8_t buf[RECORD_SIZE_LIMIT_SPE];
+    std::vector<uint8_t> readBuf(RECORD_SIZE_LIMIT_SPE);
+    uint8_t *buf = readBuf.data();
     // diff with reader
-    uint64_t remainingSize = dataSection_.size;
+    uint64_t remainingSize = rawDataSize_;
     size_t recordNumber = 0;
+    if (compressor_ != nullptr) {
+        decompressor_ = std::make_unique<RecordDecompressor>(
+            [this](void *buf, size_t len) { return Read(buf, len); }, dataSection_.size);
+    }
     while (remainingSize > 0) {
         if (remainingSize < sizeof(perf_event_header)) {
             HLOGW("not enough sizeof(perf_event_header).");
             return false;
-        } else if (!Read(buf, sizeof(perf_event_header))) {
+        } else if (!ReadData(buf, sizeof(perf_event_header))) {
             HLOGW("read perf_event_header failed.");
             return false;
         }
@@ -176,14 +334,14 @@ bool PerfFileWriter::ReadRecords(ProcessRecordCB &callback)
             return false;
         }
         size_t headerSize = sizeof(perf_event_header);
-        if (remainingSize >= header->size && Read(buf + headerSize, header->size - headerSize)) {
+        if (remainingSize >= header->size && ReadData(buf + headerSize, header->size - headerSize)) {
             size_t speSize = 0;
             if (header->type == PERF_RECORD_AUXTRACE) {
                 struct PerfRecordAuxtraceData *auxtrace =
                     reinterpret_cast<struct PerfRecordAuxtraceData *>(header + 1);
                 speSize = auxtrace->size;
                 if (speSize > 0) {
-                    Read(buf + header->size, auxtrace->size);
+                    ReadData(buf + header->size, auxtrace->size);
                 }
             }
             uint8_t *data = buf;
@@ -200,10 +358,19 @@ bool PerfFileWriter::ReadRecords(ProcessRecordCB &callback)
             HLOGW("not enough header->size.");
         }
     }
+    decompressor_.reset();
     HLOGD("read back %zu records", recordNumber);
     return true;
 }
 
+bool PerfFileWriter::ReadData(void *buf, size_t len)
+{
+    if (decompressor_ != nullptr) {
+        return decompressor_->Read(buf, len);
+    }
+    return Read(buf, len);
+}
+
 bool PerfFileWriter::Read(void *buf, size_t len)
 {
     HLOG_ASSERT(buf != nullptr);
@@ -221,7 +388,7 @@ void PerfFileWriter::SetWriteRecordStat(bool isWrite)
 
 uint64_t PerfFileWriter::GetDataSize() const
 {
-    return dataSection_.size;
+    return rawDataSize_;
 }
 
 uint PerfFileWriter::GetRecordCount() const
@@ -252,9 +419,113 @@ bool PerfFileWriter::Write(const void *buf, size_t len)
     return true;
 }
 
+bool PerfFileWriter::WriteData(const void *buf, size_t len)
+{
+    if (compressor_ != nullptr) {
+        CHECK_TRUE(compressor_->Write(buf, len), false, 0, "");
+    } else {
+        CHECK_TRUE(WriteDataToFile(buf, len), false, 0, "");
+    }
+    rawDataSize_ += len;
+    return true;
+}
+
+bool PerfFileWriter::WriteDataToFile(const void *buf, size_t len)
+{
+    if (asyncWriter_ != nullptr) {
+        return asyncWriter_->Write(buf, len);
+    }
+    return Write(buf, len);
+}
+
+bool PerfFileWriter::FinishData()
+{
+    if (!dataFinished_ && (compressor_ != nullptr || asyncWriter_ != nullptr)) {
+        dataFinished_ = true;
+        if (compressor_ != nullptr) {
+            CHECK_TRUE(compressor_->Finish(), false, 1, "fail to compress data section");
+            // the reader needs this to know the records are compressed
+            AddU64Feature(FEATURE::HIPERF_COMPRESSED_DATA, rawDataSize_);
+            HLOGD("data section compressed from %" PRIu64 " to %" PRIu64 " bytes", rawDataSize_,
+                  compressor_->GetCompressedSize());
+        }
+        if (asyncWriter_ != nullptr) {
+            bool ret = asyncWriter_->Stop();
+            CloseDirectFd();
+            CHECK_TRUE(ret, false, 1, "fail to write data section");
+        }
+    }
+    dataSection_.size = compressor_ != nullptr ? compressor_->GetCompressedSize() : rawDataSize_;
+    return true;
+}
+
+void PerfFileWriter::SetAsyncWrite(const bool asyncWrite, const bool directIo)
+{
+    asyncWrite_ = asyncWrite;
+    directIo_ = directIo;
+}
+
+bool PerfFileWriter::StartAsyncWrite(const uint64_t offset)
+{
+    // the attrs written by fp_ must reach the file before the flush thread writes after them
+    CHECK_TRUE(fflush(fp_) == 0, false, 1, "fflush failed");
+    if (directIo_) {
+        std::string resolvedPath = CanonicalizeSpecPath(fileName_.c_str());
+        directFd_ = open(resolvedPath.c_str(), O_WRONLY | O_DIRECT | O_CLOEXEC);
+        if (directFd_ < 0) {
+            HLOGW("fail to open %s with O_DIRECT, errno:%d", fileName_.c_str(), errno);
+        }
+    }
+    asyncWriter_ = std::make_unique<AsyncFileWriter>(fileno(fp_));
+    return asyncWriter_->Start(offset, directFd_);
+}
+
+void PerfFileWriter::CloseDirectFd()
+{
+    if (directFd_ >= 0) {
+        close(directFd_);
+        directFd_ = -1;
+    }
+}
+
+AsyncFileWriter::Stat PerfFileWriter::GetWriteStat() const
+{
+    if (asyncWriter_ == nullptr) {
+        return {};
+    }
+    return asyncWriter_->GetStat();
+}
+
+bool PerfFileWriter::WriteStreamAttrs(const std::vector<AttrWithId> &attrIds)
+{
+    for (auto &attrId : attrIds) {
+        perf_event_header header;
+        header.type = PERF_RECORD_HEADER_ATTR;
+        header.misc = 0;
+        const size_t size = sizeof(header) + sizeof(attrId.attr) + attrId.ids.size() * sizeof(uint64_t);
+        CHECK_TRUE(size <= RECORD_SIZE_LIMIT, false, 1, "too many ids %zu for attr record", attrId.ids.size());
+        header.size = static_cast<uint16_t>(size);
+        CHECK_TRUE(Write(&header, sizeof(header)), false, 0, "");
+        CHECK_TRUE(Write(&attrId.attr, sizeof(attrId.attr)), false, 0, "");
+        CHECK_TRUE(Write(attrId.ids.data(), attrId.ids.size() * sizeof(uint64_t)), false, 0, "");
+    }
+    return true;
+}
+
 bool PerfFileWriter::WriteAttrAndId(const std::vector<AttrWithId> &attrIds, bool isSpe)
 {
     CHECK_TRUE(!attrIds.empty(), false, 0, "");
+    if (isStream_) {
+        CHECK_TRUE(fp_ != nullptr && WriteStreamAttrs(attrIds), false, 0, "");
+        defaultEventAttr_ = attrIds[0].attr;
+        // the flush thread writes by offset, records are written to the stream in order directly
+        if (!WriteAuxTraceEvent(isSpe)) {
+            HLOGE("WriteAuxTraceEvent failed");
+            return false;
+        }
+        isWritingRecord = true;
+        return true;
+    }
 
     // Skip file header part.
     if (fp_ == nullptr) {
@@ -298,6 +569,14 @@ bool PerfFileWriter::WriteAttrAndId(const std::vector<AttrWithId> &attrIds, bool
     dataSection_.offset = dataSectionOffset;
 
     defaultEventAttr_ = attrIds[0].attr;
+    if (asyncWrite_) {
+        CHECK_TRUE(StartAsyncWrite(dataSectionOffset), false, 1, "fail to start async write");
+    }
+    if (compressData_) {
+        compressor_ = std::make_unique<RecordCompressor>(
+            [this](const void *buf, size_t len) { return WriteDataToFile(buf, len); }, compressLevel_);
+        CHECK_TRUE(compressor_->Start(), false, 1, "fail to start compressor");
+    }
     if (!WriteAuxTraceEvent(isSpe)) {
         HLOGE("WriteAuxTraceEvent failed");
         return false;
@@ -320,13 +599,12 @@ bool PerfFileWriter::WriteTimeConvEvent()
     auxTimeConv.time_cycles = 1;
     auxTimeConv.cap_user_time_zero = 1;
     auxTimeConv.cap_user_time_short = 1;
-    if (!Write(&header, sizeof(header))) {
+    if (!WriteData(&header, sizeof(header))) {
         return false;
     }
-    if (!Write(&auxTimeConv, sizeof(auxTimeConv))) {
+    if (!WriteData(&auxTimeConv, sizeof(auxTimeConv))) {
         return false;
     }
-    dataSection_.size = dataSection_.size + sizeof(header) + sizeof(auxTimeConv);
     return true;
 }
 
@@ -343,13 +621,12 @@ bool PerfFileWriter::WriteAuxTraceInfoEvent()
     auxTraceEvent.type = auxTraceType;
     auxTraceEvent.priv[0] = armSpe;
     auxTraceEvent.priv[1] = cpuMmaps;
-    if (!Write(&header, sizeof(header))) {
+    if (!WriteData(&header, sizeof(header))) {
         return false;
     }
-    if (!Write(&auxTraceEvent, sizeof(auxTraceEvent))) {
+    if (!WriteData(&auxTraceEvent, sizeof(auxTraceEvent))) {
         return false;
     }
-    dataSection_.size = dataSection_.size + sizeof(header) + sizeof(auxTraceEvent);
     return true;
 }
 
@@ -365,13 +642,12 @@ bool PerfFileWriter::WriteCpuMapEvent()
     for (uint i = 0; i < cpuMap.nr; i++) {
         cpuMap.cpu[i] = i;
     }
-    if (!Write(&header, sizeof(header))) {
+    if (!WriteData(&header, sizeof(header))) {
         return false;
     }
-    if (!Write(&cpuMap, sizeof(cpuMap))) {
+    if (!WriteData(&cpuMap, sizeof(cpuMap))) {
         return false;
     }
-    dataSection_.size = dataSection_.size + sizeof(header) + sizeof(cpuMap);
     return true;
 }
 
@@ -477,6 +753,34 @@ bool PerfFileWriter::WriteFeatureData()
     return true;
 }
 
+// write the features added since the last call.
+// a feature larger than one record is split into continuous records of the same feature id
+bool PerfFileWriter::WriteStreamFeatures()
+{
+    auto pending = featureSections_.begin() + static_cast<std::ptrdiff_t>(streamFeatureCount_);
+    std::sort(pending, featureSections_.end(), LeftLessRight);
+    streamFeatureCount_ = featureSections_.size();
+    std::vector<char> buf;
+    for (auto it = pending; it != featureSections_.end(); ++it) {
+        auto &featureSection = *it;
+        buf.resize(featureSection->GetSize());
+        featureSection->GetBinary(buf.data(), buf.size());
+        const uint64_t featureId = static_cast<uint64_t>(featureSection->featureId_);
+        for (size_t offset = 0; offset < buf.size(); offset += STREAM_FEATURE_CHUNK_SIZE) {
+            const size_t chunkSize = std::min(buf.size() - offset, STREAM_FEATURE_CHUNK_SIZE);
+            perf_event_header header;
+            header.type = PERF_RECORD_HEADER_FEATURE;
+            header.misc = 0;
+            header.size = static_cast<uint16_t>(sizeof(header) + sizeof(featureId) + chunkSize);
+            CHECK_TRUE(Write(&header, sizeof(header)) && Write(&featureId, sizeof(featureId)) &&
+                       Write(buf.data() + offset, chunkSize), false, 1, "write feature %" PRIu64 " failed",
+                       featureId);
+        }
+    }
+    CHECK_TRUE(fflush(fp_) == 0, false, 1, "fflush failed");
+    return true;
+}
+
 bool PerfFileWriter::AddNrCpusFeature(FEATURE feature, uint32_t nrCpusAvailable,
                                       uint32_t nrCpusOnline)
 {
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define HILOG_TAG "Compressor"
+
+#include "record_compressor.h"
+
+#include <cinttypes>
+
+#include "hiperf_hilog.h"
+#include "perf_event_record.h"
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+namespace {
+// size in perf_event_header is u16, one compressed record can not exceed RECORD_SIZE_LIMIT
+constexpr size_t COMPRESSED_PAYLOAD_SIZE = RECORD_SIZE_LIMIT - sizeof(perf_event_header);
+constexpr size_t INFLATE_BUFFER_SIZE = 256 * 1024;
+} // namespace
+
+RecordCompressor::RecordCompressor(WriteFunc write, const int level) : write_(std::move(write)), level_(level) {}
+
+RecordCompressor::~RecordCompressor()
+{
+    if (thread_.joinable()) {
+        Finish();
+    }
+    if (streamInited_) {
+        deflateEnd(&stream_);
+    }
+}
+
+bool RecordCompressor::Start()
+{
+    CHECK_TRUE(!streamInited_, false, 1, "compressor has been started");
+    int ret = deflateInit(&stream_, level_);
+    CHECK_TRUE(ret == Z_OK, false, 1, "deflateInit failed %d", ret);
+    streamInited_ = true;
+    writeBuf_.reserve(BUFFER_SIZE);
+    compressBuf_.reserve(BUFFER_SIZE);
+    outBuf_.resize(COMPRESSED_PAYLOAD_SIZE);
+    thread_ = std::thread(&RecordCompressor::CompressLoop, this);
+    return true;
+}
+
+bool RecordCompressor::Write(const void *buf, size_t len)
+{
+    CHECK_TRUE(thread_.joinable(), false, 1, "compressor is not running");
+    const uint8_t *data = static_cast<const uint8_t *>(buf);
+    writeBuf_.insert(writeBuf_.end(), data, data + len);
+    if (writeBuf_.size() >= BUFFER_SIZE) {
+        return SubmitBuffer(false);
+    }
+    return true;
+}
+
+bool RecordCompressor::Finish()
+{
+    if (!thread_.joinable()) {
+        return !failed_;
+    }
+    SubmitBuffer(true);
+    thread_.join();
+    HLOGD("compressed to %" PRIu64 " bytes", compressedSize_);
+    return !failed_;
+}
+
+// hand over the filled buffer, wait if the thread is still compressing the last one
+bool RecordCompressor::SubmitBuffer(const bool finish)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !pending_; });
+    std::swap(writeBuf_, compressBuf_);
+    writeBuf_.clear();
+    pending_ = true;
+    finish_ = finish;
+    cv_.notify_all();
+    return !failed_;
+}
+
+void RecordCompressor::CompressLoop()
+{
+#if defined(is_ohos) && is_ohos
+    pthread_setname_np(pthread_self(), "compressor");
+#endif
+    bool finish = false;
+    while (!finish) {
+        bool failed = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return pending_; });
+            finish = finish_;
+            failed = failed_;
+        }
+        // compressBuf_ is owned by this thread until pending_ is cleared
+        if (!failed && !Deflate(compressBuf_, finish ? Z_FINISH : Z_NO_FLUSH)) {
+            failed = true;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        failed_ = failed;
+        pending_ = false;
+        cv_.notify_all();
+    }
+}
+
+bool RecordCompressor::Deflate(const std::vector<uint8_t> &data, const int flush)
+{
+    stream_.next_in = const_cast<Bytef *>(data.data());
+    stream_.avail_in = static_cast<uInt>(data.size());
+    do {
+        stream_.next_out = outBuf_.data();
+        stream_.avail_out = static_cast<uInt>(outBuf_.size());
+        int ret = deflate(&stream_, flush);
+        CHECK_TRUE(ret != Z_STREAM_ERROR, false, 1, "deflate failed %d", ret);
+        size_t outSize = outBuf_.size() - stream_.avail_out;
+        if (outSize > 0 && !WriteCompressedRecord(outBuf_.data(), outSize)) {
+            return false;
+        }
+    } while (stream_.avail_out == 0);
+    return true;
+}
+
+bool RecordCompressor::WriteCompressedRecord(const uint8_t *buf, size_t len)
+{
+    perf_event_header header;
+    header.type = PERF_RECORD_COMPRESSED;
+    header.misc = 0;
+    header.size = static_cast<uint16_t>(sizeof(header) + len);
+    CHECK_TRUE(write_(&header, sizeof(header)) && write_(buf, len), false, 1,
+               "write compressed record failed");
+    compressedSize_ += header.size;
+    return true;
+}
+
+RecordDecompressor::RecordDecompressor(ReadFunc read, const uint64_t compressedSize)
+    : read_(std::move(read)), remainingSize_(compressedSize)
+{
+    int ret = inflateInit(&stream_);
+    if (ret != Z_OK) {
+        HLOGE("inflateInit failed %d", ret);
+        return;
+    }
+    streamInited_ = true;
+}
+
+RecordDecompressor::~RecordDecompressor()
+{
+    if (streamInited_) {
+        inflateEnd(&stream_);
+    }
+}
+
+bool RecordDecompressor::Read(void *buf, size_t len)
+{
+    uint8_t *dest = static_cast<uint8_t *>(buf);
+    while (len > 0) {
+        if (outPos_ == outBuf_.size() && !Inflate()) {
+            HLOGE("not enough uncompressed data");
+            return false;
+        }
+        size_t copySize = std::min(len, outBuf_.size() - outPos_);
+        if (memcpy_s(dest, len, outBuf_.data() + outPos_, copySize) != EOK) {
+            HLOGE("memcpy_s failed");
+            return false;
+        }
+        outPos_ += copySize;
+        dest += copySize;
+        len -= copySize;
+    }
+    return true;
+}
+
+bool RecordDecompressor::IsEnd()
+{
+    if (outPos_ < outBuf_.size()) {
+        return false;
+    }
+    return !Inflate();
+}
+
+// inflate the next piece of data into outBuf_, return false if nothing left
+bool RecordDecompressor::Inflate()
+{
+    CHECK_TRUE(streamInited_, false, 1, "inflate stream is not inited");
+    outBuf_.resize(INFLATE_BUFFER_SIZE);
+    outPos_ = 0;
+    while (!streamEnd_) {
+        if (stream_.avail_in == 0 && !ReadCompressedRecord()) {
+            break;
+        }
+        stream_.next_out = outBuf_.data();
+        stream_.avail_out = static_cast<uInt>(outBuf_.size());
+        int ret = inflate(&stream_, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END) {
+            streamEnd_ = true;
+        } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            HLOGE("inflate failed %d", ret);
+            break;
+        }
+        size_t outSize = outBuf_.size() - stream_.avail_out;
+        if (outSize > 0) {
+            outBuf_.resize(outSize);
+            return true;
+        }
+    }
+    outBuf_.clear();
+    return false;
+}
+
+bool RecordDecompressor::ReadCompressedRecord()
+{
+    perf_event_header header;
+    CHECK_TRUE(remainingSize_ >= sizeof(header), false, 1, "compressed data is truncated");
+    CHECK_TRUE(read_(&header, sizeof(header)), false, 1, "read compressed record header failed");
+    CHECK_TRUE(header.type == PERF_RECORD_COMPRESSED && header.size > sizeof(header) &&
+               header.size <= remainingSize_, false, 1, "compressed record error type %u size %hu",
+               header.type, header.size);
+    inBuf_.resize(header.size - sizeof(header));
+    CHECK_TRUE(read_(inBuf_.data(), inBuf_.size()), false, 1, "read compressed record failed");
+    remainingSize_ -= header.size;
+    stream_.next_in = inBuf_.data();
+    stream_.avail_in = static_cast<uInt>(inBuf_.size());
+    return true;
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
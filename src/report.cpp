@@ -32,7 +32,20 @@ using namespace std::placeholders;
 namespace OHOS {
 namespace Developtools {
 namespace HiPerf {
-unsigned long long ReportItem::allIndex_ = 0;
+namespace {
+// "count" is not here, it changes when the items are merged
+const std::map<std::string, size_t (*)(const ReportItem &)> REPORT_KEY_HASH_FUNCTIONS = {
+    {"comm", [](const ReportItem &item) { return std::hash<std::string_view>()(item.comm_); }},
+    {"pid", [](const ReportItem &item) { return std::hash<pid_t>()(item.pid_); }},
+    {"tid", [](const ReportItem &item) { return std::hash<pid_t>()(item.tid_); }},
+    {"dso", [](const ReportItem &item) { return std::hash<std::string_view>()(item.dso_); }},
+    {"from_dso", [](const ReportItem &item) { return std::hash<std::string_view>()(item.fromDso_); }},
+    {"func", [](const ReportItem &item) { return std::hash<std::string_view>()(item.func_); }},
+    {"from_func", [](const ReportItem &item) { return std::hash<std::string_view>()(item.fromFunc_); }},
+};
+} // namespace
+
+std::atomic<unsigned long long> ReportItem::allIndex_ {0};
 
 std::string Report::GetAdltExtendMapName(const std::string &mapName, const std::string &originSoName)
 {
@@ -87,7 +100,76 @@ std::string Report::FormatCounterValues(const std::vector<uint64_t> &values,
     return result;
 }
 
+// return false if the sort keys can not be aggregated on insert
+bool Report::UpdateAggregateKeys()
+{
+    if (aggregateKeys_ == option_.sortKeys_) {
+        return !aggregateHashFunctions_.empty();
+    }
+    // the sort keys changed, the old indexes are useless
+    aggregateKeys_ = option_.sortKeys_;
+    aggregateHashFunctions_.clear();
+    for (auto &config : configs_) {
+        config.reportItemIndexes_.clear();
+        if (!config.reportItems_.empty()) {
+            // items added before are not merged by the new keys
+            itemsNotIndexed_ = true;
+        }
+    }
+    for (const auto &key : aggregateKeys_) {
+        auto it = REPORT_KEY_HASH_FUNCTIONS.find(key);
+        if (it == REPORT_KEY_HASH_FUNCTIONS.end()) {
+            HLOGD("sort key %s can not be aggregated on insert", key.c_str());
+            aggregateHashFunctions_.clear();
+            return false;
+        }
+        aggregateHashFunctions_.push_back(it->second);
+    }
+    return !aggregateHashFunctions_.empty();
+}
+
+// items are unique by the sort keys if all of them are aggregated on insert
+bool Report::IsAggregated() const
+{
+    return !aggregateHashFunctions_.empty() && !itemsNotIndexed_ && aggregateKeys_ == option_.sortKeys_;
+}
+
+size_t Report::HashReportItem(const ReportItem &item) const
+{
+    size_t hash = 0;
+    for (auto hashFunction : aggregateHashFunctions_) {
+        HashCombine(hash, hashFunction(item));
+    }
+    return hash;
+}
+
+// merge the item into the one with same sort keys, or add it as a new one.
+// the merged callstack of item is not kept, caller adds its frames to the returned one.
+ReportItem &Report::InsertReportItem(ReportEventConfigItem &config, ReportItem &item)
+{
+    if (!UpdateAggregateKeys()) {
+        return config.reportItems_.emplace_back(std::move(item));
+    }
+    size_t hash = HashReportItem(item);
+    auto range = config.reportItemIndexes_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        // the index may be out of date if the items are removed
+        if (it->second < config.reportItems_.size() &&
+            MultiLevelSameAndUpdateCount(config.reportItems_[it->second], item)) {
+            return config.reportItems_[it->second];
+        }
+    }
+    config.reportItemIndexes_.emplace(hash, config.reportItems_.size());
+    return config.reportItems_.emplace_back(std::move(item));
+}
+
 void Report::AddReportItem(const PerfRecordSample &sample, const bool includeCallStack)
+{
+    VirtualThread &thread = virtualRuntime_.GetThread(sample.data_.pid, sample.data_.tid);
+    AddReportItem(sample, includeCallStack, thread.name_);
+}
+
+void Report::AddReportItem(const PerfRecordSample &sample, const bool includeCallStack, const std::string_view &comm)
 {
     size_t configIndex = GetConfigIndex(sample.data_.id);
     HLOG_ASSERT_MESSAGE(configs_.size() > configIndex, "in %zu configs found index %zu, from ids %llu",
@@ -99,35 +181,33 @@ void Report::AddReportItem(const PerfRecordSample &sample, const bool includeCal
         return;
     }
 
-    VirtualThread &thread = virtualRuntime_.GetThread(sample.data_.pid, sample.data_.tid);
     // if we need callstack ?
     if (includeCallStack) {
         // we will use caller mode , from last to first
         auto frameIt = sample.callFrames_.rbegin();
         auto mapName = GetAdltExtendMapName(frameIt->mapName, frameIt->originSoName);
-        ReportItem &item = configs_[configIndex].reportItems_.emplace_back(
-            sample.data_.pid, sample.data_.tid, thread.name_, mapName,
-            frameIt->funcName, frameIt->funcOffset, sample.data_.period);
-        FillReportItemCounterValues(item, sample);
-        HLOGD("ReportItem: %s", item.ToDebugString().c_str());
-        HLOG_ASSERT(!item.func_.empty());
-
-        std::vector<ReportItemCallFrame> *currentCallFrames = &item.callStacks_;
+        ReportItem newItem(sample.data_.pid, sample.data_.tid, comm, mapName,
+                           frameIt->funcName, frameIt->funcOffset, sample.data_.period);
+        FillReportItemCounterValues(newItem, sample);
+        HLOGD("ReportItem: %s", newItem.ToDebugString().c_str());
+        HLOG_ASSERT(!newItem.func_.empty());
+        ReportItem &item = InsertReportItem(configs_[configIndex], newItem);
+
+        if (item.callTreeRoot_ == ReportCallTree::INVALID_ID) {
+            item.callTreeRoot_ = callTree_.NewRoot();
+        }
+        // merge the callstack into the call tree of item level by level
+        uint32_t node = item.callTreeRoot_;
         for (frameIt = sample.callFrames_.rbegin(); frameIt != sample.callFrames_.rend();
                 frameIt++) {
             HLOG_ASSERT(frameIt->pc < PERF_CONTEXT_MAX);
-            // in add items case , right one should only have 1 callstack
-            // so just new callfames and move to next level
-            ReportItemCallFrame &nextCallFrame = currentCallFrames->emplace_back(
-                frameIt->funcName, frameIt->funcOffset, frameIt->mapName, sample.data_.period,
-                (std::next(frameIt) == sample.callFrames_.rend()) ? sample.data_.period : 0);
-            HLOGV("add callframe %s", nextCallFrame.ToDebugString().c_str());
-            currentCallFrames = &nextCallFrame.childs;
-        }
-        HLOGV("callstack %zu", item.callStacks_.size());
-        if (item.callStacks_.size() > 0) {
-            HLOGV("callstack 2nd level %zu", item.callStacks_[0].childs.size());
+            uint64_t selfEventCount =
+                (std::next(frameIt) == sample.callFrames_.rend()) ? sample.data_.period : 0;
+            uint32_t frameId = callTree_.GetFrameId(frameIt->funcName, frameIt->funcOffset, frameIt->mapName);
+            node = callTree_.AddChild(node, frameId, sample.data_.period, selfEventCount);
         }
+        HLOGV("callstack depth %zu, %zu nodes in call tree", sample.callFrames_.size(),
+              callTree_.GetNodeCount());
     } else {
         auto frameIt = sample.callFrames_.begin();
         if (frameIt != sample.callFrames_.end()) {
@@ -138,15 +218,45 @@ void Report::AddReportItem(const PerfRecordSample &sample, const bool includeCal
                 frameIt++;
             }
             auto mapName = GetAdltExtendMapName(frameIt->mapName, frameIt->originSoName);
-            ReportItem &item = configs_[configIndex].reportItems_.emplace_back(sample.data_.pid, sample.data_.tid,
-                thread.name_, mapName, frameIt->funcName, frameIt->funcOffset, sample.data_.period);
-            FillReportItemCounterValues(item, sample);
-            HLOGV("%s", item.ToDebugString().c_str());
-            HLOG_ASSERT(!item.func_.empty());
+            ReportItem newItem(sample.data_.pid, sample.data_.tid, comm, mapName,
+                               frameIt->funcName, frameIt->funcOffset, sample.data_.period);
+            FillReportItemCounterValues(newItem, sample);
+            HLOGV("%s", newItem.ToDebugString().c_str());
+            HLOG_ASSERT(!newItem.func_.empty());
+            InsertReportItem(configs_[configIndex], newItem);
         }
     }
 }
 
+void Report::MergeReport(Report &other)
+{
+    // the frame ids of other tree are mapped to this tree once
+    std::vector<uint32_t> frameMap;
+    for (size_t i = 0; i < configs_.size() && i < other.configs_.size(); i++) {
+        ReportEventConfigItem &config = configs_[i];
+        ReportEventConfigItem &otherConfig = other.configs_[i];
+        config.sampleCount_ += otherConfig.sampleCount_;
+        config.eventCount_ += otherConfig.eventCount_;
+        for (ReportItem &otherItem : otherConfig.reportItems_) {
+            uint32_t otherRoot = otherItem.callTreeRoot_;
+            otherItem.callTreeRoot_ = ReportCallTree::INVALID_ID;
+            ReportItem &item = InsertReportItem(config, otherItem);
+            if (otherRoot == ReportCallTree::INVALID_ID) {
+                continue;
+            }
+            if (item.callTreeRoot_ == ReportCallTree::INVALID_ID) {
+                item.callTreeRoot_ = callTree_.NewRoot();
+            }
+            callTree_.Merge(item.callTreeRoot_, other.callTree_, otherRoot, frameMap);
+        }
+        HLOGD("merge %zu items of %s, %zu items now", otherConfig.reportItems_.size(),
+              config.eventName_.c_str(), config.reportItems_.size());
+        otherConfig.reportItems_.clear();
+        otherConfig.reportItemIndexes_.clear();
+    }
+    other.callTree_.Clear();
+}
+
 void Report::AddReportItemBranch(const PerfRecordSample &sample)
 {
     size_t configIndex = GetConfigIndex(sample.data_.id);
@@ -159,15 +269,15 @@ void Report::AddReportItemBranch(const PerfRecordSample &sample)
             virtualRuntime_.GetSymbol(sample.data_.lbr[i].from, sample.data_.pid, sample.data_.tid);
 
         // branch only have 1 time only for period
-        ReportItem &item = configs_[configIndex].reportItems_.emplace_back(
-            sample.data_.pid, sample.data_.tid, thread.name_, symbolTo.module_, symbolTo.GetName(),
-            symbolTo.funcVaddr_, 1u);
-        FillReportItemCounterValues(item, sample);
+        ReportItem newItem(sample.data_.pid, sample.data_.tid, thread.name_, symbolTo.module_,
+                           symbolTo.GetName(), symbolTo.funcVaddr_, 1u);
+        FillReportItemCounterValues(newItem, sample);
 
-        item.fromDso_ = symbolFrom.module_;
-        item.fromFunc_ = symbolFrom.GetName();
+        newItem.fromDso_ = symbolFrom.module_;
+        newItem.fromFunc_ = symbolFrom.GetName();
 
-        HLOGV("%s 0x%" PRIx64 "", item.ToDebugString().c_str(), symbolTo.taskVaddr_);
+        HLOGV("%s 0x%" PRIx64 "", newItem.ToDebugString().c_str(), symbolTo.taskVaddr_);
+        InsertReportItem(configs_[configIndex], newItem);
     }
     configs_[configIndex].sampleCount_++;
     configs_[configIndex].eventCount_ += sample.data_.bnr;
@@ -255,20 +365,25 @@ void Report::AdjustReportItems()
                 HLOGV("reportItem %s", reportItem.ToDebugString().c_str());
             }
         }
-        // sort first.
-        HLOGD("MultiLevelSorting %" PRIu64 "", totalReportCount);
-        std::sort(config.reportItems_.begin(), config.reportItems_.end(),
-            [this] (const ReportItem &a, const ReportItem &b) -> bool {
-                return this->MultiLevelSorting(a, b);
-            });
-        HLOGD("MultiLevelSorting %" PRIu64 " done", totalReportCount);
-        // reorder the callstack
-        if (option_.debug_) {
-            for (auto &reportItem : config.reportItems_) {
-                HLOGV("reportItem %s", reportItem.ToDebugString().c_str());
+        // the items have been merged when added, unless the sort keys changed after that
+        if (!IsAggregated()) {
+            // sort first.
+            HLOGD("MultiLevelSorting %" PRIu64 "", totalReportCount);
+            std::sort(config.reportItems_.begin(), config.reportItems_.end(),
+                [this] (const ReportItem &a, const ReportItem &b) -> bool {
+                    return this->MultiLevelSorting(a, b);
+                });
+            HLOGD("MultiLevelSorting %" PRIu64 " done", totalReportCount);
+            // reorder the callstack
+            if (option_.debug_) {
+                for (auto &reportItem : config.reportItems_) {
+                    HLOGV("reportItem %s", reportItem.ToDebugString().c_str());
+                }
             }
+            StatisticsRecords();
         }
-        StatisticsRecords();
+        // items will be reordered and removed, the indexes can not be used any more
+        config.reportItemIndexes_.clear();
         FilterDisplayRecords();
 
         // reorder by count
@@ -277,14 +392,34 @@ void Report::AdjustReportItems()
 
         // reorder the callstack
         for (auto &reportItem : config.reportItems_) {
+            if (reportItem.callTreeRoot_ != ReportCallTree::INVALID_ID) {
+                ExportCallFrames(reportItem.callTreeRoot_, reportItem.callStacks_);
+                reportItem.callTreeRoot_ = ReportCallTree::INVALID_ID;
+            }
             ReportItemCallFrame::OrderCallFrames(reportItem.callStacks_);
         }
         HLOGD("afater sorting and unique, we have %zu report items,", config.reportItems_.size());
     }
+    // the indexes are dropped, the items added after this are merged by the sort and unique pass
+    itemsNotIndexed_ = true;
+    // all the callstacks have been exported
+    callTree_.Clear();
     // udpate percentage
     UpdateReportItemsAfterAdjust();
 }
 
+void Report::ExportCallFrames(const uint32_t parent, std::vector<ReportItemCallFrame> &callFrames)
+{
+    for (uint32_t child = callTree_.GetNode(parent).firstChild; child != ReportCallTree::INVALID_ID;
+         child = callTree_.GetNode(child).nextSibling) {
+        const ReportCallTree::Node &node = callTree_.GetNode(child);
+        const ReportCallTree::Frame &frame = callTree_.GetFrame(node.frameId);
+        ReportItemCallFrame &callFrame = callFrames.emplace_back(std::string(frame.func), frame.vaddr,
+            std::string(frame.dso), node.eventCount, node.selfEventCount);
+        ExportCallFrames(child, callFrame.childs);
+    }
+}
+
 int Report::MultiLevelCompare(const ReportItem &a, const ReportItem &b)
 {
     HLOGM("MultiLevelCompare %s vs %s sort order %s", a.ToDebugString().c_str(),
@@ -372,6 +507,14 @@ bool Report::MultiLevelSameAndUpdateCount(ReportItem &l, ReportItem &r)
     }
     HLOGM("l %" PRIu64 " %s c:%zu vs r %" PRIu64 " %s c:%zu", l.eventCount_, l.func_.data(),
             l.callStacks_.size(), r.eventCount_, r.func_.data(), r.callStacks_.size());
+    if (r.callTreeRoot_ != ReportCallTree::INVALID_ID) {
+        if (l.callTreeRoot_ == ReportCallTree::INVALID_ID) {
+            l.callTreeRoot_ = r.callTreeRoot_;
+        } else {
+            callTree_.Merge(l.callTreeRoot_, r.callTreeRoot_);
+        }
+        r.callTreeRoot_ = ReportCallTree::INVALID_ID;
+    }
     // if it have call stack?
     if (r.callStacks_.size() != 0) {
         // add to left (right to left)
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define HILOG_TAG "Report"
+
+#include "report_call_tree.h"
+
+#include <functional>
+#include <utility>
+
+#include "debug_logger.h"
+#include "dfx_symbol.h"
+#include "hiperf_hilog.h"
+#include "utilities.h"
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+size_t ReportCallTree::FrameHash::operator()(const Frame &frame) const
+{
+    size_t hash = std::hash<std::string_view>()(frame.func);
+    HashCombine(hash, std::hash<uint64_t>()(frame.vaddr));
+    HashCombine(hash, std::hash<std::string_view>()(frame.dso));
+    return hash;
+}
+
+uint32_t ReportCallTree::NewRoot()
+{
+    nodes_.emplace_back();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+uint32_t ReportCallTree::GetFrameId(const std::string_view &func, const uint64_t vaddr, const std::string_view &dso)
+{
+    auto it = frameIds_.find({func, vaddr, dso});
+    if (it != frameIds_.end()) {
+        return it->second;
+    }
+    // the strings of the sample will be released, keep them by the string pool
+    Frame &frame = frames_.emplace_back();
+    frame.func = HiviewDFX::StringViewHold::Get().Hold(func);
+    frame.vaddr = vaddr;
+    frame.dso = HiviewDFX::StringViewHold::Get().Hold(dso);
+    uint32_t frameId = static_cast<uint32_t>(frames_.size() - 1);
+    frameIds_.emplace(frame, frameId);
+    return frameId;
+}
+
+uint32_t ReportCallTree::AddChild(const uint32_t parent, const uint32_t frameId, const uint64_t eventCount,
+                                  const uint64_t selfEventCount)
+{
+    HLOG_ASSERT(parent < nodes_.size() && frameId < frames_.size());
+    auto [it, inserted] = childIds_.try_emplace(GetChildKey(parent, frameId), static_cast<uint32_t>(nodes_.size()));
+    if (inserted) {
+        Node &child = nodes_.emplace_back();
+        child.frameId = frameId;
+        child.nextSibling = nodes_[parent].firstChild;
+        nodes_[parent].firstChild = it->second;
+    }
+    Node &child = nodes_[it->second];
+    child.eventCount += eventCount;
+    child.selfEventCount += selfEventCount;
+    return it->second;
+}
+
+// the nodes of from are left in the pool until Clear()
+void ReportCallTree::Merge(const uint32_t to, const uint32_t from)
+{
+    std::vector<std::pair<uint32_t, uint32_t>> pending = {{to, from}};
+    while (!pending.empty()) {
+        auto [toNode, fromNode] = pending.back();
+        pending.pop_back();
+        for (uint32_t child = nodes_[fromNode].firstChild; child != INVALID_ID; child = nodes_[child].nextSibling) {
+            uint32_t toChild =
+                AddChild(toNode, nodes_[child].frameId, nodes_[child].eventCount, nodes_[child].selfEventCount);
+            pending.emplace_back(toChild, child);
+        }
+    }
+}
+
+void ReportCallTree::Merge(const uint32_t to, const ReportCallTree &other, const uint32_t from,
+                           std::vector<uint32_t> &frameMap)
+{
+    if (frameMap.size() < other.frames_.size()) {
+        frameMap.resize(other.frames_.size(), INVALID_ID);
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> pending = {{to, from}};
+    while (!pending.empty()) {
+        auto [toNode, fromNode] = pending.back();
+        pending.pop_back();
+        for (uint32_t child = other.nodes_[fromNode].firstChild; child != INVALID_ID;
+             child = other.nodes_[child].nextSibling) {
+            const Node &node = other.nodes_[child];
+            uint32_t &frameId = frameMap[node.frameId];
+            if (frameId == INVALID_ID) {
+                const Frame &frame = other.frames_[node.frameId];
+                frameId = GetFrameId(frame.func, frame.vaddr, frame.dso);
+            }
+            pending.emplace_back(AddChild(toNode, frameId, node.eventCount, node.selfEventCount), child);
+        }
+    }
+}
+
+void ReportCallTree::Clear()
+{
+    nodes_.clear();
+    nodes_.shrink_to_fit();
+    frames_.clear();
+    frames_.shrink_to_fit();
+    frameIds_.clear();
+    childIds_.clear();
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
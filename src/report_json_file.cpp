@@ -36,28 +36,24 @@ void ReportJsonFile::AddNewFunction(const int libId, std::string name)
     if (it == functionMap_.end()) {
         it = functionMap_.try_emplace(libId).first;
     }
-    name = StringReplace(name, "\\", "\\\\");
-    name = StringReplace(name, "\"", "");
-    it->second.insert_or_assign(name, ReportFuncMapItem(libId, name, functionId_++));
+    // the name is escaped when it is written
+    auto funcIt = it->second.insert_or_assign(name, ReportFuncMapItem(libId, name, functionId_++)).first;
+    functionList_.emplace_back(&funcIt->second);
 }
 
-void ReportJsonFile::OutputJsonFunctionMap(FILE *output)
+void ReportJsonFile::OutputJsonFunctionMap(JsonWriter &output)
 {
-    std::string key = "SymbolMap";
-    if (fprintf(output, "\"%s\":{", key.c_str()) != -1) {
-        bool first = true;
-
-        for (const auto& [libId, funcMap] : functionMap_) {
-            for (const auto& [_, reportFuncMapItem] : funcMap) {
-                if (!reportFuncMapItem.hiddenFlag) {
-                    OutputJsonPair(output, reportFuncMapItem.reportFuncId_, reportFuncMapItem, first);
-                    first = false;
-                }
-            }
+    output.Write("\"SymbolMap\":{");
+    bool first = true;
+    for (size_t id = 0; id < functionList_.size(); id++) {
+        const ReportFuncMapItem &reportFuncMapItem = *functionList_[id];
+        // the function is replaced if the same name is added again
+        if (!reportFuncMapItem.hiddenFlag && reportFuncMapItem.reportFuncId_ == static_cast<int>(id)) {
+            OutputJsonPair(output, reportFuncMapItem.reportFuncId_, reportFuncMapItem, first);
+            first = false;
         }
-
-        fprintf(output, "}");
     }
+    output.Write('}');
 }
 
 void ReportJsonFile::ProcessSymbolsFiles(
@@ -102,6 +98,30 @@ void ReportJsonFile::UpdateCallNodeEventCount()
     }
 }
 
+void ReportCallNodeItem::OutputJson(JsonWriter &output) const
+{
+    using ChildIt = std::map<int, ReportCallNodeItem>::const_iterator;
+    // the nodes from this one to the current one, and the next child of each node to output
+    std::vector<std::pair<const ReportCallNodeItem *, ChildIt>> path;
+    OutputJsonHead(output);
+    path.emplace_back(this, childrenMap.begin());
+    while (!path.empty()) {
+        auto &[node, childIt] = path.back();
+        if (childIt == node->childrenMap.end()) {
+            output.Write("]}");
+            path.pop_back();
+            continue;
+        }
+        if (childIt != node->childrenMap.begin()) {
+            output.Write(',');
+        }
+        const ReportCallNodeItem &child = childIt->second;
+        childIt++;
+        child.OutputJsonHead(output);
+        path.emplace_back(&child, child.childrenMap.begin());
+    }
+}
+
 ReportConfigItem &ReportJsonFile::GetConfig(const uint64_t id)
 {
     for (auto &configpair : reportConfigItems_) {
@@ -165,7 +185,7 @@ void ReportJsonFile::AddReportCallStack(const uint64_t eventCount, ReportCallNod
     std::map<int, ReportCallNodeItem> *child = &callNode.childrenMap;
     auto it = frames.begin();
     while (it != frames.end()) {
-        int libId = GetLibID(it->mapName, it->originSoName, it->funcName);
+        int libId = GetLibID(*it);
         if (libId >= 0) {
             int funcId = GetFunctionID(libId, it->funcName);
             // new children funid
@@ -197,7 +217,7 @@ void ReportJsonFile::AddReportCallStackReverse(const uint64_t eventCount, Report
     std::map<int, ReportCallNodeItem> *child = &callNode.childrenMap;
     auto it = frames.rbegin();
     while (it != frames.rend()) {
-        int libId = GetLibID(it->mapName, it->originSoName, it->funcName);
+        int libId = GetLibID(*it);
         if (libId >= 0) {
             int funcId = GetFunctionID(libId, it->funcName);
             // new children funid
@@ -234,27 +254,59 @@ std::string ReportJsonFile::GetConfigName(const uint64_t id)
     return config.eventName_;
 }
 
-int ReportJsonFile::GetLibID(const std::string filepath, const std::string originSoName, const std::string funcName)
+void ReportJsonFile::IndexLibs()
 {
-    std::string newFilePath = filepath;
+    if (indexedLibCount_ > libList_.size()) {
+        // libList_ has been replaced
+        libIds_.clear();
+        libIdsBySymbolsFile_.clear();
+        indexedLibCount_ = 0;
+    }
+    for (; indexedLibCount_ < libList_.size(); indexedLibCount_++) {
+        // the first one is used for the same path
+        auto it = libIds_.try_emplace(libList_[indexedLibCount_], static_cast<int>(indexedLibCount_)).first;
+        libIdsBySymbolsFile_.emplace_back(it->second);
+    }
+}
+
+int ReportJsonFile::FindLibID(const std::string_view &filepath)
+{
+    IndexLibs();
+    auto it = libIds_.find(filepath);
+    return it == libIds_.end() ? -1 : it->second;
+}
+
+int ReportJsonFile::GetLibID(const std::string &filepath, const std::string &originSoName, const std::string &funcName)
+{
+    std::string newFilePath;
     if (filepath.find("libadlt") != std::string::npos && EndsWith(filepath.data(), ".so")) {
         HLOGW("extendName: %s", originSoName.c_str());
         if (!originSoName.empty()) {
             newFilePath = filepath + ":" + originSoName;
-            auto oldIt = std::find(libList_.begin(), libList_.end(), std::string_view(filepath));
-            if (oldIt != libList_.end()) {
-                int oldLibId = oldIt - libList_.begin();
+            int oldLibId = FindLibID(filepath);
+            if (oldLibId >= 0) {
                 HiddenFunctionInLib(oldLibId, funcName);
             }
         }
     }
-    auto it = std::find(libList_.begin(), libList_.end(), std::string_view(newFilePath));
-    if (it != libList_.end()) {
-        return it - libList_.begin();
-    } else {
+    int libId = FindLibID(newFilePath.empty() ? filepath : newFilePath);
+    if (libId < 0) {
         HLOGE("'%s' not found in lib list, liblist size: %zu", filepath.data(), libList_.size());
-        return -1;
     }
+    return libId;
+}
+
+// libList_ is built from the symbols files in order, so the symbols file index set at symbolization
+// selects the lib unless the path is extended by adlt
+int ReportJsonFile::GetLibID(const DfxFrame &frame)
+{
+    if (frame.originSoName.empty() && frame.symbolFileIndex >= 0) {
+        IndexLibs();
+        if (static_cast<size_t>(frame.symbolFileIndex) < libIdsBySymbolsFile_.size()) {
+            return libIdsBySymbolsFile_[frame.symbolFileIndex];
+        }
+    }
+    return GetLibID(frame.mapName, frame.originSoName, frame.funcName);
 }
 
 void ReportJsonFile::UpdateReportCallStack(const uint64_t id, const pid_t pid, const pid_t tid,
@@ -269,7 +321,7 @@ void ReportJsonFile::UpdateReportCallStack(const uint64_t id, const pid_t pid, c
     bool jsFrame = StringEndsWith(it->mapName, "stub.an");
     size_t skipFrame = 0;
     while (it != frames.end()) {
-        int libId = GetLibID(it->mapName, it->originSoName, it->funcName);
+        int libId = GetLibID(*it);
         if (libId < 0) {
             HLOGW("not found lib path %s", it->mapName.data());
             it++;
@@ -317,25 +369,25 @@ void ReportJsonFile::UpdateReportCallStack(const uint64_t id, const pid_t pid, c
     AddReportCallStack(eventCount, thread.callNodeReverse, frames);
 }
 
-void ReportJsonFile::OutputJsonFeatureString()
+void ReportJsonFile::OutputJsonFeatureString(JsonWriter &output)
 {
-    OutputJsonPair(output_, "deviceTime",
+    OutputJsonPair(output, "deviceTime",
                    recordFileReader_->GetFeatureString(FEATURE::HIPERF_RECORD_TIME), true);
     std::string device = recordFileReader_->GetFeatureString(FEATURE::HOSTNAME);
     device.append(" " + recordFileReader_->GetFeatureString(FEATURE::OSRELEASE));
     device.append(" " + recordFileReader_->GetFeatureString(FEATURE::ARCH));
 
-    OutputJsonPair(output_, "deviceType", device);
+    OutputJsonPair(output, "deviceType", device);
 
-    OutputJsonPair(output_, "osVersion", recordFileReader_->GetFeatureString(FEATURE::OSRELEASE));
+    OutputJsonPair(output, "osVersion", recordFileReader_->GetFeatureString(FEATURE::OSRELEASE));
 
-    OutputJsonPair(output_, "deviceCommandLine",
+    OutputJsonPair(output, "deviceCommandLine",
                    recordFileReader_->GetFeatureString(FEATURE::CMDLINE));
 
-    OutputJsonPair(output_, "totalRecordSamples", sampleCount_);
+    OutputJsonPair(output, "totalRecordSamples", sampleCount_);
 }
 
-void ReportJsonFile::OutputJsonRuntimeInfo()
+void ReportJsonFile::OutputJsonRuntimeInfo(JsonWriter &output)
 {
     const auto &threadMaps = virtualRuntime_.GetThreads();
     std::map<std::string, std::string> jsonProcesses;
@@ -349,44 +401,34 @@ void ReportJsonFile::OutputJsonRuntimeInfo()
         jsonThreads.emplace(std::to_string(thread.tid_), thread.name_);
     }
 
-    OutputJsonMap(output_, "processNameMap", jsonProcesses);
+    OutputJsonMap(output, "processNameMap", jsonProcesses);
 
-    OutputJsonMap(output_, "threadNameMap", jsonThreads);
+    OutputJsonMap(output, "threadNameMap", jsonThreads);
 
     const auto &symbolsFiles = virtualRuntime_.GetSymbolsFiles();
-    jsonStringVector jsonFilePaths;
+    std::vector<std::string_view> jsonFilePaths;
     for (const auto &symbolsFile : symbolsFiles) {
-        std::string filePath = StringReplace(symbolsFile->filePath_, "\"", "");
-        jsonFilePaths.emplace_back(filePath);
+        jsonFilePaths.emplace_back(symbolsFile->filePath_);
     }
 
-    OutputJsonVectorList(output_, "symbolsFileList", jsonFilePaths);
-    if (fprintf(output_, ",") < 0) {
-        return;
-    }
+    OutputJsonVectorList(output, "symbolsFileList", jsonFilePaths);
+    output.Write(',');
 
-    OutputJsonFunctionMap(output_);
-    if (fprintf(output_, ",") < 0) {
-        return;
-    }
+    OutputJsonFunctionMap(output);
+    output.Write(',');
 
-    OutputJsonMapList(output_, "recordSampleInfo", reportConfigItems_, true);
+    OutputJsonMapList(output, "recordSampleInfo", reportConfigItems_, true);
 }
 
 bool ReportJsonFile::OutputJson(FILE *output)
 {
     CHECK_TRUE(output != nullptr, false, 0, "");
-    output_ = output;
-    if (fprintf(output, "{") < 0) {
-        return false;
-    }
-    OutputJsonFeatureString();
-    OutputJsonRuntimeInfo();
-
-    if (fprintf(output, "}") < 0) {
-        return false;
-    }
-    return true;
+    JsonWriter writer(output);
+    writer.Write('{');
+    OutputJsonFeatureString(writer);
+    OutputJsonRuntimeInfo(writer);
+    writer.Write('}');
+    return writer.Flush();
 }
 } // namespace HiPerf
 } // namespace Developtools
@@ -43,21 +43,12 @@ RingBuffer::~RingBuffer()
 // get size of the writable space
 size_t RingBuffer::GetFreeSize() const
 {
-    return size_ - (head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_relaxed));
+    return size_ - (writeHead_ - tail_.load(std::memory_order_relaxed));
 }
 
-uint8_t *RingBuffer::AllocForWrite(const size_t writeSize)
+uint8_t *RingBuffer::AllocAt(const size_t writeSize, const size_t readHead)
 {
-    if (buf_ == nullptr) {
-        HLOGE("buf_ is nullptr");
-        return nullptr;
-    }
-    size_t writeHead = head_.load(std::memory_order_relaxed);
-    size_t readHead = tail_.load(std::memory_order_acquire);
-    if (size_ == 0) {
-        return nullptr;
-    }
-    size_t writePos = writeHead % size_;
+    size_t writePos = writeHead_ % size_;
     size_t readPos = readHead % size_;
     writeSize_ = writeSize;
     if (writePos < readPos) {
@@ -65,7 +56,7 @@ uint8_t *RingBuffer::AllocForWrite(const size_t writeSize)
         if (writePos + writeSize > readPos) {
             return nullptr;
         }
-    } else if (writePos == readPos && writeHead != readHead) {
+    } else if (writePos == readPos && writeHead_ != readHead) {
         // writePos catch up with readPos, but buffer is full
         return nullptr;
     } else {
@@ -86,28 +77,69 @@ uint8_t *RingBuffer::AllocForWrite(const size_t writeSize)
     return buf_.get() + writePos;
 }
 
+uint8_t *RingBuffer::AllocForWrite(const size_t writeSize)
+{
+    if (buf_ == nullptr) {
+        HLOGE("buf_ is nullptr");
+        return nullptr;
+    }
+    if (size_ == 0) {
+        return nullptr;
+    }
+    // try with the tail seen last time first, reader only makes more space
+    uint8_t *buf = AllocAt(writeSize, cachedTail_);
+    if (buf == nullptr) {
+        cachedTail_ = tail_.load(std::memory_order_acquire);
+        buf = AllocAt(writeSize, cachedTail_);
+    }
+    return buf;
+}
+
 void RingBuffer::EndWrite()
+{
+    writeHead_ += writeSize_;
+    if (writeHead_ - head_.load(std::memory_order_relaxed) >= size_ / AUTO_COMMIT_DIVISOR) {
+        PublishHead();
+    }
+}
+
+void RingBuffer::PublishHead()
 {
     size_t head = head_.load(std::memory_order_relaxed);
-    head += writeSize_;
-    head_.store(head, std::memory_order_release);
+    if (head == writeHead_) {
+        return;
+    }
+    head_.store(writeHead_, std::memory_order_seq_cst);
+    // pairs with CommitRead, one of writer and reader must see the other
+    if (tail_.load(std::memory_order_seq_cst) == head) {
+        needWakeup_ = true;
+    }
+}
+
+bool RingBuffer::CommitWrite()
+{
+    PublishHead();
+    bool needWakeup = needWakeup_;
+    needWakeup_ = false;
+    return needWakeup;
 }
 
 uint8_t *RingBuffer::GetReadData()
 {
     CHECK_TRUE(buf_ != nullptr && buf_.get() != nullptr, nullptr, 0, "");
-    size_t writeHead = head_.load(std::memory_order_acquire);
-    size_t readHead = tail_.load(std::memory_order_relaxed);
-    if (writeHead == readHead) {
-        return nullptr;
+    if (cachedHead_ == readTail_) {
+        cachedHead_ = head_.load(std::memory_order_acquire);
+        if (cachedHead_ == readTail_) {
+            return nullptr;
+        }
     }
 
     readSize_ = 0;
     if (size_ == 0) {
         return nullptr;
     }
-    size_t writePos = writeHead % size_;
-    size_t readPos = readHead % size_;
+    size_t writePos = cachedHead_ % size_;
+    size_t readPos = readTail_ % size_;
     if (writePos <= readPos) {
         // |<---data2--->writePos---readPos<---data1--->|
         if (buf_.get()[readPos] == MARGIN_BYTE) {
@@ -131,9 +163,18 @@ uint8_t *RingBuffer::GetReadData()
 
 void RingBuffer::EndRead()
 {
-    size_t tail = tail_.load(std::memory_order_relaxed);
-    tail += readSize_;
-    tail_.store(tail, std::memory_order_release);
+    readTail_ += readSize_;
+    if (readTail_ - tail_.load(std::memory_order_relaxed) >= size_ / AUTO_COMMIT_DIVISOR) {
+        tail_.store(readTail_, std::memory_order_release);
+    }
+}
+
+bool RingBuffer::CommitRead()
+{
+    tail_.store(readTail_, std::memory_order_seq_cst);
+    // pairs with PublishHead, see the head published before the tail is stored
+    cachedHead_ = head_.load(std::memory_order_seq_cst);
+    return cachedHead_ == readTail_;
 }
 } // namespace HiPerf
 } // namespace Developtools
@@ -73,6 +73,14 @@ bool SubCommandDump::CheckOptions()
     if (!CheckInputFile()) {
         return false;
     }
+    if (rangeStartTime_ > rangeEndTime_) {
+        printf("--start-time %" PRIu64 " is later than --end-time %" PRIu64 "\n", rangeStartTime_, rangeEndTime_);
+        return false;
+    }
+    if (rangePid_ < -1) {
+        printf("invalid --pid %d\n", rangePid_);
+        return false;
+    }
     if (!CheckOutputFile()) {
         return false;
     }
@@ -116,6 +124,18 @@ bool SubCommandDump::ParseOption(std::vector<std::string> &args)
         HLOGD("get option --export failed");
         return false;
     }
+    if (!Option::GetOptionValue(args, "--pid", rangePid_)) {
+        HLOGD("get option --pid failed");
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "--start-time", rangeStartTime_)) {
+        HLOGD("get option --start-time failed");
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "--end-time", rangeEndTime_)) {
+        HLOGD("get option --end-time failed");
+        return false;
+    }
 
     if (dumpHeader_ || dumpFeatures_ || dumpData_) {
         dumpAll_ = false;
@@ -171,7 +191,7 @@ HiperfError SubCommandDump::OnSubCommand(std::vector<std::string>& args)
     }
 #endif
 
-    if (access(dumpFileName_.c_str(), F_OK) != 0) {
+    if (dumpFileName_ != PIPE_OUTPUT_STDIO && access(dumpFileName_.c_str(), F_OK) != 0) {
         printf("Can not access data file %s\n", dumpFileName_.c_str());
         return HiperfError::ACCESS_DATA_FILE_FAIL;
     }
@@ -508,7 +528,15 @@ void SubCommandDump::DumpDataPortion(const int indent)
         return true;
     };
 
-    reader_->ReadDataSection(recordcCallback);
+    if (IsRangeDump()) {
+        if (reader_->GetFeatureSections().empty()) {
+            // the record index is a feature
+            reader_->ReadFeatureSection();
+        }
+        reader_->ReadDataSectionInRange(recordcCallback, rangeStartTime_, rangeEndTime_, rangePid_);
+    } else {
+        reader_->ReadDataSection(recordcCallback);
+    }
 
     PRINT_INDENT(indent, "\n ======= there are %d records ======== \n", recordCount);
 }
@@ -587,6 +615,25 @@ void SubCommandDump::DumpFeatureSection(const int indent, const std::unique_ptr<
             PRINT_INDENT(indent + INDENT_TWO, "get StackTable failed\n");
         }
         return;
+    } else if (featureSection.get()->featureId_ == FEATURE::HIPERF_COMPRESSED_DATA) {
+        uint64_t rawSize = 0;
+        static_cast<const PerfFileSectionU64 *>(featureSection.get())->GetValue(rawSize);
+        PRINT_INDENT(indent + INDENT_TWO, "uncompressed data size: %" PRIu64 "\n", rawSize);
+        return;
+    } else if (featureSection.get()->featureId_ == FEATURE::HIPERF_RECORD_INDEX) {
+        const PerfFileSectionRecordIndex *sectionRecordIndex =
+            static_cast<const PerfFileSectionRecordIndex *>(featureSection.get());
+        PRINT_INDENT(indent + INDENT_TWO, "blocks: %zu\n", sectionRecordIndex->entries_.size());
+        for (const RecordIndexEntry &entry : sectionRecordIndex->entries_) {
+            PRINT_INDENT(indent + INDENT_TWO + 1, "offset %" PRIu64 " size %" PRIu64 " flags 0x%x", entry.offset,
+                         entry.size, entry.flags);
+            if (entry.minTime <= entry.maxTime) {
+                PRINT_INDENT(0, " time %" PRIu64 "-%" PRIu64 " pids %zu", entry.minTime, entry.maxTime,
+                             entry.pids.size());
+            }
+            PRINT_INDENT(0, "\n");
+        }
+        return;
     } else {
         PRINT_INDENT(indent + INDENT_TWO, "not support dump this feature(%d).\n", featureSection.get()->featureId_);
     }
@@ -30,6 +30,7 @@
 #include <parameters.h>
 #endif
 
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/utsname.h>
 #include <sys/wait.h>
@@ -43,15 +44,21 @@
 #endif
 #include "ipc_utilities.h"
 #include "option.h"
+#include "parallel_symbol_resolver.h"
 #include "perf_event_record.h"
 #include "perf_file_reader.h"
 #include "subcommand_report.h"
+#include "symbol_cache.h"
 #include "utilities.h"
 
 using namespace std::chrono;
 namespace OHOS {
 namespace Developtools {
 namespace HiPerf {
+// records are read back and unwound in batches of this size
+constexpr size_t DELAY_UNWIND_BATCH_SIZE = 32 * 1024 * 1024;
+// the rewritten part of temp file is released in blocks of this size
+constexpr uint64_t DELAY_UNWIND_RELEASE_SIZE = 64 * 1024 * 1024;
 const std::string PERF_CPU_TIME_MAX_PERCENT = "/proc/sys/kernel/perf_cpu_time_max_percent";
 const std::string PERF_EVENT_MAX_SAMPLE_RATE = "/proc/sys/kernel/perf_event_max_sample_rate";
 const std::string PERF_EVENT_MLOCK_KB = "/proc/sys/kernel/perf_event_mlock_kb";
@@ -118,6 +125,7 @@ uint64_t GetBranchSampleType(const std::string &name)
 
 SubCommandRecord::~SubCommandRecord()
 {
+    WaitBackgroundTasks();
     CloseReplyThread();
     CloseClientThread();
     if (readFd_ != -1) {
@@ -164,12 +172,21 @@ void SubCommandRecord::DumpOptions() const
     printf(" sampleRaw_:\t%d\n", sampleRaw_);
     printf(" parallelSymbols_:\t%d\n", parallelSymbols_);
     printf(" symbolDir_:\t%s\n", VectorToString(symbolDir_).c_str());
+    printf(" symbolCacheDir_:\t%s\n", symbolCacheDir_.c_str());
     printf(" outputFilename_:\t%s\n", outputFilename_.c_str());
     printf(" appPackage_:\t%s\n", appPackage_.c_str());
     printf(" checkAppMs_:\t%d\n", checkAppMs_);
     printf(" clockId_:\t%s\n", clockId_.c_str());
     printf(" mmapPages_:\t%d\n", mmapPages_);
+    printf(" mmapReaders_:\t%d\n", mmapReaders_);
+    printf(" mmapAdaptive_:\t%s\n", mmapAdaptive_ ? "true" : "false");
+    printf(" compressLevel_:\t%d\n", compressLevel_);
+    printf(" directIo_:\t%s\n", directIo_ ? "true" : "false");
+    printf(" reorderWindowMs_:\t%d\n", reorderWindowMs_);
     printf(" dataLimit:\t%s\n", strLimit_.c_str());
+    printf(" splitSize:\t%s\n", strSplitSize_.c_str());
+    printf(" splitTimeSec_:\t%d\n", splitTimeSec_);
+    printf(" splitMaxFiles_:\t%d\n", splitMaxFiles_);
     printf(" callStack:\t%s\n", VectorToString(callStackType_).c_str());
     printf(" branchSampleTypes:\t%s\n", VectorToString(vecBranchFilters_).c_str());
     printf(" trackedCommand:\t%s\n", VectorToString(trackedCommand_).c_str());
@@ -248,6 +265,12 @@ bool SubCommandRecord::GetOptions(std::vector<std::string> &args)
     if (!Option::GetOptionValue(args, "-z", compressData_)) {
         return false;
     }
+    if (!Option::GetOptionValue(args, "--compress-level", compressLevel_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "--direct-io", directIo_)) {
+        return false;
+    }
     if (!Option::GetOptionValue(args, "--no-inherit", noInherit_)) {
         return false;
     }
@@ -278,16 +301,27 @@ bool SubCommandRecord::GetOptions(std::vector<std::string> &args)
     if (!Option::GetOptionValue(args, "--raw-data", sampleRaw_)) {
         return false;
     }
-    bool hasCpuLimit = Option::FindOption(args, "--cpu-limit") != args.end();
     if (!Option::GetOptionValue(args, "--cpu-limit", cpuPercent_)) {
         return false;
     }
     if (!Option::GetOptionValue(args, "-m", mmapPages_)) {
         return false;
     }
+    if (!Option::GetOptionValue(args, "--mmap-readers", mmapReaders_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "--mmap-adaptive", mmapAdaptive_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "--reorder-window", reorderWindowMs_)) {
+        return false;
+    }
     if (!Option::GetOptionValue(args, "--symbol-dir", symbolDir_)) {
         return false;
     }
+    if (!Option::GetOptionValue(args, "--symbol-cache", symbolCacheDir_)) {
+        return false;
+    }
     if (!Option::GetOptionValue(args, "-o", outputFilename_)) {
         return false;
     }
@@ -356,11 +390,6 @@ bool SubCommandRecord::GetOptions(std::vector<std::string> &args)
     if (!Option::GetOptionValue(args, "--parallel-symbolic", parallelSymbols_)) {
         return false;
     }
-    if (parallelSymbols_ && hasCpuLimit) {
-        printf("--parallel-symbolic option is conflict with --cpu-limit.\n");
-        HLOGE("--parallel-symbolic option is conflict with --cpu-limit.");
-        return false;
-    }
     if (!callStackType_.empty()) {
         if (!callStackType.empty()) {
             printf("'-s %s --call-stack %s' option usage error, please check usage.\n",
@@ -373,6 +402,15 @@ bool SubCommandRecord::GetOptions(std::vector<std::string> &args)
     if (!Option::GetOptionValue(args, "--data-limit", strLimit_)) {
         return false;
     }
+    if (!Option::GetOptionValue(args, "--split-size", strSplitSize_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "--split-time", splitTimeSec_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "--split-max-files", splitMaxFiles_)) {
+        return false;
+    }
     if (!Option::GetOptionValue(args, "-j", vecBranchFilters_)) {
         return false;
     }
@@ -452,6 +490,65 @@ bool SubCommandRecord::CheckDataLimitOption()
     return true;
 }
 
+bool SubCommandRecord::CheckSplitOption()
+{
+    if (!strSplitSize_.empty() && !ParseSizeOption(strSplitSize_, splitSize_)) {
+        printf("Invalid --split-size value %s\n", strSplitSize_.c_str());
+        return false;
+    }
+    if (CheckOutOfRange<int>(splitTimeSec_, 0, MAX_SPLIT_TIME_SEC)) {
+        printf("Invalid --split-time value '%d', value should be in 1~%d \n", splitTimeSec_, MAX_SPLIT_TIME_SEC);
+        return false;
+    }
+    if (CheckOutOfRange<int>(splitMaxFiles_, 0, MAX_SPLIT_FILES)) {
+        printf("Invalid --split-max-files value '%d', value should be in 0~%d \n", splitMaxFiles_, MAX_SPLIT_FILES);
+        return false;
+    }
+    if (splitSize_ == 0 && splitTimeSec_ == 0) {
+        if (splitMaxFiles_ > 0) {
+            printf("--split-max-files must be used with --split-size or --split-time.\n");
+            return false;
+        }
+        return true;
+    }
+    // every file is finished with its own symbols, the later steps work on one file only
+    // the closed files are symbolized from their own records, the dedup stack table lives in the runtime
+    if (dataSizeLimit_ > 0 || delayUnwind_ || backtrack_ || dedupStack_) {
+        printf("--split-size and --split-time can not be used with --data-limit, --delay-unwind, --backtrack "
+               "or --dedup_stack.\n");
+        return false;
+    }
+    return true;
+}
+
+bool SubCommandRecord::CheckStreamOption()
+{
+    CHECK_TRUE(PerfFileWriter::IsStreamOutput(outputFilename_), true, 0, "");
+    // the stream can not be compressed or read back after recording
+    if (compressData_ || delayUnwind_ || backtrack_ || report_ || splitSize_ > 0 || splitTimeSec_ > 0) {
+        printf("stream output %s can not be used with -z, --delay-unwind, --backtrack, --report or --split-*.\n",
+               outputFilename_.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool SubCommandRecord::PrepareStreamOutput()
+{
+    CHECK_TRUE(PerfFileWriter::IsStreamOutput(outputFilename_), true, 0, "");
+    // the consumer may exit early, let the write fail rather than be killed
+    signal(SIGPIPE, SIG_IGN);
+    if (outputFilename_ == PIPE_OUTPUT_STDIO) {
+        // records own stdout, messages are printed to stderr from now on
+        fflush(stdout);
+        int fd = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 0);
+        CHECK_TRUE(fd >= 0 && dup2(STDERR_FILENO, STDOUT_FILENO) >= 0, false, 1, "redirect stdout failed, errno:%d",
+                   errno);
+        outputFilename_ = PIPE_OUTPUT_FD_PREFIX + std::to_string(fd);
+    }
+    return true;
+}
+
 bool SubCommandRecord::CheckSelectCpuPidOption()
 {
     if (!selectCpus_.empty()) {
@@ -516,6 +613,21 @@ bool SubCommandRecord::CheckArgsRange()
                mmapPages_, MIN_PERF_MMAP_PAGE, MAX_PERF_MMAP_PAGE);
         return false;
     }
+    const int maxMmapReaders = sysconf(_SC_NPROCESSORS_CONF);
+    if (CheckOutOfRange<int>(mmapReaders_, 0, maxMmapReaders)) {
+        printf("Invalid --mmap-readers value '%d', value should be in 0~%d \n", mmapReaders_, maxMmapReaders);
+        return false;
+    }
+    if (CheckOutOfRange<int>(compressLevel_, MIN_COMPRESS_LEVEL, MAX_COMPRESS_LEVEL)) {
+        printf("Invalid --compress-level value '%d', value should be in %d~%d \n",
+               compressLevel_, MIN_COMPRESS_LEVEL, MAX_COMPRESS_LEVEL);
+        return false;
+    }
+    if (CheckOutOfRange<int>(reorderWindowMs_, 0, MAX_REORDER_WINDOW_MS)) {
+        printf("Invalid --reorder-window value '%d', value should be in 0~%d \n",
+               reorderWindowMs_, MAX_REORDER_WINDOW_MS);
+        return false;
+    }
     if (CheckOutOfRange<int>(cmdlinesSize_, MIN_SAVED_CMDLINES_SIZE, MAX_SAVED_CMDLINES_SIZE) ||
         !PowerOfTwo(cmdlinesSize_)) {
         printf("Invalid --cmdline-size value '%d', value should be in %d~%d and must be a power of two \n",
@@ -565,6 +677,12 @@ bool SubCommandRecord::CheckOptions()
     if (!CheckDataLimitOption()) {
         return false;
     }
+    if (!CheckSplitOption()) {
+        return false;
+    }
+    if (!CheckStreamOption()) {
+        return false;
+    }
     if (!ParseCallStackOption(callStackType_)) {
         return false;
     }
@@ -597,6 +715,10 @@ bool SubCommandRecord::CheckOptions()
         printf("--add-counter must be used with --no-inherit.\n");
         return false;
     }
+    if (mmapAdaptive_ && (mmapReaders_ > 0 || backtrack_)) {
+        printf("--mmap-adaptive can not be used with --mmap-readers or --backtrack.\n");
+        return false;
+    }
     return true;
 }
 
@@ -864,6 +986,11 @@ bool SubCommandRecord::IsAppRunning()
 }
 
 bool SubCommandRecord::ParseDataLimitOption(const std::string &str)
+{
+    return ParseSizeOption(str, dataSizeLimit_);
+}
+
+bool SubCommandRecord::ParseSizeOption(const std::string &str, uint64_t &size)
 {
     uint unit = 1;
     char c = str.at(str.size() >= 1 ? str.size() - 1 : 0);
@@ -878,16 +1005,16 @@ bool SubCommandRecord::ParseDataLimitOption(const std::string &str)
     }
 
     std::string numStr = str.substr(0, str.size() >= 1 ? str.size() - 1 : 0);
-    unsigned long size = 0;
+    unsigned long num = 0;
     char *endPtr = nullptr;
     errno = 0;
-    size = std::strtoul(numStr.c_str(), &endPtr, 10); // 10 : decimal scale
-    if (endPtr == numStr.c_str() || *endPtr != '\0' || errno != 0 || size == 0) {
+    num = std::strtoul(numStr.c_str(), &endPtr, 10); // 10 : decimal scale
+    if (endPtr == numStr.c_str() || *endPtr != '\0' || errno != 0 || num == 0) {
         HLOGE("num string convert to size failed, numStr: %s", numStr.c_str());
         return false;
     }
 
-    dataSizeLimit_ = size * unit;
+    size = static_cast<uint64_t>(num) * unit;
 
     return true;
 }
@@ -1022,6 +1149,34 @@ bool SubCommandRecord::SetPerfMaxSampleRate()
                         "hiviewdfx.hiperf.perf_event_max_sample_rate");
 }
 
+// the samples of backtrack are kept in the kernel mmaps, make them large enough for the backtrack time
+int SubCommandRecord::GetBacktrackMmapPages() const
+{
+    if (frequency_ <= 0 && period_ > 0) {
+        // the sample rate is unknown
+        return mmapPages_;
+    }
+    uint64_t frequency = frequency_ > 0 ? static_cast<uint64_t>(frequency_) : PerfEvents::DEFAULT_SAMPLE_FREQUNCY;
+    size_t eventCount = selectEvents_.size();
+    for (const auto &group : selectGroups_) {
+        eventCount += group.size();
+    }
+    uint64_t sampleSize = BACKTRACK_SAMPLE_SIZE;
+    if (isCallStackFp_) {
+        sampleSize += BACKTRACK_CALLCHAIN_SIZE;
+    } else if (isCallStackDwarf_) {
+        sampleSize += BACKTRACK_CALLCHAIN_SIZE + callStackDwarfSize_;
+    }
+    const uint64_t historySize = frequency * std::max<size_t>(eventCount, 1) * backtrackTime_ * sampleSize;
+    const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    int pages = mmapPages_;
+    while (pages < MAX_BACKTRACK_MMAP_PAGE && static_cast<uint64_t>(pages) * pageSize < historySize) {
+        pages *= 2; // 2 : keep it a power of two
+    }
+    HLOGD("backtrack %" PRIu64 " sec needs %" PRIu64 " bytes, mmap pages %d", backtrackTime_, historySize, pages);
+    return pages;
+}
+
 bool SubCommandRecord::SetPerfEventMlock()
 {
     auto cmp = [](int oldValue, int newValue) { return oldValue == newValue; };
@@ -1083,6 +1238,11 @@ bool SubCommandRecord::PreparePerfEvent()
         return this->ProcessRecord(record);
     };
     perfEvents_.SetRecordCallBack(processRecord);
+    if (splitTimeSec_ > 0) {
+        perfEvents_.SetRecordTickCallBack([this]() {
+            this->OnRecordTick();
+        });
+    }
 
     CHECK_TRUE(HandleArmSpeEvent(), false, 1, "HandleArmSpeEvent failed");
 
@@ -1094,6 +1254,9 @@ bool SubCommandRecord::PreparePerfEvent()
            .SetTimeOut(timeStopSec_)
            .SetVerboseReport(verboseReport_)
            .SetMmapPages(mmapPages_)
+           .SetMmapReaders(static_cast<size_t>(mmapReaders_))
+           .SetMmapAdaptive(mmapAdaptive_)
+           .SetReorderWindow(static_cast<uint64_t>(reorderWindowMs_))
            .SetSampleRaw(sampleRaw_);
     if (!clockId_.empty()) {
         builder.SetClockId(GetClockId(clockId_));
@@ -1169,6 +1332,9 @@ bool SubCommandRecord::PrepareSysKernel()
 
     CHECK_TRUE(SetPerfCpuMaxPercent(), false, 1, "Fail to set perf event cpu limit to %d\n", cpuPercent_);
 
+    if (backtrack_) {
+        mmapPages_ = GetBacktrackMmapPages();
+    }
     CHECK_TRUE(SetPerfEventMlock(), false, 1, "Fail to set perf event mlock limit\n");
 
     CHECK_TRUE(SetPerfHarden(), false, 1, "Fail to set perf event harden\n");
@@ -1222,6 +1388,7 @@ bool SubCommandRecord::PrepareVirtualRuntime()
             return false;
         }
     }
+    SymbolCache::SetDirectory(symbolCacheDir_);
 
     PrepareKernelMaps();
     if (dedupStack_) {
@@ -1815,13 +1982,14 @@ HiperfError SubCommandRecord::StartSamplingAndFile()
     }
     HIPERF_HILOGI(MODULE_DEFAULT, "[StartSamplingAndFile] perfEvents tracking finish");
 
-    if (isSpe_) {
+    if (isSpe_ && fileWriter_ != nullptr) {
         HLOGD("stop write spe record");
         fileWriter_->SetWriteRecordStat(false);
     }
     startSaveFileTimes_ = steady_clock::now();
     if (!backtrack_) {
-        if (!FinishWriteRecordFile()) {
+        // a failed split leaves no file to finish
+        if (!WaitBackgroundTasks() || fileWriter_ == nullptr || !FinishWriteRecordFile()) {
             HLOGE("Fail to finish record file %s", outputFilename_.c_str());
             HIPERF_HILOGE(MODULE_DEFAULT, "Fail to finish record file");
             return HiperfError::FINISH_WRITE_RECORD_FILE_FAIL;
@@ -1846,6 +2014,9 @@ HiperfError SubCommandRecord::OnSubCommand(std::vector<std::string>& args)
         return HiperfError::NO_ERR;
     }
     HIPERF_HILOGI(MODULE_DEFAULT, "[OnSubCommand] ProcessControl finish");
+    if (!PrepareStreamOutput()) {
+        return HiperfError::OPEN_DATA_FILE_FAIL;
+    }
     HiperfError err = CheckTargetAndApp();
     if (err != HiperfError::NO_ERR) {
         return err;
@@ -1963,6 +2134,12 @@ bool SubCommandRecord::ProcessRecord(PerfEventRecord& record)
         return true;
     }
 
+    // switch file before the record updates the runtime, so the threads it refers to are emitted again
+    if (IsSplitNeeded() && !RotateRecordFile()) {
+        perfEvents_.StopTracking();
+        return false;
+    }
+
     // May create some simulated events
     // it will call ProcessRecord before next line
     UpdateDevHostMapsAndIPs(record);
@@ -1972,7 +2149,22 @@ bool SubCommandRecord::ProcessRecord(PerfEventRecord& record)
 #if !HIDEBUG_RECORD_NOT_PROCESS_VM
     virtualRuntime_.UpdateFromRecord(record);
 #endif
-    return SaveRecord(record);
+    if (!SaveRecord(record)) {
+        return false;
+    }
+    // a stream can not be read back, collect the symbols on the way
+    if (fileWriter_ != nullptr && fileWriter_->IsStream() && !dedupStack_) {
+#if USE_COLLECT_SYMBOLIC
+        if (record.GetType() == PERF_RECORD_SAMPLE) {
+            QueueSymbolHits(static_cast<PerfRecordSample *>(&record));
+        } else {
+            CollectionSymbol(record);
+        }
+#else
+        CollectionSymbol(record);
+#endif
+    }
+    return true;
 #endif
 }
 
@@ -2212,13 +2404,16 @@ bool SubCommandRecord::CreateInitRecordFile(const bool compressData)
         fileWriter_ = std::make_unique<PerfFileWriter>();
     }
 
-    if (!fileWriter_->Open(outputFilename_, compressData)) {
+    if (!fileWriter_->Open(outputFilename_, compressData, compressLevel_)) {
         return false;
     }
+    // records are saved in the callback of the record buffer, do not let a slow disk block it
+    fileWriter_->SetAsyncWrite(true, directIo_);
 
     CHECK_TRUE(fileWriter_->WriteAttrAndId(perfEvents_.GetAttrWithId(), isSpe_), false, 0, "");
 
     CHECK_TRUE(AddFeatureRecordFile(), false, 0, "");
+    segmentStartTime_ = steady_clock::now();
     HLOGD("create new record file %s", outputFilename_.c_str());
     return true;
 }
@@ -2256,24 +2451,59 @@ bool SubCommandRecord::PostProcessRecordFile()
             return false;
         }
 
-        // 2. read out the file and unwind
+        // 2. read out the records in batches, unwind the samples of each batch by several threads
+        const std::vector<AttrWithId> attrIds = fileReader->GetAttrSection();
+        CHECK_TRUE(!attrIds.empty(), false, 1, "no attr in %s", tempFileName.c_str());
+        const perf_event_attr *attr = &attrIds[0].attr;
+        ParallelUnwinder unwinder(virtualRuntime_, std::thread::hardware_concurrency());
+        HLOGD("delay unwind by %zu threads", unwinder.GetThreadCount());
+        DelayUnwindBatch batch;
+        // the part of temp file which has been rewritten is released, the disk is not doubled
+        int tempFd = open(tempFileName.c_str(), O_WRONLY | O_CLOEXEC);
+        const uint64_t dataOffset = fileReader->GetHeader().data.offset;
+        uint64_t releasedSize = 0;
+        uint64_t rewrittenSize = 0;
+        bool ret = true;
         auto record_callback = [&](PerfEventRecord& record) {
-            if (record.GetName() == nullptr) {
+            if (record.GetName() == nullptr || !AddDelayUnwindRecord(batch, record)) {
                 // return false in callback can stop the read process
+                ret = false;
                 return false;
-            } else if (record.GetType() == PERF_RECORD_SAMPLE) {
-                HLOGM("readback record for unwind");
-                virtualRuntime_.UnwindFromRecord(static_cast<PerfRecordSample&>(record));
             }
-            SaveRecord(record);
+            if (batch.size < DELAY_UNWIND_BATCH_SIZE) {
+                return true;
+            }
+            rewrittenSize += batch.size;
+            FlushDelayUnwindBatch(batch, unwinder, *attr);
+            if (tempFd >= 0 && rewrittenSize - releasedSize >= DELAY_UNWIND_RELEASE_SIZE) {
+                const uint64_t releaseSize = (rewrittenSize - releasedSize) & ~(DELAY_UNWIND_RELEASE_SIZE - 1);
+                if (fallocate(tempFd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                              static_cast<off_t>(dataOffset + releasedSize), static_cast<off_t>(releaseSize)) != 0) {
+                    HLOGW("release temp file failed, errno:%d", errno);
+                    close(tempFd);
+                    tempFd = -1;
+                }
+                releasedSize += releaseSize;
+            }
             return true;
         };
-        fileReader->ReadDataSection(record_callback);
+        if (!fileReader->ReadDataSection(record_callback)) {
+            HLOGE("Fail to read data section of %s", tempFileName.c_str());
+            ret = false;
+        }
+        if (ret) {
+            FlushDelayUnwindBatch(batch, unwinder, *attr);
+        }
+        if (tempFd >= 0) {
+            close(tempFd);
+        }
+        CHECK_TRUE(ret, false, 1, "Fail to delay unwind %s", tempFileName.c_str());
 
         // 3. close again
 
         // lte FinishWriteRecordFile write matched only symbols
         delayUnwind_ = false;
+        symbolsCollected_ = true;
         CHECK_TRUE(FinishWriteRecordFile(), false, 1, "Fail to finish record file %s", outputFilename_.c_str());
 
         remove(tempFileName.c_str());
@@ -2281,221 +2511,121 @@ bool SubCommandRecord::PostProcessRecordFile()
     return true;
 }
 
-#if USE_COLLECT_SYMBOLIC
-void SubCommandRecord::SymbolicHits()
+bool SubCommandRecord::AddDelayUnwindRecord(DelayUnwindBatch &batch, const PerfEventRecord &record)
 {
-    if (isHM_) {
-        for (auto &processPair : kernelThreadSymbolsHits_) {
-            for (auto &vaddr : processPair.second) {
-                virtualRuntime_.GetSymbol(vaddr, processPair.first, processPair.first,
-                                          PERF_CONTEXT_MAX);
-            }
-        }
-    }
-
-    for (auto &vaddr : kernelSymbolsHits_) {
-        virtualRuntime_.GetSymbol(vaddr, 0, 0, PERF_CONTEXT_KERNEL);
-    }
-
-    for (auto &processPair : userSymbolsHits_) {
-        for (auto &vaddr : processPair.second) {
-            virtualRuntime_.GetSymbol(vaddr, processPair.first, processPair.first,
-                                      PERF_CONTEXT_USER);
-        }
+    if (batch.count == batch.records.size()) {
+        batch.records.emplace_back();
     }
+    // copied once, into a buffer kept for the next batches
+    CHECK_TRUE(record.GetBinary(batch.records[batch.count]), false, 1, "Fail to copy record %s", record.GetName());
+    batch.count++;
+    batch.size += record.GetSize();
+    return true;
 }
 
-void SubCommandRecord::SymbolicHitsParallel()
+// the records of batch are saved in the order they are read, after the samples are unwound
+void SubCommandRecord::FlushDelayUnwindBatch(DelayUnwindBatch &batch, ParallelUnwinder &unwinder,
+                                             const perf_event_attr &attr)
 {
-    if (!parallelSymbols_) {
-        SymbolicHits();
-        return;
-    }
-    if (!IsParallelHitsEnabled()) {
-        SymbolicHits();
-        return;
+    std::vector<PerfRecordSample *> samples;
+    for (size_t i = 0; i < batch.count; i++) {
+        uint8_t *data = batch.records[i].data();
+        if (reinterpret_cast<perf_event_header *>(data)->type != PERF_RECORD_SAMPLE) {
+            continue;
+        }
+        if (samples.size() == batch.samples.size()) {
+            batch.samples.emplace_back(std::make_unique<PerfRecordSample>());
+        }
+        PerfRecordSample *sample = batch.samples[samples.size()].get();
+        sample->Init(data, attr);
+        samples.emplace_back(sample);
     }
+    unwinder.Unwind(samples);
 
-    constexpr size_t numThreads = SymbolResolver::PARALLEL_THREAD_COUNT;
-    HLOGD("SymbolicHitsParallel: using %zu threads", numThreads);
-    HIPERF_HILOGI(MODULE_DEFAULT, "SymbolicHitsParallel: using %{public}zu threads", numThreads);
-
-    std::unordered_map<SymbolsFile*, std::vector<AddrItem>> userBuckets;
-    std::vector<AddrItem> ktAddrs;
-    std::vector<uint64_t> kAddrs;
-    std::vector<AddrItem> unknownItems;
-    CollectSymbolBuckets(userBuckets, ktAddrs, kAddrs, unknownItems);
-
-    size_t totalSymbols = ktAddrs.size() + kAddrs.size() + unknownItems.size();
-    for (const auto& [sf, items] : userBuckets) {
-        totalSymbols += items.size();
-    }
-    constexpr size_t PARALLEL_MIN_SYMBOL_COUNT = 1000;
-    if (totalSymbols < PARALLEL_MIN_SYMBOL_COUNT) {
-        HLOGD("SymbolicHitsParallel: total symbols %zu < %zu, fallback to serial",
-              totalSymbols, PARALLEL_MIN_SYMBOL_COUNT);
-        HIPERF_HILOGI(MODULE_DEFAULT, "SymbolicHitsParallel: total symbols "
-                      "%{public}zu < %{public}zu, fallback to serial", totalSymbols, PARALLEL_MIN_SYMBOL_COUNT);
-        SymbolicHits();
-        return;
+    size_t sampleIndex = 0;
+    for (size_t i = 0; i < batch.count; i++) {
+        uint8_t *data = batch.records[i].data();
+        const uint32_t type = reinterpret_cast<perf_event_header *>(data)->type;
+        PerfEventRecord &record = type == PERF_RECORD_SAMPLE ? *samples[sampleIndex++] :
+            PerfEventRecordFactory::GetPerfEventRecord(type, data, attr);
+        SaveRecord(record);
+        // saves reading the rewritten file again for the symbols
+        if (!dedupStack_) {
+            CollectionSymbol(record);
+        }
     }
-
-    std::vector<SymbolBucket> bucketVec;
-    BuildSymbolBuckets(userBuckets, ktAddrs, kAddrs, bucketVec);
-
-    std::vector<std::vector<size_t>> threadBuckets(numThreads);
-    AssignBucketsToThreads(bucketVec, threadBuckets, numThreads);
-
-    ExecuteParallelResolution(bucketVec, threadBuckets, unknownItems, numThreads);
-
-    HLOGD("SymbolicHitsParallel: completed");
-    HIPERF_HILOGI(MODULE_DEFAULT, "SymbolicHitsParallel: completed");
+    batch.count = 0;
+    batch.size = 0;
 }
 
-void SubCommandRecord::CollectSymbolBuckets(
-    std::unordered_map<SymbolsFile*, std::vector<AddrItem>>& userBuckets,
-    std::vector<AddrItem>& ktAddrs,
-    std::vector<uint64_t>& kAddrs,
-    std::vector<AddrItem>& unknownItems)
+#if USE_COLLECT_SYMBOLIC
+void SubCommandRecord::SymbolicHits(VirtualRuntime &runtime, const SymbolHits &hits)
 {
-    // Collect user symbol addresses and bucket by SymbolsFile
-    for (const auto& [pid, addrs] : userSymbolsHits_) {
-        VirtualThread& thread = virtualRuntime_.GetThread(pid, pid);
-        for (const uint64_t ip : addrs) {
-            int64_t mapIdx = thread.FindMapIndexByAddr(ip);
-            if (mapIdx < 0) {
-                unknownItems.emplace_back(pid, ip);
-                continue;
-            }
-            auto map = thread.GetMaps()[mapIdx];
-            if (!map) {
-                unknownItems.emplace_back(pid, ip);
-                continue;
-            }
-            SymbolsFile* sf = thread.FindSymbolsFileByMap(map);
-            if (!sf) {
-                unknownItems.emplace_back(pid, ip);
-                continue;
+    if (isHM_) {
+        for (auto &processPair : hits.kernelThreadHits) {
+            for (auto &vaddr : processPair.second) {
+                runtime.GetSymbol(vaddr, processPair.first, processPair.first,
+                                  PERF_CONTEXT_MAX);
             }
-            userBuckets[sf].emplace_back(pid, ip);
         }
     }
-    HLOGD("CollectSymbolBuckets: user buckets=%zu, unknown=%zu", userBuckets.size(), unknownItems.size());
 
-    // Collect kernel thread addresses - all in one bucket
-    if (isHM_ && !kernelThreadSymbolsHits_.empty()) {
-        for (const auto& [pid, addrs] : kernelThreadSymbolsHits_) {
-            virtualRuntime_.GetThread(pid, pid);
-            for (const uint64_t vaddr : addrs) {
-                ktAddrs.emplace_back(pid, vaddr);
-            }
-        }
+    for (auto &vaddr : hits.kernelHits) {
+        runtime.GetSymbol(vaddr, 0, 0, PERF_CONTEXT_KERNEL);
     }
 
-    // Collect kernel addresses
-    if (!kernelSymbolsHits_.empty()) {
-        kAddrs.reserve(kernelSymbolsHits_.size());
-        for (const uint64_t vaddr : kernelSymbolsHits_) {
-            kAddrs.emplace_back(vaddr);
+    for (auto &processPair : hits.userHits) {
+        for (auto &vaddr : processPair.second) {
+            runtime.GetSymbol(vaddr, processPair.first, processPair.first,
+                              PERF_CONTEXT_USER);
         }
     }
-    HLOGD("CollectSymbolBuckets: kthread addrs=%zu, kernel addrs=%zu", ktAddrs.size(), kAddrs.size());
 }
 
-void SubCommandRecord::BuildSymbolBuckets(
-    std::unordered_map<SymbolsFile*, std::vector<AddrItem>>& userBuckets,
-    std::vector<AddrItem>& ktAddrs,
-    std::vector<uint64_t>& kAddrs,
-    std::vector<SymbolBucket>& bucketVec)
+void SubCommandRecord::SymbolicHitsParallel(VirtualRuntime &runtime, const SymbolHits &hits)
 {
-    bucketVec.reserve(userBuckets.size() + (ktAddrs.empty() ? 0 : 1) + (kAddrs.empty() ? 0 : 1));
-
-    for (auto& [sf, items] : userBuckets) {
-        bucketVec.push_back({BucketType::User, std::move(items)});
+    if (!parallelSymbols_) {
+        SymbolicHits(runtime, hits);
+        return;
     }
-
-    if (!ktAddrs.empty()) {
-        bucketVec.push_back({BucketType::KernelThread, std::move(ktAddrs)});
+    if (!IsParallelHitsEnabled()) {
+        SymbolicHits(runtime, hits);
+        return;
     }
 
-    if (!kAddrs.empty()) {
-        std::vector<AddrItem> kernelItems;
-        kernelItems.reserve(kAddrs.size());
-        for (uint64_t ip : kAddrs) {
-            kernelItems.emplace_back(0, ip);
+    std::vector<ParallelSymbolResolver::Request> requests;
+    if (isHM_) {
+        for (const auto& [pid, addrs] : hits.kernelThreadHits) {
+            for (const uint64_t vaddr : addrs) {
+                requests.push_back({pid, vaddr, PERF_CONTEXT_MAX});
+            }
         }
-        bucketVec.push_back({BucketType::Kernel, std::move(kernelItems)});
     }
-}
-
-void SubCommandRecord::AssignBucketsToThreads(
-    std::vector<SymbolBucket>& bucketVec,
-    std::vector<std::vector<size_t>>& threadBuckets,
-    size_t numThreads)
-{
-    std::sort(bucketVec.begin(), bucketVec.end(),
-              [](const SymbolBucket& a, const SymbolBucket& b) {
-                  return a.items.size() > b.items.size();
-              });
-
-    std::vector<size_t> threadLoads(numThreads, 0);
-    for (size_t i = 0; i < bucketVec.size(); ++i) {
-        size_t minThread = std::min_element(
-            threadLoads.begin(), threadLoads.end()) - threadLoads.begin();
-        threadBuckets[minThread].push_back(i);
-        threadLoads[minThread] += bucketVec[i].items.size();
+    for (const uint64_t vaddr : hits.kernelHits) {
+        requests.push_back({0, vaddr, PERF_CONTEXT_KERNEL});
     }
-}
-
-void SubCommandRecord::ExecuteParallelResolution(
-    const std::vector<SymbolBucket>& bucketVec,
-    const std::vector<std::vector<size_t>>& threadBuckets,
-    const std::vector<AddrItem>& unknownItems,
-    size_t numThreads)
-{
-    std::vector<std::thread> threads;
-    threads.reserve(numThreads);
-    for (size_t i = 0; i < numThreads; ++i) {
-        if (threadBuckets[i].empty()) {
-            continue;
+    for (const auto& [pid, addrs] : hits.userHits) {
+        for (const uint64_t ip : addrs) {
+            requests.push_back({pid, ip, PERF_CONTEXT_USER});
         }
-        threads.emplace_back([&, i] {
-            SymbolResolver::SetCurrentThreadId(i);
-            for (size_t bucketIdx : threadBuckets[i]) {
-                ResolveBucket(bucketVec[bucketIdx]);
-            }
-        });
     }
-    for (auto& t : threads) {
-        t.join();
+    constexpr size_t PARALLEL_MIN_SYMBOL_COUNT = 1000;
+    if (requests.size() < PARALLEL_MIN_SYMBOL_COUNT) {
+        HLOGD("SymbolicHitsParallel: total symbols %zu < %zu, fallback to serial",
+              requests.size(), PARALLEL_MIN_SYMBOL_COUNT);
+        HIPERF_HILOGI(MODULE_DEFAULT, "SymbolicHitsParallel: total symbols "
+                      "%{public}zu < %{public}zu, fallback to serial", requests.size(), PARALLEL_MIN_SYMBOL_COUNT);
+        SymbolicHits(runtime, hits);
+        return;
     }
 
-    for (const auto& [pid, ip] : unknownItems) {
-        virtualRuntime_.GetSymbol(ip, pid, pid, PERF_CONTEXT_USER);
-    }
-}
+    ParallelSymbolResolver resolver(runtime, ParallelSymbolResolver::GetThreadCountByCpuPercent(cpuPercent_));
+    HLOGD("SymbolicHitsParallel: using %zu threads", resolver.GetThreadCount());
+    HIPERF_HILOGI(MODULE_DEFAULT, "SymbolicHitsParallel: using %{public}zu threads", resolver.GetThreadCount());
+    resolver.Resolve(requests);
 
-void SubCommandRecord::ResolveBucket(const SymbolBucket& bucket)
-{
-    switch (bucket.type) {
-        case BucketType::User:
-            for (const auto& [pid, ip] : bucket.items) {
-                virtualRuntime_.GetSymbol(ip, pid, pid, PERF_CONTEXT_USER);
-            }
-            break;
-        case BucketType::KernelThread:
-            for (const auto& [pid, ip] : bucket.items) {
-                virtualRuntime_.GetSymbol(ip, pid, pid, PERF_CONTEXT_MAX);
-            }
-            break;
-        case BucketType::Kernel:
-            for (const auto& [pid, ip] : bucket.items) {
-                virtualRuntime_.GetSymbol(ip, 0, 0, PERF_CONTEXT_KERNEL);
-            }
-            break;
-        default:
-            break;
-    }
+    HLOGD("SymbolicHitsParallel: completed");
+    HIPERF_HILOGI(MODULE_DEFAULT, "SymbolicHitsParallel: completed");
 }
 #endif
 
@@ -2520,6 +2650,13 @@ bool SubCommandRecord::CollectionSymbol(PerfEventRecord& record)
 }
 
 void SubCommandRecord::CollectSymbol(PerfRecordSample *sample)
+{
+    CollectSymbol(sample, virtualRuntime_, symbolHits_);
+}
+
+#if USE_COLLECT_SYMBOLIC
+template <typename AddHit>
+void SubCommandRecord::ForEachSymbolHit(PerfRecordSample *sample, VirtualRuntime &runtime, AddHit addHit) const
 {
     CHECK_TRUE(sample != nullptr, NO_RETVAL, 0, "");
     perf_callchain_context context = sample->InKernel() ? PERF_CONTEXT_KERNEL
@@ -2528,12 +2665,10 @@ void SubCommandRecord::CollectSymbol(PerfRecordSample *sample)
     // if no nr use ip ? remove stack nr == 0?
     if (sample->data_.nr == 0) {
         serverPid = sample->GetServerPidof(0);
-        if (virtualRuntime_.IsKernelThread(serverPid)) {
-            kernelThreadSymbolsHits_[serverPid].insert(sample->data_.ip);
-        } else if (context == PERF_CONTEXT_KERNEL) {
-            kernelSymbolsHits_.insert(sample->data_.ip);
+        if (runtime.IsKernelThread(serverPid)) {
+            addHit(SymbolHit {serverPid, sample->data_.ip, PERF_CONTEXT_MAX});
         } else {
-            userSymbolsHits_[sample->data_.pid].insert(sample->data_.ip);
+            addHit(SymbolHit {static_cast<pid_t>(sample->data_.pid), sample->data_.ip, context});
         }
         return;
     }
@@ -2555,16 +2690,45 @@ void SubCommandRecord::CollectSymbol(PerfRecordSample *sample)
                 sample->data_.ips[i] -= offset_;
             }
         }
-        if (virtualRuntime_.IsKernelThread(serverPid)) {
-            kernelThreadSymbolsHits_[serverPid].insert(sample->data_.ips[i]);
-        } else if (context == PERF_CONTEXT_KERNEL) {
-            kernelSymbolsHits_.insert(sample->data_.ips[i]);
+        if (runtime.IsKernelThread(serverPid)) {
+            addHit(SymbolHit {serverPid, sample->data_.ips[i], PERF_CONTEXT_MAX});
         } else {
-            userSymbolsHits_[sample->data_.pid].insert(sample->data_.ips[i]);
+            addHit(SymbolHit {static_cast<pid_t>(sample->data_.pid), sample->data_.ips[i], context});
         }
     }
 }
 
+void SubCommandRecord::CollectSymbol(PerfRecordSample *sample, VirtualRuntime &runtime, SymbolHits &hits) const
+{
+    ForEachSymbolHit(sample, runtime, [&hits](const SymbolHit &hit) { hits.Add(hit); });
+}
+
+// only the addresses are taken on the record path, the hash sets are filled by the background thread
+void SubCommandRecord::QueueSymbolHits(PerfRecordSample *sample)
+{
+    ForEachSymbolHit(sample, virtualRuntime_, [this](const SymbolHit &hit) { pendingHits_.emplace_back(hit); });
+    if (pendingHits_.size() >= SYMBOL_HITS_BATCH_SIZE) {
+        PostSymbolHits();
+    }
+}
+
+void SubCommandRecord::PostSymbolHits()
+{
+    if (pendingHits_.empty()) {
+        return;
+    }
+    auto batch = std::make_shared<std::vector<SymbolHit>>(std::move(pendingHits_));
+    pendingHits_.clear();
+    pendingHits_.reserve(SYMBOL_HITS_BATCH_SIZE);
+    PostBackgroundTask([this, batch]() -> bool {
+        for (const SymbolHit &hit : *batch) {
+            symbolHits_.Add(hit);
+        }
+        return true;
+    });
+}
+#endif
+
 bool SubCommandRecord::FinishWriteRecordFile()
 {
 #ifdef HIPERF_DEBUG_TIME
@@ -2573,8 +2737,12 @@ bool SubCommandRecord::FinishWriteRecordFile()
     ProcessSymbolsIfNeeded();
     if (virtualRuntime_.GetRuntimeContext().smoFlag) {
         for (auto it = mapPids_.begin(); it != mapPids_.end(); ++it) {
-            const VirtualThread &thread = virtualRuntime_.GetThreads().at(it->first);
-            if (virtualRuntime_.UpdateProcessSmoInfo(thread)) {
+            // threads are created again from the records of each split file, some may be missing
+            auto threadIt = virtualRuntime_.GetThreads().find(it->first);
+            if (threadIt == virtualRuntime_.GetThreads().end()) {
+                continue;
+            }
+            if (virtualRuntime_.UpdateProcessSmoInfo(threadIt->second)) {
                 break;
             }
         }
@@ -2594,6 +2762,188 @@ bool SubCommandRecord::FinishWriteRecordFile()
     return true;
 }
 
+bool SubCommandRecord::IsSplitNeeded()
+{
+    // --split-time is checked by OnRecordTick(), not for each record
+    return splitSize_ > 0 && fileWriter_ != nullptr && fileWriter_->GetDataSize() >= splitSize_;
+}
+
+void SubCommandRecord::OnRecordTick()
+{
+    // also called when there is no record, an idle system is split on time too
+    if (fileWriter_ == nullptr || steady_clock::now() - segmentStartTime_ < seconds(splitTimeSec_)) {
+        return;
+    }
+    if (!RotateRecordFile()) {
+        perfEvents_.StopTracking();
+    }
+}
+
+// close the current file and continue in a new one.
+// the closed file is finished by the split thread with a runtime rebuilt from its own records,
+// the runtime here is cleared as backtrack does, threads and maps are emitted again
+// to the new file when the following records refer to them.
+bool SubCommandRecord::RotateRecordFile()
+{
+    SplitFile splitFile;
+    splitFile.fileName = outputFilename_ + "." + std::to_string(++splitIndex_);
+    // the writer keeps the opened file, the new file takes the output name
+    CHECK_TRUE(fileWriter_->Rename(splitFile.fileName), false, 1, "Fail to rename split file %s",
+               splitFile.fileName.c_str());
+    splitFile.fileWriter = std::move(fileWriter_);
+    for (const auto &pair : mapPids_) {
+        splitFile.mapPids.emplace_back(pair.first);
+    }
+    splitFile.devhostPid = virtualRuntime_.GetRuntimeContext().devhostPid;
+    auto pendingFile = std::make_shared<SplitFile>(std::move(splitFile));
+    PostBackgroundTask([this, pendingFile]() -> bool {
+        bool finished = FinishSplitFile(*pendingFile);
+        if (!finished) {
+            printf("Fail to finish split file %s\n", pendingFile->fileName.c_str());
+        }
+        return finished;
+    });
+
+    virtualRuntime_.ClearSymbolCache();
+    symbolHits_ = SymbolHits();
+    if (!CreateInitRecordFile(compressData_)) {
+        HLOGE("Fail to create split file %s", outputFilename_.c_str());
+        fileWriter_ = nullptr;
+        return false;
+    }
+    PrepareKernelMaps();
+    return true;
+}
+
+void SubCommandRecord::PostBackgroundTask(BackgroundTask task)
+{
+    {
+        std::lock_guard<std::mutex> lock(backgroundMutex_);
+        if (!backgroundThread_.joinable()) {
+            backgroundThreadExit_ = false;
+            backgroundThread_ = std::thread(&SubCommandRecord::BackgroundThreadLoop, this);
+        }
+        backgroundTasks_.emplace_back(std::move(task));
+    }
+    backgroundCond_.notify_one();
+}
+
+void SubCommandRecord::BackgroundThreadLoop()
+{
+    std::unique_lock<std::mutex> lock(backgroundMutex_);
+    while (true) {
+        backgroundCond_.wait(lock, [this] { return backgroundThreadExit_ || !backgroundTasks_.empty(); });
+        if (backgroundTasks_.empty()) {
+            break;
+        }
+        BackgroundTask task = std::move(backgroundTasks_.front());
+        backgroundTasks_.pop_front();
+        lock.unlock();
+        bool done = task();
+        lock.lock();
+        backgroundFailed_ = backgroundFailed_ || !done;
+    }
+    PerfEventRecordFactory::Cleanup();
+}
+
+bool SubCommandRecord::WaitBackgroundTasks()
+{
+    {
+        std::lock_guard<std::mutex> lock(backgroundMutex_);
+        backgroundThreadExit_ = true;
+    }
+    backgroundCond_.notify_one();
+    if (backgroundThread_.joinable()) {
+        backgroundThread_.join();
+    }
+    return !backgroundFailed_;
+}
+
+void SubCommandRecord::PrepareSplitRuntime(VirtualRuntime &runtime, const SplitFile &splitFile)
+{
+    runtime.SetIsRoot(isRoot_);
+    runtime.SetHM(isHM_);
+    if (splitFile.devhostPid > 0) {
+        runtime.SetDevhostPid(splitFile.devhostPid);
+    }
+    runtime.SetSmoFlag(isRoot_ || appendSmoData_);
+    runtime.SetNeedKernelCallChain(!callChainUserOnly_);
+    // the samples of the file have been unwound
+    runtime.SetDisableUnwind(true);
+    runtime.EnableDebugInfoSymbolic(enableDebugInfoSymbolic_);
+    if (!symbolDir_.empty()) {
+        runtime.SetSymbolsPaths(symbolDir_);
+    }
+}
+
+// runs on the split thread, only the options and the split file are used here
+bool SubCommandRecord::FinishSplitFile(SplitFile &splitFile)
+{
+    PerfFileWriter &fileWriter = *splitFile.fileWriter;
+    VirtualRuntime runtime;
+    PrepareSplitRuntime(runtime, splitFile);
+    // the threads and maps are rebuilt as report does, the kernel symbols are loaded before symbolizing
+    SymbolHits hits;
+    fileWriter.ReadDataSection([this, &runtime, &hits](PerfEventRecord &record) -> bool {
+        if (record.GetType() == PERF_RECORD_SAMPLE) {
+            CollectSymbol(static_cast<PerfRecordSample *>(&record), runtime, hits);
+        } else if (record.GetType() != PERF_RECORD_AUXTRACE) {
+            runtime.UpdateFromRecord(record);
+        }
+        return true;
+    });
+
+    // the kernel and smo records follow the records of the file, like FinishWriteRecordFile()
+    runtime.SetRecordMode([&fileWriter](PerfEventRecord &record) -> bool {
+        return fileWriter.WriteRecord(record);
+    });
+#if !HIDEBUG_SKIP_LOAD_KERNEL_SYMBOLS
+    if (!callChainUserOnly_) {
+        runtime.UpdateKernelSymbols();
+        runtime.UpdateKernelModulesSymbols();
+        if (isHM_) {
+            runtime.UpdateServiceSymbols();
+        }
+    }
+    if (isHM_) {
+        runtime.UpdateDevhostSymbols();
+    }
+#endif
+    SymbolicHitsParallel(runtime, hits);
+    if (isSpe_) {
+        fileWriter.ReadDataSection([&runtime](PerfEventRecord &record) -> bool {
+            if (record.GetType() == PERF_RECORD_AUXTRACE) {
+                runtime.SymbolSpeRecord(static_cast<PerfRecordAuxtrace &>(record));
+            }
+            return true;
+        });
+    }
+#if !HIDEBUG_SKIP_SAVE_SYMBOLS
+    CHECK_TRUE(fileWriter.AddSymbolsFeature(runtime.GetSymbolsFiles()), false, 1, "Fail to AddSymbolsFeature");
+#endif
+    if (runtime.GetRuntimeContext().smoFlag) {
+        for (const pid_t pid : splitFile.mapPids) {
+            auto threadIt = runtime.GetThreads().find(pid);
+            if (threadIt != runtime.GetThreads().end() && runtime.UpdateProcessSmoInfo(threadIt->second)) {
+                break;
+            }
+        }
+    }
+    CHECK_TRUE(fileWriter.Close(), false, 1, "Fail to close split file %s", splitFile.fileName.c_str());
+    splitFile.fileWriter = nullptr;
+    printf("record file %s saved.\n", splitFile.fileName.c_str());
+
+    // only this thread adds and removes the split files
+    splitFiles_.push_back(splitFile.fileName);
+    while (splitMaxFiles_ > 0 && splitFiles_.size() > static_cast<size_t>(splitMaxFiles_)) {
+        if (remove(splitFiles_.front().c_str()) != 0) {
+            HLOGW("remove old split file %s failed", splitFiles_.front().c_str());
+        }
+        splitFiles_.pop_front();
+    }
+    return true;
+}
+
 bool SubCommandRecord::ProcessSymbolsIfNeeded()
 {
 #if !HIDEBUG_SKIP_PROCESS_SYMBOLS
@@ -2638,8 +2988,13 @@ bool SubCommandRecord::ProcessUserSymbols()
 {
     HLOGD("Load user symbols");
     if (dedupStack_) {
-        virtualRuntime_.CollectDedupSymbol(kernelSymbolsHits_, userSymbolsHits_);
-    } else {
+        virtualRuntime_.CollectDedupSymbol(symbolHits_.kernelHits, symbolHits_.userHits);
+#if USE_COLLECT_SYMBOLIC
+    } else if (fileWriter_->IsStream()) {
+        PostSymbolHits();
+        CHECK_TRUE(WaitBackgroundTasks(), false, 1, "Fail to collect the symbols of the stream");
+#endif
+    } else if (!fileWriter_->IsStream() && !symbolsCollected_) {
         fileWriter_->ReadDataSection(
             [this](PerfEventRecord& record) -> bool {
                 return this->CollectionSymbol(record);
@@ -2647,7 +3002,7 @@ bool SubCommandRecord::ProcessUserSymbols()
     }
 
 #if USE_COLLECT_SYMBOLIC
-    SymbolicHitsParallel();
+    SymbolicHitsParallel(virtualRuntime_, symbolHits_);
 #endif
 
 #if HIDEBUG_SKIP_MATCH_SYMBOLS
@@ -2660,9 +3015,7 @@ bool SubCommandRecord::ProcessUserSymbols()
 #endif
 
 #if USE_COLLECT_SYMBOLIC
-    std::unordered_map<pid_t, std::unordered_set<uint64_t>>().swap(kernelThreadSymbolsHits_);
-    kSymbolsHits().swap(kernelSymbolsHits_);
-    uSymbolsHits().swap(userSymbolsHits_);
+    symbolHits_ = SymbolHits();
 #endif
 
     return true;
@@ -2673,9 +3026,7 @@ void SubCommandRecord::CleanupForBacktrack()
     if (backtrack_) {
         virtualRuntime_.ClearSymbolCache();
 #if USE_COLLECT_SYMBOLIC
-        kernelThreadSymbolsHits_.clear();
-        kernelSymbolsHits_.clear();
-        userSymbolsHits_.clear();
+        symbolHits_ = SymbolHits();
 #endif
     }
 }
@@ -2713,6 +3064,9 @@ void SubCommandRecord::ReportTime()
            virtualRuntime_.symbolicRecordTimes_.count() / MS_DURATION);
     printf("saveRecordTimes: %0.3f ms\n", saveRecordTimes_.count() / MS_DURATION);
     printf("-writeTimes: %0.3f ms\n", fileWriter_->writeTimes_.count() / MS_DURATION);
+    AsyncFileWriter::Stat writeStat = fileWriter_->GetWriteStat();
+    printf("-flushTimes: %0.3f ms (%" PRIu64 " flushes, max %zu pending buffers)\n",
+           writeStat.flushTime.count() / MS_DURATION, writeStat.flushCount, writeStat.maxPendingBuffers);
 
     printf("logTimes: %0.3f ms\n", DebugLogger::GetInstance()->logTimes_.count() / MS_DURATION);
     printf("-logSprintfTimes: %0.3f ms\n",
@@ -2755,6 +3109,14 @@ bool SubCommandRecord::RecordCompleted()
     printf("[ Sample lost: %zu, Non sample lost: %zu ]\n", lostSamples, lostNonSamples);
     HIPERF_HILOGI(MODULE_DEFAULT, "[ Sample lost: %{public}zu, Non sample lost: %{public}zu ]",
                   lostSamples, lostNonSamples);
+    // the records waited for the disk, samples may be lost because of it
+    AsyncFileWriter::Stat writeStat = fileWriter_->GetWriteStat();
+    if (writeStat.stallCount > 0) {
+        printf("[ Write stalled: %" PRIu64 " times, %.3f ms ]\n", writeStat.stallCount,
+               writeStat.stallTime.count() / MS_DURATION);
+        HIPERF_HILOGI(MODULE_DEFAULT, "[ Write stalled: %{public}" PRIu64 " times, %{public}.3f ms ]",
+                      writeStat.stallCount, writeStat.stallTime.count() / MS_DURATION);
+    }
 
 #ifdef HIPERF_DEBUG_TIME
     ReportTime();
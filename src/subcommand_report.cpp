@@ -20,6 +20,7 @@
 #include <limits>
 #include <set>
 #include <sstream>
+#include <thread>
 
 #if defined(is_mingw) && is_mingw
 #include <windows.h>
@@ -29,6 +30,7 @@
 
 #include "hiperf_hilog.h"
 #include "register.h"
+#include "symbol_cache.h"
 #include "utilities.h"
 
 namespace OHOS {
@@ -88,6 +90,9 @@ bool SubCommandReport::ParseOption(std::vector<std::string> &args)
     if (!Option::GetOptionValue(args, "--symbol-dir", symbolsPaths_)) {
         return false;
     }
+    if (!Option::GetOptionValue(args, "--symbol-cache", symbolCacheDir_)) {
+        return false;
+    }
     if (!Option::GetOptionValue(args, "--limit-percent", reportOption_.heatLimit_)) {
         return false;
     }
@@ -137,6 +142,15 @@ bool SubCommandReport::ParseOption(std::vector<std::string> &args)
     if (!Option::GetOptionValue(args, "--branch", branch_)) {
         return false;
     }
+    if (!Option::GetOptionValue(args, "--parallel", parallel_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "--parallel-threads", parallelThreads_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "--decode-threads", decodeThreads_)) {
+        return false;
+    }
     // this is a hidden option for compare result
     if (!Option::GetOptionValue(args, "--hide_count", reportOption_.hideCount_)) {
         return false;
@@ -191,6 +205,14 @@ bool SubCommandReport::VerifyOption()
         printf("head limit error. must in (0 <= limit < 100).\n");
         return false;
     }
+    if (decodeThreads_ < 0 || decodeThreads_ > static_cast<int>(MAX_DECODE_THREADS)) {
+        printf("decode threads error. must in (0 <= count <= %zu).\n", MAX_DECODE_THREADS);
+        return false;
+    }
+    if (parallelThreads_ < 0 || parallelThreads_ > static_cast<int>(ParallelReportAggregator::MAX_THREAD_COUNT)) {
+        printf("parallel threads error. must in (0 <= count <= %zu).\n", ParallelReportAggregator::MAX_THREAD_COUNT);
+        return false;
+    }
     if (recordFile_[FIRST].empty()) {
         printf("input file name can't be empty\n");
         return false;
@@ -260,6 +282,10 @@ void SubCommandReport::ProcessSample(std::unique_ptr<PerfRecordSample> &sample)
     } else {
         if (branch_) {
             GetReport().AddReportItemBranch(*sample);
+        } else if (parallelAggregator_ != nullptr) {
+            const VirtualThread &thread =
+                GetReport().virtualRuntime_.GetThread(sample->data_.pid, sample->data_.tid);
+            parallelAggregator_->AddSample(*sample, thread.name_);
         } else {
             GetReport().AddReportItem(*sample, showCallStack_);
         }
@@ -329,6 +355,7 @@ void SubCommandReport::LoadPerfDataCompleted()
 void SubCommandReport::ProcessSymbolsData()
 {
     GetReport().virtualRuntime_.SetSymbolsPaths(symbolsPaths_);
+    SymbolCache::SetDirectory(symbolCacheDir_);
     // we need unwind it (for function name match) even not give us path
     GetReport().virtualRuntime_.SetDisableUnwind(false);
 
@@ -507,6 +534,25 @@ void SubCommandReport::ProcessFeaturesData()
 #endif
 }
 
+// the samples are still unwound and symbolized in order, only the aggregation is parallel
+void SubCommandReport::StartParallelAggregator()
+{
+    if (!parallel_ || jsonFormat_ || protobufFormat_ || branch_) {
+        return;
+    }
+    // cpu off samples are processed more than once, counters are read from the sample itself
+    if (cpuOffMode_ || !GetReport().addCounterNames_.empty()) {
+        HLOGW("parallel report is not supported for cpu off mode or add counters");
+        return;
+    }
+    const size_t threadCount = parallelThreads_ > 0 ? static_cast<size_t>(parallelThreads_)
+                                                    : ParallelReportAggregator::GetDefaultThreadCount();
+    parallelAggregator_ = std::make_unique<ParallelReportAggregator>(GetReport(), threadCount, showCallStack_);
+    if (!parallelAggregator_->Start()) {
+        parallelAggregator_ = nullptr;
+    }
+}
+
 void SubCommandReport::FlushCacheRecord()
 {
     for (auto &pair : prevSampleCache_) {
@@ -549,13 +595,19 @@ bool SubCommandReport::LoadPerfData()
     HLOGD("process record");
     // before load data section
     SetHM();
-    recordFileReader_->ReadDataSection(
+    StartParallelAggregator();
+    // records are decoded by other threads, RecordCallBack() still gets them in order
+    recordFileReader_->ReadDataSectionParallel(
         [this] (PerfEventRecord& record) -> bool {
             return this->RecordCallBack(record);
-        });
+        }, static_cast<size_t>(decodeThreads_));
     if (cpuOffMode_) {
         FlushCacheRecord();
     }
+    if (parallelAggregator_ != nullptr) {
+        parallelAggregator_->Finish();
+        parallelAggregator_ = nullptr;
+    }
     HLOGD("process record completed");
 
     LoadPerfDataCompleted();
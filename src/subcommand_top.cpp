@@ -0,0 +1,417 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define HILOG_TAG "Top"
+
+#include "subcommand_top.h"
+
+#include <cinttypes>
+#include <csignal>
+#include <cstring>
+#include <unistd.h>
+
+#include "debug_logger.h"
+#include "hiperf_hilog.h"
+#include "option.h"
+#include "utilities.h"
+
+using namespace std::chrono;
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+namespace {
+const std::string CLEAR_SCREEN = "\033[H\033[2J";
+constexpr int MIN_DSO_WIDTH = 16;
+// how often the refresh thread checks the stop signal
+constexpr int STOP_CHECK_MS = 100;
+constexpr size_t STOP_SIGNAL_COUNT = 2;
+constexpr int STOP_SIGNALS[STOP_SIGNAL_COUNT] = {SIGINT, SIGTERM};
+
+std::atomic_bool g_stopSignaled(false);
+struct sigaction g_oldStopSigs[STOP_SIGNAL_COUNT] {};
+size_t g_capturedStopSigs = 0;
+
+void RecoverStopSignals()
+{
+    for (; g_capturedStopSigs > 0; g_capturedStopSigs--) {
+        if (sigaction(STOP_SIGNALS[g_capturedStopSigs - 1], &g_oldStopSigs[g_capturedStopSigs - 1], nullptr) < 0) {
+            perror("Fail to call sigaction for the stop signal");
+        }
+    }
+}
+
+// only flag it here, the tracking is stopped by the refresh thread
+bool CaptureStopSignals()
+{
+    g_stopSignaled.store(false);
+    struct sigaction sig {};
+    sig.sa_handler = [](int) {
+        const char msg[] = "\n Stop signal detected.\n";
+        (void)write(STDOUT_FILENO, msg, strlen(msg));
+        g_stopSignaled.store(true);
+    };
+    sig.sa_flags = 0;
+    for (; g_capturedStopSigs < STOP_SIGNAL_COUNT; g_capturedStopSigs++) {
+        if (sigaction(STOP_SIGNALS[g_capturedStopSigs], &sig, &g_oldStopSigs[g_capturedStopSigs]) < 0) {
+            perror("Fail to call sigaction for the stop signal");
+            RecoverStopSignals();
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+void SubCommandTop::DumpOptions() const
+{
+    printf("DumpOptions:\n");
+    printf(" targetSystemWide:\t%s\n", targetSystemWide_ ? "true" : "false");
+    printf(" selectCpus:\t%s\n", VectorToString(selectCpus_).c_str());
+    printf(" timeStopSec:\t%f sec\n", timeStopSec_);
+    printf(" frequency:\t%d\n", frequency_);
+    printf(" selectEvents:\t%s\n", VectorToString(selectEvents_).c_str());
+    printf(" selectPids:\t%s\n", VectorToString(selectPids_).c_str());
+    printf(" selectTids:\t%s\n", VectorToString(selectTids_).c_str());
+    printf(" refreshMs:\t%d\n", refreshMs_);
+    printf(" showCount:\t%d\n", showCount_);
+    printf(" showDso:\t%s\n", showDso_ ? "true" : "false");
+    printf(" decay:\t%f\n", decay_);
+    printf(" maxEntries:\t%d\n", maxEntries_);
+    printf(" includeHiperf:\t%s\n", includeHiperf_ ? "true" : "false");
+}
+
+bool SubCommandTop::ParseOption(std::vector<std::string> &args)
+{
+    if (!Option::GetOptionValue(args, "-a", targetSystemWide_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "-c", selectCpus_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "-d", timeStopSec_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "-f", frequency_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "-e", selectEvents_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "-p", selectPids_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "-t", selectTids_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "-i", refreshMs_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "-n", showCount_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "--dso", showDso_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "--decay", decay_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "--max-entries", maxEntries_)) {
+        return false;
+    }
+    if (!Option::GetOptionValue(args, "--include-hiperf", includeHiperf_)) {
+        return false;
+    }
+    CHECK_TRUE(args.empty(), false, LOG_TYPE_PRINTF,
+               "'%s' option usage error, please check usage.\n", VectorToString(args).c_str());
+    return CheckOptions();
+}
+
+bool SubCommandTop::CheckOptions()
+{
+    if (CheckOutOfRange<float>(timeStopSec_, MIN_STOP_SECONDS, MAX_STOP_SECONDS)) {
+        printf("Invalid -d value '%.3f', the seconds should be in %.3f~%.3f  \n", timeStopSec_,
+               MIN_STOP_SECONDS, MAX_STOP_SECONDS);
+        return false;
+    }
+    if (CheckOutOfRange<int>(frequency_, MIN_SAMPLE_FREQUENCY, MAX_SAMPLE_FREQUENCY)) {
+        printf("Invalid -f value '%d', frequency should be in %d~%d \n", frequency_,
+               MIN_SAMPLE_FREQUENCY, MAX_SAMPLE_FREQUENCY);
+        return false;
+    }
+    if (CheckOutOfRange<int>(refreshMs_, MIN_REFRESH_MS, MAX_REFRESH_MS)) {
+        printf("Invalid -i value '%d', the milliseconds should be in %d~%d \n", refreshMs_,
+               MIN_REFRESH_MS, MAX_REFRESH_MS);
+        return false;
+    }
+    if (CheckOutOfRange<int>(showCount_, MIN_SHOW_COUNT, MAX_SHOW_COUNT)) {
+        printf("Invalid -n value '%d', value should be in %d~%d \n", showCount_, MIN_SHOW_COUNT, MAX_SHOW_COUNT);
+        return false;
+    }
+    if (decay_ <= 0 || decay_ > 1) {
+        printf("Invalid --decay value '%f', value should be in (0, 1] \n", decay_);
+        return false;
+    }
+    if (CheckOutOfRange<int>(maxEntries_, MIN_MAX_ENTRIES, MAX_MAX_ENTRIES)) {
+        printf("Invalid --max-entries value '%d', value should be in %d~%d \n", maxEntries_,
+               MIN_MAX_ENTRIES, MAX_MAX_ENTRIES);
+        return false;
+    }
+    return CheckTargetOptions();
+}
+
+bool SubCommandTop::CheckTargetOptions()
+{
+    if (!selectCpus_.empty()) {
+        int maxCpuid = sysconf(_SC_NPROCESSORS_CONF) - 1;
+        for (auto cpu : selectCpus_) {
+            if (cpu < 0 || cpu > maxCpuid) {
+                printf("Invalid -c value '%d', the CPU ID should be in 0~%d \n", cpu, maxCpuid);
+                return false;
+            }
+        }
+    }
+    for (auto pid : selectPids_) {
+        if (pid <= 0 || !IsDir("/proc/" + std::to_string(pid))) {
+            printf("not exist pid %d\n", pid);
+            return false;
+        }
+    }
+    for (auto tid : selectTids_) {
+        if (tid <= 0 || !IsDir("/proc/" + std::to_string(tid))) {
+            printf("not exist tid %d\n", tid);
+            return false;
+        }
+    }
+    if (!selectPids_.empty() || !selectTids_.empty()) {
+        CHECK_TRUE(!targetSystemWide_, false, LOG_TYPE_PRINTF,
+                   "-p/-t %s options conflict, please check usage\n", VectorToString(selectPids_).c_str());
+    } else {
+        // like the top command, show the whole system if no target is given
+        targetSystemWide_ = true;
+    }
+    if (targetSystemWide_ && !IsSupportNonDebuggableApp()) {
+        printf("-a option needs root privilege for system wide profiling, please select a target by -p/-t.\n");
+        return false;
+    }
+    return true;
+}
+
+bool SubCommandTop::PreparePerfEvent()
+{
+    auto processRecord = [this](PerfEventRecord& record) -> bool {
+        return this->ProcessRecord(record);
+    };
+    perfEvents_.SetRecordCallBack(processRecord);
+
+    // the threads created before sampling are not inherited, add them one by one
+    std::vector<pid_t> pids = selectPids_;
+    for (auto pid : selectPids_) {
+        auto tids = GetSubthreadIDs(pid);
+        pids.insert(pids.end(), tids.begin(), tids.end());
+    }
+    pids.insert(pids.end(), selectTids_.begin(), selectTids_.end());
+
+    PerfEventsBuilder builder(perfEvents_);
+    builder.SetCpu(selectCpus_)
+           .SetPid(pids)
+           .SetOriginPids(selectPids_)
+           .SetSystemTarget(targetSystemWide_)
+           .SetTimeOut(timeStopSec_)
+           .SetSampleFrequency(static_cast<unsigned int>(frequency_))
+           .SetInherit(true);
+    CHECK_TRUE(builder.Apply(), false, 1, "Fail to apply perf events options");
+
+    if (selectEvents_.empty()) {
+        selectEvents_.push_back("hw-cpu-cycles");
+    }
+    CHECK_TRUE(perfEvents_.AddEvents(selectEvents_), false, 1, "Fail to AddEvents events");
+    return true;
+}
+
+void SubCommandTop::PrepareVirtualRuntime()
+{
+    // nothing is saved, the records made by runtime only update itself
+    auto dropRecord = [](PerfEventRecord&) -> bool {
+        return true;
+    };
+    virtualRuntime_.SetRecordMode(dropRecord);
+    virtualRuntime_.SetIsRoot(isRoot_);
+    virtualRuntime_.SetHM(isHM_);
+    perfEvents_.SetHM(isHM_);
+
+    virtualRuntime_.LoadVdso();
+    virtualRuntime_.SetNeedKernelCallChain(true);
+    virtualRuntime_.UpdateKernelSpaceMaps();
+    if (isRoot_) {
+        virtualRuntime_.UpdateKernelModulesSpaceMaps();
+        virtualRuntime_.UpdateKernelSymbols();
+        virtualRuntime_.UpdateKernelModulesSymbols();
+    }
+    // maps of the target threads are parsed before sampling
+    for (auto pid : selectPids_) {
+        virtualRuntime_.GetThread(pid, pid);
+    }
+}
+
+bool SubCommandTop::ProcessRecord(PerfEventRecord &record)
+{
+    CHECK_TRUE(record.GetName() != nullptr, false, 1, "record is null");
+    if (record.GetType() != PERF_RECORD_SAMPLE) {
+        virtualRuntime_.UpdateFromRecord(record);
+        return true;
+    }
+    PerfRecordSample &sample = static_cast<PerfRecordSample &>(record);
+    if (!includeHiperf_ && static_cast<pid_t>(sample.data_.pid) == hiperfPid_) {
+        return true;
+    }
+    virtualRuntime_.UpdateFromRecord(sample);
+    // no callstack is sampled, the only frame is the ip
+    virtualRuntime_.SymbolicRecord(sample);
+    if (sample.callFrames_.empty()) {
+        return true;
+    }
+    const DfxFrame &frame = sample.callFrames_.front();
+    std::lock_guard<std::mutex> lock(mutex_);
+    aggregator_->AddSample(frame.mapName, frame.funcName, sample.data_.period);
+    return true;
+}
+
+void SubCommandTop::StartRefresh()
+{
+    stopRefresh_ = false;
+    lastRefreshTime_ = steady_clock::now();
+    refreshThread_ = std::thread(&SubCommandTop::RefreshLoop, this);
+}
+
+void SubCommandTop::StopRefresh()
+{
+    if (!refreshThread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopRefresh_ = true;
+    }
+    cv_.notify_all();
+    refreshThread_.join();
+}
+
+void SubCommandTop::RefreshLoop()
+{
+    const milliseconds refreshInterval(refreshMs_);
+    const milliseconds checkInterval(std::min(refreshMs_, STOP_CHECK_MS));
+    auto nextRefreshTime = steady_clock::now() + refreshInterval;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!cv_.wait_for(lock, checkInterval, [this] { return stopRefresh_; })) {
+        lock.unlock();
+        if (g_stopSignaled.load() && perfEvents_.IsTrackRunning()) {
+            perfEvents_.StopTracking();
+        }
+        if (steady_clock::now() >= nextRefreshTime) {
+            Refresh(false);
+            nextRefreshTime = steady_clock::now() + refreshInterval;
+        }
+        lock.lock();
+    }
+}
+
+void SubCommandTop::Refresh(const bool last)
+{
+    std::vector<TopAggregator::TopItem> items;
+    double totalWeight = 0;
+    uint64_t samples = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const size_t count = static_cast<size_t>(showCount_);
+        items = showDso_ ? aggregator_->GetTopDsos(count) : aggregator_->GetTopFunctions(count);
+        totalWeight = aggregator_->GetTotalWeight();
+        samples = aggregator_->GetRecentSamples();
+        aggregator_->Decay();
+    }
+    const auto now = steady_clock::now();
+    const auto usedMs = duration_cast<milliseconds>(now - lastRefreshTime_).count();
+    lastRefreshTime_ = now;
+
+    std::string output;
+    if (!last && isatty(STDOUT_FILENO)) {
+        output += CLEAR_SCREEN;
+    }
+    output += StringPrintf("Samples: %" PRIu64 " in %" PRId64 " ms, event: %s\n", samples,
+                           static_cast<int64_t>(usedMs), VectorToString(selectEvents_).c_str());
+    int dsoWidth = MIN_DSO_WIDTH;
+    for (const auto &item : items) {
+        dsoWidth = std::max(dsoWidth, static_cast<int>(item.dso.size()));
+    }
+    if (showDso_) {
+        output += StringPrintf("%9s  %s\n", "Overhead", "Shared Object");
+    } else {
+        output += StringPrintf("%9s  %-*s  %s\n", "Overhead", dsoWidth, "Shared Object", "Symbol");
+    }
+    for (const auto &item : items) {
+        double overhead = totalWeight > 0 ? item.weight * 100 / totalWeight : 0; // 100 : percent
+        if (showDso_) {
+            output += StringPrintf("%8.2f%%  %s\n", overhead, item.dso.c_str());
+        } else {
+            output += StringPrintf("%8.2f%%  %-*s  %s\n", overhead, dsoWidth, item.dso.c_str(),
+                                   item.func.c_str());
+        }
+    }
+    printf("%s", output.c_str());
+    fflush(stdout);
+}
+
+HiperfError SubCommandTop::OnSubCommand(std::vector<std::string>& args)
+{
+    isRoot_ = IsRoot();
+    isHM_ = IsHM();
+    hiperfPid_ = getpid();
+    aggregator_ = std::make_unique<TopAggregator>(static_cast<size_t>(maxEntries_), decay_);
+
+    PrepareVirtualRuntime();
+    if (!PreparePerfEvent()) {
+        return HiperfError::PREPARE_PERF_EVENT_FAIL;
+    }
+    if (!perfEvents_.PrepareTracking()) {
+        HLOGE("Fail to prepare tracking");
+        return HiperfError::PREPARE_TACKING_FAIL;
+    }
+
+    // perf events captures SIGINT while tracking, SIGTERM and the one before tracking are captured here
+    if (!CaptureStopSignals()) {
+        return HiperfError::START_TRACKING_FAIL;
+    }
+    StartRefresh();
+    bool tracked = perfEvents_.StartTracking();
+    StopRefresh();
+    RecoverStopSignals();
+    RETURN_IF(!tracked, HiperfError::START_TRACKING_FAIL);
+    // the samples after the last refresh
+    Refresh(true);
+    perfEvents_.ReleaseRecordResources();
+    return HiperfError::NO_ERR;
+}
+
+bool SubCommandTop::RegisterSubCommandTop()
+{
+    return SubCommand::RegisterSubCommand("top", SubCommandTop::GetInstance);
+}
+
+SubCommand& SubCommandTop::GetInstance()
+{
+    static SubCommandTop subCommand;
+    return subCommand;
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
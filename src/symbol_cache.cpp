@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define HILOG_TAG "SymbolCache"
+
+#include "symbol_cache.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <limits>
+#if defined(is_mingw) && is_mingw
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "hiperf_hilog.h"
+#include "utilities.h"
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+namespace {
+const std::string CACHE_FILE_SUFFIX = ".sym";
+// kallsyms in the cache tells the kernel base address, only the owner can read it
+constexpr mode_t CACHE_DIR_MODE = 0700;
+constexpr mode_t CACHE_FILE_MODE = 0600;
+// build id is printed as hex, at most 64 bytes
+constexpr size_t MAX_BUILD_ID_LENGTH = 128;
+
+bool IsValidBuildId(const std::string &buildId)
+{
+    if (buildId.empty() || buildId.size() > MAX_BUILD_ID_LENGTH) {
+        return false;
+    }
+    for (const char c : buildId) {
+        if (!std::isxdigit(static_cast<unsigned char>(c))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IsValidString(const uint32_t offset, const uint32_t size, const uint64_t stringTableSize)
+{
+    return static_cast<uint64_t>(offset) + size <= stringTableSize;
+}
+} // namespace
+
+std::string SymbolCache::directory_;
+
+void SymbolCache::SetDirectory(const std::string &dir)
+{
+    directory_ = dir;
+    if (!directory_.empty() && directory_.back() == PATH_SEPARATOR) {
+        directory_.pop_back();
+    }
+}
+
+const std::string &SymbolCache::GetDirectory()
+{
+    return directory_;
+}
+
+bool SymbolCache::IsEnabled()
+{
+    return !directory_.empty();
+}
+
+std::string SymbolCache::GetCacheFilePath(const std::string &buildId)
+{
+    if (!IsEnabled() || !IsValidBuildId(buildId)) {
+        return EMPTY_STRING;
+    }
+    return directory_ + PATH_SEPARATOR + buildId + CACHE_FILE_SUFFIX;
+}
+
+bool SymbolCache::Load(const std::string &buildId, const std::string &module, std::vector<DfxSymbol> &symbols)
+{
+    const std::string filePath = GetCacheFilePath(buildId);
+    if (filePath.empty()) {
+        return false;
+    }
+#if defined(is_mingw) && is_mingw
+    std::string content;
+    if (!ReadFileToString(filePath, content)) {
+        return false;
+    }
+    bool ret = ParseCacheData(reinterpret_cast<const uint8_t *>(content.data()), content.size(), module, symbols);
+#else
+    int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(SymbolCacheHeader))) {
+        HLOGW("symbol cache %s is too small", filePath.c_str());
+        close(fd);
+        return false;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    CHECK_TRUE(addr != MAP_FAILED, false, 1, "mmap symbol cache %s failed", filePath.c_str());
+    bool ret = ParseCacheData(static_cast<const uint8_t *>(addr), size, module, symbols);
+    munmap(addr, size);
+#endif
+    if (!ret) {
+        HLOGW("symbol cache %s is broken, ignore it", filePath.c_str());
+        return false;
+    }
+    HLOGD("load %zu symbols of %s from cache %s", symbols.size(), module.c_str(), filePath.c_str());
+    return true;
+}
+
+bool SymbolCache::ParseCacheData(const uint8_t *data, const size_t size, const std::string &module,
+                                 std::vector<DfxSymbol> &symbols)
+{
+    CHECK_TRUE(size >= sizeof(SymbolCacheHeader), false, 0, "");
+    const SymbolCacheHeader defaultHeader;
+    const SymbolCacheHeader *header = reinterpret_cast<const SymbolCacheHeader *>(data);
+    CHECK_TRUE(memcmp(header->magic, defaultHeader.magic, sizeof(header->magic)) == 0 &&
+               header->version == defaultHeader.version, false, 0, "");
+    const uint64_t entriesSize = static_cast<uint64_t>(header->symbolCount) * sizeof(SymbolCacheEntry);
+    CHECK_TRUE(entriesSize + header->stringTableSize == size - sizeof(SymbolCacheHeader), false, 0, "");
+
+    const SymbolCacheEntry *entries = reinterpret_cast<const SymbolCacheEntry *>(data + sizeof(SymbolCacheHeader));
+    const char *strings = reinterpret_cast<const char *>(data + sizeof(SymbolCacheHeader) + entriesSize);
+    std::vector<DfxSymbol> cached;
+    cached.reserve(header->symbolCount);
+    for (uint32_t i = 0; i < header->symbolCount; i++) {
+        const SymbolCacheEntry &entry = entries[i];
+        CHECK_TRUE(IsValidString(entry.nameOffset, entry.nameSize, header->stringTableSize) &&
+                   IsValidString(entry.demangleOffset, entry.demangleSize, header->stringTableSize) &&
+                   IsValidString(entry.moduleOffset, entry.moduleSize, header->stringTableSize), false, 0, "");
+        // the entries are saved sorted, a disorder means the file is broken
+        CHECK_TRUE(i == 0 || entry.vaddr > entries[i - 1].vaddr, false, 0, "");
+        cached.emplace_back(entry.vaddr, entry.len, std::string(strings + entry.nameOffset, entry.nameSize),
+                            std::string(strings + entry.demangleOffset, entry.demangleSize),
+                            entry.moduleSize == 0 ? module : std::string(strings + entry.moduleOffset, entry.moduleSize));
+    }
+    symbols.insert(symbols.end(), std::make_move_iterator(cached.begin()), std::make_move_iterator(cached.end()));
+    return true;
+}
+
+bool SymbolCache::Save(const std::string &buildId, const std::string &module, const std::vector<DfxSymbol> &symbols)
+{
+    const std::string filePath = GetCacheFilePath(buildId);
+    if (filePath.empty() || symbols.empty()) {
+        return false;
+    }
+    CHECK_TRUE(symbols.size() <= std::numeric_limits<uint32_t>::max(), false, 1, "too many symbols");
+    if (!IsDirectoryExists(directory_) && !CreateDirectory(directory_, CACHE_DIR_MODE)) {
+        HLOGE("create symbol cache directory %s failed", directory_.c_str());
+        return false;
+    }
+
+    SymbolCacheHeader header;
+    std::vector<SymbolCacheEntry> entries;
+    entries.reserve(symbols.size());
+    std::string stringTable;
+    auto appendString = [&stringTable](const std::string_view &str, uint32_t &offset, uint32_t &size) {
+        offset = static_cast<uint32_t>(stringTable.size());
+        size = static_cast<uint32_t>(str.size());
+        stringTable.append(str.data(), str.size());
+    };
+    for (const DfxSymbol &symbol : symbols) {
+        SymbolCacheEntry entry;
+        entry.vaddr = symbol.funcVaddr_;
+        entry.len = symbol.size_;
+        appendString(symbol.name_, entry.nameOffset, entry.nameSize);
+        if (symbol.demangle_ == symbol.name_) {
+            // most of the c symbols are not mangled, share the string
+            entry.demangleOffset = entry.nameOffset;
+            entry.demangleSize = entry.nameSize;
+        } else {
+            appendString(symbol.demangle_, entry.demangleOffset, entry.demangleSize);
+        }
+        if (symbol.module_ != module) {
+            appendString(symbol.module_, entry.moduleOffset, entry.moduleSize);
+        }
+        CHECK_TRUE(stringTable.size() <= std::numeric_limits<uint32_t>::max(), false, 1,
+                   "string table of symbol cache is too large");
+        entries.emplace_back(entry);
+    }
+    header.symbolCount = static_cast<uint32_t>(entries.size());
+    header.stringTableSize = stringTable.size();
+
+    // write to a temp file and rename, the other processes never see a half written cache
+    const std::string tempPath = filePath + "." + std::to_string(getpid()) + ".tmp";
+#if defined(is_mingw) && is_mingw
+    FILE *fp = fopen(tempPath.c_str(), "wb");
+#else
+    int fd = open(tempPath.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, CACHE_FILE_MODE);
+    FILE *fp = fd < 0 ? nullptr : fdopen(fd, "wb");
+    if (fp == nullptr && fd >= 0) {
+        close(fd);
+    }
+#endif
+    CHECK_TRUE(fp != nullptr, false, 1, "open %s failed", tempPath.c_str());
+    bool ret = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+               fwrite(entries.data(), sizeof(SymbolCacheEntry), entries.size(), fp) == entries.size() &&
+               fwrite(stringTable.data(), 1, stringTable.size(), fp) == stringTable.size();
+    ret = (fclose(fp) == 0) && ret;
+    if (!ret || rename(tempPath.c_str(), filePath.c_str()) != 0) {
+        HLOGE("write symbol cache %s failed", filePath.c_str());
+        remove(tempPath.c_str());
+        return false;
+    }
+    HLOGD("save %zu symbols to cache %s", symbols.size(), filePath.c_str());
+    return true;
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
@@ -27,8 +27,6 @@ namespace OHOS {
 namespace Developtools {
 namespace HiPerf {
 
-thread_local size_t SymbolResolver::currentThreadId_ = 0;
-
 SymbolResolver::SymbolResolver(
     const std::vector<std::unique_ptr<SymbolsFile>>& symbolsFiles)
     : symbolsFiles_(symbolsFiles)
@@ -38,7 +36,12 @@ SymbolResolver::SymbolResolver(
 bool SymbolResolver::GetFromCache(uint64_t fileVaddr, DfxSymbol& symbol,
                                   const STRING_VIEW& moduleCheck)
 {
-    auto& cache = GetCurrentCache();
+    CacheShard& shard = GetCacheShard(fileVaddr);
+    std::unique_lock<std::mutex> lock(shard.mutex, std::defer_lock);
+    if (concurrent_) {
+        lock.lock();
+    }
+    auto& cache = shard.cache;
     auto it = cache.find(fileVaddr);
     if (!(it == cache.end())) {
         if (!moduleCheck.empty() && it->module_ != moduleCheck) {
@@ -56,8 +59,12 @@ bool SymbolResolver::GetFromCache(uint64_t fileVaddr, DfxSymbol& symbol,
 
 void SymbolResolver::PutToCache(uint64_t fileVaddr, const DfxSymbol& symbol)
 {
-    auto& cache = GetCurrentCache();
-    cache.push_front(fileVaddr, symbol);
+    CacheShard& shard = GetCacheShard(fileVaddr);
+    std::unique_lock<std::mutex> lock(shard.mutex, std::defer_lock);
+    if (concurrent_) {
+        lock.lock();
+    }
+    shard.cache.push_front(fileVaddr, symbol);
 }
 
 SymbolsFile* SymbolResolver::FindSymbolsFile(const std::string& filePath) const
@@ -84,18 +91,16 @@ SymbolResolver::CacheStats SymbolResolver::GetCacheStats() const
 size_t SymbolResolver::GetCacheSize() const
 {
     size_t total = 0;
-    for (size_t i = 0; i < PARALLEL_THREAD_COUNT; ++i) {
-        total += threadCaches_[i].cache.size();
+    for (const auto& shard : cacheShards_) {
+        std::unique_lock<std::mutex> lock(shard.mutex, std::defer_lock);
+        if (concurrent_) {
+            lock.lock();
+        }
+        total += shard.cache.size();
     }
     return total;
 }
 
-size_t SymbolResolver::GetCurrentCacheSize() const
-{
-    size_t id = currentThreadId_ < PARALLEL_THREAD_COUNT ? currentThreadId_ : 0;
-    return threadCaches_[id].cache.size();
-}
-
 void SymbolResolver::ClearCache()
 {
     ClearAllCaches();
@@ -175,7 +180,6 @@ DfxSymbol UserSymbolResolver::Resolve(uint64_t ip, const VirtualThread& thread)
             vaddrSymbol.hit_, vaddrSymbol.ToDebugString().c_str());
         return vaddrSymbol;
     }
-    HLOGM("cache miss u %zu", GetCurrentCache().size());
     HLOGV("found symbol vaddr 0x%" PRIx64 " for runtime vaddr 0x%" PRIx64 " at '%s'",
           vaddrSymbol.fileVaddr_, ip, map->name.c_str());
     if (!symbolsFile->SymbolsLoaded()) {
@@ -185,7 +189,10 @@ DfxSymbol UserSymbolResolver::Resolve(uint64_t ip, const VirtualThread& thread)
     DfxSymbol foundSymbol;
     bool isAbcOrJsEngine = symbolsFile->IsAbc() || IsJsvmV8File(map->name) || IsArkwebV8File(map->name);
     if (!isAbcOrJsEngine) {
-        foundSymbol = symbolsFile->GetSymbolWithVaddr(vaddrSymbol.fileVaddr_);
+        const DfxSymbol *found = symbolsFile->FindSymbolWithVaddr(vaddrSymbol.fileVaddr_);
+        if (found != nullptr) {
+            foundSymbol = symbolsFile->GetVaddrSymbol(*found, vaddrSymbol.fileVaddr_);
+        }
     } else {
         HLOGD("symbolsFile:%s is ABC or JS engine :%d", symbolsFile->filePath_.c_str(), isAbcOrJsEngine);
         foundSymbol = symbolsFile->GetSymbolWithPcAndMap(ip, map);
@@ -247,16 +254,16 @@ DfxSymbol KernelSymbolResolver::Resolve(uint64_t ip, const VirtualThread& thread
         HLOGV("hit kernel cache 0x%" PRIx64 " %d", vaddrSymbol.fileVaddr_, vaddrSymbol.hit_);
         return vaddrSymbol;
     }
-    HLOGM("cache miss k %zu", GetCurrentCache().size());
     HLOGV("found symbol vaddr 0x%" PRIx64 " for runtime vaddr 0x%" PRIx64
           " at '%s'", vaddrSymbol.fileVaddr_, ip, map.name.c_str());
     if (!symbolsFile->SymbolsLoaded()) {
         symbolsFile->LoadSymbols();
     }
 
-    DfxSymbol foundSymbol = symbolsFile->GetSymbolWithVaddr(vaddrSymbol.fileVaddr_);
-    foundSymbol.taskVaddr_ = ip;
-    if (foundSymbol.IsValid()) {
+    const DfxSymbol *found = symbolsFile->FindSymbolWithVaddr(vaddrSymbol.fileVaddr_);
+    if (found != nullptr && found->IsValid()) {
+        DfxSymbol foundSymbol = symbolsFile->GetVaddrSymbol(*found, vaddrSymbol.fileVaddr_);
+        foundSymbol.taskVaddr_ = ip;
         PutToCache(vaddrSymbol.fileVaddr_, foundSymbol);
         return foundSymbol;
     }
@@ -305,7 +312,6 @@ DfxSymbol KernelThreadSymbolResolver::Resolve(uint64_t ip, const VirtualThread&
         HLOGV("hit kernel thread cache 0x%" PRIx64 " %d", vaddrSymbol.fileVaddr_, vaddrSymbol.hit_);
         return vaddrSymbol;
     }
-    HLOGM("cache miss kt %zu", GetCurrentCache().size());
     HLOGV("found symbol vaddr 0x%" PRIx64 " for runtime vaddr 0x%" PRIx64 " at '%s'",
           vaddrSymbol.fileVaddr_, ip, map->name.c_str());
     if (!symbolsFile->SymbolsLoaded()) {
@@ -317,7 +323,10 @@ DfxSymbol KernelThreadSymbolResolver::Resolve(uint64_t ip, const VirtualThread&
     if (thread.pid_ == devhostPid_ && needRecordCallBack_) {
         foundSymbol = symbolsFile->GetSymbolWithPcAndMap(vaddrSymbol.fileVaddr_, map);
     } else {
-        foundSymbol = symbolsFile->GetSymbolWithVaddr(vaddrSymbol.fileVaddr_);
+        const DfxSymbol *found = symbolsFile->FindSymbolWithVaddr(vaddrSymbol.fileVaddr_);
+        if (found != nullptr) {
+            foundSymbol = symbolsFile->GetVaddrSymbol(*found, vaddrSymbol.fileVaddr_);
+        }
     }
 
     foundSymbol.taskVaddr_ = ip;
@@ -354,7 +363,7 @@ DfxSymbol SymbolManager::ResolveSymbol(
         DfxSymbol symbol = kernelThreadResolver_->Resolve(ip, thread);
         kernelThreadResolveCount_.fetch_add(1, std::memory_order_relaxed);
         HLOGM("add addr to kernel thread cache 0x%" PRIx64 " cache size %zu", ip,
-              kernelThreadResolver_->GetCurrentCacheSize());
+              kernelThreadResolver_->GetCacheSize());
         if (symbol.IsValid()) {
             return symbol;
         }
@@ -365,7 +374,7 @@ DfxSymbol SymbolManager::ResolveSymbol(
         DfxSymbol kernelSymbol = kernelResolver_->Resolve(ip, thread);
         kernelResolveCount_.fetch_add(1, std::memory_order_relaxed);
         HLOGM("add addr to kernel cache 0x%" PRIx64 " cache size %zu", ip,
-              kernelResolver_->GetCurrentCacheSize());
+              kernelResolver_->GetCacheSize());
         return kernelSymbol;
     } else if (context == PERF_CONTEXT_USER) {
         userResolveCount_.fetch_add(1, std::memory_order_relaxed);
@@ -382,7 +391,7 @@ DfxSymbol SymbolManager::ResolveSymbol(
         DfxSymbol kernelSymbol = kernelResolver_->Resolve(ip, thread);
         kernelResolveCount_.fetch_add(1, std::memory_order_relaxed);
         HLOGM("add addr to kernel cache 0x%" PRIx64 " cache size %zu", ip,
-              kernelResolver_->GetCurrentCacheSize());
+              kernelResolver_->GetCacheSize());
         return kernelSymbol;
     }
 }
@@ -401,6 +410,13 @@ void SymbolManager::SetDevhostPid(pid_t devhostPid)
     }
 }
 
+void SymbolManager::SetConcurrent(const bool concurrent)
+{
+    userResolver_->SetConcurrent(concurrent);
+    kernelResolver_->SetConcurrent(concurrent);
+    kernelThreadResolver_->SetConcurrent(concurrent);
+}
+
 void SymbolManager::SetRecordMode(bool needRecordCallBack)
 {
     if (kernelThreadResolver_) {
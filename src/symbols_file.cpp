@@ -41,6 +41,7 @@
 #include "dwarf_encoding.h"
 #include "elf_factory.h"
 #include "hiperf_hilog.h"
+#include "symbol_cache.h"
 #include "unwinder_config.h"
 #include "utilities.h"
 #include "ipc_utilities.h"
@@ -411,14 +412,14 @@ private:
         return false;
     }
 
-    void UpdateSymbols(std::vector<DfxSymbol> &symbolsTable, const std::string &elfPath)
+    void UpdateSymbols(std::vector<DfxSymbol> &symbolsTable, const std::string &elfPath, const bool sorted = false)
     {
         symbols_.clear();
         HLOGD("%zu symbols loadded from symbolsTable.", symbolsTable.size());
 
         symbols_.swap(symbolsTable);
 
-        AdjustSymbols();
+        AdjustSymbols(sorted);
         HLOGD("%zu symbols loadded from elf '%s'.", symbols_.size(), elfPath.c_str());
         for (auto& symbol: symbols_) {
             HLOGD("symbol %s", symbol.ToDebugString().c_str());
@@ -484,16 +485,20 @@ private:
         // only one we will push in to symbols_
         // or both drop if build id is not same
         std::string buildIdFound = elfFile_->GetBuildId();
-        std::vector<DfxSymbol> symbolsTable;
-        AddSymbols(symbolsTable, elfFile_, filePath_);
-        if (UpdateBuildIdIfMatch(buildIdFound)) {
-            UpdateSymbols(symbolsTable, elfPath);
-        } else {
+        if (!UpdateBuildIdIfMatch(buildIdFound)) {
             HLOGW("symbols will not update for '%s' because buildId is not match.",
                   elfPath.c_str());
             // this mean failed . we don't goon for this.
             return false;
         }
+        std::vector<DfxSymbol> symbolsTable;
+        if (SymbolCache::Load(buildIdFound, filePath_, symbolsTable)) {
+            UpdateSymbols(symbolsTable, elfPath, true);
+        } else {
+            AddSymbols(symbolsTable, elfFile_, filePath_);
+            UpdateSymbols(symbolsTable, elfPath);
+            SymbolCache::Save(buildIdFound, filePath_, symbols_);
+        }
 
 #ifdef HIPERF_DEBUG_TIME
         auto usedTime = duration_cast<microseconds>(steady_clock::now() - startTime);
@@ -545,53 +550,11 @@ public:
     {
     }
 
-    static constexpr const int KSYM_MIN_TOKENS = 3;
     static constexpr const int KSYM_DEFAULT_LINE = 35000;
     static constexpr const int KSYM_DEFAULT_SIZE = 1024 * 1024 * 1; // 1MB
 
-    struct ParseTime {
-        std::chrono::microseconds parseLineTime = std::chrono::microseconds::zero();
-        std::chrono::microseconds sscanfTime = std::chrono::microseconds::zero();
-        std::chrono::microseconds newTime = std::chrono::microseconds::zero();
-        std::chrono::microseconds readFileTime = std::chrono::microseconds::zero();
-    };
-
-    void ParseKsymsLine(char **lineBegin, char **dataEnd, size_t &lines, ParseTime &parseTime)
+    static bool IsTextSymbolType(const char type)
     {
-        char *lineEnd = strchr(*lineBegin, '\n');
-        if (lineEnd != nullptr) {
-            *lineEnd = '\0';
-        } else {
-            lineEnd = *dataEnd;
-        }
-        size_t lineSize = (lineEnd != nullptr) ? (lineEnd - *lineBegin) : (*dataEnd - *lineBegin);
-
-        const auto eachLineStartTime = std::chrono::steady_clock::now();
-        lines++;
-        uint64_t addr = 0;
-        char type = '\0';
-
-        char nameRaw[lineSize];
-        char moduleRaw[lineSize];
-        int ret = sscanf_s(*lineBegin, "%" PRIx64 " %c %s%s", &addr, &type, sizeof(type),
-                           nameRaw, (unsigned)(sizeof(nameRaw) - 1),
-                           moduleRaw, (unsigned)(sizeof(moduleRaw) - 1));
-
-        // any way we finish the line scan
-        parseTime.sscanfTime += duration_cast<milliseconds>(steady_clock::now() - eachLineStartTime);
-
-        if (ret >= KSYM_MIN_TOKENS) {
-            if (ret == KSYM_MIN_TOKENS) {
-                moduleRaw[0] = '\0';
-            }
-            HLOGM(" 0x%016" PRIx64 " %c '%s' '%s'", addr, type, nameRaw, moduleRaw);
-        } else {
-            HLOGW("unknown line %d: '%s'", ret, *lineBegin);
-            *lineBegin = lineEnd + 1;
-            return;
-        }
-        *lineBegin = lineEnd + 1;
-
         /*
         T
         The symbol is in the text (code) section.
@@ -604,115 +567,153 @@ public:
         and the symbol is not defined, the value of the weak symbol
         becomes zero with no error.
         */
-        if (addr != 0 && strchr("TtWw", type)) {
-            const auto eachNewSymbolTime = steady_clock::now();
-            std::string name = nameRaw;
-            std::string module = moduleRaw;
-            // we only need text symbols
-            symbols_.emplace_back(addr, name, module.empty() ? filePath_ : module);
-            parseTime.newTime += duration_cast<milliseconds>(steady_clock::now() - eachNewSymbolTime);
-        }
-        parseTime.parseLineTime += duration_cast<milliseconds>(steady_clock::now() - eachLineStartTime);
+        return type == 'T' || type == 't' || type == 'W' || type == 'w';
     }
 
-    void ParseKsymsLine(char **lineBegin, char **dataEnd, size_t &lines)
+    static const char *SkipSpace(const char *begin, const char *end)
     {
-        char *lineEnd = strchr(*lineBegin, '\n');
-        if (lineEnd != nullptr) {
-            *lineEnd = '\0';
-        } else {
-            lineEnd = *dataEnd;
+        while (begin < end && (*begin == ' ' || *begin == '\t')) {
+            begin++;
         }
-        size_t lineSize = (lineEnd != nullptr) ? (lineEnd - *lineBegin) : (*dataEnd - *lineBegin);
+        return begin;
+    }
 
-        lines++;
-        uint64_t addr = 0;
-        char type = '\0';
+    static const char *FindSpace(const char *begin, const char *end)
+    {
+        while (begin < end && *begin != ' ' && *begin != '\t') {
+            begin++;
+        }
+        return begin;
+    }
 
-        char nameRaw[lineSize];
-        char moduleRaw[lineSize];
-        int ret = sscanf_s(*lineBegin, "%" PRIx64 " %c %s%s", &addr, &type, sizeof(type),
-                            nameRaw, (unsigned)(sizeof(nameRaw) - 1),
-                            moduleRaw, (unsigned)(sizeof(moduleRaw) - 1));
+    static int HexCharToInt(const char c)
+    {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10; // 10: value of 'a'
+        }
+        if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10; // 10: value of 'A'
+        }
+        return -1;
+    }
 
-        if (ret >= KSYM_MIN_TOKENS) {
-            if (ret == KSYM_MIN_TOKENS) {
-                moduleRaw[0] = '\0';
+    // line is "<addr> <type> <name>[\t[module]]", the type is checked first,
+    // so the lines of non text symbols are skipped without parsing the address and name.
+    void ParseKsymsLine(const char *lineBegin, const char *lineEnd)
+    {
+        const char *addrEnd = FindSpace(lineBegin, lineEnd);
+        const char *typeBegin = SkipSpace(addrEnd, lineEnd);
+        if (addrEnd == lineBegin || typeBegin == lineEnd) {
+            HLOGW("unknown line: '%s'", std::string(lineBegin, lineEnd).c_str());
+            return;
+        }
+        if (!IsTextSymbolType(*typeBegin)) {
+            return;
+        }
+        uint64_t addr = 0;
+        for (const char *p = lineBegin; p < addrEnd; p++) {
+            int digit = HexCharToInt(*p);
+            if (digit < 0) {
+                HLOGW("unknown line: '%s'", std::string(lineBegin, lineEnd).c_str());
+                return;
             }
-            HLOGM(" 0x%016" PRIx64 " %c '%s' '%s'", addr, type, nameRaw, moduleRaw);
-        } else {
-            HLOGW("unknown line %d: '%s'", ret, *lineBegin);
-            *lineBegin = lineEnd + 1;
+            addr = (addr << 4) | static_cast<uint64_t>(digit); // 4: bits of a hex digit
+        }
+        const char *nameBegin = SkipSpace(typeBegin + 1, lineEnd);
+        const char *nameEnd = FindSpace(nameBegin, lineEnd);
+        if (nameBegin == nameEnd) {
+            HLOGW("unknown line: '%s'", std::string(lineBegin, lineEnd).c_str());
             return;
         }
-        *lineBegin = lineEnd + 1;
-
-        /*
-        T
-        The symbol is in the text (code) section.
-
-        W
-        The symbol is a weak symbol that has not been specifically
-        tagged as a weak object symbol. When a weak defined symbol is
-        linked with a normal defined symbol, the normal defined symbol
-        is used with no error. When a weak undefined symbol is linked
-        and the symbol is not defined, the value of the weak symbol
-        becomes zero with no error.
-        */
-        if (addr != 0 && strchr("TtWw", type)) {
-            std::string name = nameRaw;
-            std::string module = moduleRaw;
-            // we only need text symbols
-            symbols_.emplace_back(addr, name, module.empty() ? filePath_ : module);
+        if (addr == 0) {
+            return;
         }
+        const char *moduleBegin = SkipSpace(nameEnd, lineEnd);
+        const char *moduleEnd = FindSpace(moduleBegin, lineEnd);
+        // we only need text symbols
+        symbols_.emplace_back(addr, std::string(nameBegin, nameEnd),
+                              moduleBegin == moduleEnd ? filePath_ : std::string(moduleBegin, moduleEnd));
     }
 
     bool ParseKallsymsLine(const std::string &kallsymsPath)
     {
 #ifdef HIPERF_DEBUG_SYMBOLS_TIME
         const auto startTime = steady_clock::now();
-        ParseTime parseTime;
-        parseTime.parseLineTime = std::chrono::microseconds::zero();
-        parseTime.sscanfTime = std::chrono::microseconds::zero();
-        parseTime.newTime = std::chrono::microseconds::zero();
-        parseTime.readFileTime = std::chrono::microseconds::zero();
-#endif
-        size_t lines = 0;
-#ifdef HIPERF_DEBUG_SYMBOLS_TIME
-        const auto eachFileStartTime = steady_clock::now();
 #endif
         std::string kallsym;
         CHECK_TRUE(ReadFileToString(kallsymsPath, kallsym, KSYM_DEFAULT_SIZE) && !kallsym.empty(), false, 1,
                    "%s load failed.", kallsymsPath.c_str());
 #ifdef HIPERF_DEBUG_SYMBOLS_TIME
-        // any way we finish the line scan
-        readFileTime += duration_cast<milliseconds>(steady_clock::now() - eachFileStartTime);
+        const auto readFileTime = duration_cast<microseconds>(steady_clock::now() - startTime);
 #endif
         // reduce the mem alloc
         symbols_.reserve(KSYM_DEFAULT_LINE);
 
-        char *lineBegin = kallsym.data();
-        char *dataEnd = lineBegin + kallsym.size();
+        size_t lines = 0;
+        const char *lineBegin = kallsym.data();
+        const char *dataEnd = lineBegin + kallsym.size();
         while (lineBegin < dataEnd) {
-#ifdef HIPERF_DEBUG_SYMBOLS_TIME
-            ParseKsymsLine(&lineBegin, &dataEnd, lines, parseTime);
-#else
-            ParseKsymsLine(&lineBegin, &dataEnd, lines);
-#endif
+            // memchr is much faster than a char by char loop for the long lines
+            const char *lineEnd = static_cast<const char *>(memchr(lineBegin, '\n', dataEnd - lineBegin));
+            if (lineEnd == nullptr) {
+                lineEnd = dataEnd;
+            }
+            lines++;
+            ParseKsymsLine(lineBegin, lineEnd);
+            lineBegin = lineEnd + 1;
         }
 #ifdef HIPERF_DEBUG_SYMBOLS_TIME
-        std::chrono::microseconds usedTime =
-            duration_cast<milliseconds>(steady_clock::now() - startTime);
+        const auto usedTime = duration_cast<microseconds>(steady_clock::now() - startTime);
         printf("parse kernel symbols use : %0.3f ms\n", usedTime.count() / MS_DURATION);
-        printf("parse line use : %0.3f ms\n", parseTime.parseLineTime.count() / MS_DURATION);
-        printf("sscanf line use : %0.3f ms\n", parseTime.sscanfTime.count() / MS_DURATION);
-        printf("new symbols use : %0.3f ms\n", parseTime.newTime.count() / MS_DURATION);
-        printf("read file use : %0.3f ms\n", parseTime.readFileTime.count() / MS_DURATION);
+        printf("read file use : %0.3f ms\n", readFileTime.count() / MS_DURATION);
 #endif
         HLOGD("load %s: %zu line processed(%zu symbols)", kallsymsPath.c_str(), lines, symbols_.size());
         return true;
     }
 
+    // kallsyms changes every boot with kaslr, so the symbols are cached by both the kernel build id and boot id
+    std::string GetKallsymsCacheKey() const
+    {
+        std::string notes = ReadFileToString(KERNEL_NOTES_PATH);
+        std::string bootId = ReadFileToString(BOOT_ID_PATH);
+        if (notes.empty() || bootId.empty()) {
+            return EMPTY_STRING;
+        }
+        std::string buildId = DfxElf::GetBuildId((uint64_t)notes.data(), (uint64_t)notes.size());
+        // boot id is an uuid like "1b4e28ba-2fa1-11d2-883f-b9a761bde3fb\n"
+        bootId.erase(std::remove_if(bootId.begin(), bootId.end(), [](const char c) {
+            return HexCharToInt(c) < 0;
+        }), bootId.end());
+        if (buildId.empty() || bootId.empty()) {
+            return EMPTY_STRING;
+        }
+        return buildId + bootId + GetModulesHash();
+    }
+
+    // the modules loaded or unloaded within a boot change kallsyms, their names and addresses are hashed.
+    // the use counts are left out, they change without changing the symbols
+    std::string GetModulesHash() const
+    {
+        std::string modules = ReadFileToString(MODULES_PATH);
+        std::string layout;
+        for (const std::string &line : StringSplit(modules, "\n")) {
+            const size_t nameEnd = line.find(' ');
+            const size_t addrBegin = line.find(" 0x");
+            layout.append(line, 0, nameEnd);
+            if (addrBegin != std::string::npos) {
+                layout.append(line, addrBegin, line.find(' ', addrBegin + 1) - addrBegin);
+            }
+            layout.push_back('\n');
+        }
+        return StringPrintf("%016zx", std::hash<std::string> {}(layout));
+    }
+
+    const std::string KERNEL_NOTES_PATH = "/sys/kernel/notes";
+    const std::string MODULES_PATH = "/proc/modules";
+    const std::string BOOT_ID_PATH = "/proc/sys/kernel/random/boot_id";
     const std::string KPTR_RESTRICT = "/proc/sys/kernel/kptr_restrict";
 
     bool LoadKernelSyms()
@@ -725,6 +726,12 @@ public:
             printf("No vmlinux path is given, and kallsyms cannot be opened\n");
             return false;
         }
+        const std::string cacheKey = SymbolCache::IsEnabled() ? GetKallsymsCacheKey() : EMPTY_STRING;
+        if (!cacheKey.empty() && SymbolCache::Load(cacheKey, filePath_, symbols_)) {
+            AdjustSymbols(true);
+            HLOGV("%zu symbols_ loadded from symbol cache.\n", symbols_.size());
+            return true;
+        }
         bool hasChangeKptr = false;
         std::string oldKptrRestrict = ReadFileToString(KPTR_RESTRICT);
         if (oldKptrRestrict.front() != '0') {
@@ -761,6 +768,9 @@ public:
         } else {
             AdjustSymbols();
             HLOGV("%zu symbols_ loadded from kallsyms.\n", symbols_.size());
+            if (!cacheKey.empty()) {
+                SymbolCache::Save(cacheKey, filePath_, symbols_);
+            }
             return true;
         }
     }
@@ -1574,28 +1584,29 @@ std::unique_ptr<SymbolsFile> SymbolsFile::CreateSymbolsFile(const std::string &s
     }
 }
 
-void SymbolsFile::AdjustSymbols()
+void SymbolsFile::AdjustSymbols(const bool sorted)
 {
     if (symbols_.size() <= 0) {
         return;
     }
 
-    // order
-    sort(symbols_.begin(), symbols_.end(), [](const DfxSymbol& a, const DfxSymbol& b) {
-        return a.funcVaddr_ < b.funcVaddr_;
-    });
-    HLOGV("sort completed");
-
     size_t fullSize = symbols_.size();
     size_t erased = 0;
-
-    // Check for duplicate vaddr
-    auto last = std::unique(symbols_.begin(), symbols_.end(), [](const DfxSymbol &a, const DfxSymbol &b) {
-        return (a.funcVaddr_ == b.funcVaddr_);
-    });
-    symbols_.erase(last, symbols_.end());
-    erased = fullSize - symbols_.size();
-    HLOGV("uniqued completed");
+    if (!sorted) {
+        // order
+        sort(symbols_.begin(), symbols_.end(), [](const DfxSymbol& a, const DfxSymbol& b) {
+            return a.funcVaddr_ < b.funcVaddr_;
+        });
+        HLOGV("sort completed");
+
+        // Check for duplicate vaddr
+        auto last = std::unique(symbols_.begin(), symbols_.end(), [](const DfxSymbol &a, const DfxSymbol &b) {
+            return (a.funcVaddr_ == b.funcVaddr_);
+        });
+        symbols_.erase(last, symbols_.end());
+        erased = fullSize - symbols_.size();
+        HLOGV("uniqued completed");
+    }
     auto it = symbols_.begin();
     while (it != symbols_.end()) {
         it->index_ = it - symbols_.begin();
@@ -1608,6 +1619,7 @@ void SymbolsFile::AdjustSymbols()
     if (textExecVaddrRange_ == maxVaddr) {
         textExecVaddrRange_ = symbols_.back().funcVaddr_ - symbols_.front().funcVaddr_;
     }
+    symbolsIndex_.Build(symbols_);
 
     HLOGDDD("%zu symbols after adjust (%zu erased) 0x%016" PRIx64 " - 0x%016" PRIx64
             " @0x%016" PRIx64 " ",
@@ -1638,59 +1650,46 @@ const std::vector<DfxSymbol *> &SymbolsFile::GetMatchedSymbols()
     return matchedSymbols_;
 }
 
+DfxSymbol *SymbolsFile::FindSymbolWithVaddr(const uint64_t vaddrInFile)
+{
+    // it should be already order from small to large
+    size_t pos = SymbolVaddrIndex::NOT_FOUND;
+    if (symbolsIndex_.Size() == symbols_.size()) {
+        pos = symbolsIndex_.FindFloor(vaddrInFile);
+    } else {
+        // symbols_ changed without indexed, the index is not built here, it may be searched by several threads
+        auto it = std::upper_bound(symbols_.begin(), symbols_.end(), vaddrInFile, DfxSymbol::ValueLessThen);
+        if (it != symbols_.begin()) {
+            pos = static_cast<size_t>(it - symbols_.begin()) - 1;
+        }
+    }
+    if (pos == SymbolVaddrIndex::NOT_FOUND || !symbols_[pos].Contain(vaddrInFile)) {
+        return nullptr;
+    }
+    DfxSymbol *found = &symbols_[pos];
+    if (!found->matched_) {
+        found->matched_ = true;
+        matchedSymbols_.push_back(found);
+    }
+    return found;
+}
+
 const DfxSymbol SymbolsFile::GetSymbolWithVaddr(uint64_t vaddrInFile)
 {
 #ifdef HIPERF_DEBUG_TIME
     const auto startTime = steady_clock::now();
 #endif
     DfxSymbol symbol;
-    // it should be already order from small to large
-    auto found =
-        std::upper_bound(symbols_.begin(), symbols_.end(), vaddrInFile, DfxSymbol::ValueLessThen);
-    /*
-    if data is { 1, 2, 4, 5, 5, 6 };
-    upper_bound for each val :
-        0 < 1 at index 0
-        1 < 2 at index 1
-        2 < 4 at index 2
-        3 < 4 at index 2
-        4 < 5 at index 3
-        5 < 6 at index 5
-        6 < not found
-    if key symbol vaddr is { 1, 2, 4, 5, 5, 6 };
-     check ip vaddr for each val :
-       ip   sym
-        0   not found
-        1   1
-        1   1
-        2   2
-        3   3
-        4   4
-        5   5
-        6   6
-        7   7
-    */
-    if (found != symbols_.begin()) {
-        found = std::prev(found);
-        if (found != symbols_.end()) {
-            if (found->Contain(vaddrInFile)) {
-                found->offsetToVaddr_ = vaddrInFile - found->funcVaddr_;
-                if (!found->matched_) {
-                    found->matched_ = true;
-                    matchedSymbols_.push_back(&(*found));
-                }
-                symbol = *found; // copy
-                HLOGV("found '%s' for vaddr 0x%016" PRIx64 "", symbol.ToString().c_str(), vaddrInFile);
-            }
-        }
-    }
-
-    if (!symbol.IsValid()) {
+    const DfxSymbol *found = FindSymbolWithVaddr(vaddrInFile);
+    if (found != nullptr) {
+        symbol = GetVaddrSymbol(*found, vaddrInFile);
+        HLOGV("found '%s' for vaddr 0x%016" PRIx64 "", symbol.ToString().c_str(), vaddrInFile);
+    } else {
         HLOGV("NOT found vaddr 0x%" PRIx64 " in symbole file %s(%zu)", vaddrInFile,
               filePath_.c_str(), symbols_.size());
+        symbol.fileVaddr_ = vaddrInFile;
+        symbol.symbolFileIndex_ = id_;
     }
-    symbol.fileVaddr_ = vaddrInFile;
-    symbol.symbolFileIndex_ = id_;
 
 #ifdef HIPERF_DEBUG_TIME
     auto usedTime = duration_cast<milliseconds>(steady_clock::now() - startTime);
@@ -1701,6 +1700,16 @@ const DfxSymbol SymbolsFile::GetSymbolWithVaddr(uint64_t vaddrInFile)
     return symbol;
 }
 
+DfxSymbol SymbolsFile::GetVaddrSymbol(const DfxSymbol &found, const uint64_t vaddrInFile) const
+{
+    // the found one is shared, only the copy is changed
+    DfxSymbol symbol = found;
+    symbol.offsetToVaddr_ = vaddrInFile - found.funcVaddr_;
+    symbol.fileVaddr_ = vaddrInFile;
+    symbol.symbolFileIndex_ = id_;
+    return symbol;
+}
+
 bool SymbolsFile::CheckPathReadable(const std::string &path) const
 {
     if (access(path.c_str(), R_OK) == 0) {
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define HILOG_TAG "Top"
+
+#include "top_aggregator.h"
+
+#include <algorithm>
+
+#include "debug_logger.h"
+
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+namespace {
+struct ItemRef {
+    double weight;
+    const std::string *dso;
+    const std::string *func;
+};
+
+// heaviest first, the same weight is ordered by name so the output is stable
+bool HeavierThan(const ItemRef &a, const ItemRef &b)
+{
+    if (a.weight != b.weight) {
+        return a.weight > b.weight;
+    }
+    if (*a.dso != *b.dso) {
+        return *a.dso < *b.dso;
+    }
+    return *a.func < *b.func;
+}
+
+std::vector<TopAggregator::TopItem> MakeTopItems(std::vector<ItemRef> &refs, const size_t count)
+{
+    const size_t topCount = std::min(count, refs.size());
+    std::partial_sort(refs.begin(), refs.begin() + topCount, refs.end(), HeavierThan);
+    std::vector<TopAggregator::TopItem> items;
+    items.reserve(topCount);
+    for (size_t i = 0; i < topCount; i++) {
+        items.push_back({*refs[i].dso, *refs[i].func, refs[i].weight});
+    }
+    return items;
+}
+} // namespace
+
+TopAggregator::TopAggregator(const size_t maxEntries, const double decay)
+    : maxEntries_(std::max<size_t>(maxEntries, 1)), decay_(decay)
+{
+}
+
+void TopAggregator::AddSample(const std::string &dso, const std::string &func, const uint64_t eventCount)
+{
+    recentSamples_++;
+    totalWeight_ += eventCount;
+    auto dsoIt = dsos_.find(dso);
+    if (dsoIt == dsos_.end()) {
+        dsoIt = dsos_.emplace(dso, DsoEntry()).first;
+    }
+    dsoIt->second.weight += eventCount;
+    auto &funcs = dsoIt->second.funcs;
+    auto funcIt = funcs.find(func);
+    if (funcIt != funcs.end()) {
+        funcIt->second += eventCount;
+        return;
+    }
+    if (funcCount_ >= maxEntries_) {
+        // the dso of dsoIt is kept, erasing the others does not invalidate it
+        Evict(dsoIt->first);
+    }
+    funcs.emplace(func, eventCount);
+    funcCount_++;
+}
+
+void TopAggregator::Decay()
+{
+    recentSamples_ = 0;
+    totalWeight_ *= decay_;
+    const double coldWeight = std::max(totalWeight_ * COLD_RATIO, MIN_WEIGHT);
+    for (auto dsoIt = dsos_.begin(); dsoIt != dsos_.end();) {
+        DsoEntry &entry = dsoIt->second;
+        entry.weight *= decay_;
+        for (auto funcIt = entry.funcs.begin(); funcIt != entry.funcs.end();) {
+            funcIt->second *= decay_;
+            if (funcIt->second < coldWeight) {
+                funcIt = entry.funcs.erase(funcIt);
+                funcCount_--;
+            } else {
+                funcIt++;
+            }
+        }
+        if (entry.weight < coldWeight) {
+            funcCount_ -= entry.funcs.size();
+            dsoIt = dsos_.erase(dsoIt);
+        } else {
+            dsoIt++;
+        }
+    }
+    HLOGV("%zu dsos %zu functions after decay", dsos_.size(), funcCount_);
+}
+
+void TopAggregator::Evict(const std::string &keepDso)
+{
+    const size_t keepCount = maxEntries_ * 3 / 4; // 3 / 4 : evict a quarter at once
+    if (funcCount_ <= keepCount) {
+        return;
+    }
+    std::vector<double> weights;
+    weights.reserve(funcCount_);
+    for (const auto &dso : dsos_) {
+        for (const auto &func : dso.second.funcs) {
+            weights.push_back(func.second);
+        }
+    }
+    size_t evictCount = weights.size() - keepCount;
+    auto nth = weights.begin() + (evictCount - 1);
+    std::nth_element(weights.begin(), nth, weights.end());
+    const double threshold = *nth;
+    // the lighter ones first, then the ones same as threshold until enough
+    for (bool sameAsThreshold : {false, true}) {
+        for (auto &dso : dsos_) {
+            auto &funcs = dso.second.funcs;
+            for (auto funcIt = funcs.begin(); funcIt != funcs.end() && evictCount > 0;) {
+                bool evict = sameAsThreshold ? funcIt->second == threshold : funcIt->second < threshold;
+                if (evict) {
+                    funcIt = funcs.erase(funcIt);
+                    funcCount_--;
+                    evictCount--;
+                } else {
+                    funcIt++;
+                }
+            }
+        }
+    }
+    for (auto dsoIt = dsos_.begin(); dsoIt != dsos_.end();) {
+        if (dsoIt->second.funcs.empty() && dsoIt->first != keepDso) {
+            dsoIt = dsos_.erase(dsoIt);
+        } else {
+            dsoIt++;
+        }
+    }
+    HLOGV("evicted to %zu dsos %zu functions", dsos_.size(), funcCount_);
+}
+
+std::vector<TopAggregator::TopItem> TopAggregator::GetTopFunctions(const size_t count) const
+{
+    std::vector<ItemRef> refs;
+    refs.reserve(funcCount_);
+    for (const auto &dso : dsos_) {
+        for (const auto &func : dso.second.funcs) {
+            refs.push_back({func.second, &dso.first, &func.first});
+        }
+    }
+    return MakeTopItems(refs, count);
+}
+
+std::vector<TopAggregator::TopItem> TopAggregator::GetTopDsos(const size_t count) const
+{
+    static const std::string noFunc;
+    std::vector<ItemRef> refs;
+    refs.reserve(dsos_.size());
+    for (const auto &dso : dsos_) {
+        refs.push_back({dso.second.weight, &dso.first, &noFunc});
+    }
+    return MakeTopItems(refs, count);
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
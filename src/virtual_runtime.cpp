@@ -259,6 +259,13 @@ DfxSymbol VirtualRuntime::GetSymbol(const uint64_t ip, const pid_t pid, const pi
     return symbolManager_->ResolveSymbol(ip, threadManager_->GetThread(pid, tid), context, isKernelThread);
 }
 
+void VirtualRuntime::SetSymbolConcurrent(const bool concurrent)
+{
+    if (symbolManager_ != nullptr) {
+        symbolManager_->SetConcurrent(concurrent);
+    }
+}
+
 void VirtualRuntime::ClearSymbolCache()
 {
     if (threadManager_) {
@@ -357,6 +364,25 @@ void VirtualRuntime::UnwindFromRecord(PerfRecordSample& recordSample)
     callStackProcessor_->UnwindFromRecord(recordSample);
 }
 
+#if defined(is_ohos) && is_ohos
+VirtualThread *VirtualRuntime::GetUnwindThread(PerfRecordSample& recordSample)
+{
+    return callStackProcessor_->GetUnwindThread(recordSample);
+}
+
+void VirtualRuntime::UnwindUserStack(PerfRecordSample& recordSample, const VirtualThread& thread,
+                                     CallStack& callstack, std::vector<DfxFrame>& callFrames,
+                                     std::vector<u64>& ips) const
+{
+    callStackProcessor_->UnwindUserStack(recordSample, thread, callstack, callFrames, ips);
+}
+#endif
+
+void VirtualRuntime::FinishUnwind(PerfRecordSample& recordSample)
+{
+    callStackProcessor_->FinishUnwind(recordSample);
+}
+
 std::string VirtualRuntime::ReadThreadName(const pid_t tid, const bool isThread)
 {
     return threadManager_->ReadThreadName(tid, isThread);
@@ -102,8 +102,10 @@ SymbolsFile *VirtualThread::FindSymbolsFileByMap(std::shared_ptr<DfxMap> map) co
     }
     if (map->symbolFileIndex != -1) {
         // no need further operation
-        if (symbolsFiles_[map->symbolFileIndex]->LoadDebugInfo(map)) {
-            return symbolsFiles_[map->symbolFileIndex].get();
+        SymbolsFile *symbolsFile = symbolsFiles_[map->symbolFileIndex].get();
+        std::lock_guard<std::mutex> lock(symbolsFile->loadMutex_);
+        if (symbolsFile->LoadDebugInfo(map)) {
+            return symbolsFile;
         }
     } else {
         // add it to cache
@@ -111,6 +113,7 @@ SymbolsFile *VirtualThread::FindSymbolsFileByMap(std::shared_ptr<DfxMap> map) co
             if (symbolsFiles_[i]->filePath_ == map->name) {
                 HLOGD("found symbol for map '%s'", map->name.c_str());
                 map->symbolFileIndex = static_cast<int32_t>(i);
+                std::lock_guard<std::mutex> lock(symbolsFiles_[i]->loadMutex_);
                 if (symbolsFiles_[i]->LoadDebugInfo(map)) {
                     return symbolsFiles_[i].get();
                 }
@@ -176,6 +179,7 @@ bool VirtualThread::ReadRoMemory(uint64_t vaddr, uint8_t *data, const size_t siz
                 if (symFile == nullptr) {
                     return false;
                 }
+                std::lock_guard<std::mutex> lock(symFile->loadMutex_);
                 map->elf = symFile->GetElfFile();
             }
             if (map->elf != nullptr) {
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "async_file_writer_test.h"
+
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace testing::ext;
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+class AsyncFileWriterTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+    void SetUp();
+    void TearDown();
+
+    static std::vector<uint8_t> MakeData(const size_t size);
+    std::vector<uint8_t> ReadFile(const size_t offset, const size_t size) const;
+
+    const std::string fileName_ = "/data/local/tmp/async_file_writer_test.data";
+    int fd_ = -1;
+};
+
+void AsyncFileWriterTest::SetUpTestCase() {}
+
+void AsyncFileWriterTest::TearDownTestCase() {}
+
+void AsyncFileWriterTest::SetUp()
+{
+    fd_ = open(fileName_.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    ASSERT_GE(fd_, 0);
+}
+
+void AsyncFileWriterTest::TearDown()
+{
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    unlink(fileName_.c_str());
+}
+
+std::vector<uint8_t> AsyncFileWriterTest::MakeData(const size_t size)
+{
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = static_cast<uint8_t>(i * 7 + (i >> 12));
+    }
+    return data;
+}
+
+std::vector<uint8_t> AsyncFileWriterTest::ReadFile(const size_t offset, const size_t size) const
+{
+    std::vector<uint8_t> data(size);
+    if (pread(fd_, data.data(), size, offset) != static_cast<ssize_t>(size)) {
+        data.clear();
+    }
+    return data;
+}
+
+/**
+ * @tc.name: WriteInOrder
+ * @tc.desc: data written across many buffers is in the file at the right offset
+ * @tc.type: FUNC
+ */
+HWTEST_F(AsyncFileWriterTest, WriteInOrder, TestSize.Level1)
+{
+    constexpr size_t bufferSize = 8 * 1024;
+    constexpr size_t bufferCount = 2;
+    constexpr size_t offset = 100;
+    constexpr size_t pieceSize = 300;
+    std::vector<uint8_t> data = MakeData(bufferSize * 10 + 123);
+    AsyncFileWriter writer(fd_, bufferSize, bufferCount);
+    ASSERT_TRUE(writer.Start(offset));
+    for (size_t pos = 0; pos < data.size(); pos += pieceSize) {
+        ASSERT_TRUE(writer.Write(data.data() + pos, std::min(pieceSize, data.size() - pos)));
+    }
+    ASSERT_TRUE(writer.Stop());
+    EXPECT_FALSE(writer.Write(data.data(), 1));
+
+    EXPECT_EQ(ReadFile(offset, data.size()), data);
+    AsyncFileWriter::Stat stat = writer.GetStat();
+    EXPECT_EQ(stat.writtenBytes, data.size());
+    EXPECT_GT(stat.flushCount, 1u);
+    EXPECT_LE(stat.maxPendingBuffers, bufferCount);
+}
+
+/**
+ * @tc.name: DirectIo
+ * @tc.desc: the aligned buffers are written by the O_DIRECT fd, the result is the same
+ * @tc.type: FUNC
+ */
+HWTEST_F(AsyncFileWriterTest, DirectIo, TestSize.Level1)
+{
+    constexpr size_t offset = 1000;
+    std::vector<uint8_t> data = MakeData(AsyncFileWriter::DIRECT_IO_ALIGN * 20 + 1);
+    int directFd = open(fileName_.c_str(), O_WRONLY | O_DIRECT | O_CLOEXEC);
+    {
+        AsyncFileWriter writer(fd_, AsyncFileWriter::DIRECT_IO_ALIGN * 4);
+        ASSERT_TRUE(writer.Start(offset, directFd));
+        ASSERT_TRUE(writer.Write(data.data(), data.size()));
+        ASSERT_TRUE(writer.Stop());
+    }
+    if (directFd >= 0) {
+        close(directFd);
+    }
+    EXPECT_EQ(ReadFile(offset, data.size()), data);
+}
+
+/**
+ * @tc.name: WriteError
+ * @tc.desc: a failed flush is reported to the caller
+ * @tc.type: FUNC
+ */
+HWTEST_F(AsyncFileWriterTest, WriteError, TestSize.Level2)
+{
+    int readOnlyFd = open(fileName_.c_str(), O_RDONLY | O_CLOEXEC);
+    ASSERT_GE(readOnlyFd, 0);
+    constexpr size_t bufferSize = 4096;
+    std::vector<uint8_t> data = MakeData(bufferSize * 4);
+    AsyncFileWriter writer(readOnlyFd, bufferSize, 1);
+    ASSERT_TRUE(writer.Start(0));
+    writer.Write(data.data(), data.size());
+    EXPECT_FALSE(writer.Stop());
+    close(readOnlyFd);
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
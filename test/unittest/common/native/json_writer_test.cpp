@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "json_writer_test.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+using namespace testing::ext;
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+class JsonWriterTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+    void SetUp();
+    void TearDown();
+
+    std::string ReadOutput();
+
+    FILE *output_ = nullptr;
+};
+
+void JsonWriterTest::SetUpTestCase() {}
+
+void JsonWriterTest::TearDownTestCase() {}
+
+void JsonWriterTest::SetUp()
+{
+    output_ = tmpfile();
+    ASSERT_NE(output_, nullptr);
+}
+
+void JsonWriterTest::TearDown()
+{
+    if (output_ != nullptr) {
+        fclose(output_);
+        output_ = nullptr;
+    }
+}
+
+std::string JsonWriterTest::ReadOutput()
+{
+    std::string content;
+    rewind(output_);
+    char buf[BUFSIZ];
+    size_t size = 0;
+    while ((size = fread(buf, 1, sizeof(buf), output_)) > 0) {
+        content.append(buf, size);
+    }
+    return content;
+}
+
+/**
+ * @tc.name: WriteNumber
+ * @tc.desc: integers are written as decimal
+ * @tc.type: FUNC
+ */
+HWTEST_F(JsonWriterTest, WriteNumber, TestSize.Level1)
+{
+    {
+        JsonWriter writer(output_);
+        writer.WriteNumber(0);
+        writer.Write(',');
+        writer.WriteNumber(-123);
+        writer.Write(',');
+        writer.WriteNumber(std::numeric_limits<uint64_t>::max());
+        writer.Write(',');
+        writer.WriteNumber(std::numeric_limits<int64_t>::min());
+        writer.Write(',');
+        writer.WriteNumber(true);
+    }
+    EXPECT_EQ(ReadOutput(), "0,-123,18446744073709551615,-9223372036854775808,1");
+}
+
+/**
+ * @tc.name: WriteString
+ * @tc.desc: strings are quoted and escaped
+ * @tc.type: FUNC
+ */
+HWTEST_F(JsonWriterTest, WriteString, TestSize.Level1)
+{
+    {
+        JsonWriter writer(output_);
+        writer.WriteString("func");
+        writer.Write(',');
+        writer.WriteString("");
+        writer.Write(',');
+        writer.WriteString("a\"b\\c\nd\te\x01");
+    }
+    EXPECT_EQ(ReadOutput(), "\"func\",\"\",\"a\\\"b\\\\c\\nd\\te\\u0001\"");
+}
+
+/**
+ * @tc.name: SmallBuffer
+ * @tc.desc: the buffer is written out when it is full
+ * @tc.type: FUNC
+ */
+HWTEST_F(JsonWriterTest, SmallBuffer, TestSize.Level1)
+{
+    std::string expect;
+    {
+        JsonWriter writer(output_, 1);
+        for (int i = 0; i < 1000; i++) {
+            std::string text = "text" + std::to_string(i);
+            writer.WriteString(text);
+            writer.WriteNumber(i);
+            expect += "\"" + text + "\"" + std::to_string(i);
+        }
+        EXPECT_TRUE(writer.Flush());
+    }
+    EXPECT_EQ(ReadOutput(), expect);
+}
+
+/**
+ * @tc.name: WriteFailed
+ * @tc.desc: Flush returns false if the file can not be written
+ * @tc.type: FUNC
+ */
+HWTEST_F(JsonWriterTest, WriteFailed, TestSize.Level2)
+{
+    FILE *failFile = fopen("/dev/full", "w");
+    if (failFile == nullptr) {
+        return;
+    }
+    setvbuf(failFile, nullptr, _IONBF, 0);
+    {
+        JsonWriter writer(failFile);
+        writer.WriteString("value");
+        EXPECT_FALSE(writer.Flush());
+        // failure is kept
+        EXPECT_FALSE(writer.Flush());
+    }
+    fclose(failFile);
+
+    JsonWriter writer(nullptr);
+    writer.Write('{');
+    EXPECT_FALSE(writer.Flush());
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
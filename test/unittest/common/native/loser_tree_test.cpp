@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "loser_tree_test.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace testing::ext;
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+class LoserTreeTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+    void SetUp();
+    void TearDown();
+
+    // merge the sorted sources with loser tree
+    static std::vector<uint64_t> Merge(const std::vector<std::vector<uint64_t>> &sources);
+};
+
+void LoserTreeTest::SetUpTestCase() {}
+
+void LoserTreeTest::TearDownTestCase() {}
+
+void LoserTreeTest::SetUp() {}
+
+void LoserTreeTest::TearDown() {}
+
+std::vector<uint64_t> LoserTreeTest::Merge(const std::vector<std::vector<uint64_t>> &sources)
+{
+    // empty sources are not put into the tree
+    std::vector<const std::vector<uint64_t> *> leaves;
+    for (const auto &source : sources) {
+        if (!source.empty()) {
+            leaves.push_back(&source);
+        }
+    }
+    std::vector<size_t> pos(leaves.size(), 0);
+    auto less = [&leaves, &pos](const size_t left, const size_t right) {
+        return (*leaves[left])[pos[left]] < (*leaves[right])[pos[right]];
+    };
+    LoserTree<decltype(less)> tree(less);
+    tree.Build(leaves.size());
+
+    std::vector<uint64_t> result;
+    size_t winner = 0;
+    while ((winner = tree.Top()) != leaves.size()) {
+        result.push_back((*leaves[winner])[pos[winner]]);
+        if (++pos[winner] < leaves[winner]->size()) {
+            tree.Replay(winner);
+        } else {
+            tree.Exhaust(winner);
+        }
+    }
+    return result;
+}
+
+/**
+ * @tc.name: Empty
+ * @tc.desc: Test merge with no source
+ * @tc.type: FUNC
+ */
+HWTEST_F(LoserTreeTest, Empty, TestSize.Level1)
+{
+    EXPECT_TRUE(Merge({}).empty());
+    EXPECT_TRUE(Merge({{}, {}, {}}).empty());
+}
+
+/**
+ * @tc.name: SingleSource
+ * @tc.desc: Test merge with one source
+ * @tc.type: FUNC
+ */
+HWTEST_F(LoserTreeTest, SingleSource, TestSize.Level1)
+{
+    std::vector<uint64_t> source = {1, 2, 2, 5, 9};
+    EXPECT_EQ(Merge({source}), source);
+}
+
+/**
+ * @tc.name: MergeSorted
+ * @tc.desc: Test merge result is sorted for different source count
+ * @tc.type: FUNC
+ */
+HWTEST_F(LoserTreeTest, MergeSorted, TestSize.Level1)
+{
+    const size_t maxSources = 9;
+    for (size_t count = 2; count <= maxSources; count++) {
+        std::vector<std::vector<uint64_t>> sources(count);
+        std::vector<uint64_t> expect;
+        for (size_t i = 0; i < count; i++) {
+            // the last source is empty
+            for (uint64_t value = i; i + 1 < count && value < 100; value += count - i) {
+                sources[i].push_back(value);
+                expect.push_back(value);
+            }
+        }
+        std::sort(expect.begin(), expect.end());
+        EXPECT_EQ(Merge(sources), expect) << "source count " << count;
+    }
+}
+
+/**
+ * @tc.name: RunnerUp
+ * @tc.desc: Test runner up is the next winner
+ * @tc.type: FUNC
+ */
+HWTEST_F(LoserTreeTest, RunnerUp, TestSize.Level1)
+{
+    std::vector<uint64_t> keys = {7, 3, 9, 5, 4};
+    auto less = [&keys](const size_t left, const size_t right) { return keys[left] < keys[right]; };
+    LoserTree<decltype(less)> tree(less);
+    tree.Build(keys.size());
+    EXPECT_EQ(tree.Top(), 1u);
+    EXPECT_EQ(tree.RunnerUp(1), 4u);
+    tree.Exhaust(1);
+    EXPECT_EQ(tree.Top(), 4u);
+    EXPECT_EQ(tree.RunnerUp(4), 3u);
+    keys[4] = 10;
+    tree.Replay(4);
+    EXPECT_EQ(tree.Top(), 3u);
+    EXPECT_EQ(tree.RunnerUp(3), 0u);
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "parallel_report_aggregator_test.h"
+
+#include <string>
+
+using namespace testing::ext;
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+class ParallelReportAggregatorTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+    void SetUp();
+    void TearDown();
+
+    static void InitConfig(Report &report);
+    // the frames of the sample are kept in PerfRecordSample::callFrames_
+    static PerfRecordSample MakeSample(const size_t index);
+};
+
+void ParallelReportAggregatorTest::SetUpTestCase() {}
+
+void ParallelReportAggregatorTest::TearDownTestCase() {}
+
+void ParallelReportAggregatorTest::SetUp() {}
+
+void ParallelReportAggregatorTest::TearDown()
+{
+    PerfRecordSample::callFrames_.clear();
+}
+
+void ParallelReportAggregatorTest::InitConfig(Report &report)
+{
+    report.configs_.emplace_back("dummy", 0, 0);
+    report.configIdIndexMaps_.emplace(0u, 0u); // id 0 as config 0
+}
+
+PerfRecordSample ParallelReportAggregatorTest::MakeSample(const size_t index)
+{
+    constexpr size_t pidCount = 13;
+    constexpr size_t funcCount = 7;
+    const u32 pid = static_cast<u32>(index % pidCount + 1);
+    PerfRecordSample sample(false, pid, pid, index % 3 + 1);
+    PerfRecordSample::callFrames_.clear();
+    // callee first
+    PerfRecordSample::callFrames_.emplace_back(0x1, 0x100, "libtest.so",
+                                               "func" + std::to_string(index % funcCount));
+    PerfRecordSample::callFrames_.emplace_back(0x2, 0x200, "libtest.so",
+                                               "caller" + std::to_string(index % 2));
+    PerfRecordSample::callFrames_.emplace_back(0x3, 0x300, "bin", "main");
+    return sample;
+}
+
+/**
+ * @tc.name: SameAsSerial
+ * @tc.desc: the items and callstacks are same as the ones added by one thread
+ * @tc.type: FUNC
+ */
+HWTEST_F(ParallelReportAggregatorTest, SameAsSerial, TestSize.Level1)
+{
+    constexpr size_t sampleCount = 5000;
+    for (bool includeCallStack : {false, true}) {
+        Report serial;
+        InitConfig(serial);
+        Report parallel;
+        InitConfig(parallel);
+        ParallelReportAggregator aggregator(parallel, 4, includeCallStack);
+        ASSERT_TRUE(aggregator.Start());
+        for (size_t i = 0; i < sampleCount; i++) {
+            PerfRecordSample sample = MakeSample(i);
+            serial.AddReportItem(sample, includeCallStack, "comm");
+            aggregator.AddSample(sample, "comm");
+            EXPECT_TRUE(PerfRecordSample::callFrames_.empty());
+        }
+        ASSERT_TRUE(aggregator.Finish());
+        serial.AdjustReportItems();
+        parallel.AdjustReportItems();
+
+        const auto &serialConfig = serial.configs_[0];
+        const auto &parallelConfig = parallel.configs_[0];
+        EXPECT_EQ(parallelConfig.sampleCount_, sampleCount);
+        EXPECT_EQ(parallelConfig.eventCount_, serialConfig.eventCount_);
+        ASSERT_EQ(parallelConfig.reportItems_.size(), serialConfig.reportItems_.size());
+        for (size_t i = 0; i < serialConfig.reportItems_.size(); i++) {
+            const ReportItem &a = serialConfig.reportItems_[i];
+            const ReportItem &b = parallelConfig.reportItems_[i];
+            EXPECT_EQ(a.pid_, b.pid_);
+            EXPECT_EQ(a.func_, b.func_);
+            EXPECT_EQ(a.comm_, b.comm_);
+            EXPECT_EQ(a.eventCount_, b.eventCount_);
+            ASSERT_EQ(a.callStacks_.size(), b.callStacks_.size());
+            for (size_t j = 0; j < a.callStacks_.size(); j++) {
+                EXPECT_EQ(a.callStacks_[j].func_, b.callStacks_[j].func_);
+                EXPECT_EQ(a.callStacks_[j].eventCount_, b.callStacks_[j].eventCount_);
+                EXPECT_EQ(a.callStacks_[j].childs.size(), b.callStacks_[j].childs.size());
+            }
+        }
+    }
+}
+
+/**
+ * @tc.name: SampleWithoutFrames
+ * @tc.desc: samples without frames are only counted
+ * @tc.type: FUNC
+ */
+HWTEST_F(ParallelReportAggregatorTest, SampleWithoutFrames, TestSize.Level1)
+{
+    Report report;
+    InitConfig(report);
+    ParallelReportAggregator aggregator(report, 2, false);
+    ASSERT_TRUE(aggregator.Start());
+    PerfRecordSample sample(false, 1, 1, 10);
+    PerfRecordSample::callFrames_.clear();
+    aggregator.AddSample(sample, "comm");
+    ASSERT_TRUE(aggregator.Finish());
+    EXPECT_EQ(report.configs_[0].sampleCount_, 1u);
+    EXPECT_EQ(report.configs_[0].eventCount_, 10u);
+    EXPECT_TRUE(report.configs_[0].reportItems_.empty());
+}
+
+/**
+ * @tc.name: StartWithoutConfig
+ * @tc.desc: no config, no shard is started
+ * @tc.type: FUNC
+ */
+HWTEST_F(ParallelReportAggregatorTest, StartWithoutConfig, TestSize.Level1)
+{
+    Report report;
+    ParallelReportAggregator aggregator(report, 0, false);
+    EXPECT_EQ(aggregator.GetThreadCount(), 1u);
+    EXPECT_FALSE(aggregator.Start());
+    EXPECT_FALSE(aggregator.Finish());
+
+    ParallelReportAggregator manyThreads(report, ParallelReportAggregator::MAX_THREAD_COUNT + 1, false);
+    EXPECT_EQ(manyThreads.GetThreadCount(), ParallelReportAggregator::MAX_THREAD_COUNT);
+}
+
+/**
+ * @tc.name: DefaultThreadCount
+ * @tc.desc: the default thread count is limited
+ * @tc.type: FUNC
+ */
+HWTEST_F(ParallelReportAggregatorTest, DefaultThreadCount, TestSize.Level1)
+{
+    size_t threadCount = ParallelReportAggregator::GetDefaultThreadCount();
+    EXPECT_GE(threadCount, 1u);
+    EXPECT_LE(threadCount, ParallelReportAggregator::DEFAULT_THREAD_COUNT);
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "parallel_symbol_resolver_test.h"
+
+#include <thread>
+#include <vector>
+
+using namespace testing::ext;
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+class ParallelSymbolResolverTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+    void SetUp();
+    void TearDown();
+
+    static constexpr size_t REQUEST_COUNT = 64;
+    static constexpr pid_t PID_COUNT = 5;
+    static constexpr uint64_t IP_BASE = 0x1000;
+};
+
+void ParallelSymbolResolverTest::SetUpTestCase() {}
+
+void ParallelSymbolResolverTest::TearDownTestCase() {}
+
+void ParallelSymbolResolverTest::SetUp() {}
+
+void ParallelSymbolResolverTest::TearDown() {}
+
+HWTEST_F(ParallelSymbolResolverTest, ThreadCount, TestSize.Level1)
+{
+    VirtualRuntime runtime(false);
+    EXPECT_EQ(ParallelSymbolResolver(runtime, 0).GetThreadCount(), 1u);
+    EXPECT_EQ(ParallelSymbolResolver(runtime, 2).GetThreadCount(), 2u);
+    EXPECT_EQ(ParallelSymbolResolver(runtime, ParallelSymbolResolver::MAX_THREAD_COUNT * 2).GetThreadCount(),
+              ParallelSymbolResolver::MAX_THREAD_COUNT);
+}
+
+/**
+ * @tc.name: ThreadCountByCpuPercent
+ * @tc.desc: the thread count grows with the cpu percent from two threads, and is limited by the cpu count
+ * @tc.type: FUNC
+ */
+HWTEST_F(ParallelSymbolResolverTest, ThreadCountByCpuPercent, TestSize.Level1)
+{
+    constexpr int halfPercent = 50;
+    constexpr int fullPercent = 100;
+    size_t cpuCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    EXPECT_EQ(ParallelSymbolResolver::GetThreadCountByCpuPercent(0), ParallelSymbolResolver::MIN_THREAD_COUNT);
+    EXPECT_LE(ParallelSymbolResolver::GetThreadCountByCpuPercent(halfPercent),
+              ParallelSymbolResolver::GetThreadCountByCpuPercent(fullPercent));
+    EXPECT_EQ(ParallelSymbolResolver::GetThreadCountByCpuPercent(fullPercent),
+              std::clamp(cpuCount, ParallelSymbolResolver::MIN_THREAD_COUNT, ParallelSymbolResolver::MAX_THREAD_COUNT));
+    EXPECT_EQ(ParallelSymbolResolver::GetThreadCountByCpuPercent(fullPercent * 2),
+              ParallelSymbolResolver::GetThreadCountByCpuPercent(fullPercent));
+}
+
+/**
+ * @tc.name: Resolve
+ * @tc.desc: the addresses of every context are resolved, the unknown ones are resolved too
+ * @tc.type: FUNC
+ */
+HWTEST_F(ParallelSymbolResolverTest, Resolve, TestSize.Level1)
+{
+    VirtualRuntime runtime(false);
+    ParallelSymbolResolver resolver(runtime, ParallelSymbolResolver::MAX_THREAD_COUNT);
+    std::vector<ParallelSymbolResolver::Request> requests;
+    for (size_t i = 0; i < REQUEST_COUNT; i++) {
+        pid_t pid = static_cast<pid_t>(i % PID_COUNT) + 1;
+        requests.push_back({pid, IP_BASE + i, PERF_CONTEXT_USER});
+        requests.push_back({0, IP_BASE + i, PERF_CONTEXT_KERNEL});
+    }
+    resolver.Resolve(requests);
+    for (pid_t pid = 1; pid <= PID_COUNT; pid++) {
+        EXPECT_EQ(runtime.GetThreads().count(pid), 1u);
+    }
+    // still usable after the threads are done
+    EXPECT_EQ(runtime.GetSymbol(IP_BASE, 1, 1, PERF_CONTEXT_USER).fileVaddr_, IP_BASE);
+}
+
+HWTEST_F(ParallelSymbolResolverTest, ResolveEmpty, TestSize.Level2)
+{
+    VirtualRuntime runtime(false);
+    ParallelSymbolResolver resolver(runtime, ParallelSymbolResolver::MAX_THREAD_COUNT);
+    std::vector<ParallelSymbolResolver::Request> requests;
+    resolver.Resolve(requests);
+    EXPECT_TRUE(requests.empty());
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
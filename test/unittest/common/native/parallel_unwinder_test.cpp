@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "parallel_unwinder_test.h"
+
+#include <memory>
+#include <vector>
+
+using namespace testing::ext;
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+class ParallelUnwinderTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+    void SetUp();
+    void TearDown();
+
+    static constexpr size_t SAMPLE_COUNT = 64;
+    static constexpr pid_t PID_COUNT = 5;
+    static constexpr u64 IP_BASE = 0x1000;
+};
+
+void ParallelUnwinderTest::SetUpTestCase() {}
+
+void ParallelUnwinderTest::TearDownTestCase() {}
+
+void ParallelUnwinderTest::SetUp() {}
+
+void ParallelUnwinderTest::TearDown() {}
+
+HWTEST_F(ParallelUnwinderTest, ThreadCount, TestSize.Level1)
+{
+    VirtualRuntime runtime(false);
+    EXPECT_EQ(ParallelUnwinder(runtime, 0).GetThreadCount(), 1u);
+    EXPECT_EQ(ParallelUnwinder(runtime, 2).GetThreadCount(), 2u);
+    EXPECT_EQ(ParallelUnwinder(runtime, ParallelUnwinder::MAX_THREAD_COUNT * 2).GetThreadCount(),
+              ParallelUnwinder::MAX_THREAD_COUNT);
+}
+
+/**
+ * @tc.name: Unwind
+ * @tc.desc: every sample is finished after unwinding, the samples without user stack are kept
+ * @tc.type: FUNC
+ */
+HWTEST_F(ParallelUnwinderTest, Unwind, TestSize.Level1)
+{
+    VirtualRuntime runtime(false);
+    ParallelUnwinder unwinder(runtime, ParallelUnwinder::MAX_THREAD_COUNT);
+    std::vector<std::unique_ptr<PerfRecordSample>> records;
+    std::vector<u64> ips(SAMPLE_COUNT);
+    std::vector<PerfRecordSample *> samples;
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        auto &sample = records.emplace_back(std::make_unique<PerfRecordSample>());
+        sample->data_.pid = static_cast<u32>(i % PID_COUNT) + 1;
+        sample->data_.tid = sample->data_.pid;
+        ips[i] = IP_BASE + i;
+        sample->data_.nr = 1;
+        sample->data_.ips = &ips[i];
+        samples.emplace_back(sample.get());
+    }
+    unwinder.Unwind(samples);
+    // not in record mode, the samples are symbolized after unwinding
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        ASSERT_EQ(samples[i]->callFrames_.size(), 1u);
+        EXPECT_EQ(samples[i]->callFrames_[0].pc, IP_BASE + i);
+        EXPECT_EQ(samples[i]->data_.stack_size, 0u);
+    }
+}
+
+HWTEST_F(ParallelUnwinderTest, UnwindEmpty, TestSize.Level2)
+{
+    VirtualRuntime runtime(false);
+    ParallelUnwinder unwinder(runtime, ParallelUnwinder::MAX_THREAD_COUNT);
+    std::vector<PerfRecordSample *> samples;
+    unwinder.Unwind(samples);
+    EXPECT_TRUE(samples.empty());
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
@@ -246,6 +246,152 @@ HWTEST_F(PerfEventsTest, RecordNormal, TestSize.Level1)
     std::string stringOut = stdoutRecord.Stop();
 }
 
+HWTEST_F(PerfEventsTest, RecordWithMmapReaders, TestSize.Level1)
+{
+    ScopeDebugLevel tempLogLevel(LEVEL_DEBUG);
+    StdoutRecord stdoutRecord;
+    stdoutRecord.Start();
+
+    PerfEvents event;
+    // prepare
+    gRecordCount = 0;
+    event.SetMmapPages(DEFAULT_SAMPLE_MMAPAGE);
+    event.SetMmapReaders(2); // 2: split cpus into two groups
+    event.SetRecordCallBack(RecordCount);
+
+    std::vector<pid_t> selectCpus_;
+    event.SetCpu(selectCpus_);
+    std::vector<pid_t> pids;
+    event.SetPid(pids);
+    const unsigned int frequency = 1000;
+    event.SetSampleFrequency(frequency);
+    event.SetSystemTarget(true);
+    event.SetTimeOut(DEFAULT_TRACKING_TIME);
+    event.SetInherit(false);
+    event.AddDefaultEvent(PERF_TYPE_SOFTWARE);
+
+    ASSERT_EQ(event.PrepareTracking(), true);
+    std::thread runThread(RunTrack, std::ref(event));
+    std::vector<std::thread> testThreads;
+    RunTestThreads(testThreads);
+
+    std::this_thread::sleep_for(TEST_TIME);
+    EXPECT_EQ(event.StopTracking(), true);
+    runThread.join();
+    for (std::thread &t : testThreads) {
+        t.join();
+    }
+    EXPECT_GT(gRecordCount, 0u);
+    EXPECT_TRUE(event.mmapReaders_.empty());
+
+    std::string stringOut = stdoutRecord.Stop();
+}
+
+HWTEST_F(PerfEventsTest, MergeWatermarkOfReaders, TestSize.Level1)
+{
+    PerfEvents event;
+    const uint64_t times[] = {300, 100, 200};
+    for (uint64_t time : times) {
+        auto reader = std::make_unique<PerfEvents::MmapReader>();
+        reader->publishedTime = time;
+        event.mmapReaders_.emplace_back(std::move(reader));
+    }
+    event.readRecordThreadRunning_ = true;
+    EXPECT_EQ(event.GetMergeWatermark(), 100u);
+    event.mmapReaders_[1]->publishedTime = 400; // 400: the idle reader publishes a newer time
+    EXPECT_EQ(event.GetMergeWatermark(), 200u);
+    event.readRecordThreadRunning_ = false;
+    EXPECT_EQ(event.GetMergeWatermark(), std::numeric_limits<uint64_t>::max());
+}
+
+HWTEST_F(PerfEventsTest, RecordDwarfStackInPlace, TestSize.Level1)
+{
+    StdoutRecord stdoutRecord;
+    stdoutRecord.Start();
+
+    PerfEvents event;
+    static uint64_t sampleCount = 0;
+    static uint64_t badSampleCount = 0;
+    sampleCount = 0;
+    badSampleCount = 0;
+    // samples in mmap are used in place, the cut stack must be the same as CutStackAndMove
+    auto checkSample = [](PerfEventRecord& record) -> bool {
+        if (record.GetType() != PERF_RECORD_SAMPLE) {
+            return true;
+        }
+        sampleCount++;
+        PerfRecordSample& sample = static_cast<PerfRecordSample&>(record);
+        std::vector<uint8_t> buf;
+        if (!sample.GetBinary(buf) || buf.size() != sample.GetSize() ||
+            sample.data_.dyn_size > sample.data_.stack_size) {
+            badSampleCount++;
+        }
+        return true;
+    };
+    event.SetMmapPages(DEFAULT_SAMPLE_MMAPAGE);
+    event.SetRecordCallBack(checkSample);
+    event.SetSampleStackType(PerfEvents::SampleStackType::DWARF);
+    event.SetDwarfSampleStackSize(MAX_SAMPLE_STACK_SIZE);
+
+    std::vector<pid_t> selectCpus_;
+    event.SetCpu(selectCpus_);
+    std::vector<pid_t> pids;
+    event.SetPid(pids);
+    const unsigned int frequency = 1000;
+    event.SetSampleFrequency(frequency);
+    event.SetSystemTarget(true);
+    event.SetTimeOut(DEFAULT_TRACKING_TIME);
+    event.AddDefaultEvent(PERF_TYPE_SOFTWARE);
+
+    ASSERT_EQ(event.PrepareTracking(), true);
+    std::thread runThread(RunTrack, std::ref(event));
+    std::vector<std::thread> testThreads;
+    RunTestThreads(testThreads);
+
+    std::this_thread::sleep_for(TEST_TIME);
+    EXPECT_EQ(event.StopTracking(), true);
+    runThread.join();
+    for (std::thread &t : testThreads) {
+        t.join();
+    }
+    EXPECT_TRUE(event.mmapZeroCopy_);
+    EXPECT_GT(sampleCount, 0u);
+    EXPECT_EQ(badSampleCount, 0u);
+
+    std::string stringOut = stdoutRecord.Stop();
+}
+
+HWTEST_F(PerfEventsTest, CreateFdEventsInOrder, TestSize.Level1)
+{
+    StdoutRecord stdoutRecord;
+    stdoutRecord.Start();
+
+    PerfEvents event;
+    std::vector<pid_t> selectCpus;
+    event.SetCpu(selectCpus);
+    std::vector<pid_t> pids;
+    event.SetPid(pids);
+    event.SetSystemTarget(true);
+    ASSERT_EQ(event.AddEvents({"sw-cpu-clock", "sw-task-clock"}, true), true);
+    ASSERT_EQ(event.PrepareTracking(), true);
+
+    // fds are opened in parallel, but kept in cpu order and grouped by the leader of the same cpu
+    const std::vector<PerfEvents::EventItem> &eventItems = event.eventGroupItem_.at(0).eventItems;
+    ASSERT_EQ(eventItems.size(), 2u);
+    const std::vector<PerfEvents::FdItem> &leaders = eventItems[0].fdItems;
+    const std::vector<PerfEvents::FdItem> &members = eventItems[1].fdItems;
+    ASSERT_EQ(leaders.size(), members.size());
+    for (size_t i = 0; i < leaders.size(); i++) {
+        if (i > 0) {
+            EXPECT_LT(leaders[i - 1].cpu, leaders[i].cpu);
+        }
+        EXPECT_EQ(leaders[i].groupFd, leaders[i].fd.Get());
+        EXPECT_EQ(members[i].cpu, leaders[i].cpu);
+        EXPECT_EQ(members[i].groupFd, leaders[i].fd.Get());
+    }
+    std::string stringOut = stdoutRecord.Stop();
+}
+
 HWTEST_F(PerfEventsTest, RecordSetAll, TestSize.Level0)
 {
     ScopeDebugLevel tempLogLevel(LEVEL_DEBUG);
@@ -449,6 +595,67 @@ HWTEST_F(PerfEventsTest, CalcBufferSizeLargeMemory, TestSize.Level1)
     }
 }
 
+HWTEST_F(PerfEventsTest, PlanMmapPages, TestSize.Level1)
+{
+    static constexpr size_t PAGES = 16;
+    PerfEvents event;
+    event.mmapPages_ = PAGES;
+    event.pageSize_ = PAGE_SIZE;
+    for (int cpu = 0; cpu < 3; cpu++) { // 3: one hot cpu and two idle cpus
+        event.cpuMmap_[cpu].mmapPages = PAGES;
+        event.cpuMmap_[cpu].bufSize = PAGES * PAGE_SIZE;
+    }
+    event.cpuMmap_[0].lostInPeriod = 1;
+
+    std::map<int, size_t> plan = event.PlanMmapPages();
+    EXPECT_EQ(plan[0], PAGES * 2);
+    EXPECT_EQ(plan[1], PAGES / 2);
+    EXPECT_EQ(plan[2], PAGES / 2);
+
+    // idle cpus are not shrunk if they can not give enough pages
+    event.cpuMmap_.erase(2);
+    plan = event.PlanMmapPages();
+    EXPECT_EQ(plan[0], PAGES);
+    EXPECT_EQ(plan[1], PAGES);
+
+    // a busy cpu gives nothing
+    event.cpuMmap_[1].peakDataSize = PAGES * PAGE_SIZE / 2;
+    event.cpuMmap_[0].mmapPages = PAGES / 2;
+    event.cpuMmap_[0].bufSize = PAGES / 2 * PAGE_SIZE;
+    plan = event.PlanMmapPages();
+    EXPECT_EQ(plan[0], PAGES);
+    EXPECT_EQ(plan[1], PAGES);
+}
+
+HWTEST_F(PerfEventsTest, CountUnreadRecords, TestSize.Level1)
+{
+    constexpr size_t bufSize = 256;
+    constexpr uint16_t recordSize = 16;
+    perf_event_mmap_page page = {};
+    std::vector<uint8_t> buf(bufSize, 0);
+    PerfEvents::MmapFd mmap;
+    mmap.mmapPage = &page;
+    mmap.buf = buf.data();
+    mmap.bufSize = bufSize;
+    mmap.readPos = recordSize; // the first record has been read
+    const uint32_t types[] = {PERF_RECORD_SAMPLE, PERF_RECORD_SAMPLE, PERF_RECORD_MMAP, PERF_RECORD_SAMPLE};
+    uint64_t pos = 0;
+    for (uint32_t type : types) {
+        perf_event_header header = {type, 0, recordSize};
+        ASSERT_EQ(memcpy_s(buf.data() + pos, sizeof(header), &header, sizeof(header)), 0);
+        pos += recordSize;
+    }
+    page.data_head = pos;
+
+    PerfEvents event;
+    event.CountUnreadRecords(mmap);
+    size_t lostSamples = 0;
+    size_t lostNonSamples = 0;
+    event.GetLostSamples(lostSamples, lostNonSamples);
+    EXPECT_EQ(lostSamples, 2u);
+    EXPECT_EQ(lostNonSamples, 1u);
+}
+
 HWTEST_F(PerfEventsTest, IsSkipRecordForBacktrack1, TestSize.Level1)
 {
     static constexpr size_t BACKTRACK_TIME = 2000u;
@@ -502,7 +709,7 @@ HWTEST_F(PerfEventsTest, IsSkipRecordForBacktrack3, TestSize.Level2)
     sample.data_.time = SAMPLE_TIME * NANO_SECONDS_PER_SECOND;
 
     EXPECT_EQ(event.IsSkipRecordForBacktrack(sample), true);
-    EXPECT_EQ(event.outputTracking_, false);
+    EXPECT_EQ(event.outputTracking_.load(), false);
     EXPECT_EQ(event.outputEndTime_, 0);
 }
 
@@ -525,7 +732,102 @@ HWTEST_F(PerfEventsTest, OutputTracking, TestSize.Level1)
     PerfEvents::currentTimeSecond_.store(TIME);
     EXPECT_EQ(event.OutputTracking(), true);
     EXPECT_EQ(event.outputEndTime_, TIME);
-    EXPECT_EQ(event.outputTracking_, true);
+    EXPECT_EQ(event.outputTracking_.load(), true);
+}
+
+HWTEST_F(PerfEventsTest, OutputTrackingOverwrite, TestSize.Level1)
+{
+    static constexpr int MAX_WAIT_COUNT = 100;
+    StdoutRecord stdoutRecord;
+    stdoutRecord.Start();
+
+    PerfEvents event;
+    gRecordCount = 0;
+    event.SetMmapPages(DEFAULT_SAMPLE_MMAPAGE);
+    event.SetBackTrack(true);
+    event.SetBackTrackTime(10); // 10: keep the last 10 seconds
+    event.SetRecordCallBack(RecordCount);
+
+    std::vector<pid_t> selectCpus_;
+    event.SetCpu(selectCpus_);
+    std::vector<pid_t> pids;
+    event.SetPid(pids);
+    const unsigned int frequency = 1000;
+    event.SetSampleFrequency(frequency);
+    event.SetSystemTarget(true);
+    event.SetTimeOut(DEFAULT_TRACKING_TIME);
+    event.SetInherit(false);
+    event.AddDefaultEvent(PERF_TYPE_SOFTWARE);
+
+    ASSERT_EQ(event.PrepareTracking(), true);
+    std::thread runThread(RunTrack, std::ref(event));
+    std::vector<std::thread> testThreads;
+    RunTestThreads(testThreads);
+
+    std::this_thread::sleep_for(TEST_TIME);
+    // records are kept in the kernel until output
+    EXPECT_EQ(gRecordCount, 0u);
+    EXPECT_EQ(event.OutputTracking(), true);
+    int waitCount = 0;
+    while (event.IsOutputTracking() && waitCount++ < MAX_WAIT_COUNT) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10)); // 10: wait the consumer thread
+    }
+    EXPECT_GT(gRecordCount, 0u);
+
+    EXPECT_EQ(event.StopTracking(), true);
+    runThread.join();
+    for (std::thread &t : testThreads) {
+        t.join();
+    }
+    std::string stringOut = stdoutRecord.Stop();
+}
+
+HWTEST_F(PerfEventsTest, OverwriteBacktrackAttr, TestSize.Level1)
+{
+    PerfEvents event;
+    event.SetMmapPages(DEFAULT_SAMPLE_MMAPAGE);
+    event.SetBackTrack(true);
+    ASSERT_TRUE(event.AddDefaultEvent(PERF_TYPE_SOFTWARE));
+    const perf_event_attr *attr = event.GetDefaultAttr();
+    ASSERT_NE(attr, nullptr);
+    EXPECT_EQ(attr->write_backward, 1u);
+    // nothing is read at wakeup, only wake up once per whole mmap
+    EXPECT_EQ(attr->wakeup_watermark, DEFAULT_SAMPLE_MMAPAGE * event.pageSize_);
+}
+
+HWTEST_F(PerfEventsTest, CollectBackwardRecordsSinceLastSnapshot, TestSize.Level1)
+{
+    constexpr size_t bufSize = 256;
+    constexpr uint16_t recordSize = 16;
+    perf_event_mmap_page page = {};
+    std::vector<uint8_t> buf(bufSize, 0);
+    PerfEvents::MmapFd mmap;
+    mmap.mmapPage = &page;
+    mmap.buf = buf.data();
+    mmap.bufSize = bufSize;
+    auto writeRecord = [&buf](uint64_t pos) {
+        perf_event_header header = {PERF_RECORD_SAMPLE, 0, recordSize};
+        ASSERT_EQ(memcpy_s(buf.data() + pos % bufSize, sizeof(header), &header, sizeof(header)), 0);
+    };
+    // the kernel writes backward from 0
+    writeRecord(-recordSize);
+    writeRecord(-2 * recordSize);
+    page.data_head = -2 * recordSize;
+
+    PerfEvents event;
+    std::vector<uint64_t> positions;
+    event.CollectBackwardRecords(mmap, positions);
+    ASSERT_EQ(positions.size(), 2u);
+    EXPECT_EQ(positions[0], static_cast<uint64_t>(-recordSize)); // oldest first
+    EXPECT_EQ(positions[1], static_cast<uint64_t>(-2 * recordSize));
+
+    // only the record written since the last snapshot
+    writeRecord(-3 * recordSize);
+    page.data_head = -3 * recordSize;
+    positions.clear();
+    event.CollectBackwardRecords(mmap, positions);
+    ASSERT_EQ(positions.size(), 1u);
+    EXPECT_EQ(positions[0], static_cast<uint64_t>(-3 * recordSize));
 }
 
 HWTEST_F(PerfEventsTest, SetConfig, TestSize.Level1)
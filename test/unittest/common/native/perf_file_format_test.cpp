@@ -207,6 +207,46 @@ HWTEST_F(PerfFileFormatTest, PerfFileSectionU64, TestSize.Level1)
     ASSERT_EQ(withBuff.featureId_, FEATURE::RESERVED);
 }
 
+HWTEST_F(PerfFileFormatTest, PerfFileSectionRecordIndex, TestSize.Level1)
+{
+    std::vector<RecordIndexEntry> entries(TESTNUMBER2);
+    entries[0].size = BIGK;
+    entries[0].AddSample(TESTNUMBER3, TESTNUMBER1);
+    entries[0].AddSample(TESTNUMBER1, TESTNUMBER2);
+    entries[0].AddSample(TESTNUMBER2, TESTNUMBER1);
+    entries[0].flags |= RecordIndexEntry::FLAG_SIDEBAND;
+    entries[1].offset = BIGK;
+    entries[1].size = BIGK;
+    for (size_t pid = 0; pid <= RecordIndexEntry::MAX_PIDS; pid++) {
+        entries[1].AddSample(BIGK + pid, static_cast<pid_t>(pid));
+    }
+
+    PerfFileSectionRecordIndex section(FEATURE::HIPERF_RECORD_INDEX, entries);
+    std::vector<char> buff(section.GetSize());
+    ASSERT_TRUE(section.GetBinary(buff.data(), buff.size()));
+    PerfFileSectionRecordIndex withBuff(FEATURE::HIPERF_RECORD_INDEX, buff.data(), buff.size());
+    ASSERT_EQ(withBuff.entries_.size(), entries.size());
+    const RecordIndexEntry &first = withBuff.entries_[0];
+    EXPECT_EQ(first.size, static_cast<uint64_t>(BIGK));
+    EXPECT_EQ(first.minTime, static_cast<uint64_t>(TESTNUMBER1));
+    EXPECT_EQ(first.maxTime, static_cast<uint64_t>(TESTNUMBER3));
+    EXPECT_EQ(first.flags, RecordIndexEntry::FLAG_SIDEBAND);
+    EXPECT_EQ(first.pids, std::vector<pid_t>({static_cast<pid_t>(TESTNUMBER1), static_cast<pid_t>(TESTNUMBER2)}));
+    EXPECT_TRUE(first.MatchSample(0, TESTNUMBER1, TESTNUMBER2));
+    EXPECT_FALSE(first.MatchSample(0, TESTNUMBER1, TESTNUMBER3));
+    EXPECT_FALSE(first.MatchSample(TESTNUMBER3 + 1, BIGK, -1));
+    // too many pids to be listed
+    const RecordIndexEntry &second = withBuff.entries_[1];
+    EXPECT_EQ(second.offset, static_cast<uint64_t>(BIGK));
+    EXPECT_NE(second.flags & RecordIndexEntry::FLAG_ALL_PIDS, 0u);
+    EXPECT_TRUE(second.pids.empty());
+    EXPECT_TRUE(second.MatchSample(BIGK, BIGK, BIGK));
+
+    // truncated
+    PerfFileSectionRecordIndex truncated(FEATURE::HIPERF_RECORD_INDEX, buff.data(), buff.size() - 1);
+    EXPECT_TRUE(truncated.entries_.empty());
+}
+
 void PerfFileFormatTest::TestEventDescInit(std::vector<AttrWithId> &eventDesc, size_t &size)
 {
     size = sizeof(uint32_t) + sizeof(uint32_t); // nr + attr_size
@@ -13,9 +13,12 @@
  * limitations under the License.
  */
 
+#include <atomic>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <unistd.h>
 
 #include "perf_file_reader.h"
 #include "perf_file_reader_test.h"
@@ -25,6 +28,7 @@ namespace OHOS {
 namespace Developtools {
 namespace HiPerf {
 using ProcessRecordCB = const std::function<bool(PerfEventRecord& record)>;
+constexpr size_t TEST_DECODE_THREADS = 4;
 class PerfFileReaderTest : public testing::Test {
 public:
     static void SetUpTestCase(void);
@@ -226,6 +230,119 @@ HWTEST_F(PerfFileReaderTest, ReadDataSection_RealPerfData, TestSize.Level0)
     EXPECT_GT(recordCount, 0);
 }
 
+/**
+ * @tc.name: MapDataSection_RealPerfData
+ * @tc.desc: Test the mapped data section is the same as the data in file
+ * @tc.type: FUNC
+ */
+HWTEST_F(PerfFileReaderTest, MapDataSection_RealPerfData, TestSize.Level1)
+{
+    const std::string fileName = "/data/test/resource/testdata/perf.data";
+    if (access(fileName.c_str(), R_OK) != 0) {
+        printf("perf.data not exist.\n");
+        return;
+    }
+    auto reader = PerfFileReader::Instance(fileName);
+    ASSERT_NE(reader, nullptr);
+    const perf_file_header &header = reader->GetHeader();
+    ASSERT_GT(header.data.size, sizeof(perf_event_header));
+    std::vector<char> buf(sizeof(perf_event_header));
+    ASSERT_TRUE(reader->Read(buf.data(), header.data.offset, buf.size()));
+
+    ASSERT_TRUE(reader->MapDataSection());
+    uint8_t *data = reader->ReadData(nullptr, buf.size());
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(memcmp(data, buf.data(), buf.size()), 0);
+    EXPECT_EQ(reader->ReadData(nullptr, header.data.size), nullptr);
+    reader->UnmapDataSection();
+
+    // the records read from the mapped pages are the same as the ones read by file
+    int recordCount = 0;
+    ProcessRecordCB callback = [&recordCount](PerfEventRecord& record) -> bool {
+        recordCount++;
+        return true;
+    };
+    reader->ReadDataSection(callback);
+    EXPECT_GT(recordCount, 0);
+    EXPECT_EQ(reader->mappedData_, nullptr);
+}
+
+/**
+ * @tc.name: ReadDataSectionParallel_RealPerfData
+ * @tc.desc: Test the records decoded in parallel are the same as the ones read sequentially
+ * @tc.type: FUNC
+ */
+HWTEST_F(PerfFileReaderTest, ReadDataSectionParallel_RealPerfData, TestSize.Level1)
+{
+    const std::string fileName = "/data/test/resource/testdata/perf.data";
+    if (access(fileName.c_str(), R_OK) != 0) {
+        printf("perf.data not exist.\n");
+        return;
+    }
+    auto reader = PerfFileReader::Instance(fileName);
+    ASSERT_NE(reader, nullptr);
+    ASSERT_TRUE(reader->ReadFeatureSection());
+    std::vector<std::pair<uint32_t, size_t>> records;
+    reader->ReadDataSection([&records](PerfEventRecord& record) -> bool {
+        records.emplace_back(record.GetType(), record.GetSize());
+        return true;
+    });
+    ASSERT_FALSE(records.empty());
+
+    size_t index = 0;
+    ASSERT_TRUE(reader->ReadDataSectionParallel([&records, &index](PerfEventRecord& record) -> bool {
+        EXPECT_LT(index, records.size());
+        if (index < records.size()) {
+            EXPECT_EQ(records[index].first, record.GetType());
+            EXPECT_EQ(records[index].second, record.GetSize());
+        }
+        index++;
+        return true;
+    }, TEST_DECODE_THREADS));
+    EXPECT_EQ(index, records.size());
+    EXPECT_EQ(reader->mappedData_, nullptr);
+
+    std::atomic<size_t> recordCount = 0;
+    ASSERT_TRUE(reader->ReadDataSectionParallel([&recordCount](PerfEventRecord& record) -> bool {
+        recordCount++;
+        return true;
+    }, TEST_DECODE_THREADS, false));
+    EXPECT_EQ(recordCount, records.size());
+}
+
+/**
+ * @tc.name: GetAutoDecodeThreads
+ * @tc.desc: Test a small data section is decoded by one thread and a large one by the capped thread count
+ * @tc.type: FUNC
+ */
+HWTEST_F(PerfFileReaderTest, GetAutoDecodeThreads, TestSize.Level1)
+{
+    PerfFileReader reader("", nullptr);
+    reader.header_.data.size = MIN_DECODE_SIZE_PER_THREAD - 1;
+    EXPECT_EQ(reader.GetAutoDecodeThreads(), 1u);
+    reader.header_.data.size = MIN_DECODE_SIZE_PER_THREAD * MAX_DECODE_THREADS * 2;
+    EXPECT_GE(reader.GetAutoDecodeThreads(), 1u);
+    EXPECT_LE(reader.GetAutoDecodeThreads(), MAX_DECODE_THREADS);
+}
+
+/**
+ * @tc.name: MapDataSection_Pipe
+ * @tc.desc: Test the data section of a pipe is not mapped
+ * @tc.type: FUNC
+ */
+HWTEST_F(PerfFileReaderTest, MapDataSection_Pipe, TestSize.Level2)
+{
+    int fds[2] = {-1, -1};
+    ASSERT_EQ(pipe(fds), 0);
+    FILE *fp = fdopen(fds[0], "rb");
+    ASSERT_NE(fp, nullptr);
+    PerfFileReader reader("", fp);
+    reader.header_.data.offset = 0;
+    reader.header_.data.size = sizeof(perf_event_header);
+    EXPECT_FALSE(reader.MapDataSection());
+    close(fds[1]);
+}
+
 /**
  * @tc.name: ReadFeatureSection_RealPerfData
  * @tc.desc: Test ReadFeatureSection with real perf.data covers feature section parsing
@@ -15,6 +15,10 @@
 
 #include "perf_file_writer_test.h"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "perf_file_reader.h"
 #include "virtual_runtime.h"
 
 using namespace testing::ext;
@@ -110,7 +114,7 @@ HWTEST_F(PerfFileWriterTest, TestFileWriter_Compress, TestSize.Level1)
 
     std::vector<AttrWithId> attrIds;
     AttrWithId attrId;
-    perf_event_attr attr;
+    perf_event_attr attr {};
     attrId.attr = attr;
     attrId.ids.emplace_back(0);
     attrIds.emplace_back(attrId);
@@ -130,11 +134,231 @@ HWTEST_F(PerfFileWriterTest, TestFileWriter_Compress, TestSize.Level1)
     }
     ASSERT_EQ(fileWriter.GetDataSize(), dataSize);
     ASSERT_EQ(fileWriter.GetRecordCount(), TESTRECORDCOUNT);
+    // records can be read back before close, like collecting symbols
+    uint readCount = 0;
+    auto countRecord = [&readCount](PerfEventRecord &record) {
+        if (record.GetType() == PERF_RECORD_MMAP) {
+            readCount++;
+        }
+        return true;
+    };
+    ASSERT_TRUE(fileWriter.ReadDataSection(countRecord));
+    EXPECT_EQ(readCount, TESTRECORDCOUNT);
     ASSERT_TRUE(fileWriter.Close());
     // check file
     ASSERT_TRUE((access(filename.c_str(), F_OK) == 0));
-    filename += ".gz";
-    ASSERT_TRUE((access(filename.c_str(), F_OK) != 0));
+    std::string gzName = filename + ".gz";
+    ASSERT_TRUE((access(gzName.c_str(), F_OK) != 0));
+
+    // the data section is compressed in place, the reader decompresses it on the fly
+    auto reader = PerfFileReader::Instance(filename);
+    ASSERT_NE(reader, nullptr);
+    const std::vector<FEATURE> &features = reader->GetFeatures();
+    EXPECT_NE(std::find(features.begin(), features.end(), FEATURE::HIPERF_COMPRESSED_DATA), features.end());
+    EXPECT_LT(reader->GetHeader().data.size, dataSize);
+    readCount = 0;
+    reader->ReadDataSection(countRecord);
+    EXPECT_EQ(readCount, TESTRECORDCOUNT);
+}
+
+HWTEST_F(PerfFileWriterTest, TestFileWriter_AsyncWrite, TestSize.Level1)
+{
+    std::string filename = "./TestFileWriter_AsyncWrite";
+    PerfFileWriter fileWriter;
+    ASSERT_TRUE(fileWriter.Open(filename)) << "current path no write permission?";
+    fileWriter.SetAsyncWrite(true);
+
+    std::vector<AttrWithId> attrIds;
+    AttrWithId attrId;
+    perf_event_attr attr {};
+    attrId.attr = attr;
+    attrId.ids.emplace_back(0);
+    attrIds.emplace_back(attrId);
+    ASSERT_TRUE(fileWriter.WriteAttrAndId(attrIds));
+
+    // mmap records are larger than 64 bytes, more than the buffer pool can hold
+    constexpr size_t minRecordSize = 64;
+    const uint recordCount =
+        AsyncFileWriter::DEFAULT_BUFFER_SIZE * AsyncFileWriter::DEFAULT_BUFFER_COUNT / minRecordSize;
+    for (uint i = 0; i < recordCount; i++) {
+        PerfRecordMmap recordmmap(true, i, i, i, i, i, "testAsyncWrite " + std::to_string(i));
+        ASSERT_TRUE(fileWriter.WriteRecord(recordmmap));
+    }
+    uint readCount = 0;
+    auto countRecord = [&readCount](PerfEventRecord &record) {
+        if (record.GetType() == PERF_RECORD_MMAP) {
+            readCount++;
+        }
+        return true;
+    };
+    ASSERT_TRUE(fileWriter.ReadDataSection(countRecord));
+    EXPECT_EQ(readCount, recordCount);
+    ASSERT_TRUE(fileWriter.Close());
+    EXPECT_EQ(fileWriter.GetWriteStat().writtenBytes, fileWriter.GetDataSize());
+
+    auto reader = PerfFileReader::Instance(filename);
+    ASSERT_NE(reader, nullptr);
+    EXPECT_EQ(reader->GetHeader().data.size, fileWriter.GetDataSize());
+    readCount = 0;
+    reader->ReadDataSection(countRecord);
+    EXPECT_EQ(readCount, recordCount);
+}
+
+HWTEST_F(PerfFileWriterTest, TestFileWriter_RecordIndex, TestSize.Level1)
+{
+    std::string filename = "./TestFileWriter_RecordIndex";
+    PerfFileWriter fileWriter;
+    ASSERT_TRUE(fileWriter.Open(filename)) << "current path no write permission?";
+
+    std::vector<AttrWithId> attrIds;
+    AttrWithId attrId;
+    perf_event_attr attr {};
+    attr.sample_type = PERF_SAMPLE_TID | PERF_SAMPLE_TIME;
+    attrId.attr = attr;
+    attrId.ids.emplace_back(0);
+    attrIds.emplace_back(attrId);
+    ASSERT_TRUE(fileWriter.WriteAttrAndId(attrIds));
+
+    struct {
+        perf_event_header header;
+        uint32_t pid;
+        uint32_t tid;
+        uint64_t time;
+    } sampleData = {{PERF_RECORD_SAMPLE, PERF_RECORD_MISC_USER, sizeof(sampleData)}, 0, 0, 0};
+    // several index blocks, a mmap record in each of them
+    constexpr uint32_t pidCount = 4;
+    constexpr uint64_t mmapInterval = 1000;
+    const uint64_t sampleCount = RECORD_INDEX_BLOCK_SIZE * 4 / sizeof(sampleData);
+    for (uint64_t i = 0; i < sampleCount; i++) {
+        if (i % mmapInterval == 0) {
+            PerfRecordMmap recordmmap(true, 1, 1, i, i, i, "testRecordIndex");
+            ASSERT_TRUE(fileWriter.WriteRecord(recordmmap));
+        }
+        sampleData.pid = i % pidCount;
+        sampleData.tid = sampleData.pid;
+        sampleData.time = i;
+        PerfRecordSample sample;
+        sample.Init(reinterpret_cast<uint8_t *>(&sampleData), attr);
+        ASSERT_TRUE(fileWriter.WriteRecord(sample));
+    }
+    ASSERT_TRUE(fileWriter.Close());
+
+    auto reader = PerfFileReader::Instance(filename);
+    ASSERT_NE(reader, nullptr);
+    ASSERT_TRUE(reader->ReadFeatureSection());
+    const PerfFileSectionRecordIndex *index = static_cast<const PerfFileSectionRecordIndex *>(
+        reader->GetFeatureSection(FEATURE::HIPERF_RECORD_INDEX));
+    ASSERT_NE(index, nullptr);
+    ASSERT_GT(index->entries_.size(), 1u);
+    EXPECT_EQ(index->entries_.back().offset + index->entries_.back().size, reader->GetHeader().data.size);
+
+    const uint64_t startTime = sampleCount / 2;
+    const uint64_t endTime = startTime + mmapInterval;
+    const pid_t pid = 1;
+    uint64_t sampleNumber = 0;
+    uint64_t mmapNumber = 0;
+    auto countRecord = [&](PerfEventRecord &record) {
+        if (record.GetType() == PERF_RECORD_MMAP) {
+            mmapNumber++;
+        } else if (record.GetType() == PERF_RECORD_SAMPLE) {
+            const uint64_t time = static_cast<PerfRecordSample &>(record).GetTime();
+            EXPECT_TRUE(time >= startTime && time <= endTime);
+            EXPECT_EQ(record.GetPid(), pid);
+            sampleNumber++;
+        }
+        return true;
+    };
+    ASSERT_TRUE(reader->ReadDataSectionInRange(countRecord, startTime, endTime, pid));
+    EXPECT_EQ(sampleNumber, (endTime - startTime + 1) / pidCount);
+    // the mmap records before the time range are needed, the ones in the blocks after it are not
+    EXPECT_GT(mmapNumber, startTime / mmapInterval);
+    EXPECT_LT(mmapNumber, sampleCount / mmapInterval);
+}
+
+HWTEST_F(PerfFileWriterTest, TestFileWriter_Rename, TestSize.Level1)
+{
+    std::string filename = "./TestFileWriter_Rename";
+    std::string newName = filename + ".1";
+    PerfFileWriter fileWriter;
+    ASSERT_TRUE(fileWriter.Open(filename)) << "current path no write permission?";
+    std::vector<AttrWithId> attrIds;
+    TestEventDescInit(attrIds);
+    ASSERT_TRUE(fileWriter.WriteAttrAndId(attrIds));
+    ASSERT_TRUE(fileWriter.Rename(newName));
+    // the records go on to the renamed file
+    for (uint i = 0; i < TESTRECORDCOUNT; i++) {
+        PerfRecordMmap recordmmap(true, i, i, i, i, i, "testRename");
+        ASSERT_TRUE(fileWriter.WriteRecord(recordmmap));
+    }
+    ASSERT_TRUE(fileWriter.Close());
+    EXPECT_NE(access(filename.c_str(), F_OK), 0);
+
+    auto reader = PerfFileReader::Instance(newName);
+    ASSERT_NE(reader, nullptr);
+    uint recordCount = 0;
+    ASSERT_TRUE(reader->ReadDataSection([&recordCount](PerfEventRecord &record) {
+        recordCount++;
+        return true;
+    }));
+    EXPECT_EQ(recordCount, TESTRECORDCOUNT);
+}
+
+HWTEST_F(PerfFileWriterTest, TestFileWriter_Stream, TestSize.Level1)
+{
+    std::string filename = "./TestFileWriter_Stream";
+    int fd = open(filename.c_str(), O_CREAT | O_TRUNC | O_WRONLY, S_IRUSR | S_IWUSR);
+    ASSERT_GE(fd, 0) << "current path no write permission?";
+    std::string streamName = PIPE_OUTPUT_FD_PREFIX + std::to_string(fd);
+    EXPECT_TRUE(PerfFileWriter::IsStreamOutput(streamName));
+    EXPECT_FALSE(PerfFileWriter::IsStreamOutput(filename));
+    {
+        PerfFileWriter fileWriter;
+        // the stream can not be compressed
+        EXPECT_FALSE(fileWriter.Open(streamName, true));
+    }
+    PerfFileWriter fileWriter;
+    ASSERT_TRUE(fileWriter.Open(streamName));
+    close(fd);
+    EXPECT_TRUE(fileWriter.IsStream());
+
+    std::vector<AttrWithId> attrIds;
+    TestEventDescInit(attrIds);
+    ASSERT_TRUE(fileWriter.WriteAttrAndId(attrIds));
+    // added before the records, it is written ahead of them
+    ASSERT_TRUE(fileWriter.AddStringFeature(FEATURE::OSRELEASE, "testRelease"));
+    for (uint i = 0; i < TESTRECORDCOUNT; i++) {
+        PerfRecordMmap recordmmap(true, i, i, i, i, i, "testStream");
+        ASSERT_TRUE(fileWriter.WriteRecord(recordmmap));
+    }
+    ASSERT_TRUE(fileWriter.AddStringFeature(FEATURE::HOSTNAME, "testHost"));
+    // larger than one feature record, it is split in the stream
+    const std::string cmdline(RECORD_SIZE_LIMIT * TESTNUMBER2, 'c');
+    ASSERT_TRUE(fileWriter.AddStringFeature(FEATURE::CMDLINE, cmdline));
+    ASSERT_FALSE(fileWriter.ReadDataSection([](PerfEventRecord &) { return true; }));
+    ASSERT_TRUE(fileWriter.Close());
+    // the stream is owned by the consumer, it is not removed
+    ASSERT_EQ(access(filename.c_str(), F_OK), 0);
+
+    auto reader = PerfFileReader::Instance(filename);
+    ASSERT_NE(reader, nullptr);
+    ASSERT_EQ(reader->GetAttrSection().size(), attrIds.size());
+    EXPECT_EQ(reader->GetFeatureString(FEATURE::OSRELEASE), "testRelease");
+    EXPECT_EQ(reader->GetFeatureSection(FEATURE::HOSTNAME), nullptr);
+    uint recordCount = 0;
+    ASSERT_TRUE(reader->ReadDataSection([&recordCount](PerfEventRecord &record) {
+        EXPECT_EQ(record.GetType(), PERF_RECORD_MMAP);
+        recordCount++;
+        return true;
+    }));
+    EXPECT_EQ(recordCount, TESTRECORDCOUNT);
+    // the features added after the records follow the data in the stream
+    ASSERT_TRUE(reader->ReadFeatureSection());
+    const PerfFileSectionString *host =
+        static_cast<const PerfFileSectionString *>(reader->GetFeatureSection(FEATURE::HOSTNAME));
+    ASSERT_NE(host, nullptr);
+    EXPECT_EQ(host->ToString(), "testHost");
+    EXPECT_EQ(reader->GetFeatureString(FEATURE::CMDLINE), cmdline);
+    EXPECT_EQ(reader->GetFeatureString(FEATURE::OSRELEASE), "testRelease");
 }
 
 HWTEST_F(PerfFileWriterTest, TestFileWriter_AuxTraceInfo, TestSize.Level2)
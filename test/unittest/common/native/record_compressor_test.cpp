@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "record_compressor_test.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "perf_event_record.h"
+
+using namespace testing::ext;
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+class RecordCompressorTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+    void SetUp();
+    void TearDown();
+
+    // compress data into file_ with len bytes each write
+    bool Compress(const std::vector<uint8_t> &data, const size_t len, const int level = DEFAULT_COMPRESS_LEVEL);
+    // decompress file_ with len bytes each read until the stream ends
+    bool Decompress(std::vector<uint8_t> &data, const size_t len);
+
+    std::vector<uint8_t> file_;
+    size_t readPos_ = 0;
+};
+
+void RecordCompressorTest::SetUpTestCase() {}
+
+void RecordCompressorTest::TearDownTestCase() {}
+
+void RecordCompressorTest::SetUp()
+{
+    file_.clear();
+    readPos_ = 0;
+}
+
+void RecordCompressorTest::TearDown() {}
+
+bool RecordCompressorTest::Compress(const std::vector<uint8_t> &data, const size_t len, const int level)
+{
+    RecordCompressor compressor(
+        [this](const void *buf, size_t size) {
+            const uint8_t *bytes = static_cast<const uint8_t *>(buf);
+            file_.insert(file_.end(), bytes, bytes + size);
+            return true;
+        }, level);
+    if (!compressor.Start()) {
+        return false;
+    }
+    for (size_t pos = 0; pos < data.size(); pos += len) {
+        if (!compressor.Write(data.data() + pos, std::min(len, data.size() - pos))) {
+            return false;
+        }
+    }
+    if (!compressor.Finish()) {
+        return false;
+    }
+    return compressor.GetCompressedSize() == file_.size();
+}
+
+bool RecordCompressorTest::Decompress(std::vector<uint8_t> &data, const size_t len)
+{
+    RecordDecompressor decompressor(
+        [this](void *buf, size_t size) {
+            if (readPos_ + size > file_.size()) {
+                return false;
+            }
+            std::copy(file_.begin() + readPos_, file_.begin() + readPos_ + size, static_cast<uint8_t *>(buf));
+            readPos_ += size;
+            return true;
+        }, file_.size());
+    std::vector<uint8_t> buf(len);
+    while (!decompressor.IsEnd()) {
+        if (!decompressor.Read(buf.data(), buf.size())) {
+            return false;
+        }
+        data.insert(data.end(), buf.begin(), buf.end());
+    }
+    return true;
+}
+
+/**
+ * @tc.name: RoundTrip
+ * @tc.desc: data written in small pieces is read back the same across many compressed records
+ * @tc.type: FUNC
+ */
+HWTEST_F(RecordCompressorTest, RoundTrip, TestSize.Level1)
+{
+    constexpr size_t recordSize = 64;
+    constexpr size_t recordCount = 3 * RecordCompressor::BUFFER_SIZE / recordSize;
+    std::vector<uint8_t> data(recordSize * recordCount);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>((i * i) >> 3);
+    }
+    ASSERT_TRUE(Compress(data, recordSize));
+    EXPECT_LT(file_.size(), data.size());
+
+    std::vector<uint8_t> result;
+    ASSERT_TRUE(Decompress(result, recordSize));
+    EXPECT_EQ(result, data);
+    EXPECT_EQ(readPos_, file_.size());
+}
+
+/**
+ * @tc.name: CompressedRecords
+ * @tc.desc: the output is made of PERF_RECORD_COMPRESSED records
+ * @tc.type: FUNC
+ */
+HWTEST_F(RecordCompressorTest, CompressedRecords, TestSize.Level1)
+{
+    std::vector<uint8_t> data(RecordCompressor::BUFFER_SIZE);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(i * 0x9e3779b1u >> 24);
+    }
+    ASSERT_TRUE(Compress(data, data.size(), MIN_COMPRESS_LEVEL));
+    size_t pos = 0;
+    size_t count = 0;
+    while (pos < file_.size()) {
+        perf_event_header header;
+        ASSERT_LE(pos + sizeof(header), file_.size());
+        ASSERT_EQ(memcpy_s(&header, sizeof(header), file_.data() + pos, sizeof(header)), EOK);
+        EXPECT_EQ(header.type, PERF_RECORD_COMPRESSED);
+        EXPECT_GT(header.size, sizeof(header));
+        pos += header.size;
+        count++;
+    }
+    EXPECT_EQ(pos, file_.size());
+    EXPECT_GT(count, 1u);
+}
+
+/**
+ * @tc.name: Empty
+ * @tc.desc: an empty stream ends at once
+ * @tc.type: FUNC
+ */
+HWTEST_F(RecordCompressorTest, Empty, TestSize.Level2)
+{
+    ASSERT_TRUE(Compress({}, 1));
+    EXPECT_FALSE(file_.empty());
+    std::vector<uint8_t> result;
+    ASSERT_TRUE(Decompress(result, 1));
+    EXPECT_TRUE(result.empty());
+}
+
+/**
+ * @tc.name: Truncated
+ * @tc.desc: reading from a truncated stream fails
+ * @tc.type: FUNC
+ */
+HWTEST_F(RecordCompressorTest, Truncated, TestSize.Level2)
+{
+    std::vector<uint8_t> data(RecordCompressor::BUFFER_SIZE * 2, 'a');
+    ASSERT_TRUE(Compress(data, data.size()));
+    file_.resize(file_.size() / 2);
+    std::vector<uint8_t> result;
+    EXPECT_TRUE(!Decompress(result, data.size()) || result.size() < data.size());
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
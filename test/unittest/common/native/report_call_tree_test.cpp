@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "report_call_tree_test.h"
+
+#include <string>
+
+using namespace testing::ext;
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+class ReportCallTreeTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+    void SetUp();
+    void TearDown();
+
+    static size_t GetChildCount(const ReportCallTree &tree, const uint32_t parent);
+};
+
+void ReportCallTreeTest::SetUpTestCase() {}
+
+void ReportCallTreeTest::TearDownTestCase() {}
+
+void ReportCallTreeTest::SetUp() {}
+
+void ReportCallTreeTest::TearDown() {}
+
+size_t ReportCallTreeTest::GetChildCount(const ReportCallTree &tree, const uint32_t parent)
+{
+    size_t count = 0;
+    for (uint32_t child = tree.GetNode(parent).firstChild; child != ReportCallTree::INVALID_ID;
+         child = tree.GetNode(child).nextSibling) {
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @tc.name: GetFrameId
+ * @tc.desc: same frame gets same id, the strings are kept by the tree
+ * @tc.type: FUNC
+ */
+HWTEST_F(ReportCallTreeTest, GetFrameId, TestSize.Level1)
+{
+    ReportCallTree tree;
+    uint32_t frameId = ReportCallTree::INVALID_ID;
+    {
+        std::string func = "func";
+        std::string dso = "libtest.so";
+        frameId = tree.GetFrameId(func, 0x100, dso);
+        EXPECT_EQ(tree.GetFrameId(func, 0x100, dso), frameId);
+        EXPECT_NE(tree.GetFrameId(func, 0x200, dso), frameId);
+        EXPECT_NE(tree.GetFrameId("func2", 0x100, dso), frameId);
+        EXPECT_NE(tree.GetFrameId(func, 0x100, "libtest2.so"), frameId);
+    }
+    EXPECT_EQ(tree.GetFrameCount(), 4u);
+    EXPECT_EQ(tree.GetFrame(frameId).func, "func");
+    EXPECT_EQ(tree.GetFrame(frameId).vaddr, 0x100u);
+    EXPECT_EQ(tree.GetFrame(frameId).dso, "libtest.so");
+}
+
+/**
+ * @tc.name: AddChild
+ * @tc.desc: same callstack is merged into the same nodes
+ * @tc.type: FUNC
+ */
+HWTEST_F(ReportCallTreeTest, AddChild, TestSize.Level1)
+{
+    ReportCallTree tree;
+    uint32_t root = tree.NewRoot();
+    uint32_t main = tree.GetFrameId("main", 0x10, "bin");
+    uint32_t work = tree.GetFrameId("work", 0x20, "bin");
+    for (int i = 0; i < 3; i++) {
+        uint32_t node = tree.AddChild(root, main, 1, 0);
+        node = tree.AddChild(node, work, 1, 1);
+        EXPECT_EQ(tree.GetNode(node).frameId, work);
+    }
+    ASSERT_EQ(GetChildCount(tree, root), 1u);
+    uint32_t mainNode = tree.GetNode(root).firstChild;
+    EXPECT_EQ(tree.GetNode(mainNode).eventCount, 3u);
+    EXPECT_EQ(tree.GetNode(mainNode).selfEventCount, 0u);
+    ASSERT_EQ(GetChildCount(tree, mainNode), 1u);
+    uint32_t workNode = tree.GetNode(mainNode).firstChild;
+    EXPECT_EQ(tree.GetNode(workNode).eventCount, 3u);
+    EXPECT_EQ(tree.GetNode(workNode).selfEventCount, 3u);
+    // root + main + work
+    EXPECT_EQ(tree.GetNodeCount(), 3u);
+}
+
+/**
+ * @tc.name: ManySiblings
+ * @tc.desc: siblings are found by hash
+ * @tc.type: FUNC
+ */
+HWTEST_F(ReportCallTreeTest, ManySiblings, TestSize.Level1)
+{
+    constexpr uint32_t siblingCount = 10000;
+    ReportCallTree tree;
+    uint32_t root = tree.NewRoot();
+    for (int round = 0; round < 2; round++) {
+        for (uint32_t i = 0; i < siblingCount; i++) {
+            uint32_t frameId = tree.GetFrameId("func" + std::to_string(i), i, "bin");
+            tree.AddChild(root, frameId, 1, 1);
+        }
+    }
+    EXPECT_EQ(GetChildCount(tree, root), siblingCount);
+    EXPECT_EQ(tree.GetFrameCount(), siblingCount);
+    for (uint32_t child = tree.GetNode(root).firstChild; child != ReportCallTree::INVALID_ID;
+         child = tree.GetNode(child).nextSibling) {
+        EXPECT_EQ(tree.GetNode(child).eventCount, 2u);
+    }
+}
+
+/**
+ * @tc.name: Merge
+ * @tc.desc: merge two trees into one
+ * @tc.type: FUNC
+ */
+HWTEST_F(ReportCallTreeTest, Merge, TestSize.Level1)
+{
+    ReportCallTree tree;
+    uint32_t main = tree.GetFrameId("main", 0x10, "bin");
+    uint32_t funcA = tree.GetFrameId("funcA", 0x20, "bin");
+    uint32_t funcB = tree.GetFrameId("funcB", 0x30, "bin");
+
+    // main -> funcA
+    uint32_t left = tree.NewRoot();
+    tree.AddChild(tree.AddChild(left, main, 1, 0), funcA, 1, 1);
+    // main -> funcA, main -> funcB
+    uint32_t right = tree.NewRoot();
+    uint32_t rightMain = tree.AddChild(right, main, 2, 0);
+    tree.AddChild(rightMain, funcA, 1, 1);
+    tree.AddChild(rightMain, funcB, 1, 1);
+
+    tree.Merge(left, right);
+    ASSERT_EQ(GetChildCount(tree, left), 1u);
+    uint32_t mainNode = tree.GetNode(left).firstChild;
+    EXPECT_EQ(tree.GetNode(mainNode).eventCount, 3u);
+    ASSERT_EQ(GetChildCount(tree, mainNode), 2u);
+    for (uint32_t child = tree.GetNode(mainNode).firstChild; child != ReportCallTree::INVALID_ID;
+         child = tree.GetNode(child).nextSibling) {
+        const auto &node = tree.GetNode(child);
+        EXPECT_EQ(node.eventCount, node.frameId == funcA ? 2u : 1u);
+        EXPECT_EQ(node.selfEventCount, node.eventCount);
+    }
+
+    tree.Clear();
+    EXPECT_EQ(tree.GetNodeCount(), 0u);
+    EXPECT_EQ(tree.GetFrameCount(), 0u);
+}
+
+/**
+ * @tc.name: MergeOtherTree
+ * @tc.desc: merge the nodes of another tree, the frames are mapped to this tree
+ * @tc.type: FUNC
+ */
+HWTEST_F(ReportCallTreeTest, MergeOtherTree, TestSize.Level1)
+{
+    ReportCallTree tree;
+    uint32_t funcA = tree.GetFrameId("funcA", 0x20, "bin");
+    uint32_t left = tree.NewRoot();
+    tree.AddChild(left, funcA, 1, 1);
+
+    // frame ids of other are in different order
+    ReportCallTree other;
+    uint32_t otherFuncB = other.GetFrameId("funcB", 0x30, "bin");
+    uint32_t otherFuncA = other.GetFrameId("funcA", 0x20, "bin");
+    uint32_t right = other.NewRoot();
+    other.AddChild(other.AddChild(right, otherFuncA, 2, 0), otherFuncB, 2, 2);
+
+    std::vector<uint32_t> frameMap;
+    tree.Merge(left, other, right, frameMap);
+    EXPECT_EQ(tree.GetFrameCount(), 2u);
+    ASSERT_EQ(GetChildCount(tree, left), 1u);
+    uint32_t funcANode = tree.GetNode(left).firstChild;
+    EXPECT_EQ(tree.GetNode(funcANode).frameId, funcA);
+    EXPECT_EQ(tree.GetNode(funcANode).eventCount, 3u);
+    EXPECT_EQ(tree.GetNode(funcANode).selfEventCount, 1u);
+    ASSERT_EQ(GetChildCount(tree, funcANode), 1u);
+    uint32_t funcBNode = tree.GetNode(funcANode).firstChild;
+    EXPECT_EQ(tree.GetFrame(tree.GetNode(funcBNode).frameId).func, "funcB");
+    EXPECT_EQ(tree.GetNode(funcBNode).selfEventCount, 2u);
+    ASSERT_EQ(frameMap.size(), 2u);
+    EXPECT_EQ(frameMap[otherFuncA], funcA);
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
@@ -103,36 +103,44 @@ std::unique_ptr<ReportJsonFile> ReportJsonFileTest::PrepairReportJson(
 HWTEST_F(ReportJsonFileTest, OutputJsonKey, TestSize.Level2)
 {
     StdoutRecord output;
+    JsonWriter writer(stdout);
 
     // no name
     output.Start();
-    OutputJsonKey(stdout, std::string());
+    OutputJsonKey(writer, std::string());
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "");
 
     output.Start();
-    OutputJsonKey(stdout, "");
+    OutputJsonKey(writer, "");
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "");
 
     // have name
     output.Start();
-    OutputJsonKey(stdout, "keyname");
+    OutputJsonKey(writer, "keyname");
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "\"keyname\":");
 
     output.Start();
-    OutputJsonKey(stdout, static_cast<int>(1));
+    OutputJsonKey(writer, static_cast<int>(1));
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "\"1\":");
 
     output.Start();
-    OutputJsonKey(stdout, static_cast<long>(1));
+    OutputJsonKey(writer, static_cast<long>(1));
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "\"1\":");
 
     output.Start();
-    OutputJsonKey(stdout, static_cast<size_t>(2));
+    OutputJsonKey(writer, static_cast<size_t>(2));
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "\"2\":");
 
     output.Start();
 
-    OutputJsonKey(stdout, std::string("keyname"));
+    OutputJsonKey(writer, std::string("keyname"));
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "\"keyname\":");
 }
 
@@ -144,33 +152,41 @@ HWTEST_F(ReportJsonFileTest, OutputJsonKey, TestSize.Level2)
 HWTEST_F(ReportJsonFileTest, OutputJsonValue, TestSize.Level1)
 {
     StdoutRecord output;
+    JsonWriter writer(stdout);
 
     output.Start();
-    OutputJsonValue(stdout, std::string("value"));
+    OutputJsonValue(writer, std::string("value"));
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "\"value\"");
 
     output.Start();
-    OutputJsonValue(stdout, int(1));
+    OutputJsonValue(writer, int(1));
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "1");
 
     output.Start();
-    OutputJsonValue(stdout, uint64_t(1));
+    OutputJsonValue(writer, uint64_t(1));
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "1");
 
     output.Start();
-    OutputJsonValue(stdout, bool(true));
+    OutputJsonValue(writer, bool(true));
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "1");
 
     output.Start();
-    OutputJsonValue(stdout, size_t(1));
+    OutputJsonValue(writer, size_t(1));
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "1");
 
     output.Start();
-    OutputJsonValue(stdout, "value");
+    OutputJsonValue(writer, "value");
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "\"value\"");
 
     output.Start();
-    OutputJsonValue(stdout, "value", false);
+    OutputJsonValue(writer, "value", false);
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), ",\"value\"");
 }
 
@@ -182,8 +198,10 @@ HWTEST_F(ReportJsonFileTest, OutputJsonValue, TestSize.Level1)
 HWTEST_F(ReportJsonFileTest, OutputJsonPair, TestSize.Level1)
 {
     StdoutRecord output;
+    JsonWriter writer(stdout);
     output.Start();
-    OutputJsonValue(stdout, std::string("value"));
+    OutputJsonValue(writer, std::string("value"));
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "\"value\"");
 }
 
@@ -195,13 +213,16 @@ HWTEST_F(ReportJsonFileTest, OutputJsonPair, TestSize.Level1)
 HWTEST_F(ReportJsonFileTest, OutputJsonVectorList, TestSize.Level2)
 {
     StdoutRecord output;
+    JsonWriter writer(stdout);
 
     output.Start();
-    OutputJsonVectorList<int>(stdout, "listname", {1, 2, 3}, true);
+    OutputJsonVectorList<int>(writer, "listname", {1, 2, 3}, true);
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "\"listname\":[1,2,3]");
 
     output.Start();
-    OutputJsonVectorList<std::string>(stdout, "listname", {"1", "2", "3"}, true);
+    OutputJsonVectorList<std::string>(writer, "listname", {"1", "2", "3"}, true);
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "\"listname\":[\"1\",\"2\",\"3\"]");
 }
 
@@ -213,6 +234,7 @@ HWTEST_F(ReportJsonFileTest, OutputJsonVectorList, TestSize.Level2)
 HWTEST_F(ReportJsonFileTest, OutputJsonMapList, TestSize.Level2)
 {
     StdoutRecord output;
+    JsonWriter writer(stdout);
     std::map<int, int> map = {
         {1, 2},
         {3, 4},
@@ -220,7 +242,8 @@ HWTEST_F(ReportJsonFileTest, OutputJsonMapList, TestSize.Level2)
     };
 
     output.Start();
-    OutputJsonMapList(stdout, "map", map, true);
+    OutputJsonMapList(writer, "map", map, true);
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "\"map\":[2,4,6]");
 
     std::map<std::string, std::string> map2 = {
@@ -230,7 +253,8 @@ HWTEST_F(ReportJsonFileTest, OutputJsonMapList, TestSize.Level2)
     };
 
     output.Start();
-    OutputJsonMapList(stdout, "map2", map2, true);
+    OutputJsonMapList(writer, "map2", map2, true);
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "\"map2\":[\"2\",\"4\",\"6\"]");
 }
 
@@ -242,6 +266,7 @@ HWTEST_F(ReportJsonFileTest, OutputJsonMapList, TestSize.Level2)
 HWTEST_F(ReportJsonFileTest, OutputJsonMap, TestSize.Level0)
 {
     StdoutRecord output;
+    JsonWriter writer(stdout);
     std::map<int, int> map = {
         {1, 2},
         {3, 4},
@@ -249,7 +274,8 @@ HWTEST_F(ReportJsonFileTest, OutputJsonMap, TestSize.Level0)
     };
 
     output.Start();
-    OutputJsonMap(stdout, "map", map, true);
+    OutputJsonMap(writer, "map", map, true);
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "\"map\":{\"1\":2,\"3\":4,\"5\":6}");
 
     std::map<std::string, std::string> map2 = {
@@ -259,7 +285,8 @@ HWTEST_F(ReportJsonFileTest, OutputJsonMap, TestSize.Level0)
     };
 
     output.Start();
-    OutputJsonMap(stdout, "map2", map2, true);
+    OutputJsonMap(writer, "map2", map2, true);
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "\"map2\":{\"1\":\"2\",\"3\":\"4\",\"5\":\"6\"}");
 }
 
@@ -290,14 +317,16 @@ HWTEST_F(ReportJsonFileTest, GetOrCreateMapItem, TestSize.Level1)
 HWTEST_F(ReportJsonFileTest, ReportFuncItem, TestSize.Level2)
 {
     StdoutRecord output;
+    JsonWriter writer(stdout);
     ReportFuncItem func(1);
     func.sampleCount_ = 2;
     func.eventCount_ = 3;
     func.subTreeEventCount_ = 4;
 
     output.Start();
-    func.OutputJson(stdout);
+    func.OutputJson(writer);
 
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "{\"symbol\":1,\"counts\":[2,3,4]}");
 }
 
@@ -309,6 +338,7 @@ HWTEST_F(ReportJsonFileTest, ReportFuncItem, TestSize.Level2)
 HWTEST_F(ReportJsonFileTest, ReportCallNodeItem, TestSize.Level1)
 {
     StdoutRecord output;
+    JsonWriter writer(stdout);
     /*
     2 / 12
         4 / 10
@@ -320,8 +350,9 @@ HWTEST_F(ReportJsonFileTest, ReportCallNodeItem, TestSize.Level1)
     callnode.subTreeEventCount_ = 12;
 
     output.Start();
-    callnode.OutputJson(stdout);
+    callnode.OutputJson(writer);
 
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(),
                  "{\"selfEvents\":2,\"subEvents\":12,\"symbol\":1,\"callStack\":[]}");
 
@@ -329,7 +360,8 @@ HWTEST_F(ReportJsonFileTest, ReportCallNodeItem, TestSize.Level1)
     callnode2.selfEventCount_ = 4;
     callnode2.subTreeEventCount_ = 10;
     output.Start();
-    callnode.OutputJson(stdout);
+    callnode.OutputJson(writer);
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(),
                  "{\"selfEvents\":2,\"subEvents\":12,\"symbol\":1,\"callStack\":[{\"selfEvents\":4,"
                  "\"subEvents\":10,\"symbol\":2,\"callStack\":[]}]}");
@@ -338,14 +370,64 @@ HWTEST_F(ReportJsonFileTest, ReportCallNodeItem, TestSize.Level1)
     callnode3.selfEventCount_ = 6;
     callnode3.subTreeEventCount_ = 6;
     output.Start();
-    callnode.OutputJson(stdout);
+    callnode.OutputJson(writer);
 
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(),
                  "{\"selfEvents\":2,\"subEvents\":12,\"symbol\":1,\"callStack\":[{\"selfEvents\":4,"
                  "\"subEvents\":10,\"symbol\":2,\"callStack\":[{\"selfEvents\":6,\"subEvents\":6,"
                  "\"symbol\":3,\"callStack\":[]}]}]}");
 }
 
+/**
+ * @tc.name: ReportCallNodeItemDeep
+ * @tc.desc: a very deep call tree is output without recursion
+ * @tc.type: FUNC
+ */
+HWTEST_F(ReportJsonFileTest, ReportCallNodeItemDeep, TestSize.Level2)
+{
+    constexpr int depth = 10000;
+    ReportCallNodeItem callnode(0);
+    ReportCallNodeItem *node = &callnode;
+    for (int i = 1; i < depth; i++) {
+        node = &GetOrCreateMapItem(node->childrenMap, i);
+    }
+
+    StdoutRecord output;
+    JsonWriter writer(stdout);
+    output.Start();
+    callnode.OutputJson(writer);
+    writer.Flush();
+    std::string result = output.Stop();
+
+    std::string head = "{\"selfEvents\":0,\"subEvents\":0,\"symbol\":0,\"callStack\":[";
+    EXPECT_EQ(result.compare(0, head.size(), head), 0);
+    EXPECT_NE(result.find("\"symbol\":9999,\"callStack\":[]}]}"), std::string::npos);
+    std::string tail;
+    for (int i = 0; i < depth; i++) {
+        tail += "]}";
+    }
+    EXPECT_EQ(result.compare(result.size() - tail.size(), tail.size(), tail), 0);
+}
+
+/**
+ * @tc.name: ReportFuncMapItem
+ * @tc.desc: the symbol name is escaped when it is output
+ * @tc.type: FUNC
+ */
+HWTEST_F(ReportJsonFileTest, ReportFuncMapItem, TestSize.Level2)
+{
+    std::string name = "operator\"\"_s\\";
+    ReportFuncMapItem func(1, name, 2);
+
+    StdoutRecord output;
+    JsonWriter writer(stdout);
+    output.Start();
+    func.OutputJson(writer);
+    writer.Flush();
+    EXPECT_STREQ(output.Stop().c_str(), "{\"file\":1,\"symbol\":\"operator\\\"\\\"_s\\\\\"}");
+}
+
 /**
  * @tc.name: ReportCallNodeItem
  * @tc.desc:
@@ -354,6 +436,7 @@ HWTEST_F(ReportJsonFileTest, ReportCallNodeItem, TestSize.Level1)
 HWTEST_F(ReportJsonFileTest, UpdateChildrenEventCount, TestSize.Level2)
 {
     StdoutRecord output;
+    JsonWriter writer(stdout);
     /*
     2 / 12
         4 / 10
@@ -374,8 +457,9 @@ HWTEST_F(ReportJsonFileTest, UpdateChildrenEventCount, TestSize.Level2)
 
     output.Start();
     callnode.UpdateChildrenEventCount();
-    callnode.OutputJson(stdout);
+    callnode.OutputJson(writer);
 
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(),
                  "{\"selfEvents\":2,\"subEvents\":12,\"symbol\":1,\"callStack\":[{\"selfEvents\":4,"
                  "\"subEvents\":10,\"symbol\":2,\"callStack\":[{\"selfEvents\":6,\"subEvents\":6,"
@@ -390,6 +474,7 @@ HWTEST_F(ReportJsonFileTest, UpdateChildrenEventCount, TestSize.Level2)
 HWTEST_F(ReportJsonFileTest, ReportLibItem, TestSize.Level1)
 {
     StdoutRecord output;
+    JsonWriter writer(stdout);
     ReportLibItem lib;
     lib.libId_ = 1;
     lib.eventCount_ = 2;
@@ -400,10 +485,10 @@ HWTEST_F(ReportJsonFileTest, ReportLibItem, TestSize.Level1)
     func.subTreeEventCount_ = 4;
 
     output.Start();
-    lib.OutputJson(stdout);
+    lib.OutputJson(writer);
+    writer.Flush();
 
-    EXPECT_STREQ(
-        output.Stop().c_str(),
+    EXPECT_STREQ(output.Stop().c_str(),
         "{\"fileId\":1,\"eventCount\":2,\"functions\":[{\"symbol\":1,\"counts\":[2,3,4]}]}");
 }
 
@@ -415,14 +500,16 @@ HWTEST_F(ReportJsonFileTest, ReportLibItem, TestSize.Level1)
 HWTEST_F(ReportJsonFileTest, ReportThreadItem, TestSize.Level1)
 {
     StdoutRecord output;
+    JsonWriter writer(stdout);
     ReportThreadItem thread(1);
     thread.tid_ = 2;
     thread.eventCount_ = 3;
     thread.sampleCount_ = 4;
 
     output.Start();
-    thread.OutputJson(stdout);
+    thread.OutputJson(writer);
 
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(),
                  "{\"tid\":2,\"eventCount\":3,\"sampleCount\":4,\"libs\":[],\"CallOrder\":{"
                  "\"selfEvents\":0,\"subEvents\":0,\"symbol\":-1,\"callStack\":[]},\"CalledOrder\":"
@@ -437,13 +524,15 @@ HWTEST_F(ReportJsonFileTest, ReportThreadItem, TestSize.Level1)
 HWTEST_F(ReportJsonFileTest, ReportProcessItem, TestSize.Level1)
 {
     StdoutRecord output;
+    JsonWriter writer(stdout);
     ReportProcessItem process(1);
     process.pid_ = 2;
     process.eventCount_ = 3;
 
     output.Start();
-    process.OutputJson(stdout);
+    process.OutputJson(writer);
 
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(), "{\"pid\":2,\"eventCount\":3,\"threads\":[]}");
 }
 
@@ -455,12 +544,14 @@ HWTEST_F(ReportJsonFileTest, ReportProcessItem, TestSize.Level1)
 HWTEST_F(ReportJsonFileTest, ReportConfigItem, TestSize.Level2)
 {
     StdoutRecord output;
+    JsonWriter writer(stdout);
     ReportConfigItem config(1, "configname");
     config.eventCount_ = 3;
 
     output.Start();
-    config.OutputJson(stdout);
+    config.OutputJson(writer);
 
+    writer.Flush();
     EXPECT_STREQ(output.Stop().c_str(),
                  "{\"eventConfigName\":\"configname\",\"eventCount\":3,\"processes\":[]}");
 }
@@ -818,8 +909,10 @@ HWTEST_F(ReportJsonFileTest, OutputJsonFunctionMapHidden, TestSize.Level2)
     json->HiddenFunctionInLib(0, "funca1");
 
     StdoutRecord output;
+    JsonWriter writer(stdout);
     output.Start();
-    json->OutputJsonFunctionMap(stdout);
+    json->OutputJsonFunctionMap(writer);
+    writer.Flush();
     std::string result = output.Stop();
 
     EXPECT_NE(result.find("funca2"), std::string::npos);
@@ -839,8 +932,10 @@ HWTEST_F(ReportJsonFileTest, OutputJsonFunctionMapFail, TestSize.Level2)
     json->AddNewFunction(0, "funca1");
 
     StdoutRecord output;
+    JsonWriter writer(stdout);
     output.Start();
-    json->OutputJsonFunctionMap(stdout);
+    json->OutputJsonFunctionMap(writer);
+    writer.Flush();
     std::string result = output.Stop();
 
     EXPECT_NE(result.find("SymbolMap"), std::string::npos);
@@ -875,6 +970,77 @@ HWTEST_F(ReportJsonFileTest, UpdateReportCallStackDebug, TestSize.Level2)
     EXPECT_GT(json->nodeIndex_, 0);
 }
 
+/**
+ * @tc.name: GetLibIDBySymbolsFileIndex
+ * @tc.desc: Test GetLibID uses the symbols file index of frame if it is in the lib list.
+ * @tc.type: FUNC
+ */
+HWTEST_F(ReportJsonFileTest, GetLibIDBySymbolsFileIndex, TestSize.Level2)
+{
+    VirtualRuntime virtualRuntime;
+    std::unique_ptr<ReportJsonFile> json =
+        std::make_unique<ReportJsonFile>(nullptr, virtualRuntime);
+    json->libList_ = {"liba", "libb"};
+
+    DfxFrame frame = {0x1u, 0x1u, "libb", "funcb1"};
+    EXPECT_EQ(json->GetLibID(frame), 1);
+    frame.symbolFileIndex = 1;
+    EXPECT_EQ(json->GetLibID(frame), 1);
+    // the index is used without comparing the path
+    frame.symbolFileIndex = 0;
+    EXPECT_EQ(json->GetLibID(frame), 0);
+    frame.symbolFileIndex = 2; // 2: out of lib list
+    EXPECT_EQ(json->GetLibID(frame), 1);
+    // adlt extends the path, so the index is not used
+    frame.symbolFileIndex = 1;
+    frame.originSoName = "origin.so";
+    EXPECT_EQ(json->GetLibID(frame), json->GetLibID(frame.mapName, frame.originSoName, frame.funcName));
+}
+
+/**
+ * @tc.name: GetLibIDDuplicatedPath
+ * @tc.desc: Test GetLibID returns the first id of a path by index and by path.
+ * @tc.type: FUNC
+ */
+HWTEST_F(ReportJsonFileTest, GetLibIDDuplicatedPath, TestSize.Level2)
+{
+    VirtualRuntime virtualRuntime;
+    std::unique_ptr<ReportJsonFile> json =
+        std::make_unique<ReportJsonFile>(nullptr, virtualRuntime);
+    json->libList_ = {"liba", "libb", "liba"};
+
+    DfxFrame frame = {0x1u, 0x1u, "liba", "funca1"};
+    EXPECT_EQ(json->GetLibID(frame), 0);
+    frame.symbolFileIndex = 2; // 2: the second liba
+    EXPECT_EQ(json->GetLibID(frame), 0);
+    EXPECT_EQ(json->GetLibID("liba"), 0);
+
+    json->libList_ = {"libb", "liba"};
+    frame.symbolFileIndex = 1;
+    EXPECT_EQ(json->GetLibID(frame), 1);
+}
+
+/**
+ * @tc.name: GetLibIDAppended
+ * @tc.desc: Test GetLibID finds the libs appended after the last lookup.
+ * @tc.type: FUNC
+ */
+HWTEST_F(ReportJsonFileTest, GetLibIDAppended, TestSize.Level2)
+{
+    VirtualRuntime virtualRuntime;
+    std::unique_ptr<ReportJsonFile> json =
+        std::make_unique<ReportJsonFile>(nullptr, virtualRuntime);
+    json->libList_ = {"liba", "libb", "liba"};
+    EXPECT_EQ(json->GetLibID("liba"), 0);
+    EXPECT_EQ(json->GetLibID("libc"), -1);
+    json->libList_.emplace_back("libc");
+    EXPECT_EQ(json->GetLibID("libc"), 3); // 3: the fourth lib
+
+    json->libList_ = {"libd"};
+    EXPECT_EQ(json->GetLibID("libd"), 0);
+    EXPECT_EQ(json->GetLibID("liba"), -1);
+}
+
 /**
  * @tc.name: GetLibIDLibadlt
  * @tc.desc: Test GetLibID with libadlt filepath and various originSoName.
@@ -974,9 +1140,10 @@ HWTEST_F(ReportJsonFileTest, OutputJsonRuntimeInfoFail, TestSize.Level2)
     json->AddNewFunction(0, "funca1");
 
     StdoutRecord output;
+    JsonWriter writer(stdout);
     output.Start();
-    json->output_ = stdout;
-    json->OutputJsonRuntimeInfo();
+    json->OutputJsonRuntimeInfo(writer);
+    writer.Flush();
     std::string result = output.Stop();
 
     EXPECT_FALSE(result.empty());
@@ -746,8 +746,11 @@ HWTEST_F(ReportTest, AddReportItem, TestSize.Level0)
     ASSERT_EQ(reportItems.size(), 2u);
 
     // no call frame
-    ASSERT_EQ(reportItems[0].callStacks_.size(), 0u);
-    // have call frame
+    ASSERT_EQ(reportItems[0].callTreeRoot_, ReportCallTree::INVALID_ID);
+    // have call frame, merged in call tree, not exported yet
+    ASSERT_NE(reportItems[1].callTreeRoot_, ReportCallTree::INVALID_ID);
+    ASSERT_EQ(reportItems[1].callStacks_.size(), 0u);
+    report_->ExportCallFrames(reportItems[1].callTreeRoot_, reportItems[1].callStacks_);
     ASSERT_EQ(reportItems[1].callStacks_.size(), 1u);
 
     // first on the end caller
@@ -767,8 +770,42 @@ HWTEST_F(ReportTest, AddReportItem, TestSize.Level0)
                  "frame1");
     ASSERT_EQ(reportItems[1].callStacks_[0].childs[0].childs[0].childs[0].childs.size(), 0u);
 
+    // same sort keys as the first one, merged into it
     report_->AddReportItem(sample, false);
-    EXPECT_EQ(reportItems.size(), 3u);
+    EXPECT_EQ(reportItems.size(), 2u);
+    EXPECT_EQ(reportItems[0].eventCount_, 2u);
+}
+
+/**
+ * @tc.name: AddReportItemMerge
+ * @tc.desc: test the samples of same sort keys are merged into one item and one call tree
+ * @tc.type: FUNC
+ */
+HWTEST_F(ReportTest, AddReportItemMerge, TestSize.Level1)
+{
+    PerfRecordSample sample(false, 0, 0, 1);
+    sample.callFrames_.emplace_back(0x1, 0x1234, "dummy", "frame1");
+    sample.callFrames_.emplace_back(0x2, 0x1234, "dummy", "frame2");
+    sample.callFrames_.emplace_back(0x3, 0x1234, "dummy", "frame3");
+    sample.callFrames_.emplace_back(0x3, 0x1234, "dummy", "frame4");
+
+    report_->AddReportItem(sample, true);
+    report_->AddReportItem(sample, true);
+    auto &reportItems = report_->configs_[0].reportItems_;
+    ASSERT_EQ(reportItems.size(), 1u);
+    EXPECT_EQ(reportItems[0].eventCount_, 2u);
+    EXPECT_EQ(reportItems[0].mergedSampleCount_, 2u);
+    // root + 4 frames
+    EXPECT_EQ(report_->callTree_.GetNodeCount(), 5u);
+
+    report_->AdjustReportItems();
+    ASSERT_EQ(reportItems.size(), 1u);
+    EXPECT_EQ(reportItems[0].callTreeRoot_, ReportCallTree::INVALID_ID);
+    ASSERT_EQ(reportItems[0].callStacks_.size(), 1u);
+    EXPECT_EQ(reportItems[0].callStacks_[0].eventCount_, 2u);
+    EXPECT_EQ(reportItems[0].callStacks_[0].selfEventCount_, 0u);
+    ASSERT_STREQ(reportItems[0].callStacks_[0].childs[0].childs[0].childs[0].func_.data(), "frame1");
+    EXPECT_EQ(reportItems[0].callStacks_[0].childs[0].childs[0].childs[0].selfEventCount_, 2u);
 }
 
 /**
@@ -1154,19 +1191,19 @@ HWTEST_F(ReportTest, FilterDisplayRecordsBranches, TestSize.Level1)
     addSample("funcA", 70);
 
     auto &config = report_->configs_[0];
-    ASSERT_EQ(config.reportItems_.size(), 3u);
+    ASSERT_EQ(config.reportItems_.size(), 2u);          // funcA merged
     uint64_t totalBefore = config.eventCount_;
 
     // only keep funcA
     report_->option_.displayFuncs_ = {"funcA"};
     report_->FilterDisplayRecords();
-    EXPECT_EQ(config.reportItems_.size(), 2u);          // funcB filtered out
+    EXPECT_EQ(config.reportItems_.size(), 1u);          // funcB filtered out
     EXPECT_EQ(config.eventCount_, totalBefore - 30);    // eventCount reduced
 
     // empty displayFilter
     report_->option_.displayFuncs_.clear();
     report_->FilterDisplayRecords();
-    EXPECT_EQ(config.reportItems_.size(), 2u);          // unchanged
+    EXPECT_EQ(config.reportItems_.size(), 1u);          // unchanged
 }
 
 /**
@@ -1200,6 +1237,93 @@ HWTEST_F(ReportTest, AdjustReportItemsBranches, TestSize.Level1)
     EXPECT_GT(config.reportItems_[0].heat, 0.0f);
 }
 
+/**
+ * @tc.name: AddReportItemAggregated
+ * @tc.desc: test items of same sort keys are merged when added
+ * @tc.type: FUNC
+ */
+HWTEST_F(ReportTest, AddReportItemAggregated, TestSize.Level1)
+{
+    const std::vector<std::string> funcs = {"funcA", "funcB", "funcC"};
+    const size_t sampleCount = 300;
+    auto addSamples = [this, &funcs, sampleCount]() {
+        for (size_t i = 0; i < sampleCount; i++) {
+            PerfRecordSample sample(false, 1, 2, 1);
+            sample.callFrames_.emplace_back(0x1, 0x100, "d.so", funcs[i % funcs.size()]);
+            report_->AddReportItem(sample, false);
+        }
+    };
+    auto &config = report_->configs_[0];
+    addSamples();
+    ASSERT_EQ(config.reportItems_.size(), funcs.size());
+    for (const auto &item : config.reportItems_) {
+        EXPECT_EQ(item.eventCount_, sampleCount / funcs.size());
+        EXPECT_EQ(item.mergedSampleCount_, sampleCount / funcs.size());
+    }
+    report_->AdjustReportItems();
+    EXPECT_EQ(config.reportItems_.size(), funcs.size());
+    EXPECT_EQ(config.eventCount_, sampleCount);
+
+    // the indexes are dropped after adjusted, the items added later are merged by the next adjust
+    EXPECT_FALSE(report_->IsAggregated());
+    addSamples();
+    report_->AdjustReportItems();
+    EXPECT_EQ(config.reportItems_.size(), funcs.size());
+
+    // count changes when merged, items are merged in AdjustReportItems
+    config.reportItems_.clear();
+    config.eventCount_ = 0;
+    report_->option_.sortKeys_ = {"func", "count"};
+    addSamples();
+    EXPECT_EQ(config.reportItems_.size(), sampleCount);
+
+    // sort keys changed after the items are added
+    report_->option_.sortKeys_ = {"dso"};
+    report_->AdjustReportItems();
+    EXPECT_EQ(config.reportItems_.size(), 1u);
+}
+
+/**
+ * @tc.name: AddReportItemCommRenamed
+ * @tc.desc: test the samples after a comm rename are merged into one item, the old item keeps its comm
+ * @tc.type: FUNC
+ */
+HWTEST_F(ReportTest, AddReportItemCommRenamed, TestSize.Level1)
+{
+    const std::string oldComm = "appspawn";
+    const std::string newComm = "com.example.app";
+    auto addSamples = [this](size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            PerfRecordSample sample(false, 1, 2, 1);
+            sample.callFrames_.emplace_back(0x1, 0x100, "d.so", "funcA");
+            report_->AddReportItem(sample, false);
+        }
+    };
+    PerfRecordComm comm(false, 1, 2, oldComm);
+    report_->virtualRuntime_.UpdateFromRecord(comm);
+    addSamples(2); // 2 : samples before rename
+    // the name of thread is reassigned in place
+    PerfRecordComm rename(false, 1, 2, newComm);
+    report_->virtualRuntime_.UpdateFromRecord(rename);
+    ASSERT_EQ(report_->virtualRuntime_.GetThread(1, 2).name_, newComm);
+    addSamples(3); // 3 : samples after rename
+
+    auto &config = report_->configs_[0];
+    report_->AdjustReportItems();
+    ASSERT_EQ(config.reportItems_.size(), 2u);
+    size_t newCommItems = 0;
+    for (const auto &item : config.reportItems_) {
+        if (item.comm_ == newComm) {
+            newCommItems++;
+            EXPECT_EQ(item.eventCount_, 3u);
+        } else {
+            EXPECT_EQ(item.comm_, oldComm);
+            EXPECT_EQ(item.eventCount_, 2u);
+        }
+    }
+    EXPECT_EQ(newCommItems, 1u);
+}
+
 /**
  * @tc.name: OutputStdStatisticsBranches
  * @tc.desc: test OutputStdStatistics with different coutMode and counters
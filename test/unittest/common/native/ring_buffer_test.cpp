@@ -73,6 +73,7 @@ void RingBufferTest::ReadBufferAndCheck(RingBuffer &buf)
         }
         buf.EndRead();
     }
+    buf.CommitRead();
 }
 
 void RingBufferTest::WriteBuffer(RingBuffer &buf)
@@ -94,6 +95,7 @@ void RingBufferTest::WriteBuffer(RingBuffer &buf)
             writeData.size = sizeof(perf_event_header);
         }
     }
+    buf.CommitWrite();
 }
 
 /**
@@ -129,9 +131,11 @@ HWTEST_F(RingBufferTest, Wrap, TestSize.Level0)
     }
     ASSERT_LE(rb.GetFreeSize(), cap);
 
+    rb.CommitWrite();
     while (rb.GetReadData() != nullptr) {
         rb.EndRead();
     }
+    rb.CommitRead();
     ASSERT_EQ(rb.GetFreeSize(), cap);
 
     WriteBuffer(rb); // write_head has turned round
@@ -144,6 +148,39 @@ HWTEST_F(RingBufferTest, Wrap, TestSize.Level0)
     ReadBufferAndCheck(rb);
     ASSERT_TRUE(rb.GetFreeSize() == cap) << "the buffer should be empty now";
 }
+
+/**
+ * @tc.name: Commit
+ * @tc.desc: records are visible after commit, only the first commit to an empty buffer needs wakeup
+ * @tc.type: FUNC
+ */
+HWTEST_F(RingBufferTest, Commit, TestSize.Level1)
+{
+    RingBuffer rb {cap};
+    perf_event_header writeData = {PERF_RECORD_MMAP, 0, sizeof(perf_event_header)};
+    uint8_t *p = rb.AllocForWrite(writeData.size);
+    ASSERT_NE(p, nullptr);
+    ASSERT_EQ(memcpy_s(p, writeData.size, &writeData, sizeof(perf_event_header)), 0);
+    rb.EndWrite();
+    EXPECT_EQ(rb.GetReadData(), nullptr) << "not committed yet";
+    EXPECT_TRUE(rb.CommitWrite()) << "buffer was empty";
+
+    p = rb.AllocForWrite(writeData.size);
+    ASSERT_NE(p, nullptr);
+    ASSERT_EQ(memcpy_s(p, writeData.size, &writeData, sizeof(perf_event_header)), 0);
+    rb.EndWrite();
+    EXPECT_FALSE(rb.CommitWrite()) << "buffer was not empty";
+    EXPECT_FALSE(rb.CommitWrite()) << "nothing to commit";
+
+    ASSERT_NE(rb.GetReadData(), nullptr);
+    rb.EndRead();
+    EXPECT_EQ(rb.GetFreeSize(), cap - writeData.size * 2) << "read space is not released before commit";
+    EXPECT_FALSE(rb.CommitRead()) << "one more record to read";
+    ASSERT_NE(rb.GetReadData(), nullptr);
+    rb.EndRead();
+    EXPECT_TRUE(rb.CommitRead());
+    EXPECT_EQ(rb.GetFreeSize(), cap);
+}
 } // namespace HiPerf
 } // namespace Developtools
 } // namespace OHOS
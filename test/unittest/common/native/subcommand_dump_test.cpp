@@ -155,6 +155,23 @@ HWTEST_F(SubCommandDumpTest, DumpData, TestSize.Level2)
     TestDumpCommand("-i /data/test/resource/testdata/perf.data -d ");
 }
 
+HWTEST_F(SubCommandDumpTest, DumpDataInRange, TestSize.Level1)
+{
+    StdoutRecord stdoutRecord;
+    stdoutRecord.Start();
+    std::string cmdString = "dump -i /data/test/resource/testdata/perf.data -d --pid 99999";
+    EXPECT_EQ(Command::DispatchCommand(cmdString), true);
+    std::string stringOut = stdoutRecord.Stop();
+    // no sample of this pid, the non-sample records are still dumped
+    EXPECT_EQ(stringOut.find("record sample"), std::string::npos);
+    EXPECT_NE(stringOut.find("record mmap"), std::string::npos);
+}
+
+HWTEST_F(SubCommandDumpTest, DumpDataInRangeErr, TestSize.Level2)
+{
+    TestDumpCommand("-i /data/test/resource/testdata/perf.data -d --start-time 2 --end-time 1 ", false);
+}
+
 HWTEST_F(SubCommandDumpTest, DumpFeatures, TestSize.Level1)
 {
     TestDumpCommand("-i /data/test/resource/testdata/perf.data -f ");
@@ -1031,6 +1031,43 @@ HWTEST_F(SubCommandRecordTest, MmapPagesInputErr, TestSize.Level2)
     TestRecordCommand("-d 1 -m abc ", false);
 }
 
+// mmap readers
+HWTEST_F(SubCommandRecordTest, MmapReaders, TestSize.Level1)
+{
+    ForkAndRunTest("-d 1 --mmap-readers 2 ");
+}
+
+HWTEST_F(SubCommandRecordTest, MmapReadersMinErr, TestSize.Level2)
+{
+    TestRecordCommand("-d 1 --mmap-readers -1 ", false);
+}
+
+HWTEST_F(SubCommandRecordTest, MmapReadersMaxErr, TestSize.Level2)
+{
+    TestRecordCommand("-d 1 --mmap-readers 100000 ", false);
+}
+
+HWTEST_F(SubCommandRecordTest, MmapAdaptive, TestSize.Level1)
+{
+    ForkAndRunTest("-d 2 --mmap-adaptive -m 16 ");
+}
+
+HWTEST_F(SubCommandRecordTest, MmapAdaptiveWithReadersErr, TestSize.Level2)
+{
+    TestRecordCommand("-d 1 --mmap-adaptive --mmap-readers 2 ", false);
+}
+
+// reorder window
+HWTEST_F(SubCommandRecordTest, ReorderWindow, TestSize.Level1)
+{
+    ForkAndRunTest("-d 1 --reorder-window 10 ");
+}
+
+HWTEST_F(SubCommandRecordTest, ReorderWindowMaxErr, TestSize.Level2)
+{
+    TestRecordCommand("-d 1 --reorder-window 1001 ", false);
+}
+
 // output file name
 HWTEST_F(SubCommandRecordTest, OutputFileName, TestSize.Level2)
 {
@@ -1068,11 +1105,105 @@ HWTEST_F(SubCommandRecordTest, DataLimitErr, TestSize.Level2)
     TestRecordCommand("-d 1 --data-limit 0G ", false);
 }
 
+// split output files
+HWTEST_F(SubCommandRecordTest, SplitSize, TestSize.Level1)
+{
+    ForkAndRunTest("-d 2 -a -e sw-cpu-clock --split-size 8K --split-max-files 2 ", true, false);
+}
+
+HWTEST_F(SubCommandRecordTest, SplitTime, TestSize.Level1)
+{
+    ForkAndRunTest("-d 3 --split-time 1 ");
+}
+
+HWTEST_F(SubCommandRecordTest, SplitErr, TestSize.Level2)
+{
+    TestRecordCommand("-d 1 --split-size 10A ", false);
+    TearDown();
+    SetUp();
+    TestRecordCommand("-d 1 --split-time 86401 ", false);
+    TearDown();
+    SetUp();
+    TestRecordCommand("-d 1 --split-max-files 2 ", false);
+    TearDown();
+    SetUp();
+    TestRecordCommand("-d 1 --split-size 1M --data-limit 1M ", false);
+    TearDown();
+    SetUp();
+    TestRecordCommand("-d 1 --split-time 1 --delay-unwind ", false);
+    TearDown();
+    SetUp();
+    TestRecordCommand("-d 1 --split-time 1 --dedup_stack ", false);
+}
+
+HWTEST_F(SubCommandRecordTest, CheckSplitOption, TestSize.Level2)
+{
+    SubCommandRecord recordCmd;
+    recordCmd.strSplitSize_ = "2M";
+    EXPECT_TRUE(recordCmd.CheckSplitOption());
+    EXPECT_EQ(recordCmd.splitSize_, 2u * 1024 * 1024);
+    recordCmd.backtrack_ = true;
+    EXPECT_FALSE(recordCmd.CheckSplitOption());
+    recordCmd.backtrack_ = false;
+    recordCmd.dedupStack_ = true;
+    EXPECT_FALSE(recordCmd.CheckSplitOption());
+}
+
+HWTEST_F(SubCommandRecordTest, SplitTimeOnTick, TestSize.Level2)
+{
+    SubCommandRecord recordCmd;
+    recordCmd.splitTimeSec_ = 1;
+    // no file, nothing to split
+    recordCmd.OnRecordTick();
+    EXPECT_EQ(recordCmd.splitIndex_, 0u);
+    EXPECT_FALSE(recordCmd.IsSplitNeeded());
+    EXPECT_TRUE(recordCmd.WaitBackgroundTasks());
+}
+
+HWTEST_F(SubCommandRecordTest, StreamOutputErr, TestSize.Level2)
+{
+    TestRecordCommand("-d 1 -o - -z ", false);
+    TearDown();
+    SetUp();
+    TestRecordCommand("-d 1 -o fd:1 --delay-unwind ", false);
+    TearDown();
+    SetUp();
+    TestRecordCommand("-d 1 -o - --split-size 1M ", false);
+}
+
+HWTEST_F(SubCommandRecordTest, CheckStreamOption, TestSize.Level2)
+{
+    SubCommandRecord recordCmd;
+    EXPECT_TRUE(recordCmd.CheckStreamOption());
+    recordCmd.outputFilename_ = "-";
+    EXPECT_TRUE(recordCmd.CheckStreamOption());
+    recordCmd.report_ = true;
+    EXPECT_FALSE(recordCmd.CheckStreamOption());
+}
+
 HWTEST_F(SubCommandRecordTest, RecordCompress, TestSize.Level1)
 {
     ForkAndRunTest("-d 1 -z -o /data/local/tmp/perf.data.tar.gz");
 }
 
+HWTEST_F(SubCommandRecordTest, RecordCompressLevel, TestSize.Level1)
+{
+    ForkAndRunTest("-d 1 -z --compress-level 1 ");
+}
+
+HWTEST_F(SubCommandRecordTest, RecordCompressLevelErr, TestSize.Level2)
+{
+    TestRecordCommand("-d 1 -z --compress-level 10 ", false);
+    TearDown();
+    SetUp();
+    TestRecordCommand("-d 1 -z --compress-level 0 ", false);
+}
+
+HWTEST_F(SubCommandRecordTest, DirectIo, TestSize.Level1)
+{
+    ForkAndRunTest("-d 1 --direct-io ");
+}
+
 HWTEST_F(SubCommandRecordTest, Verbose, TestSize.Level2)
 {
     ForkAndRunTest("-d 1 --verbose ");
@@ -1927,6 +2058,47 @@ HWTEST_F(SubCommandRecordTest, CheckBacktrackOption, TestSize.Level1)
     EXPECT_EQ(record.CheckBacktrackOption(), true);
 }
 
+/**
+ * @tc.name: GetBacktrackMmapPages
+ * @tc.desc: Test the mmap pages of backtrack grow with the backtrack time and the sample size
+ * @tc.type: FUNC
+ */
+HWTEST_F(SubCommandRecordTest, GetBacktrackMmapPages, TestSize.Level1)
+{
+    SubCommandRecord record;
+    record.mmapPages_ = SubCommandRecord::MIN_PERF_MMAP_PAGE;
+    record.backtrackTime_ = SubCommandRecord::MIN_BACKTRACK_TIME_SEC;
+    record.frequency_ = 1;
+    int minPages = record.GetBacktrackMmapPages();
+    EXPECT_GE(minPages, SubCommandRecord::MIN_PERF_MMAP_PAGE);
+    EXPECT_TRUE(PowerOfTwo(minPages));
+
+    record.frequency_ = 1000; // 1000 : samples per second
+    record.isCallStackFp_ = true;
+    int fpPages = record.GetBacktrackMmapPages();
+    EXPECT_GT(fpPages, minPages);
+    EXPECT_LT(fpPages, SubCommandRecord::MAX_BACKTRACK_MMAP_PAGE);
+    EXPECT_TRUE(PowerOfTwo(fpPages));
+    record.backtrackTime_ = SubCommandRecord::MAX_BACKTRACK_TIME_SEC;
+    EXPECT_GT(record.GetBacktrackMmapPages(), fpPages);
+
+    // the user stacks do not fit, limited
+    record.isCallStackFp_ = false;
+    record.isCallStackDwarf_ = true;
+    EXPECT_EQ(record.GetBacktrackMmapPages(), SubCommandRecord::MAX_BACKTRACK_MMAP_PAGE);
+
+    // the sample rate is unknown with a period
+    record.frequency_ = 0;
+    record.period_ = 1000; // 1000 : events per sample
+    EXPECT_EQ(record.GetBacktrackMmapPages(), SubCommandRecord::MIN_PERF_MMAP_PAGE);
+
+    // never smaller than -m
+    record.period_ = 0;
+    record.frequency_ = 1;
+    record.mmapPages_ = SubCommandRecord::MAX_BACKTRACK_MMAP_PAGE * 2; // 2 : larger than the limit
+    EXPECT_EQ(record.GetBacktrackMmapPages(), SubCommandRecord::MAX_BACKTRACK_MMAP_PAGE * 2);
+}
+
 /**
  * @tc.name: GetSpeOptions
  * @tc.desc: Test GetSpeOptions
@@ -1514,6 +1514,40 @@ HWTEST_F(SubCommandReportTest, ProcessSample_BranchMode, TestSize.Level2)
     reportCmd.ProcessSample(sample);
     EXPECT_GE(reportCmd.GetReport().configs_[0].sampleCount_, 1u);
 }
+
+/**
+ * @tc.name: VerifyOption_DecodeThreads
+ * @tc.desc: Test VerifyOption rejects a decode thread count out of range
+ * @tc.type: FUNC
+ */
+HWTEST_F(SubCommandReportTest, VerifyOption_DecodeThreads, TestSize.Level2)
+{
+    SubCommandReport reportCmd;
+    reportCmd.recordFile_[0] = RESOURCE_PATH + "/report_test.data";
+    reportCmd.decodeThreads_ = -1;
+    EXPECT_FALSE(reportCmd.VerifyOption());
+    reportCmd.decodeThreads_ = static_cast<int>(MAX_DECODE_THREADS) + 1;
+    EXPECT_FALSE(reportCmd.VerifyOption());
+    reportCmd.decodeThreads_ = 1;
+    EXPECT_TRUE(reportCmd.VerifyOption());
+}
+
+/**
+ * @tc.name: VerifyOption_ParallelThreads
+ * @tc.desc: Test VerifyOption rejects a parallel thread count out of range
+ * @tc.type: FUNC
+ */
+HWTEST_F(SubCommandReportTest, VerifyOption_ParallelThreads, TestSize.Level2)
+{
+    SubCommandReport reportCmd;
+    reportCmd.recordFile_[0] = RESOURCE_PATH + "/report_test.data";
+    reportCmd.parallelThreads_ = -1;
+    EXPECT_FALSE(reportCmd.VerifyOption());
+    reportCmd.parallelThreads_ = static_cast<int>(ParallelReportAggregator::MAX_THREAD_COUNT) + 1;
+    EXPECT_FALSE(reportCmd.VerifyOption());
+    reportCmd.parallelThreads_ = 2;
+    EXPECT_TRUE(reportCmd.VerifyOption());
+}
 } // namespace HiPerf
 } // namespace Developtools
 } // namespace OHOS
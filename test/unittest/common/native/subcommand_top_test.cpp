@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "subcommand_top_test.h"
+
+#include <chrono>
+#include <csignal>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "utilities.h"
+
+using namespace testing::ext;
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+class SubCommandTopTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+    void SetUp();
+    void TearDown();
+
+    static bool ParseOption(SubCommandTop &cmd, const std::string &args);
+};
+
+void SubCommandTopTest::SetUpTestCase() {}
+
+void SubCommandTopTest::TearDownTestCase() {}
+
+void SubCommandTopTest::SetUp() {}
+
+void SubCommandTopTest::TearDown() {}
+
+bool SubCommandTopTest::ParseOption(SubCommandTop &cmd, const std::string &args)
+{
+    std::vector<std::string> argsVector = StringSplit(args, " ");
+    return cmd.ParseOption(argsVector);
+}
+
+/**
+ * @tc.name: ParseOption
+ * @tc.desc: Test the options of top are parsed
+ * @tc.type: FUNC
+ */
+HWTEST_F(SubCommandTopTest, ParseOption, TestSize.Level1)
+{
+    SubCommandTop cmd;
+    std::string pid = std::to_string(getpid());
+    EXPECT_TRUE(ParseOption(cmd, "-p " + pid + " -i 500 -n 5 --dso --decay 0.8 --max-entries 100"));
+    EXPECT_FALSE(cmd.targetSystemWide_);
+    EXPECT_EQ(cmd.refreshMs_, 500);
+    EXPECT_EQ(cmd.showCount_, 5);
+    EXPECT_TRUE(cmd.showDso_);
+    EXPECT_FLOAT_EQ(cmd.decay_, 0.8f);
+    EXPECT_EQ(cmd.maxEntries_, 100);
+}
+
+/**
+ * @tc.name: ParseOptionOutOfRange
+ * @tc.desc: Test the options out of range are refused
+ * @tc.type: FUNC
+ */
+HWTEST_F(SubCommandTopTest, ParseOptionOutOfRange, TestSize.Level2)
+{
+    std::string pid = std::to_string(getpid());
+    const std::vector<std::string> badOptions = {
+        "-i 10", "-n 0", "--decay 0", "--decay 1.5", "--max-entries 1", "-f 0", "-d 0", "--unknown",
+    };
+    for (const auto &option : badOptions) {
+        SubCommandTop cmd;
+        EXPECT_FALSE(ParseOption(cmd, "-p " + pid + " " + option)) << option;
+    }
+}
+
+/**
+ * @tc.name: ParseOptionTarget
+ * @tc.desc: Test -a conflicts with -p and the pid must exist
+ * @tc.type: FUNC
+ */
+HWTEST_F(SubCommandTopTest, ParseOptionTarget, TestSize.Level2)
+{
+    std::string pid = std::to_string(getpid());
+    SubCommandTop conflictCmd;
+    EXPECT_FALSE(ParseOption(conflictCmd, "-a -p " + pid));
+    SubCommandTop notExistCmd;
+    EXPECT_FALSE(ParseOption(notExistCmd, "-p 99999999"));
+}
+
+/**
+ * @tc.name: Refresh
+ * @tc.desc: Test the hot functions are shown and decayed
+ * @tc.type: FUNC
+ */
+HWTEST_F(SubCommandTopTest, Refresh, TestSize.Level1)
+{
+    SubCommandTop cmd;
+    cmd.selectEvents_ = {"hw-cpu-cycles"};
+    cmd.aggregator_ = std::make_unique<TopAggregator>();
+    cmd.aggregator_->AddSample("liba.so", "funcA", 300);
+    cmd.aggregator_->AddSample("libb.so", "funcB", 100);
+
+    StdoutRecord stdoutRecord;
+    stdoutRecord.Start();
+    cmd.Refresh(true);
+    std::string stringOut = stdoutRecord.Stop();
+    EXPECT_NE(stringOut.find("Samples: 2"), std::string::npos);
+    EXPECT_NE(stringOut.find("75.00%"), std::string::npos);
+    EXPECT_NE(stringOut.find("funcA"), std::string::npos);
+    EXPECT_NE(stringOut.find("25.00%"), std::string::npos);
+    EXPECT_LT(stringOut.find("funcA"), stringOut.find("funcB"));
+    EXPECT_EQ(cmd.aggregator_->GetRecentSamples(), 0u);
+
+    cmd.showDso_ = true;
+    stdoutRecord.Start();
+    cmd.Refresh(true);
+    stringOut = stdoutRecord.Stop();
+    EXPECT_NE(stringOut.find("liba.so"), std::string::npos);
+    EXPECT_EQ(stringOut.find("funcA"), std::string::npos);
+}
+
+/**
+ * @tc.name: DumpOptions
+ * @tc.desc: Test the default options are dumped
+ * @tc.type: FUNC
+ */
+HWTEST_F(SubCommandTopTest, DumpOptions, TestSize.Level2)
+{
+    StdoutRecord stdoutRecord;
+    stdoutRecord.Start();
+    SubCommandTop cmd;
+    cmd.DumpOptions();
+    std::string stringOut = stdoutRecord.Stop();
+    EXPECT_NE(stringOut.find("refreshMs:\t1000"), std::string::npos);
+    EXPECT_NE(stringOut.find("showCount:\t20"), std::string::npos);
+}
+
+/**
+ * @tc.name: OnSubCommand
+ * @tc.desc: Test top samples the process for a while
+ * @tc.type: FUNC
+ */
+HWTEST_F(SubCommandTopTest, OnSubCommand, TestSize.Level1)
+{
+    SubCommandTop cmd;
+    std::vector<std::string> args = {"-p", std::to_string(getpid()), "-d", "0.5", "-i", "100", "--include-hiperf"};
+    ASSERT_TRUE(cmd.OnSubCommandOptions(args));
+    StdoutRecord stdoutRecord;
+    stdoutRecord.Start();
+    HiperfError ret = cmd.OnSubCommand(args);
+    std::string stringOut = stdoutRecord.Stop();
+    EXPECT_EQ(ret, HiperfError::NO_ERR);
+    EXPECT_NE(stringOut.find("Overhead"), std::string::npos);
+}
+
+/**
+ * @tc.name: OnSubCommandSigterm
+ * @tc.desc: Test top stops at SIGTERM and shows the last table
+ * @tc.type: FUNC
+ */
+HWTEST_F(SubCommandTopTest, OnSubCommandSigterm, TestSize.Level2)
+{
+    SubCommandTop cmd;
+    std::vector<std::string> args = {"-p", std::to_string(getpid()), "-d", "10", "-i", "100", "--include-hiperf"};
+    ASSERT_TRUE(cmd.OnSubCommandOptions(args));
+    std::thread killer([&cmd] {
+        constexpr int waitCount = 500;
+        for (int i = 0; i < waitCount && !cmd.perfEvents_.IsTrackRunning(); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10)); // 10 : ms
+        }
+        kill(getpid(), SIGTERM);
+    });
+    StdoutRecord stdoutRecord;
+    stdoutRecord.Start();
+    const auto startTime = std::chrono::steady_clock::now();
+    HiperfError ret = cmd.OnSubCommand(args);
+    const auto usedTime = std::chrono::steady_clock::now() - startTime;
+    std::string stringOut = stdoutRecord.Stop();
+    killer.join();
+    EXPECT_EQ(ret, HiperfError::NO_ERR);
+    EXPECT_LT(usedTime, std::chrono::seconds(10)); // 10 : the -d seconds
+    EXPECT_NE(stringOut.find("Stop signal detected"), std::string::npos);
+    EXPECT_NE(stringOut.find("Overhead"), std::string::npos);
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "symbol_cache_test.h"
+
+#include <fstream>
+#include <vector>
+#include <sys/stat.h>
+
+#include "utilities.h"
+
+using namespace testing::ext;
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+class SymbolCacheTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+    void SetUp();
+    void TearDown();
+
+    static std::vector<DfxSymbol> CreateSymbols();
+
+    const std::string cacheDir_ = "/data/local/tmp/symbol_cache_test";
+    const std::string buildId_ = "0123456789abcdef0123456789abcdef01234567";
+    const std::string module_ = "/system/lib/libtest.so";
+};
+
+void SymbolCacheTest::SetUpTestCase() {}
+
+void SymbolCacheTest::TearDownTestCase() {}
+
+void SymbolCacheTest::SetUp()
+{
+    SymbolCache::SetDirectory(cacheDir_);
+}
+
+void SymbolCacheTest::TearDown()
+{
+    remove(SymbolCache::GetCacheFilePath(buildId_).c_str());
+    SymbolCache::SetDirectory("");
+}
+
+std::vector<DfxSymbol> SymbolCacheTest::CreateSymbols()
+{
+    std::vector<DfxSymbol> symbols;
+    symbols.emplace_back(0x1000, 0x10, "main", "main", "");
+    symbols.emplace_back(0x1010, 0x20, "_ZN4test3fooEv", "test::foo()", "");
+    symbols.emplace_back(0x1030, 0x30, "bar", "bar", "");
+    return symbols;
+}
+
+/**
+ * @tc.name: SaveAndLoad
+ * @tc.desc: the symbols loaded from cache are the same as the saved ones
+ * @tc.type: FUNC
+ */
+HWTEST_F(SymbolCacheTest, SaveAndLoad, TestSize.Level1)
+{
+    std::vector<DfxSymbol> symbols = CreateSymbols();
+    ASSERT_TRUE(SymbolCache::Save(buildId_, module_, symbols));
+
+    std::vector<DfxSymbol> loaded;
+    ASSERT_TRUE(SymbolCache::Load(buildId_, module_, loaded));
+    ASSERT_EQ(loaded.size(), symbols.size());
+    for (size_t i = 0; i < symbols.size(); i++) {
+        EXPECT_EQ(loaded[i].funcVaddr_, symbols[i].funcVaddr_);
+        EXPECT_EQ(loaded[i].size_, symbols[i].size_);
+        EXPECT_EQ(loaded[i].name_, symbols[i].name_);
+        EXPECT_EQ(loaded[i].GetName(), symbols[i].GetName());
+        EXPECT_EQ(loaded[i].module_, module_);
+    }
+}
+
+/**
+ * @tc.name: SaveAndLoadModule
+ * @tc.desc: the symbols of other modules keep their own module, like the kernel module symbols of kallsyms
+ * @tc.type: FUNC
+ */
+HWTEST_F(SymbolCacheTest, SaveAndLoadModule, TestSize.Level1)
+{
+    const std::string kernelModule = "[ext4]";
+    std::vector<DfxSymbol> symbols;
+    symbols.emplace_back(0x1000, 0x10, "start_kernel", "start_kernel", module_);
+    symbols.emplace_back(0x2000, 0x10, "ext4_read", "ext4_read", kernelModule);
+    ASSERT_TRUE(SymbolCache::Save(buildId_, module_, symbols));
+
+    std::vector<DfxSymbol> loaded;
+    ASSERT_TRUE(SymbolCache::Load(buildId_, module_, loaded));
+    ASSERT_EQ(loaded.size(), symbols.size());
+    EXPECT_EQ(loaded[0].module_, module_);
+    EXPECT_EQ(loaded[1].module_, kernelModule);
+}
+
+/**
+ * @tc.name: OwnerOnly
+ * @tc.desc: the cache may hold kallsyms, only the owner can read it
+ * @tc.type: FUNC
+ */
+HWTEST_F(SymbolCacheTest, OwnerOnly, TestSize.Level1)
+{
+    constexpr mode_t permMask = 0777;
+    rmdir(cacheDir_.c_str());
+    std::vector<DfxSymbol> symbols = CreateSymbols();
+    ASSERT_TRUE(SymbolCache::Save(buildId_, module_, symbols));
+
+    struct stat st;
+    ASSERT_EQ(stat(SymbolCache::GetCacheFilePath(buildId_).c_str(), &st), 0);
+    EXPECT_EQ(st.st_mode & permMask, S_IRUSR | S_IWUSR);
+    ASSERT_EQ(stat(cacheDir_.c_str(), &st), 0);
+    EXPECT_EQ(st.st_mode & permMask, S_IRWXU);
+}
+
+/**
+ * @tc.name: Disabled
+ * @tc.desc: nothing is saved or loaded without cache directory
+ * @tc.type: FUNC
+ */
+HWTEST_F(SymbolCacheTest, Disabled, TestSize.Level2)
+{
+    SymbolCache::SetDirectory("");
+    EXPECT_FALSE(SymbolCache::IsEnabled());
+    std::vector<DfxSymbol> symbols = CreateSymbols();
+    EXPECT_FALSE(SymbolCache::Save(buildId_, module_, symbols));
+    std::vector<DfxSymbol> loaded;
+    EXPECT_FALSE(SymbolCache::Load(buildId_, module_, loaded));
+}
+
+/**
+ * @tc.name: InvalidBuildId
+ * @tc.desc: empty or non hex build id is not cached
+ * @tc.type: FUNC
+ */
+HWTEST_F(SymbolCacheTest, InvalidBuildId, TestSize.Level2)
+{
+    std::vector<DfxSymbol> symbols = CreateSymbols();
+    EXPECT_FALSE(SymbolCache::Save("", module_, symbols));
+    EXPECT_FALSE(SymbolCache::Save("../libtest", module_, symbols));
+    EXPECT_TRUE(SymbolCache::GetCacheFilePath("../libtest").empty());
+}
+
+/**
+ * @tc.name: BrokenCache
+ * @tc.desc: a truncated cache file is ignored
+ * @tc.type: FUNC
+ */
+HWTEST_F(SymbolCacheTest, BrokenCache, TestSize.Level2)
+{
+    std::vector<DfxSymbol> symbols = CreateSymbols();
+    ASSERT_TRUE(SymbolCache::Save(buildId_, module_, symbols));
+    const std::string filePath = SymbolCache::GetCacheFilePath(buildId_);
+    std::string content = ReadFileToString(filePath);
+    ASSERT_GT(content.size(), sizeof(SymbolCacheHeader));
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    file.write(content.data(), content.size() - 1);
+    file.close();
+
+    std::vector<DfxSymbol> loaded;
+    EXPECT_FALSE(SymbolCache::Load(buildId_, module_, loaded));
+    EXPECT_TRUE(loaded.empty());
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
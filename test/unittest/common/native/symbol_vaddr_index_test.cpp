@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "symbol_vaddr_index_test.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "dfx_symbol.h"
+
+using namespace testing::ext;
+using namespace OHOS::HiviewDFX;
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+class SymbolVaddrIndexTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+    void SetUp();
+    void TearDown();
+
+    // same as upper_bound - 1 on the sorted symbols
+    static size_t ExpectFloor(const std::vector<DfxSymbol> &symbols, const uint64_t vaddr);
+};
+
+void SymbolVaddrIndexTest::SetUpTestCase() {}
+
+void SymbolVaddrIndexTest::TearDownTestCase() {}
+
+void SymbolVaddrIndexTest::SetUp() {}
+
+void SymbolVaddrIndexTest::TearDown() {}
+
+size_t SymbolVaddrIndexTest::ExpectFloor(const std::vector<DfxSymbol> &symbols, const uint64_t vaddr)
+{
+    auto found = std::upper_bound(symbols.begin(), symbols.end(), vaddr, DfxSymbol::ValueLessThen);
+    if (found == symbols.begin()) {
+        return SymbolVaddrIndex::NOT_FOUND;
+    }
+    return static_cast<size_t>(found - symbols.begin()) - 1;
+}
+
+/**
+ * @tc.name: Empty
+ * @tc.desc: nothing is found in an empty index
+ * @tc.type: FUNC
+ */
+HWTEST_F(SymbolVaddrIndexTest, Empty, TestSize.Level2)
+{
+    SymbolVaddrIndex index;
+    index.Build(std::vector<DfxSymbol>());
+    EXPECT_EQ(index.Size(), 0u);
+    EXPECT_EQ(index.FindFloor(0), SymbolVaddrIndex::NOT_FOUND);
+    EXPECT_EQ(index.FindFloor(UINT64_MAX), SymbolVaddrIndex::NOT_FOUND);
+}
+
+/**
+ * @tc.name: FindFloor
+ * @tc.desc: every size of tree finds the same symbol as upper_bound
+ * @tc.type: FUNC
+ */
+HWTEST_F(SymbolVaddrIndexTest, FindFloor, TestSize.Level1)
+{
+    constexpr size_t maxCount = 70;
+    constexpr uint64_t step = 0x10;
+    for (size_t count = 1; count <= maxCount; count++) {
+        std::vector<DfxSymbol> symbols;
+        for (size_t i = 0; i < count; i++) {
+            symbols.emplace_back(step * (i + 1), step / 2, "func", "func", "");
+        }
+        SymbolVaddrIndex index;
+        index.Build(symbols);
+        ASSERT_EQ(index.Size(), count);
+        for (uint64_t vaddr = 0; vaddr <= step * (count + 1); vaddr++) {
+            ASSERT_EQ(index.FindFloor(vaddr), ExpectFloor(symbols, vaddr)) << count << " " << vaddr;
+        }
+    }
+}
+
+/**
+ * @tc.name: FindFloorRandom
+ * @tc.desc: random vaddrs find the same symbol as upper_bound
+ * @tc.type: FUNC
+ */
+HWTEST_F(SymbolVaddrIndexTest, FindFloorRandom, TestSize.Level2)
+{
+    constexpr size_t count = 1000;
+    constexpr uint64_t range = 100000;
+    std::mt19937_64 random(count);
+    std::vector<uint64_t> vaddrs;
+    for (size_t i = 0; i < count; i++) {
+        vaddrs.emplace_back(random() % range);
+    }
+    std::sort(vaddrs.begin(), vaddrs.end());
+    vaddrs.erase(std::unique(vaddrs.begin(), vaddrs.end()), vaddrs.end());
+    std::vector<DfxSymbol> symbols;
+    for (uint64_t vaddr : vaddrs) {
+        symbols.emplace_back(vaddr, 1, "func", "func", "");
+    }
+    SymbolVaddrIndex index;
+    index.Build(symbols);
+    for (size_t i = 0; i < count; i++) {
+        uint64_t vaddr = random() % (range + 1);
+        EXPECT_EQ(index.FindFloor(vaddr), ExpectFloor(symbols, vaddr));
+    }
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS
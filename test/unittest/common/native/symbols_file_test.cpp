@@ -1551,6 +1551,31 @@ HWTEST_F(SymbolsFileTest, TestGetSymbolWithVaddrWithinRange, TestSize.Level2)
     EXPECT_EQ(result.offsetToVaddr_, 0x100u);
 }
 
+/**
+ * @tc.name: TestFindSymbolWithVaddrIndexed
+ * @tc.desc: Test FindSymbolWithVaddr returns the symbol in place after IndexSymbols
+ * @tc.type: FUNC
+ */
+HWTEST_F(SymbolsFileTest, TestFindSymbolWithVaddrIndexed, TestSize.Level2)
+{
+    auto symbolsFile = SymbolsFile::CreateSymbolsFile(SYMBOL_UNKNOW_FILE);
+    symbolsFile->AddSymbol(DfxSymbol(0x1000, 0x100, "func1", "test_mod"));
+    symbolsFile->AddSymbol(DfxSymbol(0x2000, 0x100, "func2", "test_mod"));
+    symbolsFile->IndexSymbols();
+    EXPECT_EQ(symbolsFile->symbolsIndex_.Size(), 2u);
+
+    const DfxSymbol *found = symbolsFile->FindSymbolWithVaddr(0x2010);
+    ASSERT_EQ(found, &symbolsFile->symbols_[1]);
+    DfxSymbol symbol = symbolsFile->GetVaddrSymbol(*found, 0x2010);
+    EXPECT_EQ(symbol.funcVaddr_, 0x2000u);
+    EXPECT_EQ(symbol.offsetToVaddr_, 0x10u);
+    EXPECT_EQ(symbol.fileVaddr_, 0x2010u);
+    // the shared one is not changed by the lookup
+    EXPECT_EQ(found->offsetToVaddr_, 0u);
+    EXPECT_EQ(symbolsFile->FindSymbolWithVaddr(0x1200), nullptr);
+    EXPECT_EQ(symbolsFile->FindSymbolWithVaddr(0x500), nullptr);
+}
+
 /**
  * @tc.name: TestAdjustSymbolsWithDuplicates
  * @tc.desc: Test AdjustSymbols removes duplicate symbols
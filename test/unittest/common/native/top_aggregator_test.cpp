@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "top_aggregator_test.h"
+
+#include <string>
+
+using namespace testing::ext;
+namespace OHOS {
+namespace Developtools {
+namespace HiPerf {
+class TopAggregatorTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+    void SetUp();
+    void TearDown();
+};
+
+void TopAggregatorTest::SetUpTestCase() {}
+
+void TopAggregatorTest::TearDownTestCase() {}
+
+void TopAggregatorTest::SetUp() {}
+
+void TopAggregatorTest::TearDown() {}
+
+/**
+ * @tc.name: GetTopFunctions
+ * @tc.desc: the functions and dsos are ordered by their event count
+ * @tc.type: FUNC
+ */
+HWTEST_F(TopAggregatorTest, GetTopFunctions, TestSize.Level1)
+{
+    TopAggregator aggregator;
+    aggregator.AddSample("liba.so", "funcA", 100);
+    aggregator.AddSample("libb.so", "funcB", 300);
+    aggregator.AddSample("liba.so", "funcA2", 150);
+    aggregator.AddSample("liba.so", "funcA", 100);
+    EXPECT_EQ(aggregator.GetRecentSamples(), 4u);
+    EXPECT_EQ(aggregator.GetFunctionCount(), 3u);
+    EXPECT_EQ(aggregator.GetDsoCount(), 2u);
+    EXPECT_DOUBLE_EQ(aggregator.GetTotalWeight(), 650);
+
+    auto funcs = aggregator.GetTopFunctions(2);
+    ASSERT_EQ(funcs.size(), 2u);
+    EXPECT_EQ(funcs[0].func, "funcB");
+    EXPECT_EQ(funcs[0].dso, "libb.so");
+    EXPECT_DOUBLE_EQ(funcs[0].weight, 300);
+    EXPECT_EQ(funcs[1].func, "funcA");
+    EXPECT_DOUBLE_EQ(funcs[1].weight, 200);
+
+    auto dsos = aggregator.GetTopDsos(10);
+    ASSERT_EQ(dsos.size(), 2u);
+    EXPECT_EQ(dsos[0].dso, "liba.so");
+    EXPECT_TRUE(dsos[0].func.empty());
+    EXPECT_DOUBLE_EQ(dsos[0].weight, 350);
+    EXPECT_EQ(dsos[1].dso, "libb.so");
+}
+
+/**
+ * @tc.name: Decay
+ * @tc.desc: the weight decays at each refresh and the idle items are dropped
+ * @tc.type: FUNC
+ */
+HWTEST_F(TopAggregatorTest, Decay, TestSize.Level1)
+{
+    TopAggregator aggregator(TopAggregator::DEFAULT_MAX_ENTRIES, 0.5);
+    aggregator.AddSample("liba.so", "funcA", 1000);
+    aggregator.AddSample("libb.so", "funcB", 4);
+    aggregator.Decay();
+    EXPECT_EQ(aggregator.GetRecentSamples(), 0u);
+    auto funcs = aggregator.GetTopFunctions(10);
+    ASSERT_EQ(funcs.size(), 2u);
+    EXPECT_DOUBLE_EQ(funcs[0].weight, 500);
+    EXPECT_DOUBLE_EQ(funcs[1].weight, 2);
+
+    // the new samples are heavier than the old ones
+    aggregator.AddSample("libb.so", "funcB", 600);
+    funcs = aggregator.GetTopFunctions(1);
+    ASSERT_EQ(funcs.size(), 1u);
+    EXPECT_EQ(funcs[0].func, "funcB");
+
+    for (int i = 0; i < 16; i++) { // 16 : all the weights are less than one event
+        aggregator.Decay();
+    }
+    EXPECT_EQ(aggregator.GetFunctionCount(), 0u);
+    EXPECT_EQ(aggregator.GetDsoCount(), 0u);
+    EXPECT_TRUE(aggregator.GetTopFunctions(10).empty());
+}
+
+/**
+ * @tc.name: DecayDropColdItems
+ * @tc.desc: the items much lighter than the total are dropped at decay
+ * @tc.type: FUNC
+ */
+HWTEST_F(TopAggregatorTest, DecayDropColdItems, TestSize.Level2)
+{
+    TopAggregator aggregator(TopAggregator::DEFAULT_MAX_ENTRIES, 1.0);
+    aggregator.AddSample("liba.so", "hot", 1000000);
+    aggregator.AddSample("liba.so", "cold", 10);
+    aggregator.Decay();
+    auto funcs = aggregator.GetTopFunctions(10);
+    ASSERT_EQ(funcs.size(), 1u);
+    EXPECT_EQ(funcs[0].func, "hot");
+    // the dso weight still counts the dropped function
+    auto dsos = aggregator.GetTopDsos(10);
+    ASSERT_EQ(dsos.size(), 1u);
+    EXPECT_DOUBLE_EQ(dsos[0].weight, 1000010);
+}
+
+/**
+ * @tc.name: Evict
+ * @tc.desc: the functions are bounded, the coldest ones are evicted
+ * @tc.type: FUNC
+ */
+HWTEST_F(TopAggregatorTest, Evict, TestSize.Level1)
+{
+    constexpr size_t maxEntries = 16;
+    TopAggregator aggregator(maxEntries, 1.0);
+    aggregator.AddSample("liba.so", "hot", 1000000);
+    for (size_t i = 0; i < maxEntries * 10; i++) {
+        aggregator.AddSample("lib" + std::to_string(i % 3) + ".so", "func" + std::to_string(i), i + 1);
+        EXPECT_LE(aggregator.GetFunctionCount(), maxEntries);
+    }
+    auto funcs = aggregator.GetTopFunctions(2);
+    ASSERT_EQ(funcs.size(), 2u);
+    EXPECT_EQ(funcs[0].func, "hot");
+    // the latest one is the heaviest of the others
+    EXPECT_EQ(funcs[1].func, "func" + std::to_string(maxEntries * 10 - 1));
+}
+
+/**
+ * @tc.name: EvictSameWeight
+ * @tc.desc: the functions are bounded even if all of them have the same weight
+ * @tc.type: FUNC
+ */
+HWTEST_F(TopAggregatorTest, EvictSameWeight, TestSize.Level2)
+{
+    constexpr size_t maxEntries = 16;
+    TopAggregator aggregator(maxEntries);
+    for (size_t i = 0; i < maxEntries * 10; i++) {
+        aggregator.AddSample("liba.so", "func" + std::to_string(i), 1);
+        EXPECT_LE(aggregator.GetFunctionCount(), maxEntries);
+    }
+    EXPECT_EQ(aggregator.GetDsoCount(), 1u);
+    EXPECT_EQ(aggregator.GetTopFunctions(maxEntries * 10).size(), aggregator.GetFunctionCount());
+}
+
+/**
+ * @tc.name: EvictEmptyDso
+ * @tc.desc: the dsos left without function are dropped at evict, except the one being added to
+ * @tc.type: FUNC
+ */
+HWTEST_F(TopAggregatorTest, EvictEmptyDso, TestSize.Level2)
+{
+    constexpr size_t maxEntries = 16;
+    TopAggregator aggregator(maxEntries, 1.0);
+    aggregator.AddSample("cold.so", "cold", 1);
+    for (size_t i = 1; i < maxEntries; i++) {
+        aggregator.AddSample("warm.so", "func" + std::to_string(i), 10); // 10 : heavier than cold
+    }
+    EXPECT_EQ(aggregator.GetDsoCount(), 2u);
+    aggregator.AddSample("hot.so", "hot", 100); // 100 : the hottest
+    EXPECT_EQ(aggregator.GetDsoCount(), 2u);
+    auto dsos = aggregator.GetTopDsos(maxEntries);
+    ASSERT_EQ(dsos.size(), 2u);
+    EXPECT_EQ(dsos[0].dso, "warm.so");
+    EXPECT_EQ(dsos[1].dso, "hot.so");
+    auto funcs = aggregator.GetTopFunctions(1);
+    ASSERT_EQ(funcs.size(), 1u);
+    EXPECT_EQ(funcs[0].func, "hot");
+}
+} // namespace HiPerf
+} // namespace Developtools
+} // namespace OHOS